@@ -0,0 +1,155 @@
+/**
+ * @file control_arbiter.c
+ * @brief Multi-source arbitration engine implementation
+ */
+
+#include "control_arbiter.h"
+#include <string.h>
+
+#define RATE_WINDOW_MS 1000
+
+static bool is_source(control_source_t s) {
+    return s > CONTROL_SOURCE_NONE && s < CONTROL_ARBITER_MAX_SOURCES;
+}
+
+/**
+ * @brief True if @p a should own control rather than @p b (b may be NONE)
+ */
+static bool preferred(const control_arbiter_t *arb, control_source_t a, control_source_t b) {
+    if (b == CONTROL_SOURCE_NONE) return true;
+    const control_arbiter_source_t *sa = &arb->src[a];
+    const control_arbiter_source_t *sb = &arb->src[b];
+    if (arb->policy == CONTROL_POLICY_PRIORITY && sa->cfg.priority != sb->cfg.priority) {
+        return sa->cfg.priority > sb->cfg.priority;
+    }
+    return (int32_t)(sa->last_order - sb->last_order) > 0;
+}
+
+static void set_owner(control_arbiter_t *arb, control_source_t owner) {
+    if (owner != arb->owner) {
+        arb->owner = owner;
+        arb->lease++;
+    }
+}
+
+void control_arbiter_init(control_arbiter_t *arb, control_policy_t policy,
+                          const control_arbiter_source_cfg_t cfg[CONTROL_ARBITER_MAX_SOURCES]) {
+    memset(arb, 0, sizeof(*arb));
+    arb->policy = policy;
+    arb->owner  = CONTROL_SOURCE_NONE;
+    for (int s = CONTROL_SOURCE_PS4; s < CONTROL_ARBITER_MAX_SOURCES; s++) {
+        arb->src[s].cfg = cfg[s];
+    }
+}
+
+void control_arbiter_on_frame(control_arbiter_t *arb, control_source_t source,
+                              uint32_t order, uint32_t now_ms, uint32_t count) {
+    if (!is_source(source)) return;
+
+    control_arbiter_source_t *src = &arb->src[source];
+    if (!src->seen) {
+        src->window_start_ms = now_ms;
+    }
+    src->seen         = true;
+    src->alive        = true;
+    src->last_seen_ms = now_ms;
+    src->last_order   = order;
+    src->frames      += count;
+
+    switch (arb->policy) {
+        case CONTROL_POLICY_LAST_WINS:
+            // Batches arrive in source order, not submit order: compare orders
+            if (preferred(arb, source, arb->owner)) {
+                set_owner(arb, source);
+            }
+            break;
+        case CONTROL_POLICY_PRIORITY:
+            if (preferred(arb, source, arb->owner) || source == arb->owner) {
+                // Equal priority falls back to "last wins"
+                set_owner(arb, source);
+            }
+            break;
+        case CONTROL_POLICY_STICKY_LEASE:
+            if (arb->owner == CONTROL_SOURCE_NONE) {
+                set_owner(arb, source);
+            }
+            break;
+    }
+}
+
+control_source_t control_arbiter_tick(control_arbiter_t *arb, uint32_t now_ms) {
+    // Liveness and rate bookkeeping: fixed number of sources, constant work
+    bool owner_died = false;
+    for (int s = CONTROL_SOURCE_PS4; s < CONTROL_ARBITER_MAX_SOURCES; s++) {
+        control_arbiter_source_t *src = &arb->src[s];
+        if (!src->seen) continue;
+
+        uint32_t window_ms = now_ms - src->window_start_ms;
+        if (window_ms >= RATE_WINDOW_MS) {
+            src->rate_hz = (float)(src->frames - src->window_frames) * 1000.0f / (float)window_ms;
+            src->window_frames   = src->frames;
+            src->window_start_ms = now_ms;
+        }
+
+        if (src->alive && (now_ms - src->last_seen_ms) > src->cfg.timeout_ms) {
+            src->alive = false;
+            if (s == (int)arb->owner) owner_died = true;
+        }
+    }
+
+    if (owner_died) {
+        // Fall back to the best remaining live source (policy-dependent)
+        control_source_t best = CONTROL_SOURCE_NONE;
+        for (int s = CONTROL_SOURCE_PS4; s < CONTROL_ARBITER_MAX_SOURCES; s++) {
+            if (arb->src[s].alive && preferred(arb, (control_source_t)s, best)) {
+                best = (control_source_t)s;
+            }
+        }
+        set_owner(arb, best);
+    }
+
+    return arb->owner;
+}
+
+bool control_arbiter_handover(control_arbiter_t *arb, uint32_t lease, control_source_t to) {
+    if (lease != arb->lease) return false;
+    if (to != CONTROL_SOURCE_NONE && (!is_source(to) || !arb->src[to].alive)) return false;
+    if (to == arb->owner) return false;
+    set_owner(arb, to);
+    return true;
+}
+
+bool control_arbiter_target_from_name(const char *name, control_source_t *out) {
+    static const char *const names[CONTROL_ARBITER_MAX_SOURCES] = {
+        [CONTROL_SOURCE_NONE]   = "none",
+        [CONTROL_SOURCE_PS4]    = "PS4",
+        [CONTROL_SOURCE_SERIAL] = "SERIAL",
+        [CONTROL_SOURCE_HTTP]   = "HTTP",
+    };
+    if (name == NULL) return false;
+    if (strcmp(name, "NONE") == 0) name = "none";
+    for (int s = 0; s < CONTROL_ARBITER_MAX_SOURCES; s++) {
+        if (names[s] && strcmp(name, names[s]) == 0) {
+            *out = (control_source_t)s;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool control_arbiter_lease_from_number(double value, uint32_t *out) {
+    // The range check also rejects NaN; the round trip rejects fractions
+    if (!(value >= 0.0 && value <= (double)UINT32_MAX)) return false;
+    uint32_t lease = (uint32_t)value;
+    if ((double)lease != value) return false;
+    *out = lease;
+    return true;
+}
+
+const char *control_arbiter_policy_name(control_policy_t policy) {
+    switch (policy) {
+        case CONTROL_POLICY_PRIORITY:     return "priority";
+        case CONTROL_POLICY_STICKY_LEASE: return "sticky_lease";
+        default:                          return "last_wins";
+    }
+}
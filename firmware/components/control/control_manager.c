@@ -1,164 +1,788 @@
 /**
  * @file control_manager.c
  * @brief Control arbitration manager implementation
+ *
+ * Each source owns a lock-free SPSC ring. control_manager_submit() only
+ * pushes into the caller's ring, so a Bluepad32 callback or HTTP handler on
+ * the radio core never waits for the control loop on the control core.
+ * control_task drains all rings, picks the owner, and republishes a status
+ * snapshot through a seqlock that only it writes.
+ *
+ * The loop is paced by a periodic esp_timer that notifies control_task, so
+ * each cycle starts at a fixed phase regardless of how long the previous one
+ * took. The rate is configurable up to 1 kHz; nothing in the cycle counts
+ * cycles to measure time, so timeouts and log intervals hold at any rate.
+ * Period, execution time, overruns and per-stage budgets are recorded every
+ * cycle.
+ *
+ * Between mixing and speed control the outputs pass through thermal_guard,
+ * which derates both tracks as the motors or bridges heat up, and
+ * battery_guard, which limits them while the load would pull the pack
+ * below its voltage floor.
+ *
+ * With CONFIG_ROBOT_CONTROL_PIPELINE_SINGLE_STAGE the motor ramp and PWM
+ * write also run inside the cycle, instead of in the separate motor_ramp task.
+ *
+ * E-stop frames do not wait for the loop: control_manager_submit() latches
+ * the safety e-stop and zeroes PWM from the submitting task.
+ *
+ * Ownership is decided by control_arbiter (policy and per-source priority /
+ * timeout from Kconfig). Only the owner's frames are mixed; e-stop from any
+ * source is always honoured.
+ *
+ * Every new owner frame is traced from its ingress timestamp through pickup,
+ * mix and the PWM write (latency_trace).
+ *
+ * With CONFIG_ROBOT_EVENTLOG, control_task is the only producer of the
+ * persistent event log: safety transitions, owner, thermal and battery state
+ * changes, and periodic samples while armed.
  */
 
 #include "control_manager.h"
+#include "control_arbiter.h"
+#include "latency_trace.h"
+#include "seqlock.h"
+#include "spsc_ring.h"
 #include "safety_failsafe.h"
 #include "mixer_diffdrive.h"
+#include "speed_ctrl.h"
+#include "thermal_guard.h"
+#include "battery_guard.h"
 #include "motor_bts7960.h"
+#include "event_log.h"
 #include "esp_log.h"
+#include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
+#include <stdatomic.h>
 #include <string.h>
 
 static const char *TAG = "control_mgr";
 
 static const char *source_names[] = {"NONE", "PS4", "SERIAL", "HTTP"};
 
-// Current state
-static control_source_t active_source = CONTROL_SOURCE_NONE;
-static control_frame_t  current_frame = {0};
-static float            last_left_output  = 0.0f;
-static float            last_right_output = 0.0f;
-static SemaphoreHandle_t mutex = NULL;
-static uint32_t last_update_tick = 0;
+// Sources double as safety journal origins
+_Static_assert((int)CONTROL_SOURCE_PS4 == (int)SAFETY_ORIGIN_PS4 &&
+               (int)CONTROL_SOURCE_SERIAL == (int)SAFETY_ORIGIN_SERIAL &&
+               (int)CONTROL_SOURCE_HTTP == (int)SAFETY_ORIGIN_HTTP,
+               "control_source_t and safety_origin_t numbering differ");
+
+#define CONTROL_SOURCE_COUNT 4  // including CONTROL_SOURCE_NONE
+
+#define SOURCE_RING_SIZE 32  // frames per source (power of two)
+
+/**
+ * @brief One submitted frame
+ */
+typedef struct {
+    control_frame_t frame;
+    uint32_t        order;     ///< Global submit order — newest source wins
+    uint32_t        submit_ms; ///< esp_timer time at submit (ms)
+} source_entry_t;
+
+/**
+ * @brief Frames from one source on their way to control_task
+ *
+ * Produced only by the source's task, consumed only by control_task.
+ */
+typedef struct {
+    spsc_ring_t    ring;
+    source_entry_t entries[SOURCE_RING_SIZE];
+    atomic_uint    dropped;  ///< Frames refused because the ring was full
+} source_queue_t;
+
+/**
+ * @brief Newest frame drained from one source (control_task only)
+ */
+typedef struct {
+    control_frame_t frame;
+    uint32_t        order;
+    uint32_t        submit_ms;
+    uint32_t        frames;  ///< Frames drained from this source since boot
+} source_latest_t;
+
+static source_queue_t   queues[CONTROL_SOURCE_COUNT];
+static atomic_uint      submit_order = 0;
+
+// Status snapshot (written only by control_task)
+static seqlock_t        status_lock;
+static control_status_t status = {0};
+
+// Arbitration (owned by control_task)
+static control_arbiter_t arbiter;
+
+// Pending handover request: HANDOVER_VALID | lease << 4 | target source
+#define HANDOVER_VALID      0x80000000u
+#define HANDOVER_LEASE_MASK 0x07FFFFFFu
+static atomic_uint handover_req = 0;
+
+#if defined(CONFIG_ROBOT_ARB_POLICY_PRIORITY)
+#define ARB_POLICY CONTROL_POLICY_PRIORITY
+#elif defined(CONFIG_ROBOT_ARB_POLICY_STICKY_LEASE)
+#define ARB_POLICY CONTROL_POLICY_STICKY_LEASE
+#else
+#define ARB_POLICY CONTROL_POLICY_LAST_WINS
+#endif
 
 // Constants
 #define CONTROL_TASK_STACK_SIZE 4096
 #define CONTROL_TASK_PRIORITY 5
-#define CONTROL_LOOP_RATE_MS 20  // 50Hz control loop
+#ifdef CONFIG_ROBOT_TASK_PINNING
+#define CONTROL_TASK_CORE CONFIG_ROBOT_CORE_CONTROL
+#else
+#define CONTROL_TASK_CORE tskNO_AFFINITY
+#endif
+#define SEQLOCK_READ_ATTEMPTS 4
+#define STATUS_LOG_INTERVAL_US 2000000  // periodic INFO log while active
+
+static uint32_t           loop_rate_hz;
+static uint32_t           loop_period_us;
+
+// Per-stage time budgets, indexed by control_stage_t
+static const uint32_t stage_budget_us[CONTROL_STAGE_COUNT] = {
+    [CONTROL_STAGE_ARBITRATE] = CONFIG_ROBOT_CONTROL_BUDGET_ARBITRATE_US,
+    [CONTROL_STAGE_MIX]       = CONFIG_ROBOT_CONTROL_BUDGET_MIX_US,
+    [CONTROL_STAGE_RAMP]      = CONFIG_ROBOT_CONTROL_BUDGET_RAMP_US,
+    [CONTROL_STAGE_PWM]       = CONFIG_ROBOT_CONTROL_BUDGET_PWM_US,
+};
+
+static TaskHandle_t       control_task_handle = NULL;
+static esp_timer_handle_t control_timer = NULL;
+
+// Loop timing statistics (accumulated and published by control_task only)
+static control_loop_stats_t loop_stats;
+static uint64_t             period_sum_us = 0;
+static seqlock_t            loop_stats_lock;
+static control_loop_stats_t loop_stats_pub = {0};
+static atomic_bool          loop_stats_reset = false;
+
+// E-stop fast path statistics (updated from any submitting task)
+static atomic_uint          estop_count = 0;
+static atomic_uint          estop_last_us = 0;
+static atomic_uint          estop_max_us = 0;
 
 /**
- * @brief Control loop task
+ * @brief Drain one source's ring into its newest-frame record
+ *
+ * Reads at most one ring's worth of frames, so a source that keeps pushing
+ * cannot hold the cycle. An arm request anywhere in the batch is kept even if
+ * a later frame in the same batch released the button.
+ *
+ * @return Number of frames drained
  */
-static void control_task(void *arg) {
+static uint32_t drain_queue(control_source_t source, source_latest_t *latest) {
+    source_queue_t *q = &queues[source];
+    uint32_t count = 0;
+    bool arm = false;
+    int32_t i;
+    while (count < SOURCE_RING_SIZE && (i = spsc_ring_read_slot(&q->ring)) >= 0) {
+        const source_entry_t *e = &q->entries[i];
+        latest->frame     = e->frame;
+        latest->order     = e->order;
+        latest->submit_ms = e->submit_ms;
+        arm |= e->frame.arm;
+        spsc_ring_release(&q->ring);
+        count++;
+    }
+    if (count > 0) {
+        latest->frame.arm = arm;
+        latest->frames   += count;
+    }
+    return count;
+}
+
+static void publish_status(control_source_t source, const control_frame_t *frame,
+                           float left, float right, uint32_t now_ms) {
+
+    seqlock_write_begin(&status_lock);
+    status.source       = source;
+    status.frame        = *frame;
+    status.left_output  = left;
+    status.right_output = right;
+    status.policy       = arbiter.policy;
+    status.lease        = arbiter.lease;
+    for (int s = 0; s < CONTROL_SOURCE_COUNT; s++) {
+        const control_arbiter_source_t *src = &arbiter.src[s];
+        control_source_info_t *info = &status.sources[s];
+        info->alive      = src->alive;
+        info->priority   = src->cfg.priority;
+        info->timeout_ms = src->cfg.timeout_ms;
+        info->age_ms     = src->seen ? now_ms - src->last_seen_ms : 0;
+        info->frames     = src->frames;
+        info->rate_hz    = src->rate_hz;
+        info->dropped    = atomic_load_explicit(&queues[s].dropped, memory_order_relaxed);
+    }
+    seqlock_write_end(&status_lock);
+}
+
+static void publish_loop_stats(void) {
+    seqlock_write_begin(&loop_stats_lock);
+    loop_stats_pub = loop_stats;
+    if (loop_stats.cycles > 1) {
+        loop_stats_pub.period_avg_us = (uint32_t)(period_sum_us / (loop_stats.cycles - 1));
+    }
+    seqlock_write_end(&loop_stats_lock);
+}
+
+static void reset_loop_stats(void) {
+    memset(&loop_stats, 0, sizeof(loop_stats));
+    loop_stats.rate_hz          = loop_rate_hz;
+    loop_stats.period_target_us = loop_period_us;
+    loop_stats.period_min_us    = UINT32_MAX;
+    loop_stats.exec_min_us      = UINT32_MAX;
+    for (int i = 0; i < CONTROL_STAGE_COUNT; i++) {
+        loop_stats.stages[i].budget_us = stage_budget_us[i];
+    }
+    period_sum_us = 0;
+}
+
+/**
+ * @brief Record one stage's execution time against its budget
+ */
+static void record_stage(control_stage_t stage, int64_t elapsed_us) {
+    control_stage_stats_t *st = &loop_stats.stages[stage];
+    uint32_t us = (elapsed_us > 0) ? (uint32_t)elapsed_us : 0;
+    st->last_us = us;
+    if (us > st->max_us) st->max_us = us;
+    if (us > st->budget_us) st->overruns++;
+}
+
+/**
+ * @brief Fold in the motor layer's ramp/PWM timing if it ran since last time
+ */
+static void record_motor_stages(void) {
+    static uint32_t last_runs = 0;
+    motor_tick_timing_t mt;
+    motor_get_tick_timing(&mt);
+    if (mt.runs != last_runs) {
+        last_runs = mt.runs;
+        record_stage(CONTROL_STAGE_RAMP, mt.ramp_us);
+        record_stage(CONTROL_STAGE_PWM, mt.pwm_us);
+    }
+}
+
+static int jitter_bucket(uint32_t jitter_us) {
+    static const uint32_t upper_us[CONTROL_LOOP_HIST_BUCKETS - 1] = {
+        50, 100, 250, 500, 1000, 2000, 5000,
+    };
+    for (int i = 0; i < CONTROL_LOOP_HIST_BUCKETS - 1; i++) {
+        if (jitter_us < upper_us[i]) return i;
+    }
+    return CONTROL_LOOP_HIST_BUCKETS - 1;
+}
+
+/**
+ * @brief Record one cycle's timing
+ *
+ * @param start_us   esp_timer time when the cycle started
+ * @param end_us     esp_timer time when the cycle's work finished
+ * @param late_ticks Timer ticks that expired while the previous cycle ran
+ */
+static void record_cycle(int64_t start_us, int64_t end_us, uint32_t late_ticks) {
+    static int64_t last_start_us = 0;
+
+    if (atomic_exchange(&loop_stats_reset, false)) {
+        reset_loop_stats();
+        last_start_us = 0;
+    }
+
+    uint32_t exec_us = (uint32_t)(end_us - start_us);
+    if (exec_us < loop_stats.exec_min_us) loop_stats.exec_min_us = exec_us;
+    if (exec_us > loop_stats.exec_max_us) loop_stats.exec_max_us = exec_us;
+    if (exec_us > loop_period_us) loop_stats.overruns++;
+    loop_stats.missed_ticks += late_ticks;
+
+    if (last_start_us != 0) {
+        uint32_t period_us = (uint32_t)(start_us - last_start_us);
+        if (period_us < loop_stats.period_min_us) loop_stats.period_min_us = period_us;
+        if (period_us > loop_stats.period_max_us) loop_stats.period_max_us = period_us;
+        period_sum_us += period_us;
+        uint32_t jitter_us = (period_us > loop_period_us)
+                           ? period_us - loop_period_us
+                           : loop_period_us - period_us;
+        loop_stats.jitter_hist[jitter_bucket(jitter_us)]++;
+    }
+    last_start_us = start_us;
+    loop_stats.cycles++;
+
+    publish_loop_stats();
+}
+
+/**
+ * @brief Periodic timer callback — wakes control_task at a fixed phase
+ */
+static void control_tick_cb(void *arg) {
+    xTaskNotifyGive(control_task_handle);
+}
+
+#ifdef CONFIG_ROBOT_EVENTLOG
+/**
+ * @brief Append what changed since the previous cycle to the event log
+ *
+ * Safety transitions are picked up from the safety journal, so those made
+ * by other tasks (e-stop fast path, failsafe timer) are logged as well.
+ */
+static void log_events(control_source_t source, const control_frame_t *frame,
+                       float left, float right, int64_t now_us) {
+    static safety_transition_t journal[SAFETY_JOURNAL_LEN];
+    static uint32_t           logged_transitions = 0;
+    static control_source_t   logged_source = CONTROL_SOURCE_NONE;
+    static thermal_state_t    logged_thermal = THERMAL_OK;
+    static battery_state_t    logged_battery = BATTERY_OK;
+    static int64_t            last_sample_us = 0;
+
+    const event_log_record_t base = {
+        .source   = (uint8_t)source,
+        .state    = (uint8_t)safety_get_state(),
+        .throttle = event_log_milli(frame->throttle),
+        .steering = event_log_milli(frame->steering),
+        .left     = event_log_milli(left),
+        .right    = event_log_milli(right),
+    };
+    event_log_record_t rec;
+
+    safety_journal_stats_t js;
+    safety_get_journal_stats(&js);
+    if (js.transitions != logged_transitions) {
+        size_t n = safety_get_journal(journal, SAFETY_JOURNAL_LEN);
+        for (size_t i = 0; i < n; i++) {
+            if ((int32_t)(journal[i].seq - logged_transitions) <= 0) continue;
+            rec = base;
+            rec.event  = EVENT_LOG_SAFETY;
+            rec.source = (uint8_t)journal[i].origin;
+            rec.state  = (uint8_t)journal[i].to;
+            rec.arg    = (uint8_t)journal[i].cause;
+            rec.value  = (uint32_t)journal[i].from;
+            event_log_append(&rec);
+        }
+        logged_transitions = js.transitions;
+    }
+
+    if (source != logged_source) {
+        rec = base;
+        rec.event = EVENT_LOG_SOURCE;
+        rec.arg   = (uint8_t)logged_source;
+        event_log_append(&rec);
+        logged_source = source;
+    }
+
+    thermal_guard_status_t ts;
+    thermal_guard_get_status(&ts);
+    if (ts.state != logged_thermal) {
+        rec = base;
+        rec.event = EVENT_LOG_THERMAL;
+        rec.arg   = (uint8_t)ts.state;
+        rec.value = (uint32_t)(ts.scale * 1000.0f + 0.5f);
+        event_log_append(&rec);
+        logged_thermal = ts.state;
+    }
+
+    battery_guard_status_t bs;
+    battery_guard_get_status(&bs);
+    if (bs.state != logged_battery) {
+        rec = base;
+        rec.event = EVENT_LOG_BATTERY;
+        rec.arg   = (uint8_t)bs.state;
+        rec.value = (uint32_t)(bs.volts * 1000.0f + 0.5f);
+        event_log_append(&rec);
+        logged_battery = bs.state;
+    }
+
+#if CONFIG_ROBOT_EVENTLOG_SAMPLE_MS > 0
+    if (safety_is_armed() &&
+        now_us - last_sample_us >= (int64_t)CONFIG_ROBOT_EVENTLOG_SAMPLE_MS * 1000) {
+        rec = base;
+        rec.event = EVENT_LOG_SAMPLE;
+        event_log_append(&rec);
+        last_sample_us = now_us;
+    }
+#endif
+}
+#endif
+
+/**
+ * @brief One control cycle: arbitrate, apply safety, mix, drive motors
+ */
+static void control_step(void) {
+    static control_source_t active_source = CONTROL_SOURCE_NONE;
+    static control_frame_t  current_frame = {0};
+    static source_latest_t  cached[CONTROL_SOURCE_COUNT] = {0};
+    static uint32_t         traced_frames[CONTROL_SOURCE_COUNT] = {0};
+    static int64_t          trace_pending_us = 0;  // stamp handed to the motor layer
+    static control_source_t trace_pending_src = CONTROL_SOURCE_NONE;
+    static int64_t          last_cycle_us = 0;
     float left_speed, right_speed;
-    
-    while (1) {
-        xSemaphoreTake(mutex, portMAX_DELAY);
-        
-        // Check timeout
-        uint32_t now = xTaskGetTickCount();
-        uint32_t timeout_ticks = pdMS_TO_TICKS(CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS);
-        
-        if (active_source != CONTROL_SOURCE_NONE && 
-            (now - last_update_tick) > timeout_ticks) {
+    int64_t cycle_us = esp_timer_get_time();
+    uint32_t now_ms  = (uint32_t)(cycle_us / 1000);
+    float dt_s = last_cycle_us ? (float)(cycle_us - last_cycle_us) * 1e-6f : 0.0f;
+    last_cycle_us = cycle_us;
+
+    // Feed new frames to the arbiter
+    uint32_t fresh[CONTROL_SOURCE_COUNT] = {0};
+    for (int s = CONTROL_SOURCE_PS4; s < CONTROL_SOURCE_COUNT; s++) {
+        uint32_t count = drain_queue((control_source_t)s, &cached[s]);
+        fresh[s] = count;
+        if (count > 0) {
+            control_arbiter_on_frame(&arbiter, (control_source_t)s, cached[s].order,
+                                     cached[s].submit_ms, count);
+        }
+    }
+
+    // Apply a pending explicit handover
+    uint32_t req = atomic_exchange(&handover_req, 0);
+    if (req & HANDOVER_VALID) {
+        uint32_t lease = (arbiter.lease & ~HANDOVER_LEASE_MASK) |
+                         ((req >> 4) & HANDOVER_LEASE_MASK);
+        control_source_t to = (control_source_t)(req & 0xF);
+        if (control_arbiter_handover(&arbiter, lease, to)) {
+            ESP_LOGI(TAG, "Handover: %s -> %s", source_names[active_source], source_names[to]);
+        } else {
+            ESP_LOGW(TAG, "Handover to %s refused (stale lease or dead source)", source_names[to]);
+        }
+    }
+
+    // Expire dead sources and settle ownership
+    control_source_t owner = control_arbiter_tick(&arbiter, now_ms);
+
+    if (owner != active_source) {
+        if (owner == CONTROL_SOURCE_NONE) {
             ESP_LOGW(TAG, "Control timeout! Source %d inactive for %lu ms",
-                     active_source, (now - last_update_tick) * portTICK_PERIOD_MS);
-            active_source = CONTROL_SOURCE_NONE;
-            memset(&current_frame, 0, sizeof(current_frame));
+                     active_source, arbiter.src[active_source].cfg.timeout_ms);
+        } else {
+            ESP_LOGI(TAG, "Control source changed: %d -> %d", active_source, owner);
         }
-        
-        // Handle emergency stop
-        if (current_frame.estop) {
-            safety_emergency_stop();
-            xSemaphoreGive(mutex);
-            vTaskDelay(pdMS_TO_TICKS(CONTROL_LOOP_RATE_MS));
-            continue;
+    }
+    active_source = owner;
+
+    // Trace each owner frame once, from the cycle that first picks it up
+    int64_t trace_us = 0;
+    if (active_source != CONTROL_SOURCE_NONE) {
+        current_frame = cached[active_source].frame;
+        if (cached[active_source].frames != traced_frames[active_source]) {
+            traced_frames[active_source] = cached[active_source].frames;
+            trace_us = current_frame.timestamp_us;
+            latency_trace_record(active_source, LATENCY_STAGE_PICKUP, trace_us, cycle_us);
         }
-        
-        // Handle arming
-        if (current_frame.arm) {
-            safety_arm();
+    } else {
+        memset(&current_frame, 0, sizeof(current_frame));
+    }
+    int64_t arbitrated_us = esp_timer_get_time();
+    record_stage(CONTROL_STAGE_ARBITRATE, arbitrated_us - cycle_us);
+
+    // Thermal model: integrate the duty the tracks actually ran at. Runs in
+    // every state, so the motors and bridges also cool while stopped
+    float applied_left, applied_right;
+    motor_get_speeds(NULL, NULL, &applied_left, &applied_right);
+    thermal_guard_update(applied_left, applied_right, dt_s);
+    // Battery estimator: needs the sag under load, and the rest voltage too
+    battery_guard_update(applied_left, applied_right, dt_s);
+#ifdef CONFIG_ROBOT_EVENTLOG
+    log_events(active_source, &current_frame, applied_left, applied_right, cycle_us);
+#endif
+
+    // A PWM fault input has already forced the outputs low in hardware;
+    // latch e-stop so control stays stopped until the fault is reset
+    static uint32_t seen_pwm_faults = 0;
+    uint32_t pwm_faults = motor_get_pwm_fault_count();
+    if (pwm_faults != seen_pwm_faults) {
+        seen_pwm_faults = pwm_faults;
+        ESP_LOGE(TAG, "PWM hardware fault trip (%lu total)", pwm_faults);
+        if (safety_get_state() != SAFETY_STATE_ESTOP) {
+            safety_emergency_stop_from(SAFETY_CAUSE_PWM_FAULT, SAFETY_ORIGIN_SYSTEM);
         }
-        
-        // Update watchdog
-        if (active_source != CONTROL_SOURCE_NONE) {
-            safety_update_watchdog();
+    }
+
+    // Handle emergency stop (normally already latched by the submit fast path)
+    if (current_frame.estop) {
+        if (safety_get_state() != SAFETY_STATE_ESTOP) {
+            safety_emergency_stop_from(SAFETY_CAUSE_ESTOP, (safety_origin_t)active_source);
         }
-        
-        // Mix and send to motors (only if armed)
-        if (safety_is_armed()) {
-            mixer_diffdrive_mix(current_frame.throttle, current_frame.steering,
-                                current_frame.slow_mode, &left_speed, &right_speed);
-            motor_set_speeds(left_speed, right_speed);
-            last_left_output  = left_speed;
-            last_right_output = right_speed;
-        } else {
-            motor_set_speeds(0.0f, 0.0f);
-            last_left_output  = 0.0f;
-            last_right_output = 0.0f;
+        publish_status(active_source, &current_frame, 0.0f, 0.0f, now_ms);
+        return;
+    }
+
+    // Handle arming
+    if (current_frame.arm) {
+        safety_arm_from((safety_origin_t)active_source);
+    }
+
+    // Update watchdog, only on a frame the owner delivered this cycle: an
+    // owner the arbiter still counts as alive is no proof of fresh input
+    if (active_source != CONTROL_SOURCE_NONE && fresh[active_source] > 0) {
+        safety_update_watchdog();
+    }
+
+    // Mix and send to motors (only if armed)
+    if (safety_is_armed()) {
+        mixer_diffdrive_mix(current_frame.throttle, current_frame.steering,
+                            current_frame.slow_mode, &left_speed, &right_speed);
+        // Target track speeds -> duty (pass-through when open loop). Heat
+        // derating and the battery floor limit the duty itself, the same on
+        // both tracks, so a closed loop cannot wind up past them on a stall
+        float limit = thermal_guard_get_scale() * battery_guard_get_scale();
+        speed_ctrl_run(&left_speed, &right_speed, limit, dt_s);
+        if (trace_us != 0) {
+            latency_trace_record(active_source, LATENCY_STAGE_MIX, trace_us, esp_timer_get_time());
+            trace_pending_us  = trace_us;
+            trace_pending_src = active_source;
         }
+        motor_set_speeds_traced(left_speed, right_speed, trace_us);
+    } else {
+        left_speed  = 0.0f;
+        right_speed = 0.0f;
+        motor_set_speeds(0.0f, 0.0f);
+        speed_ctrl_reset();
+    }
+    // An e-stop fast path may have run since the armed check above; make sure
+    // its zero target is not overwritten by this cycle's mix
+    if (!safety_is_armed()) {
+        left_speed  = 0.0f;
+        right_speed = 0.0f;
+        motor_set_speeds(0.0f, 0.0f);
+    }
+    record_stage(CONTROL_STAGE_MIX, esp_timer_get_time() - arbitrated_us);
+#ifdef CONFIG_ROBOT_CONTROL_PIPELINE_SINGLE_STAGE
+    // Ramp and write PWM in the same cycle as the mix
+    motor_bts7960_tick();
+#endif
+    record_motor_stages();
 
-        // Periodic INFO log every 2 s (100 loops @ 50 Hz) when active
-        static uint32_t log_counter = 0;
-        if (active_source != CONTROL_SOURCE_NONE || safety_is_armed()) {
-            if (++log_counter >= 100) {
-                log_counter = 0;
-                const char *src = (active_source < 4) ? source_names[active_source] : "?";
-                ESP_LOGI(TAG, "[%s|%s] in: thr=%+.2f str=%+.2f slow=%d | out: L=%+.2f R=%+.2f",
-                         src,
-                         safety_is_armed() ? "ARMED" : "DISARMED",
-                         current_frame.throttle, current_frame.steering,
-                         (int)current_frame.slow_mode,
-                         last_left_output, last_right_output);
-            }
-        } else {
-            log_counter = 0;
+    // Close the trace once the motor layer reports the PWM write (same cycle
+    // in the single-stage pipeline, a later one in the two-stage pipeline)
+    int64_t applied_trace_us, applied_at_us;
+    if (motor_take_applied_trace(&applied_trace_us, &applied_at_us) &&
+        applied_trace_us == trace_pending_us) {
+        latency_trace_record(trace_pending_src, LATENCY_STAGE_PWM, applied_trace_us, applied_at_us);
+        trace_pending_us = 0;
+    }
+    publish_status(active_source, &current_frame, left_speed, right_speed, now_ms);
+
+    // Periodic INFO log every 2 s when active
+    static int64_t last_log_us = 0;
+    if (active_source != CONTROL_SOURCE_NONE || safety_is_armed()) {
+        if (last_log_us == 0) {
+            last_log_us = cycle_us;
+        } else if (cycle_us - last_log_us >= STATUS_LOG_INTERVAL_US) {
+            last_log_us = cycle_us;
+            const char *src = (active_source < 4) ? source_names[active_source] : "?";
+            ESP_LOGI(TAG, "[%s|%s] in: thr=%+.2f str=%+.2f slow=%d | out: L=%+.2f R=%+.2f",
+                     src,
+                     safety_is_armed() ? "ARMED" : "DISARMED",
+                     current_frame.throttle, current_frame.steering,
+                     (int)current_frame.slow_mode,
+                     left_speed, right_speed);
         }
+    } else {
+        last_log_us = 0;
+    }
+}
 
-        xSemaphoreGive(mutex);
-        vTaskDelay(pdMS_TO_TICKS(CONTROL_LOOP_RATE_MS));
+/**
+ * @brief Control loop task — runs one cycle per control_tick_cb() notification
+ */
+static void control_task(void *arg) {
+#ifdef CONFIG_ROBOT_CONTROL_TASK_WDT
+    // A stuck cycle trips the task watchdog, which cuts the bridge outputs
+    if (esp_task_wdt_add(NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to subscribe control_task to the task watchdog");
+    }
+#endif
+    while (1) {
+        // Each timer tick adds one to the notification count; more than one
+        // pending means the previous cycle ran past a tick boundary.
+        uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int64_t start_us = esp_timer_get_time();
+
+        control_step();
+#ifdef CONFIG_ROBOT_CONTROL_TASK_WDT
+        esp_task_wdt_reset();
+#endif
+
+        record_cycle(start_us, esp_timer_get_time(), ticks > 1 ? ticks - 1 : 0);
     }
 }
 
-esp_err_t control_manager_init(void) {
-    mutex = xSemaphoreCreateMutex();
-    if (mutex == NULL) {
-        ESP_LOGE(TAG, "Failed to create mutex");
-        return ESP_FAIL;
+esp_err_t control_manager_init(const control_manager_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    loop_rate_hz = config->loop_rate_hz;
+    if (loop_rate_hz < CONTROL_LOOP_RATE_MIN_HZ) loop_rate_hz = CONTROL_LOOP_RATE_MIN_HZ;
+    if (loop_rate_hz > CONTROL_LOOP_RATE_MAX_HZ) loop_rate_hz = CONTROL_LOOP_RATE_MAX_HZ;
+    loop_period_us = 1000000 / loop_rate_hz;
+
+    for (int s = 0; s < CONTROL_SOURCE_COUNT; s++) {
+        spsc_ring_init(&queues[s].ring, SOURCE_RING_SIZE);
     }
-    
+    reset_loop_stats();
+
+    control_arbiter_source_cfg_t arb_cfg[CONTROL_SOURCE_COUNT] = {
+        [CONTROL_SOURCE_PS4]    = { CONFIG_ROBOT_ARB_PRIORITY_PS4,    CONFIG_ROBOT_ARB_TIMEOUT_PS4_MS },
+        [CONTROL_SOURCE_SERIAL] = { CONFIG_ROBOT_ARB_PRIORITY_SERIAL, CONFIG_ROBOT_ARB_TIMEOUT_SERIAL_MS },
+        [CONTROL_SOURCE_HTTP]   = { CONFIG_ROBOT_ARB_PRIORITY_HTTP,   CONFIG_ROBOT_ARB_TIMEOUT_HTTP_MS },
+    };
+    // An owner that outlives the failsafe would hold control while stopped
+    for (int s = CONTROL_SOURCE_PS4; s < CONTROL_SOURCE_COUNT; s++) {
+        if (arb_cfg[s].timeout_ms > CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS) {
+            ESP_LOGW(TAG, "%s timeout %lu ms capped at the failsafe timeout (%d ms)",
+                     source_names[s], arb_cfg[s].timeout_ms, CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS);
+            arb_cfg[s].timeout_ms = CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS;
+        }
+    }
+    control_arbiter_init(&arbiter, ARB_POLICY, arb_cfg);
+
     // Start control task
-    BaseType_t ret = xTaskCreate(control_task, "control_task",
-                                  CONTROL_TASK_STACK_SIZE, NULL,
-                                  CONTROL_TASK_PRIORITY, NULL);
+    BaseType_t ret = xTaskCreatePinnedToCore(control_task, "control_task",
+                                             CONTROL_TASK_STACK_SIZE, NULL,
+                                             CONTROL_TASK_PRIORITY, &control_task_handle,
+                                             CONTROL_TASK_CORE);
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create control task");
         return ESP_FAIL;
     }
-    
-    ESP_LOGI(TAG, "Control manager initialized (loop rate: %d ms)", CONTROL_LOOP_RATE_MS);
+
+    // Start the loop clock
+    esp_timer_create_args_t timer_args = {
+        .callback = &control_tick_cb,
+        .name = "control_tick",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &control_timer);
+    if (err == ESP_OK) {
+        err = esp_timer_start_periodic(control_timer, loop_period_us);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start control timer: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Control manager initialized (loop rate: %lu Hz, policy: %s)",
+             loop_rate_hz, control_arbiter_policy_name(ARB_POLICY));
     return ESP_OK;
 }
 
+/**
+ * @brief E-stop fast path — stop the motors from the submitting task
+ */
+static void submit_estop(control_source_t source) {
+    if (safety_get_state() == SAFETY_STATE_ESTOP) {
+        return;  // already latched, PWM already zero
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    safety_emergency_stop_from(SAFETY_CAUSE_ESTOP, (safety_origin_t)source);
+    int64_t stop_us = motor_get_last_stop_time_us();
+    atomic_fetch_add(&estop_count, 1);
+    if (stop_us <= start_us) {
+        return;  // no stop recorded since submit: no latency sample
+    }
+
+    uint32_t latency_us = (uint32_t)(stop_us - start_us);
+    atomic_store(&estop_last_us, latency_us);
+    unsigned max_us = atomic_load(&estop_max_us);
+    while (latency_us > max_us &&
+           !atomic_compare_exchange_weak(&estop_max_us, &max_us, latency_us)) {
+    }
+}
+
 esp_err_t control_manager_submit(control_source_t source, const control_frame_t *frame) {
-    if (frame == NULL) {
+    if (frame == NULL || source <= CONTROL_SOURCE_NONE || source >= CONTROL_SOURCE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (frame->estop) {
+        submit_estop(source);
+    }
+
+    source_queue_t *q = &queues[source];
+    int32_t i = spsc_ring_write_slot(&q->ring);
+    if (i < 0) {
+        // Control task stalled for a full ring; e-stop was already handled
+        atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+        return ESP_ERR_NO_MEM;
+    }
+
+    source_entry_t *e = &q->entries[i];
+    e->frame     = *frame;
+    e->order     = atomic_fetch_add_explicit(&submit_order, 1, memory_order_relaxed);
+    e->submit_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    spsc_ring_publish(&q->ring);
+
+    return ESP_OK;
+}
+
+esp_err_t control_manager_handover(control_source_t to, uint32_t lease) {
+    if (to < CONTROL_SOURCE_NONE || to >= CONTROL_SOURCE_COUNT) {
         return ESP_ERR_INVALID_ARG;
     }
-    
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    
-    // Update active source (last one wins)
-    if (source != active_source) {
-        ESP_LOGI(TAG, "Control source changed: %d -> %d", active_source, source);
-        active_source = source;
-    }
-    
-    // Update frame
-    memcpy(&current_frame, frame, sizeof(control_frame_t));
-    last_update_tick = xTaskGetTickCount();
-    
-    xSemaphoreGive(mutex);
+    atomic_store(&handover_req, HANDOVER_VALID |
+                 ((lease & HANDOVER_LEASE_MASK) << 4) | (uint32_t)to);
     return ESP_OK;
 }
 
 control_source_t control_manager_get_active_source(void) {
-    control_source_t source;
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    source = active_source;
-    xSemaphoreGive(mutex);
-    return source;
+    control_status_t snapshot;
+    control_manager_get_status(&snapshot);
+    return snapshot.source;
 }
 
 void control_manager_get_status(control_status_t *out) {
     if (!out) return;
-    xSemaphoreTake(mutex, portMAX_DELAY);
-    out->source       = active_source;
-    out->frame        = current_frame;
-    out->left_output  = last_left_output;
-    out->right_output = last_right_output;
-    xSemaphoreGive(mutex);
+    for (int attempt = 0; ; attempt++) {
+        unsigned seq = seqlock_read_begin(&status_lock);
+        *out = status;
+        if (seqlock_read_valid(&status_lock, seq)) {
+            return;
+        }
+        // This caller may have preempted the control task mid-write; let it finish
+        if (attempt >= SEQLOCK_READ_ATTEMPTS) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+void control_manager_get_loop_stats(control_loop_stats_t *out) {
+    if (!out) return;
+    for (int attempt = 0; ; attempt++) {
+        unsigned seq = seqlock_read_begin(&loop_stats_lock);
+        *out = loop_stats_pub;
+        if (seqlock_read_valid(&loop_stats_lock, seq)) {
+            break;
+        }
+        if (attempt >= SEQLOCK_READ_ATTEMPTS) {
+            vTaskDelay(1);
+        }
+    }
+    if (out->cycles == 0) {
+        out->rate_hz          = loop_rate_hz;
+        out->period_target_us = loop_period_us;
+        for (int i = 0; i < CONTROL_STAGE_COUNT; i++) {
+            out->stages[i].budget_us = stage_budget_us[i];
+        }
+        out->period_min_us = 0;
+        out->exec_min_us   = 0;
+    } else if (out->cycles == 1) {
+        out->period_min_us = 0;
+    }
+}
+
+void control_manager_get_estop_stats(control_estop_stats_t *out) {
+    if (!out) return;
+    out->count           = atomic_load(&estop_count);
+    out->last_latency_us = atomic_load(&estop_last_us);
+    out->max_latency_us  = atomic_load(&estop_max_us);
+}
+
+void control_manager_reset_loop_stats(void) {
+    atomic_store(&loop_stats_reset, true);
+}
+
+const char *control_manager_stage_name(control_stage_t stage) {
+    switch (stage) {
+        case CONTROL_STAGE_ARBITRATE: return "arbitrate";
+        case CONTROL_STAGE_MIX:       return "mix";
+        case CONTROL_STAGE_RAMP:      return "ramp";
+        case CONTROL_STAGE_PWM:       return "pwm";
+        default:                      return "?";
+    }
 }
@@ -7,18 +7,36 @@
  * - POST /control   {"throttle": 0.5, "steering": -0.2, "slow_mode": false}
  * - POST /estop     Trigger emergency stop
  * - POST /arm       Arm the system
- * - GET  /status    JSON system status
+ * - GET  /status    JSON system status (incl. control loop timing)
+ * - POST /loop-stats/reset  Clear control loop timing statistics
+ * - GET  /latency   Per-source input-to-PWM latency (p50/p99/max per stage)
+ * - POST /latency/reset  Clear latency histograms
+ * - GET  /safety    Safety state, failsafe reaction times, transition journal
+ * - GET  /eventlog  Persistent event log, binary (tools/eventlog_decode.py)
+ * - POST /handover  {"to":"PS4","lease":12}  Hand control to another source
  * - POST /wifi      {"ssid":"...", "password":"..."}  Save STA credentials to NVS
  * - GET  /config    Return current robot config (NVS overrides or Kconfig defaults)
- * - POST /config    {"deadzone":5,"expo":30,"max_speed":100,"slow_factor":50}
- *                   Save robot config to NVS — takes effect after reboot
+ * - POST /config    {"deadzone":5,"expo":30,"max_speed":100,"slow_factor":50,
+ *                    "desat":"normalize","turn":"curvature","pivot":15,"loop_hz":50}
+ *                   Save robot config to NVS — drive fields apply live,
+ *                   loop_hz after reboot
  */
 
 #include "controller_http.h"
 #include "control_manager.h"
+#include "control_arbiter.h"
 #include "control_frame.h"
+#include "latency_trace.h"
+#include "drive_config.h"
+#include "mixer_diffdrive.h"
+#include "speed_ctrl.h"
+#include "thermal_guard.h"
+#include "battery_guard.h"
+#include "controller_serial.h"
 #include "safety_failsafe.h"
 #include "motor_bts7960.h"
+#include "current_sense.h"
+#include "event_log.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
@@ -44,6 +62,11 @@ static const char *TAG = "ctrl_http";
 #define WIFI_AP_MAX_CONN       CONFIG_ROBOT_WIFI_MAX_CONN
 #define WIFI_STA_TIMEOUT_MS    15000
 #define WIFI_RECONNECT_MS      5000
+#ifdef CONFIG_ROBOT_TASK_PINNING
+#define HTTP_TASK_CORE         CONFIG_ROBOT_CORE_INPUT
+#else
+#define HTTP_TASK_CORE         tskNO_AFFINITY
+#endif
 
 static httpd_handle_t server = NULL;
 static bool sta_connected = false;
@@ -275,7 +298,7 @@ static esp_err_t control_post_handler(httpd_req_t *req) {
     }
 
     control_frame_t frame = {0};
-    frame.timestamp = xTaskGetTickCount();
+    frame.timestamp_us = esp_timer_get_time();
 
     cJSON *throttle = cJSON_GetObjectItem(root, "throttle");
     if (throttle) frame.throttle = control_clamp((float)throttle->valuedouble);
@@ -338,7 +361,7 @@ static esp_err_t wifi_post_handler(httpd_req_t *req) {
 static esp_err_t estop_post_handler(httpd_req_t *req) {
     control_frame_t frame = {0};
     frame.estop = true;
-    frame.timestamp = xTaskGetTickCount();
+    frame.timestamp_us = esp_timer_get_time();
     control_manager_submit(CONTROL_SOURCE_HTTP, &frame);
 
     httpd_resp_set_type(req, "application/json");
@@ -347,10 +370,12 @@ static esp_err_t estop_post_handler(httpd_req_t *req) {
 }
 
 static esp_err_t estop_reset_post_handler(httpd_req_t *req) {
-    esp_err_t ret = safety_estop_reset();
+    esp_err_t ret = safety_estop_reset_from(SAFETY_ORIGIN_HTTP);
     httpd_resp_set_type(req, "application/json");
     if (ret == ESP_OK) {
         httpd_resp_sendstr(req, "{\"status\":\"ok\",\"message\":\"E-STOP cleared — re-arm to continue\"}");
+    } else if (safety_get_state() == SAFETY_STATE_ESTOP) {
+        httpd_resp_sendstr(req, "{\"status\":\"err\",\"message\":\"Motor fault input still active\"}");
     } else {
         httpd_resp_sendstr(req, "{\"status\":\"err\",\"message\":\"Not in E-STOP state\"}");
     }
@@ -360,7 +385,7 @@ static esp_err_t estop_reset_post_handler(httpd_req_t *req) {
 static esp_err_t arm_post_handler(httpd_req_t *req) {
     control_frame_t frame = {0};
     frame.arm = true;
-    frame.timestamp = xTaskGetTickCount();
+    frame.timestamp_us = esp_timer_get_time();
     control_manager_submit(CONTROL_SOURCE_HTTP, &frame);
 
     httpd_resp_set_type(req, "application/json");
@@ -368,14 +393,6 @@ static esp_err_t arm_post_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
-static const char *state_name(safety_state_t s) {
-    switch (s) {
-        case SAFETY_STATE_ARMED:    return "ARMED";
-        case SAFETY_STATE_ESTOP:    return "ESTOP";
-        default:                    return "DISARMED";
-    }
-}
-
 static const char *source_name(control_source_t s) {
     switch (s) {
         case CONTROL_SOURCE_PS4:    return "PS4";
@@ -392,14 +409,71 @@ static esp_err_t status_get_handler(httpd_req_t *req) {
     float lt = 0, rt = 0, la = 0, ra = 0;
     motor_get_speeds(&lt, &rt, &la, &ra);
 
+    control_loop_stats_t ls;
+    control_manager_get_loop_stats(&ls);
+
+    motor_pipeline_stats_t ps;
+    motor_get_pipeline_stats(&ps);
+
+    motor_pwm_stats_t pw;
+    motor_get_pwm_stats(&pw);
+
+    control_estop_stats_t es;
+    control_manager_get_estop_stats(&es);
+
+    speed_ctrl_status_t sc;
+    speed_ctrl_get_status(&sc);
+
+    current_sense_status_t cur;
+    current_sense_get_status(&cur);
+
+    thermal_guard_status_t th;
+    thermal_guard_get_status(&th);
+
+    battery_guard_status_t bat;
+    battery_guard_get_status(&bat);
+
+    serial_rx_stats_t ser;
+    controller_serial_get_stats(&ser);
+
     safety_state_t st = safety_get_state();
 
-    char json[640];
+    char sources_json[448];
+    int n = 0;
+    for (int i = CONTROL_SOURCE_PS4; i <= CONTROL_SOURCE_HTTP; i++) {
+        const control_source_info_t *si = &cs.sources[i];
+        n += snprintf(sources_json + n, sizeof(sources_json) - n,
+            "%s\"%s\":{\"alive\":%s,\"priority\":%d,\"timeout_ms\":%lu,"
+            "\"age_ms\":%lu,\"frames\":%lu,\"rate_hz\":%.1f,\"dropped\":%lu}",
+            (i > CONTROL_SOURCE_PS4) ? "," : "",
+            source_name((control_source_t)i),
+            si->alive ? "true" : "false", si->priority, si->timeout_ms,
+            si->age_ms, si->frames, si->rate_hz, si->dropped);
+        if (n >= (int)sizeof(sources_json)) break;
+    }
+
+    char stages_json[320];
+    n = 0;
+    for (int i = 0; i < CONTROL_STAGE_COUNT; i++) {
+        const control_stage_stats_t *sg = &ls.stages[i];
+        n += snprintf(stages_json + n, sizeof(stages_json) - n,
+            "%s\"%s\":{\"budget_us\":%lu,\"last_us\":%lu,\"max_us\":%lu,\"overruns\":%lu}",
+            i ? "," : "", control_manager_stage_name((control_stage_t)i),
+            sg->budget_us, sg->last_us, sg->max_us, sg->overruns);
+        if (n >= (int)sizeof(stages_json)) break;
+    }
+
+    char json[3520];
     snprintf(json, sizeof(json),
         "{"
         "\"state\":\"%s\","
         "\"armed\":%s,"
         "\"source\":\"%s\","
+        "\"arbitration\":{"
+          "\"policy\":\"%s\","
+          "\"lease\":%lu,"
+          "\"sources\":{%s}"
+        "},"
         "\"input\":{"
           "\"throttle\":%.3f,"
           "\"steering\":%.3f,"
@@ -413,6 +487,89 @@ static esp_err_t status_get_handler(httpd_req_t *req) {
           "\"left_actual\":%.3f,"
           "\"right_actual\":%.3f"
         "},"
+        "\"loop\":{"
+          "\"rate_hz\":%lu,"
+          "\"cycles\":%lu,"
+          "\"period_target_us\":%lu,"
+          "\"period_min_us\":%lu,"
+          "\"period_avg_us\":%lu,"
+          "\"period_max_us\":%lu,"
+          "\"exec_max_us\":%lu,"
+          "\"overruns\":%lu,"
+          "\"missed_ticks\":%lu,"
+          "\"jitter_hist\":[%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu],"
+          "\"stages\":{%s}"
+        "},"
+        "\"pipeline\":{"
+          "\"stages\":%d,"
+          "\"latency_last_us\":%lu,"
+          "\"latency_avg_us\":%lu,"
+          "\"latency_max_us\":%lu,"
+          "\"pwm_writes\":%lu,"
+          "\"pwm_skipped\":%lu,"
+          "\"pwm_errors\":%lu,"
+          "\"pwm_faults\":%lu"
+        "},"
+        "\"estop\":{"
+          "\"count\":%lu,"
+          "\"last_latency_us\":%lu,"
+          "\"max_latency_us\":%lu"
+        "},"
+        "\"current\":{"
+          "\"enabled\":%s,"
+          "\"left_a\":%.2f,"
+          "\"right_a\":%.2f,"
+          "\"left_peak_a\":%.2f,"
+          "\"right_peak_a\":%.2f,"
+          "\"rate_hz\":%lu,"
+          "\"overflows\":%lu,"
+          "\"trips\":%lu,"
+          "\"last_trip\":\"%s\","
+          "\"last_trip_track\":\"%s\""
+        "},"
+        "\"speed_ctrl\":{"
+          "\"mode\":\"%s\","
+          "\"feedback\":\"%s\","
+          "\"read_errors\":%lu,"
+          "\"saturated\":%lu,"
+          "\"left\":{\"target\":%.3f,\"measured\":%.3f,\"output\":%.3f},"
+          "\"right\":{\"target\":%.3f,\"measured\":%.3f,\"output\":%.3f}"
+        "},"
+        "\"thermal\":{"
+          "\"enabled\":%s,"
+          "\"state\":\"%s\","
+          "\"scale\":%.2f,"
+          "\"source\":\"%s\","
+          "\"left\":{\"motor\":%.2f,\"bridge\":%.2f},"
+          "\"right\":{\"motor\":%.2f,\"bridge\":%.2f},"
+          "\"warnings\":%lu,"
+          "\"cutoffs\":%lu"
+        "},"
+        "\"battery\":{"
+          "\"enabled\":%s,"
+          "\"present\":%s,"
+          "\"state\":\"%s\","
+          "\"source\":\"%s\","
+          "\"current_source\":\"%s\","
+          "\"voltage\":%.2f,"
+          "\"ocv\":%.2f,"
+          "\"min_voltage\":%.2f,"
+          "\"current_a\":%.1f,"
+          "\"resistance_mohm\":%.0f,"
+          "\"soc_pct\":%.0f,"
+          "\"limit_a\":%.1f,"
+          "\"scale\":%.2f,"
+          "\"limits\":%lu,"
+          "\"read_errors\":%lu"
+        "},"
+        "\"serial\":{"
+          "\"json_lines\":%lu,"
+          "\"binary_frames\":%lu,"
+          "\"crc_errors\":%lu,"
+          "\"bad_frames\":%lu,"
+          "\"overflows\":%lu,"
+          "\"seq_gaps\":%lu"
+        "},"
         "\"wifi\":{"
           "\"ap\":%s,"
           "\"sta_connected\":%s,"
@@ -421,15 +578,56 @@ static esp_err_t status_get_handler(httpd_req_t *req) {
           "\"setup_ip\":\"192.168.4.1\""
         "}"
         "}",
-        state_name(st),
+        safety_state_name(st),
         (st == SAFETY_STATE_ARMED) ? "true" : "false",
         source_name(cs.source),
+        control_arbiter_policy_name(cs.policy),
+        cs.lease,
+        sources_json,
         cs.frame.throttle,
         cs.frame.steering,
         cs.frame.slow_mode ? "true" : "false",
         cs.frame.estop     ? "true" : "false",
         cs.frame.arm       ? "true" : "false",
         lt, rt, la, ra,
+        ls.rate_hz, ls.cycles, ls.period_target_us, ls.period_min_us, ls.period_avg_us,
+        ls.period_max_us, ls.exec_max_us, ls.overruns, ls.missed_ticks,
+        ls.jitter_hist[0], ls.jitter_hist[1], ls.jitter_hist[2], ls.jitter_hist[3],
+        ls.jitter_hist[4], ls.jitter_hist[5], ls.jitter_hist[6], ls.jitter_hist[7],
+        stages_json,
+#ifdef CONFIG_ROBOT_CONTROL_PIPELINE_SINGLE_STAGE
+        1,
+#else
+        2,
+#endif
+        ps.last_us, ps.avg_us, ps.max_us,
+        pw.writes, pw.skipped, pw.errors, pw.faults,
+        es.count, es.last_latency_us, es.max_latency_us,
+        cur.rate_hz ? "true" : "false",
+        cur.left_a, cur.right_a, cur.left_peak_a, cur.right_peak_a,
+        cur.rate_hz, cur.overflows, cur.trips,
+        current_sense_trip_name(cur.last_trip),
+        cur.last_trip_track < 0 ? "none" : (cur.last_trip_track ? "right" : "left"),
+        sc.closed_loop ? "closed" : "open",
+        sc.feedback ? sc.feedback : "none",
+        sc.read_errors, sc.saturated,
+        sc.left.target, sc.left.measured, sc.left.output,
+        sc.right.target, sc.right.measured, sc.right.output,
+        th.enabled ? "true" : "false",
+        thermal_state_name(th.state), th.scale,
+        th.source ? th.source : "duty",
+        th.left.motor, th.left.bridge, th.right.motor, th.right.bridge,
+        th.warnings, th.cutoffs,
+        bat.enabled ? "true" : "false",
+        bat.present ? "true" : "false",
+        battery_state_name(bat.state),
+        bat.source ? bat.source : "none",
+        bat.measured ? "measured" : "duty",
+        bat.volts, bat.ocv, bat.min_volts, bat.amps,
+        bat.r_ohm * 1000.0f, bat.soc * 100.0f, bat.limit_a, bat.scale,
+        bat.limits, bat.errors,
+        ser.json_lines, ser.drive_frames, ser.crc_errors, ser.bad_frames,
+        ser.overflows, ser.seq_gaps,
         ap_started     ? "true" : "false",
         sta_connected  ? "true" : "false",
         sta_connecting ? "true" : "false",
@@ -468,16 +666,18 @@ static esp_err_t robot_cfg_write_int(const char *key, int val) {
 // ---------------------------------------------------------------------------
 
 static esp_err_t config_get_handler(httpd_req_t *req) {
-    int dz  = robot_cfg_read_int("deadzone",   CONFIG_ROBOT_DRIVE_DEADZONE);
-    int ex  = robot_cfg_read_int("expo",        CONFIG_ROBOT_DRIVE_EXPO);
-    int ms  = robot_cfg_read_int("max_speed",  CONFIG_ROBOT_DRIVE_MAX_SPEED);
-    int sf  = robot_cfg_read_int("slow_factor", CONFIG_ROBOT_DRIVE_SLOW_MODE_FACTOR);
+    drive_config_t drive;
+    drive_config_get(&drive);
+    int hz  = robot_cfg_read_int("loop_hz",    CONFIG_ROBOT_CONTROL_LOOP_HZ);
 
-    char buf[256];
+    char buf[384];
     snprintf(buf, sizeof(buf),
         "{\"deadzone\":%d,\"expo\":%d,\"max_speed\":%d,\"slow_factor\":%d,"
-        "\"note\":\"POST /config with same fields to update. Reboot to apply.\"}",
-        dz, ex, ms, sf);
+        "\"desat\":\"%s\",\"turn\":\"%s\",\"pivot\":%d,\"loop_hz\":%d,"
+        "\"note\":\"POST /config with same fields to update. Drive fields apply live; loop_hz after reboot.\"}",
+        drive.deadzone, drive.expo, drive.max_speed, drive.slow_factor,
+        mixer_diffdrive_desat_name((mixer_desat_t)drive.desat),
+        mixer_diffdrive_turn_name((mixer_turn_t)drive.turn), drive.pivot, hz);
 
     httpd_resp_set_type(req, "application/json");
     httpd_resp_sendstr(req, buf);
@@ -485,7 +685,8 @@ static esp_err_t config_get_handler(httpd_req_t *req) {
 }
 
 // ---------------------------------------------------------------------------
-//  POST /config  {"deadzone":5,"expo":30,"max_speed":100,"slow_factor":50}
+//  POST /config  {"deadzone":5,"expo":30,"max_speed":100,"slow_factor":50,
+//                 "desat":"normalize","turn":"curvature","pivot":15,"loop_hz":50}
 // ---------------------------------------------------------------------------
 
 static esp_err_t config_post_handler(httpd_req_t *req) {
@@ -500,29 +701,34 @@ static esp_err_t config_post_handler(httpd_req_t *req) {
         return ESP_FAIL;
     }
 
-    cJSON *item;
-    if ((item = cJSON_GetObjectItem(root, "deadzone")) && cJSON_IsNumber(item)) {
-        int v = item->valueint;
-        if (v >= 0 && v <= 20) robot_cfg_write_int("deadzone", v);
-    }
-    if ((item = cJSON_GetObjectItem(root, "expo")) && cJSON_IsNumber(item)) {
-        int v = item->valueint;
-        if (v >= 0 && v <= 100) robot_cfg_write_int("expo", v);
-    }
-    if ((item = cJSON_GetObjectItem(root, "max_speed")) && cJSON_IsNumber(item)) {
-        int v = item->valueint;
-        if (v >= 10 && v <= 100) robot_cfg_write_int("max_speed", v);
+    // Drive fields: applied live, persisted in the background
+    esp_err_t drive_ret = drive_config_apply_json(root);
+    if (drive_ret == ESP_ERR_INVALID_ARG) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Drive config value out of range");
+        return ESP_FAIL;
     }
-    if ((item = cJSON_GetObjectItem(root, "slow_factor")) && cJSON_IsNumber(item)) {
+
+    bool loop_hz_saved = false;
+    cJSON *item;
+    if ((item = cJSON_GetObjectItem(root, "loop_hz")) && cJSON_IsNumber(item)) {
         int v = item->valueint;
-        if (v >= 10 && v <= 100) robot_cfg_write_int("slow_factor", v);
+        if (v >= CONTROL_LOOP_RATE_MIN_HZ && v <= CONTROL_LOOP_RATE_MAX_HZ &&
+            v != robot_cfg_read_int("loop_hz", CONFIG_ROBOT_CONTROL_LOOP_HZ)) {
+            loop_hz_saved = (robot_cfg_write_int("loop_hz", v) == ESP_OK);
+        }
     }
 
     cJSON_Delete(root);
 
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req,
-        "{\"status\":\"saved\",\"message\":\"Config saved to NVS. Reboot to apply.\"}");
+    if (loop_hz_saved) {
+        httpd_resp_sendstr(req,
+            "{\"status\":\"applied\",\"message\":\"Drive config applied. Loop rate saved; reboot to apply.\"}");
+    } else {
+        httpd_resp_sendstr(req,
+            "{\"status\":\"applied\",\"message\":\"Drive config applied.\"}");
+    }
     return ESP_OK;
 }
 
@@ -554,7 +760,7 @@ static esp_err_t index_get_handler(httpd_req_t *req) {
         ".card{background:#1e293b;border-radius:10px;padding:16px;margin-bottom:16px;border:1px solid #334155}"
         ".card h2{font-size:1em;color:#94a3b8;margin-bottom:14px;text-transform:uppercase;letter-spacing:.05em}"
         "label{display:block;font-size:0.9em;color:#94a3b8;margin-bottom:4px;margin-top:10px}"
-        "input[type=text],input[type=password],input[type=number]"
+        "input[type=text],input[type=password],input[type=number],select"
         "{width:100%;padding:10px;background:#0f172a;border:1px solid #475569;"
         "border-radius:6px;color:#e2e8f0;font-size:0.95em}"
         "input[type=range]{width:100%;accent-color:#38bdf8}"
@@ -686,7 +892,7 @@ static esp_err_t index_get_handler(httpd_req_t *req) {
         "<div class='card'>"
         "<h2>Drive parameters</h2>"
         "<p style='font-size:.9em;color:#94a3b8'>Saved to NVS. "
-        "Reboot the ESP32 to apply changes.</p>"
+        "Drive settings apply immediately; loop rate needs a reboot.</p>"
         "<label>Deadzone (0&ndash;20 %)"
         "<span class='val' id='dz-val'></span></label>"
         "<input type='number' id='cfg-deadzone' min='0' max='20' value='5'>"
@@ -699,6 +905,23 @@ static esp_err_t index_get_handler(httpd_req_t *req) {
         "<label>Slow-mode factor (10&ndash;100 %)"
         "<span class='val' id='sf-val'></span></label>"
         "<input type='number' id='cfg-slowfactor' min='10' max='100' value='50'>"
+        "<label>Track saturation</label>"
+        "<select id='cfg-desat'>"
+        "<option value='clamp'>Clamp each track</option>"
+        "<option value='normalize'>Normalize (keep turn ratio)</option>"
+        "<option value='steer_priority'>Steering priority</option>"
+        "</select>"
+        "<label>Steering model</label>"
+        "<select id='cfg-turn'>"
+        "<option value='arcade'>Arcade</option>"
+        "<option value='curvature'>Curvature with pivot</option>"
+        "</select>"
+        "<label>Pivot band (0&ndash;50 % throttle)"
+        "<span class='val' id='pv-val'></span></label>"
+        "<input type='number' id='cfg-pivot' min='0' max='50' value='15'>"
+        "<label>Control loop rate (10&ndash;1000 Hz)"
+        "<span class='val' id='hz-val'></span></label>"
+        "<input type='number' id='cfg-loophz' min='10' max='1000' value='50'>"
         "<div class='row' style='margin-top:14px'>"
         "<button class='btn-primary' onclick='saveConfig()'>Save config</button>"
         "<button class='btn-neutral' onclick='loadConfig()'>Reload</button>"
@@ -842,6 +1065,10 @@ static esp_err_t index_get_handler(httpd_req_t *req) {
         "document.getElementById('cfg-expo').value=d.expo;"
         "document.getElementById('cfg-maxspeed').value=d.max_speed;"
         "document.getElementById('cfg-slowfactor').value=d.slow_factor;"
+        "document.getElementById('cfg-desat').value=d.desat;"
+        "document.getElementById('cfg-turn').value=d.turn;"
+        "document.getElementById('cfg-pivot').value=d.pivot;"
+        "document.getElementById('cfg-loophz').value=d.loop_hz;"
         "}catch(e){msg('cfg-msg','Error loading config','msg-err');}}"
 
         "async function saveConfig(){"
@@ -849,7 +1076,11 @@ static esp_err_t index_get_handler(httpd_req_t *req) {
         "deadzone:parseInt(document.getElementById('cfg-deadzone').value),"
         "expo:parseInt(document.getElementById('cfg-expo').value),"
         "max_speed:parseInt(document.getElementById('cfg-maxspeed').value),"
-        "slow_factor:parseInt(document.getElementById('cfg-slowfactor').value)"
+        "slow_factor:parseInt(document.getElementById('cfg-slowfactor').value),"
+        "desat:document.getElementById('cfg-desat').value,"
+        "turn:document.getElementById('cfg-turn').value,"
+        "pivot:parseInt(document.getElementById('cfg-pivot').value),"
+        "loop_hz:parseInt(document.getElementById('cfg-loophz').value)"
         "};"
         "try{"
         "var r=await fetch('/config',{method:'POST',"
@@ -947,6 +1178,180 @@ static esp_err_t index_get_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+// ---------------------------------------------------------------------------
+//  POST /handover  {"to":"PS4","lease":12}
+// ---------------------------------------------------------------------------
+
+static esp_err_t handover_post_handler(httpd_req_t *req) {
+    char buf[128];
+    int len = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (len <= 0) { httpd_resp_send_500(req); return ESP_FAIL; }
+    buf[len] = '\0';
+
+    cJSON *root = cJSON_Parse(buf);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    cJSON *to    = cJSON_GetObjectItem(root, "to");
+    cJSON *lease = cJSON_GetObjectItem(root, "lease");
+    if (!cJSON_IsString(to) || !cJSON_IsNumber(lease)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Need \"to\" and \"lease\"");
+        return ESP_FAIL;
+    }
+
+    control_source_t target;
+    if (!control_arbiter_target_from_name(to->valuestring, &target)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "Unknown \"to\" (PS4, SERIAL, HTTP or none)");
+        return ESP_FAIL;
+    }
+    uint32_t lease_num;
+    if (!control_arbiter_lease_from_number(lease->valuedouble, &lease_num)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "\"lease\" must be a whole number >= 0");
+        return ESP_FAIL;
+    }
+    control_manager_handover(target, lease_num);
+    cJSON_Delete(root);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, "{\"status\":\"queued\",\"message\":\"Check /status lease to confirm\"}");
+    return ESP_OK;
+}
+
+static esp_err_t loop_stats_reset_post_handler(httpd_req_t *req) {
+    control_manager_reset_loop_stats();
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, "{\"status\":\"ok\"}");
+    return ESP_OK;
+}
+
+// ---------------------------------------------------------------------------
+//  GET /latency   POST /latency/reset
+// ---------------------------------------------------------------------------
+
+static esp_err_t latency_get_handler(httpd_req_t *req) {
+    char buf[1024];
+    int n = snprintf(buf, sizeof(buf), "{\"unit\":\"us\"");
+    for (int s = CONTROL_SOURCE_PS4; s <= CONTROL_SOURCE_HTTP && n < (int)sizeof(buf); s++) {
+        n += snprintf(buf + n, sizeof(buf) - n, ",\"%s\":{", source_name((control_source_t)s));
+        for (int st = 0; st < LATENCY_STAGE_COUNT && n < (int)sizeof(buf); st++) {
+            latency_summary_t sum;
+            latency_trace_get((control_source_t)s, (latency_stage_t)st, &sum);
+            n += snprintf(buf + n, sizeof(buf) - n,
+                "%s\"%s\":{\"count\":%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}",
+                st ? "," : "", latency_trace_stage_name((latency_stage_t)st),
+                sum.count, sum.p50_us, sum.p99_us, sum.max_us);
+        }
+        if (n < (int)sizeof(buf)) n += snprintf(buf + n, sizeof(buf) - n, "}");
+    }
+    if (n < (int)sizeof(buf)) snprintf(buf + n, sizeof(buf) - n, "}");
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, buf);
+    return ESP_OK;
+}
+
+//  GET /safety  — state, failsafe reaction times and the transition journal
+static esp_err_t safety_get_handler(httpd_req_t *req) {
+    safety_transition_t journal[SAFETY_JOURNAL_LEN];
+    size_t count = safety_get_journal(journal, SAFETY_JOURNAL_LEN);
+    safety_journal_stats_t js;
+    safety_get_journal_stats(&js);
+    safety_failsafe_stats_t fs;
+    safety_get_failsafe_stats(&fs);
+    event_log_stats_t ls;
+    event_log_get_stats(&ls);
+
+    // Streamed in chunks of up to buf: the failsafe and log blocks (~450
+    // bytes at worst) first, then the journal entries (~150 bytes each)
+    char buf[768];
+    int n = snprintf(buf, sizeof(buf),
+        "{\"state\":\"%s\","
+        "\"failsafe\":{\"timeout_ms\":%lu,\"hw_deadline\":%s,\"outputs_enabled\":%s,"
+          "\"hw_trips\":%lu,\"hw_last_us\":%lu,\"hw_max_us\":%lu,"
+          "\"sw_trips\":%lu,\"sw_last_us\":%lu,\"sw_max_us\":%lu,"
+          "\"twdt_trips\":%lu},"
+        "\"eventlog\":{\"boot\":%u,\"capacity\":%lu,\"appended\":%lu,\"flushed\":%lu,"
+          "\"dropped\":%lu,\"recovered\":%lu,\"errors\":%lu},"
+        "\"transitions\":%lu,\"journal_waits\":%lu,\"journal_skips\":%lu,\"journal\":[",
+        safety_state_name(safety_get_state()),
+        fs.timeout_ms, fs.hw_deadline ? "true" : "false", fs.outputs_enabled ? "true" : "false",
+        fs.hw_trips, fs.hw_last_us, fs.hw_max_us,
+        fs.sw_trips, fs.sw_last_us, fs.sw_max_us, fs.twdt_trips,
+        ls.boot, ls.capacity, ls.appended, ls.flushed, ls.dropped, ls.recovered, ls.errors,
+        js.transitions, js.waits, js.skips);
+    if (n < 0 || n >= (int)sizeof(buf)) {
+        ESP_LOGE(TAG, "/safety: status block does not fit (%d bytes)", n);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Response too long");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i < count && err == ESP_OK; i++) {
+        const safety_transition_t *t = &journal[i];
+        char entry[192];
+        int m = snprintf(entry, sizeof(entry),
+            "%s{\"seq\":%lu,\"time_us\":%lld,\"from\":\"%s\",\"to\":\"%s\","
+            "\"cause\":\"%s\",\"origin\":\"%s\"}",
+            i ? "," : "", t->seq, t->time_us, safety_state_name(t->from),
+            safety_state_name(t->to), safety_cause_name(t->cause),
+            safety_origin_name(t->origin));
+        if (m < 0 || m >= (int)sizeof(entry)) {
+            err = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        if (n + m > (int)sizeof(buf)) {
+            err = httpd_resp_send_chunk(req, buf, n);
+            n = 0;
+        }
+        memcpy(buf + n, entry, m);
+        n += m;
+    }
+    if (err == ESP_OK) err = httpd_resp_send_chunk(req, buf, n);
+    if (err == ESP_OK) err = httpd_resp_sendstr_chunk(req, "]}");
+    if (err == ESP_OK) err = httpd_resp_send_chunk(req, NULL, 0);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "/safety: response failed: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t eventlog_send_chunk(const void *data, size_t len, void *ctx) {
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, (const char *)data, (ssize_t)len);
+}
+
+//  GET /eventlog  — header + records oldest first, streamed straight from flash
+static esp_err_t eventlog_get_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"eventlog.bin\"");
+    esp_err_t err = event_log_export(eventlog_send_chunk, req);
+    if (err == ESP_ERR_INVALID_STATE) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Event log not available");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Event log export failed: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+static esp_err_t latency_reset_post_handler(httpd_req_t *req) {
+    latency_trace_reset();
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, "{\"status\":\"ok\"}");
+    return ESP_OK;
+}
+
 static esp_err_t reboot_post_handler(httpd_req_t *req) {
     httpd_resp_set_type(req, "application/json");
     httpd_resp_sendstr(req, "{\"status\":\"rebooting\"}");
@@ -957,7 +1362,9 @@ static esp_err_t reboot_post_handler(httpd_req_t *req) {
 
 static esp_err_t start_webserver(void) {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 13;
+    config.max_uri_handlers = 18;
+    config.stack_size = 8192;  // /status builds a ~3.5 KB JSON body on the stack
+    config.core_id = HTTP_TASK_CORE;
 
     if (server) return ESP_OK;
 
@@ -976,13 +1383,19 @@ static esp_err_t start_webserver(void) {
         {.uri = "/config",      .method = HTTP_GET,  .handler = config_get_handler},
         {.uri = "/config",      .method = HTTP_POST, .handler = config_post_handler},
         {.uri = "/reboot",      .method = HTTP_POST, .handler = reboot_post_handler},
+        {.uri = "/loop-stats/reset", .method = HTTP_POST, .handler = loop_stats_reset_post_handler},
+        {.uri = "/handover",    .method = HTTP_POST, .handler = handover_post_handler},
+        {.uri = "/latency",     .method = HTTP_GET,  .handler = latency_get_handler},
+        {.uri = "/latency/reset", .method = HTTP_POST, .handler = latency_reset_post_handler},
+        {.uri = "/safety",      .method = HTTP_GET,  .handler = safety_get_handler},
+        {.uri = "/eventlog",    .method = HTTP_GET,  .handler = eventlog_get_handler},
         {.uri = "/",            .method = HTTP_GET,  .handler = index_get_handler},
     };
     for (size_t i = 0; i < sizeof(uris) / sizeof(uris[0]); i++) {
         httpd_register_uri_handler(server, &uris[i]);
     }
 
-    ESP_LOGI(TAG, "HTTP server started — 10 endpoints registered");
+    ESP_LOGI(TAG, "HTTP server started — 16 endpoints registered");
     ESP_LOGI(TAG, "Control UI: http://192.168.4.1/ (connect to TrackRobot-Setup AP first)");
     return ESP_OK;
 }
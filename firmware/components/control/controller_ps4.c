@@ -15,6 +15,7 @@
 #include "control_frame.h"
 #include "ps4.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -22,7 +23,7 @@ static const char *TAG = "ctrl_ps4";
 
 static void ps4_input_cb(const ps4_gamepad_t *g) {
     control_frame_t frame = {0};
-    frame.timestamp = xTaskGetTickCount();
+    frame.timestamp_us = esp_timer_get_time();
 
     if (!g->connected) {
         // Submit zero frame on disconnect so motors stop immediately.
@@ -6,12 +6,20 @@
  * Example: {"throttle": 0.5, "steering": -0.2}
  * Example: {"estop": true}
  * Example: {"arm": true}
+ * Example: {"config": {"expo": 40, "max_speed": 80}}
+ *
+ * Binary drive frames (COBS + CRC-16, serial_codec.h) are accepted on the
+ * same stream and told apart per frame; they skip the JSON parse and its
+ * heap allocations. Configuration stays JSON-only.
  */
 
 #include "controller_serial.h"
 #include "control_manager.h"
 #include "control_frame.h"
+#include "drive_config.h"
+#include "serial_codec.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/uart.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -24,6 +32,15 @@ static const char *TAG = "ctrl_serial";
 #define UART_BUF_SIZE 256
 #define SERIAL_TASK_STACK_SIZE 4096
 #define SERIAL_TASK_PRIORITY 4
+#ifdef CONFIG_ROBOT_TASK_PINNING
+#define SERIAL_TASK_CORE CONFIG_ROBOT_CORE_INPUT
+#else
+#define SERIAL_TASK_CORE tskNO_AFFINITY
+#endif
+
+static serial_rx_t rx;      // serial task only
+static serial_rx_stats_t stats;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
 
 /**
  * @brief Parse JSON control command
@@ -35,8 +52,19 @@ static esp_err_t parse_command(const char *json_str) {
         return ESP_FAIL;
     }
     
+    // Live drive configuration: not a control frame
+    cJSON *config = cJSON_GetObjectItem(root, "config");
+    if (config && cJSON_IsObject(config)) {
+        esp_err_t ret = drive_config_apply_json(config);
+        cJSON_Delete(root);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Config rejected: %s", esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
     control_frame_t frame = {0};
-    frame.timestamp = xTaskGetTickCount();
+    frame.timestamp_us = esp_timer_get_time();
     
     // Parse fields
     cJSON *throttle = cJSON_GetObjectItem(root, "throttle");
@@ -75,31 +103,71 @@ static esp_err_t parse_command(const char *json_str) {
     return ESP_OK;
 }
 
+/**
+ * @brief Submit a binary drive frame
+ */
+static void submit_drive(const serial_drive_t *drive, int64_t rx_us) {
+    control_frame_t frame = {
+        .throttle     = serial_axis_to_float(drive->throttle),
+        .steering     = serial_axis_to_float(drive->steering),
+        .estop        = (drive->flags & SERIAL_FLAG_ESTOP) != 0,
+        .arm          = (drive->flags & SERIAL_FLAG_ARM) != 0,
+        .slow_mode    = (drive->flags & SERIAL_FLAG_SLOW) != 0,
+        .timestamp_us = rx_us,
+    };
+    control_manager_submit(CONTROL_SOURCE_SERIAL, &frame);
+
+    ESP_LOGD(TAG, "Serial frame %u: t=%.2f s=%.2f flags=0x%02x",
+             drive->seq, frame.throttle, frame.steering, drive->flags);
+}
+
 /**
  * @brief Serial task
  */
 static void serial_task(void *arg) {
     uint8_t data[UART_BUF_SIZE];
-    char line_buf[UART_BUF_SIZE];
-    int line_pos = 0;
     
     while (1) {
-        int len = uart_read_bytes(UART_NUM, data, sizeof(data), pdMS_TO_TICKS(100));
-        if (len > 0) {
-            for (int i = 0; i < len; i++) {
-                char c = (char)data[i];
-                
-                if (c == '\n' || c == '\r') {
-                    if (line_pos > 0) {
-                        line_buf[line_pos] = '\0';
-                        parse_command(line_buf);
-                        line_pos = 0;
-                    }
-                } else if (line_pos < sizeof(line_buf) - 1) {
-                    line_buf[line_pos++] = c;
-                }
+        // Wake on the first byte, then take whatever else has arrived, so a
+        // frame is handled as soon as it is complete rather than when the
+        // buffer fills
+        int len = uart_read_bytes(UART_NUM, data, 1, pdMS_TO_TICKS(100));
+        if (len <= 0) {
+            continue;
+        }
+        size_t more = 0;
+        uart_get_buffered_data_len(UART_NUM, &more);
+        if (more > sizeof(data) - 1) more = sizeof(data) - 1;
+        if (more > 0) {
+            int got = uart_read_bytes(UART_NUM, data + 1, more, 0);
+            if (got > 0) len += got;
+        }
+        int64_t rx_us = esp_timer_get_time();
+        bool completed = false;
+        for (int i = 0; i < len; i++) {
+            serial_drive_t drive;
+            const char *line;
+            switch (serial_rx_push(&rx, data[i], &drive, &line)) {
+                case SERIAL_RX_JSON:
+                    parse_command(line);
+                    completed = true;
+                    break;
+                case SERIAL_RX_DRIVE:
+                    submit_drive(&drive, rx_us);
+                    completed = true;
+                    break;
+                case SERIAL_RX_ERROR:
+                    completed = true;
+                    break;
+                default:
+                    break;
             }
         }
+        if (completed) {
+            portENTER_CRITICAL(&stats_lock);
+            stats = rx.stats;
+            portEXIT_CRITICAL(&stats_lock);
+        }
     }
 }
 
@@ -117,16 +185,24 @@ esp_err_t controller_serial_init(void) {
     ESP_ERROR_CHECK(uart_driver_install(UART_NUM, UART_BUF_SIZE * 2, 0, 0, NULL, 0));
     
     // Start serial task
-    BaseType_t ret = xTaskCreate(serial_task, "serial_task",
-                                  SERIAL_TASK_STACK_SIZE, NULL,
-                                  SERIAL_TASK_PRIORITY, NULL);
+    BaseType_t ret = xTaskCreatePinnedToCore(serial_task, "serial_task",
+                                             SERIAL_TASK_STACK_SIZE, NULL,
+                                             SERIAL_TASK_PRIORITY, NULL,
+                                             SERIAL_TASK_CORE);
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create serial task");
         return ESP_FAIL;
     }
     
     ESP_LOGI(TAG, "Serial controller initialized (baud: %d)", CONFIG_ROBOT_SERIAL_BAUD);
-    ESP_LOGI(TAG, "  Protocol: JSON lines (e.g., {\"throttle\": 0.5, \"steering\": 0.0})");
+    ESP_LOGI(TAG, "  Protocol: JSON lines (e.g., {\"throttle\": 0.5, \"steering\": 0.0})"
+             " or COBS binary frames");
     
     return ESP_OK;
 }
+
+void controller_serial_get_stats(serial_rx_stats_t *out) {
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
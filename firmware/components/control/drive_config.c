@@ -0,0 +1,268 @@
+/**
+ * @file drive_config.c
+ * @brief Live drive configuration with batched background persistence
+ */
+
+#include "drive_config.h"
+#include "mixer_diffdrive.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "drive_cfg";
+
+#define ROBOT_CFG_NVS_NS        "robot_cfg"
+#define PERSIST_TASK_STACK_SIZE 3072
+#define PERSIST_TASK_PRIORITY   1
+#ifdef CONFIG_ROBOT_TASK_PINNING
+#define PERSIST_TASK_CORE       CONFIG_ROBOT_CORE_INPUT
+#else
+#define PERSIST_TASK_CORE       tskNO_AFFINITY
+#endif
+
+#if defined(CONFIG_ROBOT_DRIVE_DESAT_NORMALIZE)
+#define DEFAULT_DESAT MIXER_DESAT_NORMALIZE
+#elif defined(CONFIG_ROBOT_DRIVE_DESAT_STEER_PRIORITY)
+#define DEFAULT_DESAT MIXER_DESAT_STEER_PRIORITY
+#else
+#define DEFAULT_DESAT MIXER_DESAT_CLAMP
+#endif
+#ifdef CONFIG_ROBOT_DRIVE_TURN_CURVATURE
+#define DEFAULT_TURN  MIXER_TURN_CURVATURE
+#else
+#define DEFAULT_TURN  MIXER_TURN_ARCADE
+#endif
+
+static const drive_config_t kconfig_defaults = {
+    .deadzone    = CONFIG_ROBOT_DRIVE_DEADZONE,
+    .expo        = CONFIG_ROBOT_DRIVE_EXPO,
+    .max_speed   = CONFIG_ROBOT_DRIVE_MAX_SPEED,
+    .slow_factor = CONFIG_ROBOT_DRIVE_SLOW_MODE_FACTOR,
+    .desat       = DEFAULT_DESAT,
+    .turn        = DEFAULT_TURN,
+    .pivot       = CONFIG_ROBOT_DRIVE_PIVOT_THROTTLE,
+};
+
+static SemaphoreHandle_t cfg_lock;     // guards current/persisted, orders appliers
+static drive_config_t current;         // applied to the mixer
+static drive_config_t persisted;       // last state written to (or read from) NVS
+static TaskHandle_t persist_task_handle;
+
+static const char *desat_name(int v) { return mixer_diffdrive_desat_name((mixer_desat_t)v); }
+static const char *turn_name(int v)  { return mixer_diffdrive_turn_name((mixer_turn_t)v); }
+
+// JSON field == NVS key
+static const struct {
+    const char *key;
+    size_t      offset;
+    int         min;
+    int         max;
+    const char *(*name)(int);  // enum fields: also accept the mode name
+} fields[] = {
+    {"deadzone",    offsetof(drive_config_t, deadzone),    0,  20,  NULL},
+    {"expo",        offsetof(drive_config_t, expo),        0,  100, NULL},
+    {"max_speed",   offsetof(drive_config_t, max_speed),   10, 100, NULL},
+    {"slow_factor", offsetof(drive_config_t, slow_factor), 10, 100, NULL},
+    {"desat",       offsetof(drive_config_t, desat),       0,  MIXER_DESAT_COUNT - 1, desat_name},
+    {"turn",        offsetof(drive_config_t, turn),        0,  MIXER_TURN_COUNT - 1,  turn_name},
+    {"pivot",       offsetof(drive_config_t, pivot),       0,  50,  NULL},
+};
+#define NUM_FIELDS (sizeof(fields) / sizeof(fields[0]))
+
+static inline int *field_ptr(drive_config_t *cfg, size_t i) {
+    return (int *)((char *)cfg + fields[i].offset);
+}
+
+static bool config_valid(const drive_config_t *cfg) {
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        int v = *field_ptr((drive_config_t *)cfg, i);
+        if (v < fields[i].min || v > fields[i].max) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static mixer_config_t to_mixer_config(const drive_config_t *cfg) {
+    return (mixer_config_t){
+        .deadzone         = cfg->deadzone    / 100.0f,
+        .expo             = cfg->expo        / 100.0f,
+        .max_speed        = cfg->max_speed   / 100.0f,
+        .slow_mode_factor = cfg->slow_factor / 100.0f,
+        .desat            = (mixer_desat_t)cfg->desat,
+        .turn             = (mixer_turn_t)cfg->turn,
+        .pivot_throttle   = cfg->pivot       / 100.0f,
+    };
+}
+
+/**
+ * @brief Write the keys that differ from the last persisted state, one commit
+ */
+static void persist_changes(void) {
+    xSemaphoreTake(cfg_lock, portMAX_DELAY);
+    drive_config_t want = current;
+    drive_config_t have = persisted;
+    xSemaphoreGive(cfg_lock);
+
+    nvs_handle_t h;
+    esp_err_t ret = nvs_open(ROBOT_CFG_NVS_NS, NVS_READWRITE, &h);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS open failed: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    int written = 0;
+    for (size_t i = 0; i < NUM_FIELDS && ret == ESP_OK; i++) {
+        int v = *field_ptr(&want, i);
+        if (v != *field_ptr(&have, i)) {
+            ret = nvs_set_i32(h, fields[i].key, (int32_t)v);
+            written++;
+        }
+    }
+    if (ret == ESP_OK && written > 0) {
+        ret = nvs_commit(h);
+    }
+    nvs_close(h);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS write failed: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    xSemaphoreTake(cfg_lock, portMAX_DELAY);
+    persisted = want;
+    xSemaphoreGive(cfg_lock);
+    if (written > 0) {
+        ESP_LOGI(TAG, "Persisted %d key(s) to NVS", written);
+    }
+}
+
+/**
+ * @brief Persistence task
+ *
+ * Sleeps until notified, then keeps extending the delay while further
+ * changes arrive, so a burst of updates costs one flash commit.
+ */
+static void persist_task(void *arg) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DRIVE_CONFIG_PERSIST_DELAY_MS)) != 0) {
+        }
+        persist_changes();
+    }
+}
+
+static int nvs_read_int(nvs_handle_t h, const char *key, int def) {
+    int32_t v;
+    return (nvs_get_i32(h, key, &v) == ESP_OK) ? (int)v : def;
+}
+
+esp_err_t drive_config_init(void) {
+    cfg_lock = xSemaphoreCreateMutex();
+    if (cfg_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    current = kconfig_defaults;
+    nvs_handle_t h;
+    if (nvs_open(ROBOT_CFG_NVS_NS, NVS_READONLY, &h) == ESP_OK) {
+        for (size_t i = 0; i < NUM_FIELDS; i++) {
+            int *v = field_ptr(&current, i);
+            *v = nvs_read_int(h, fields[i].key, *v);
+        }
+        nvs_close(h);
+    }
+    if (!config_valid(&current)) {
+        ESP_LOGW(TAG, "Stored drive config out of range, using Kconfig defaults");
+        current = kconfig_defaults;
+    }
+    persisted = current;
+
+    ESP_LOGI(TAG, "Drive config: deadzone=%d%% expo=%d%% max_speed=%d%% slow=%d%% desat=%s turn=%s pivot=%d%%",
+             current.deadzone, current.expo, current.max_speed, current.slow_factor,
+             desat_name(current.desat), turn_name(current.turn), current.pivot);
+
+    mixer_config_t mixer_cfg = to_mixer_config(&current);
+    esp_err_t ret = mixer_diffdrive_init(&mixer_cfg);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    BaseType_t ok = xTaskCreatePinnedToCore(persist_task, "cfg_persist",
+                                            PERSIST_TASK_STACK_SIZE, NULL,
+                                            PERSIST_TASK_PRIORITY, &persist_task_handle,
+                                            PERSIST_TASK_CORE);
+    if (ok != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create persistence task");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+void drive_config_get(drive_config_t *out) {
+    xSemaphoreTake(cfg_lock, portMAX_DELAY);
+    *out = current;
+    xSemaphoreGive(cfg_lock);
+}
+
+/**
+ * @brief Swap @p config into the mixer; caller holds cfg_lock
+ */
+static esp_err_t apply_locked(const drive_config_t *config) {
+    if (!config_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mixer_config_t mixer_cfg = to_mixer_config(config);
+    esp_err_t ret = mixer_diffdrive_set_config(&mixer_cfg);
+    if (ret == ESP_OK) {
+        current = *config;
+        xTaskNotifyGive(persist_task_handle);
+    }
+    return ret;
+}
+
+esp_err_t drive_config_apply(const drive_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(cfg_lock, portMAX_DELAY);
+    esp_err_t ret = apply_locked(config);
+    xSemaphoreGive(cfg_lock);
+    return ret;
+}
+
+esp_err_t drive_config_apply_json(const cJSON *obj) {
+    // Merge under the lock so a concurrent partial update is not lost
+    xSemaphoreTake(cfg_lock, portMAX_DELAY);
+    drive_config_t cfg = current;
+    int found = 0;
+    for (size_t i = 0; i < NUM_FIELDS; i++) {
+        const cJSON *item = cJSON_GetObjectItem(obj, fields[i].key);
+        if (item == NULL) {
+            continue;
+        }
+        if (cJSON_IsNumber(item)) {
+            *field_ptr(&cfg, i) = item->valueint;
+            found++;
+        } else if (cJSON_IsString(item) && fields[i].name != NULL) {
+            int v = fields[i].min - 1;  // out of range unless the name matches
+            for (int m = fields[i].min; m <= fields[i].max; m++) {
+                if (strcmp(item->valuestring, fields[i].name(m)) == 0) {
+                    v = m;
+                    break;
+                }
+            }
+            *field_ptr(&cfg, i) = v;
+            found++;
+        }
+    }
+    esp_err_t ret = (found > 0) ? apply_locked(&cfg) : ESP_ERR_NOT_FOUND;
+    xSemaphoreGive(cfg_lock);
+    return ret;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file control_arbiter.h
+ * @brief Multi-source arbitration engine
+ *
+ * Tracks per-source liveness, priority and frame rate, and decides which
+ * source owns the robot. Pure logic with no FreeRTOS dependency: the caller
+ * supplies a millisecond clock, so the engine can be driven from the control
+ * task or from a host-side simulation.
+ *
+ * Not thread-safe; one task owns an arbiter instance.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "control_frame.h"
+
+#define CONTROL_ARBITER_MAX_SOURCES 4  ///< Indexed by control_source_t
+
+/**
+ * @brief Ownership policy
+ */
+typedef enum {
+    CONTROL_POLICY_LAST_WINS       = 0, ///< Most recent live source owns control
+    CONTROL_POLICY_PRIORITY        = 1, ///< Higher-priority live source preempts the owner
+    CONTROL_POLICY_STICKY_LEASE    = 2, ///< Owner keeps control until its lease lapses or it hands over
+} control_policy_t;
+
+/**
+ * @brief Static per-source settings
+ */
+typedef struct {
+    uint8_t  priority;    ///< Higher wins under CONTROL_POLICY_PRIORITY
+    uint32_t timeout_ms;  ///< Source is dead this long after its last frame
+} control_arbiter_source_cfg_t;
+
+/**
+ * @brief Per-source runtime state
+ */
+typedef struct {
+    control_arbiter_source_cfg_t cfg;
+    bool     seen;          ///< At least one frame received
+    bool     alive;         ///< Last frame is within timeout_ms
+    uint32_t last_seen_ms;  ///< Clock value of the last frame
+    uint32_t last_order;    ///< Submit order of the last frame (newest wins)
+    uint32_t frames;        ///< Frames received since boot
+    uint32_t window_frames; ///< frames at the start of the rate window
+    uint32_t window_start_ms;
+    float    rate_hz;       ///< Frame rate over the last complete window
+} control_arbiter_source_t;
+
+/**
+ * @brief Arbiter instance
+ */
+typedef struct {
+    control_policy_t         policy;
+    control_source_t         owner;   ///< Current owner (CONTROL_SOURCE_NONE if none)
+    uint32_t                 lease;   ///< Incremented on every ownership change
+    control_arbiter_source_t src[CONTROL_ARBITER_MAX_SOURCES];
+} control_arbiter_t;
+
+/**
+ * @brief Reset an arbiter
+ *
+ * @param arb    Arbiter to initialise
+ * @param policy Ownership policy
+ * @param cfg    Per-source settings, indexed by control_source_t
+ *               (entry 0 / CONTROL_SOURCE_NONE is ignored)
+ */
+void control_arbiter_init(control_arbiter_t *arb, control_policy_t policy,
+                          const control_arbiter_source_cfg_t cfg[CONTROL_ARBITER_MAX_SOURCES]);
+
+/**
+ * @brief Record a frame from a source
+ *
+ * @param arb    Arbiter
+ * @param source Sending source
+ * @param order  Global submit order of the frame (wrap-safe, newer is larger)
+ * @param now_ms Clock value when the frame was submitted
+ * @param count  Frames received from this source since the last call (>= 1)
+ */
+void control_arbiter_on_frame(control_arbiter_t *arb, control_source_t source,
+                              uint32_t order, uint32_t now_ms, uint32_t count);
+
+/**
+ * @brief Expire dead sources and settle ownership — call once per control cycle
+ *
+ * Bounded work per call: one pass over the fixed source table for liveness
+ * and rates, and a second pass to pick a new owner only if the owner died.
+ *
+ * @return control_source_t Owner after this tick
+ */
+control_source_t control_arbiter_tick(control_arbiter_t *arb, uint32_t now_ms);
+
+/**
+ * @brief Explicitly hand control to another source
+ *
+ * @param lease Lease the caller believes is current; stale leases are refused
+ * @param to    New owner, or CONTROL_SOURCE_NONE to release control
+ * @return true if ownership changed
+ */
+bool control_arbiter_handover(control_arbiter_t *arb, uint32_t lease, control_source_t to);
+
+/**
+ * @brief Parse a handover target name
+ *
+ * Accepts the source names shown in /status ("PS4", "SERIAL", "HTTP") and
+ * "none" (or "NONE") to release control. Anything else is refused rather
+ * than taken as a release.
+ *
+ * @param name Target name
+ * @param out  Set on success
+ * @return true if @p name is a known target
+ */
+bool control_arbiter_target_from_name(const char *name, control_source_t *out);
+
+/**
+ * @brief Validate a lease number received as a JSON number
+ *
+ * @param value Parsed number
+ * @param out   Set on success
+ * @return true if @p value is a whole number from 0 to UINT32_MAX
+ */
+bool control_arbiter_lease_from_number(double value, uint32_t *out);
+
+/**
+ * @brief Human-readable policy name
+ */
+const char *control_arbiter_policy_name(control_policy_t policy);
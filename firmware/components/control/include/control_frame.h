@@ -30,7 +30,7 @@ typedef struct {
     bool estop;          ///< Emergency stop command
     bool arm;            ///< Arming command
     bool slow_mode;      ///< Slow mode toggle
-    uint32_t timestamp;  ///< Frame timestamp (xTaskGetTickCount())
+    int64_t timestamp_us; ///< Ingress time at the source (esp_timer_get_time())
 } control_frame_t;
 
 /**
@@ -2,25 +2,50 @@
  * @file control_manager.h
  * @brief Control arbitration manager
  * 
- * Implements "owner lock" model: last active source takes control until timeout.
+ * Arbitrates between PS4, Serial and HTTP sources. The ownership policy
+ * (last-wins, priority preemption or sticky lease) and per-source priority
+ * and timeout are set in Kconfig.
+ *
+ * Submission is wait-free: each source has its own single-producer ring, so
+ * callers never block on the control loop. Each source must submit from a
+ * single task (Bluepad32 task, serial_task, httpd task).
  */
 
 #pragma once
 
 #include "esp_err.h"
 #include "control_frame.h"
+#include "control_arbiter.h"
+
+/**
+ * @brief Control manager configuration
+ */
+typedef struct {
+    uint32_t loop_rate_hz;  ///< Control loop rate, CONTROL_LOOP_RATE_MIN_HZ..CONTROL_LOOP_RATE_MAX_HZ
+} control_manager_config_t;
+
+#define CONTROL_LOOP_RATE_MIN_HZ 10
+#define CONTROL_LOOP_RATE_MAX_HZ 1000
 
 /**
  * @brief Initialize control manager
+ *
+ * @param config Loop configuration (rate is clamped to the supported range)
+ * @return esp_err_t ESP_OK on success
  */
-esp_err_t control_manager_init(void);
+esp_err_t control_manager_init(const control_manager_config_t *config);
 
 /**
  * @brief Submit control frame from a source
+ *
+ * Never waits for the control loop. Must only be called from the one task
+ * that owns @p source. A frame with estop set stops the motors before this
+ * function returns.
  * 
  * @param source Control source ID
  * @param frame Control frame data
- * @return esp_err_t ESP_OK on success
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for a bad source,
+ *         ESP_ERR_NO_MEM if the source's ring is full (frame dropped)
  */
 esp_err_t control_manager_submit(control_source_t source, const control_frame_t *frame);
 
@@ -31,6 +56,31 @@ esp_err_t control_manager_submit(control_source_t source, const control_frame_t
  */
 control_source_t control_manager_get_active_source(void);
 
+/**
+ * @brief Request an explicit handover of control
+ *
+ * Applied at the start of the next control cycle. Refused there if @p lease
+ * is not the current lease (see control_status_t) or @p to is not live.
+ *
+ * @param to    New owner, or CONTROL_SOURCE_NONE to release control
+ * @param lease Lease observed by the caller
+ * @return esp_err_t ESP_OK if queued, ESP_ERR_INVALID_ARG for a bad source
+ */
+esp_err_t control_manager_handover(control_source_t to, uint32_t lease);
+
+/**
+ * @brief Per-source arbitration state
+ */
+typedef struct {
+    bool     alive;       ///< Last frame within this source's timeout
+    uint8_t  priority;    ///< Configured priority
+    uint32_t timeout_ms;  ///< Configured timeout
+    uint32_t age_ms;      ///< Time since the last frame (0 if never seen)
+    uint32_t frames;      ///< Frames received since boot
+    float    rate_hz;     ///< Frame rate over the last second
+    uint32_t dropped;     ///< Frames dropped because the source's ring was full
+} control_source_info_t;
+
 /**
  * @brief Snapshot of the full system state (input + output)
  */
@@ -39,6 +89,9 @@ typedef struct {
     control_frame_t  frame;        ///< Last submitted control frame
     float            left_output;  ///< Mixed left motor speed sent to motor driver
     float            right_output; ///< Mixed right motor speed sent to motor driver
+    control_policy_t policy;       ///< Arbitration policy
+    uint32_t         lease;        ///< Ownership lease, changes on every owner change
+    control_source_info_t sources[CONTROL_ARBITER_MAX_SOURCES]; ///< Indexed by control_source_t
 } control_status_t;
 
 /**
@@ -47,3 +100,86 @@ typedef struct {
  * @param out Caller-allocated struct to fill
  */
 void control_manager_get_status(control_status_t *out);
+
+/**
+ * @brief Number of jitter histogram buckets in control_loop_stats_t
+ *
+ * Bucket upper bounds (|period - target|): 50, 100, 250, 500, 1000, 2000,
+ * 5000 us; the last bucket collects everything above 5 ms.
+ */
+#define CONTROL_LOOP_HIST_BUCKETS 8
+
+/**
+ * @brief Timed stages of one control cycle
+ *
+ * RAMP and PWM run inside the cycle in the single-stage pipeline and in the
+ * motor_ramp task in the two-stage pipeline; they are timed either way.
+ */
+typedef enum {
+    CONTROL_STAGE_ARBITRATE = 0, ///< Slot reads, arbitration, frame selection
+    CONTROL_STAGE_MIX,           ///< Safety checks, mixing, target hand-off
+    CONTROL_STAGE_RAMP,          ///< Slew-rate ramp step
+    CONTROL_STAGE_PWM,           ///< PWM duty writes
+    CONTROL_STAGE_COUNT,
+} control_stage_t;
+
+/**
+ * @brief Execution time of one stage against its budget
+ */
+typedef struct {
+    uint32_t budget_us; ///< Configured budget
+    uint32_t last_us;   ///< Most recent execution time
+    uint32_t max_us;    ///< Worst execution time
+    uint32_t overruns;  ///< Runs that exceeded budget_us
+} control_stage_stats_t;
+
+/**
+ * @brief Control loop timing statistics
+ */
+typedef struct {
+    uint32_t cycles;            ///< Cycles run since boot or last reset
+    uint32_t rate_hz;           ///< Configured loop rate
+    uint32_t period_target_us;  ///< Nominal loop period
+    uint32_t period_min_us;     ///< Shortest start-to-start period
+    uint32_t period_max_us;     ///< Longest start-to-start period
+    uint32_t period_avg_us;     ///< Mean start-to-start period
+    uint32_t exec_min_us;       ///< Shortest cycle execution time
+    uint32_t exec_max_us;       ///< Longest cycle execution time
+    uint32_t overruns;          ///< Cycles whose execution exceeded the period
+    uint32_t missed_ticks;      ///< Timer ticks that fired while a cycle was still running
+    uint32_t jitter_hist[CONTROL_LOOP_HIST_BUCKETS]; ///< |period - target| histogram
+    control_stage_stats_t stages[CONTROL_STAGE_COUNT]; ///< Per-stage budgets, indexed by control_stage_t
+} control_loop_stats_t;
+
+/**
+ * @brief Get a consistent snapshot of the control loop timing statistics
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void control_manager_get_loop_stats(control_loop_stats_t *out);
+
+/**
+ * @brief Clear the loop statistics (applied at the start of the next cycle)
+ */
+void control_manager_reset_loop_stats(void);
+
+/**
+ * @brief Stage name for logs and JSON
+ */
+const char *control_manager_stage_name(control_stage_t stage);
+
+/**
+ * @brief E-stop fast path statistics
+ */
+typedef struct {
+    uint32_t count;           ///< E-stops handled by the submit fast path
+    uint32_t last_latency_us; ///< Submit-to-PWM-zero time of the last e-stop
+    uint32_t max_latency_us;  ///< Worst submit-to-PWM-zero time since boot
+} control_estop_stats_t;
+
+/**
+ * @brief Get e-stop fast path statistics
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void control_manager_get_estop_stats(control_estop_stats_t *out);
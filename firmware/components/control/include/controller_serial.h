@@ -6,6 +6,7 @@
 #pragma once
 
 #include "esp_err.h"
+#include "serial_codec.h"
 
 /**
  * @brief Initialize Serial controller
@@ -13,3 +14,10 @@
  * @return esp_err_t ESP_OK on success
  */
 esp_err_t controller_serial_init(void);
+
+/**
+ * @brief Get the serial parser counters (zeros if serial is disabled)
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void controller_serial_get_stats(serial_rx_stats_t *out);
@@ -0,0 +1,68 @@
+/**
+ * @file drive_config.h
+ * @brief Live drive configuration (mixer tuning) with background NVS persistence
+ *
+ * Changes take effect on the next control cycle via
+ * mixer_diffdrive_set_config(). Persisting them is deferred: a low-priority
+ * task waits until changes have been quiet for DRIVE_CONFIG_PERSIST_DELAY_MS
+ * and then writes every changed key in one NVS commit, so neither the control
+ * loop nor the caller ever waits on flash.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "cJSON.h"
+
+#define DRIVE_CONFIG_PERSIST_DELAY_MS 1000
+
+/**
+ * @brief Drive configuration in percent, as stored in NVS
+ */
+typedef struct {
+    int deadzone;     ///< 0..20
+    int expo;         ///< 0..100
+    int max_speed;    ///< 10..100
+    int slow_factor;  ///< 10..100
+    int desat;        ///< mixer_desat_t
+    int turn;         ///< mixer_turn_t
+    int pivot;        ///< 0..50, MIXER_TURN_CURVATURE pivot band
+} drive_config_t;
+
+/**
+ * @brief Load the configuration (NVS over Kconfig defaults), initialise the
+ *        mixer with it and start the persistence task
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t drive_config_init(void);
+
+/**
+ * @brief Copy the configuration currently applied
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void drive_config_get(drive_config_t *out);
+
+/**
+ * @brief Apply a configuration live and schedule it for persistence
+ *
+ * @param config New configuration
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if a value is out
+ *         of range (nothing is applied)
+ */
+esp_err_t drive_config_apply(const drive_config_t *config);
+
+/**
+ * @brief Apply the drive fields present in a JSON object
+ *
+ * Recognises "deadzone", "expo", "max_speed", "slow_factor", "desat",
+ * "turn" and "pivot"; other fields are ignored and missing ones keep their
+ * current value. "desat" and "turn" accept the mode number or its name
+ * (mixer_diffdrive_desat_name(), mixer_diffdrive_turn_name()).
+ *
+ * @param obj JSON object
+ * @return esp_err_t ESP_OK if applied, ESP_ERR_NOT_FOUND if @p obj has no
+ *         drive field, ESP_ERR_INVALID_ARG if a value is out of range
+ */
+esp_err_t drive_config_apply_json(const cJSON *obj);
@@ -0,0 +1,64 @@
+/**
+ * @file latency_trace.h
+ * @brief Per-source input-to-PWM latency histograms
+ *
+ * Each control frame carries its ingress time (esp_timer microseconds) from
+ * the source that produced it. The control path records the elapsed time at
+ * each stage into fixed-size log-linear histograms: one per source and stage.
+ *
+ * One writer (the control task) and any number of readers. Counters are
+ * atomics, so readers never block the writer; a snapshot taken while the
+ * writer is recording may be off by the sample in flight.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "control_frame.h"
+
+/**
+ * @brief Pipeline stages timed from frame ingress
+ */
+typedef enum {
+    LATENCY_STAGE_PICKUP = 0, ///< Control cycle picked the frame up
+    LATENCY_STAGE_MIX    = 1, ///< Frame mixed into track speeds
+    LATENCY_STAGE_PWM    = 2, ///< PWM written with the mixed speeds
+    LATENCY_STAGE_COUNT,
+} latency_stage_t;
+
+/**
+ * @brief Summary of one histogram
+ */
+typedef struct {
+    uint32_t count;   ///< Samples recorded
+    uint32_t p50_us;  ///< Median (upper edge of its bucket)
+    uint32_t p99_us;  ///< 99th percentile (upper edge of its bucket)
+    uint32_t max_us;  ///< Exact worst sample
+} latency_summary_t;
+
+/**
+ * @brief Record one latency sample
+ *
+ * @param source     Source that produced the frame
+ * @param stage      Stage reached
+ * @param ingress_us Frame ingress time (control_frame_t.timestamp_us)
+ * @param now_us     Time the stage was reached
+ */
+void latency_trace_record(control_source_t source, latency_stage_t stage,
+                          int64_t ingress_us, int64_t now_us);
+
+/**
+ * @brief Summarise the histogram for one source and stage
+ */
+void latency_trace_get(control_source_t source, latency_stage_t stage,
+                       latency_summary_t *out);
+
+/**
+ * @brief Clear all histograms
+ */
+void latency_trace_reset(void);
+
+/**
+ * @brief Stage name for logs and JSON
+ */
+const char *latency_trace_stage_name(latency_stage_t stage);
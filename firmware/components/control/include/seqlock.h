@@ -0,0 +1,66 @@
+/**
+ * @file seqlock.h
+ * @brief Single-writer sequence lock for publishing small structs
+ *
+ * The writer bumps the sequence to an odd value, copies the payload, then
+ * bumps it back to even. A reader copies the payload between
+ * seqlock_read_begin() and seqlock_read_valid(); if the sequence was odd or
+ * changed, the copy may be torn and must be discarded.
+ *
+ * The writer never waits. Readers never spin inside this header: on FreeRTOS a
+ * reader may have preempted the writer on the same core, so the caller decides
+ * whether to retry, yield, or keep its previous snapshot.
+ *
+ * Exactly one task may write a given seqlock.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+typedef struct {
+    atomic_uint seq;
+} seqlock_t;
+
+/**
+ * @brief Mark the start of a write (sequence becomes odd)
+ */
+static inline void seqlock_write_begin(seqlock_t *sl) {
+    unsigned s = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief Mark the end of a write (sequence becomes even again)
+ */
+static inline void seqlock_write_end(seqlock_t *sl) {
+    unsigned s = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, s + 1, memory_order_release);
+}
+
+/**
+ * @brief Start a read; pass the result to seqlock_read_valid()
+ */
+static inline unsigned seqlock_read_begin(const seqlock_t *sl) {
+    return atomic_load_explicit(&((seqlock_t *)sl)->seq, memory_order_acquire);
+}
+
+/**
+ * @brief Check that the data copied since seqlock_read_begin() is consistent
+ *
+ * @return true if no write overlapped the copy
+ */
+static inline bool seqlock_read_valid(const seqlock_t *sl, unsigned start) {
+    atomic_thread_fence(memory_order_acquire);
+    return (start & 1u) == 0 &&
+           atomic_load_explicit(&((seqlock_t *)sl)->seq, memory_order_relaxed) == start;
+}
+
+/**
+ * @brief True once the writer has published at least one payload
+ */
+static inline bool seqlock_has_data(const seqlock_t *sl) {
+    return atomic_load_explicit(&((seqlock_t *)sl)->seq, memory_order_acquire) >= 2;
+}
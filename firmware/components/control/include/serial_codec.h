@@ -0,0 +1,162 @@
+/**
+ * @file serial_codec.h
+ * @brief Binary drive frames (COBS + CRC-16) and the serial stream parser
+ *
+ * The serial port takes JSON lines and binary frames on the same stream;
+ * serial_rx_push() tells them apart byte by byte.
+ *
+ * A binary drive frame is 9 bytes before framing:
+ *
+ *   type (0x01) | seq | throttle int16 LE | steering int16 LE | flags | CRC-16 LE
+ *
+ * Axes are scaled so ±32767 is ±1.0. The CRC is CRC-16/CCITT-FALSE over the
+ * first 7 bytes, as in the event log. On the wire the frame is COBS-encoded
+ * (no zero bytes) and ends with one 0x00, 11 bytes in all, against about 40
+ * for the equivalent JSON line.
+ *
+ * Each line or frame is told apart by how it starts: a JSON line starts with
+ * '{' and ends at '\n' or '\r'; a drive frame starts with its COBS code byte
+ * (2..10) and the frame type, and runs to the next 0x00, even where its bytes
+ * are 0x0A / 0x0D. Line ends left over from "\r\n" are dropped, and anything
+ * else is taken as a text line. A 0x00 before a frame is optional; it only
+ * matters to cut off a partial JSON line, e.g. after the sender reconnects.
+ *
+ * Pure C with no RTOS or IDF dependencies, so the host tools
+ * (tools/serial_codec_fuzz.c) run the same parser.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SERIAL_FRAME_DRIVE      0x01    ///< Frame type: drive command
+#define SERIAL_DRIVE_LEN        9       ///< Drive frame before COBS
+#define SERIAL_DRIVE_WIRE_LEN   11      ///< Drive frame on the wire (COBS + delimiter)
+#define SERIAL_BINARY_MAX       32      ///< Longest binary frame the parser buffers
+#define SERIAL_LINE_MAX         256     ///< Longest JSON line, including the terminator
+#define SERIAL_AXIS_SCALE       32767.0f
+
+#define SERIAL_FLAG_ESTOP       0x01
+#define SERIAL_FLAG_ARM         0x02
+#define SERIAL_FLAG_SLOW        0x04
+
+/**
+ * @brief Decoded drive frame
+ */
+typedef struct {
+    uint8_t seq;        ///< Sender's sequence number, wraps at 256
+    int16_t throttle;   ///< ±32767 = ±1.0
+    int16_t steering;
+    uint8_t flags;      ///< SERIAL_FLAG_*
+} serial_drive_t;
+
+/**
+ * @brief What a byte completed
+ */
+typedef enum {
+    SERIAL_RX_NONE = 0,     ///< Nothing yet
+    SERIAL_RX_JSON,         ///< A JSON line (NUL-terminated, without the newline)
+    SERIAL_RX_DRIVE,        ///< A valid drive frame
+    SERIAL_RX_ERROR,        ///< A frame or line was dropped (see the stats)
+} serial_rx_result_t;
+
+/**
+ * @brief Parser counters
+ */
+typedef struct {
+    uint32_t json_lines;    ///< JSON lines delivered
+    uint32_t drive_frames;  ///< Drive frames delivered
+    uint32_t crc_errors;    ///< Binary frames with a bad CRC
+    uint32_t bad_frames;    ///< Binary frames with bad COBS, length or type, and
+                            ///< partial JSON lines cut off by a 0x00
+    uint32_t overflows;     ///< Lines or frames too long for the buffer
+    uint32_t seq_gaps;      ///< Drive frames missed, from sequence gaps
+} serial_rx_stats_t;
+
+/**
+ * @brief Parser state; zero-initialise (or serial_rx_reset()) before use
+ */
+typedef struct {
+    bool              text;         ///< Inside a text line (JSON or not)
+    bool              overflow;     ///< Dropping until the end of this line / frame
+    bool              have_seq;
+    uint8_t           last_seq;
+    size_t            len;
+    uint8_t           buf[SERIAL_LINE_MAX];
+    serial_rx_stats_t stats;
+} serial_rx_t;
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ */
+uint16_t serial_crc16(const uint8_t *data, size_t len);
+
+/**
+ * @brief COBS-encode, without the trailing delimiter
+ *
+ * @param out At least len + len / 254 + 1 bytes
+ * @return Encoded length
+ */
+size_t serial_cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief COBS-decode one frame (delimiter not included)
+ *
+ * @return Decoded length, or 0 if the input is not valid COBS or does not
+ *         fit in out_max
+ */
+size_t serial_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t out_max);
+
+/**
+ * @brief Encode a drive frame for the wire, delimiter included
+ *
+ * @param out At least SERIAL_DRIVE_WIRE_LEN bytes
+ * @return SERIAL_DRIVE_WIRE_LEN
+ */
+size_t serial_drive_encode(const serial_drive_t *drive, uint8_t *out);
+
+/**
+ * @brief Decode a drive frame from its COBS bytes (delimiter not included)
+ *
+ * @return SERIAL_RX_DRIVE, or SERIAL_RX_ERROR with the reason counted in
+ *         stats (may be NULL)
+ */
+serial_rx_result_t serial_drive_decode(const uint8_t *in, size_t len, serial_drive_t *drive,
+                                       serial_rx_stats_t *stats);
+
+/**
+ * @brief Axis value (±32767) to [-1.0, +1.0]
+ */
+static inline float serial_axis_to_float(int16_t v) {
+    float f = (float)v / SERIAL_AXIS_SCALE;
+    return f < -1.0f ? -1.0f : f;
+}
+
+/**
+ * @brief [-1.0, +1.0] to an axis value, clamped and rounded
+ */
+static inline int16_t serial_axis_from_float(float f) {
+    if (f > 1.0f) f = 1.0f;
+    if (f < -1.0f) f = -1.0f;
+    float v = f * SERIAL_AXIS_SCALE;
+    return (int16_t)(v < 0.0f ? v - 0.5f : v + 0.5f);
+}
+
+/**
+ * @brief Reset the parser (counters included)
+ */
+void serial_rx_reset(serial_rx_t *rx);
+
+/**
+ * @brief Feed one received byte
+ *
+ * @param rx    Parser state
+ * @param byte  Received byte
+ * @param drive Filled on SERIAL_RX_DRIVE
+ * @param line  Set on SERIAL_RX_JSON; valid until the next call
+ * @return What the byte completed
+ */
+serial_rx_result_t serial_rx_push(serial_rx_t *rx, uint8_t byte, serial_drive_t *drive,
+                                  const char **line);
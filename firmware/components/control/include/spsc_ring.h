@@ -0,0 +1,80 @@
+/**
+ * @file spsc_ring.h
+ * @brief Lock-free single-producer / single-consumer ring indices
+ *
+ * Only the indices live here; the caller owns a power-of-two element array
+ * next to the ring. The producer claims a slot with spsc_ring_write_slot(),
+ * fills it, then calls spsc_ring_publish(). The consumer reads slots from
+ * spsc_ring_read_slot() and hands them back with spsc_ring_release().
+ *
+ * head is written only by the producer and tail only by the consumer, so the
+ * two sides can run on different cores without locks or critical sections.
+ * Neither side ever waits: a full ring refuses the write, an empty ring
+ * returns no slot.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+typedef struct {
+    atomic_uint head;  ///< Next slot to write (producer)
+    atomic_uint tail;  ///< Next slot to read (consumer)
+    uint32_t    mask;  ///< Capacity - 1 (capacity must be a power of two)
+} spsc_ring_t;
+
+/**
+ * @brief Initialise an empty ring
+ *
+ * @param capacity Number of elements in the caller's array (power of two)
+ */
+static inline void spsc_ring_init(spsc_ring_t *r, uint32_t capacity) {
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->mask = capacity - 1;
+}
+
+/**
+ * @brief Producer: index of the next free slot
+ *
+ * @return Element index, or -1 if the ring is full
+ */
+static inline int32_t spsc_ring_write_slot(spsc_ring_t *r) {
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail > r->mask) {
+        return -1;
+    }
+    return (int32_t)(head & r->mask);
+}
+
+/**
+ * @brief Producer: make the slot from spsc_ring_write_slot() visible
+ */
+static inline void spsc_ring_publish(spsc_ring_t *r) {
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief Consumer: index of the oldest unread slot
+ *
+ * @return Element index, or -1 if the ring is empty
+ */
+static inline int32_t spsc_ring_read_slot(spsc_ring_t *r) {
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (head == tail) {
+        return -1;
+    }
+    return (int32_t)(tail & r->mask);
+}
+
+/**
+ * @brief Consumer: free the slot from spsc_ring_read_slot()
+ */
+static inline void spsc_ring_release(spsc_ring_t *r) {
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
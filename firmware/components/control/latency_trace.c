@@ -0,0 +1,129 @@
+/**
+ * @file latency_trace.c
+ * @brief Per-source input-to-PWM latency histograms implementation
+ *
+ * Buckets are log-linear: four sub-buckets per power of two from 4 us up to
+ * ~1 s, so percentiles are accurate to within 25% at any magnitude with a
+ * fixed 80-entry table per histogram.
+ */
+
+#include "latency_trace.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SOURCE_COUNT    3   // PS4, SERIAL, HTTP
+#define SUB_BITS        2
+#define SUB_BUCKETS     (1 << SUB_BITS)
+#define BUCKET_COUNT    80  // covers up to 2^20 us
+
+typedef struct {
+    atomic_uint max_us;
+    atomic_uint buckets[BUCKET_COUNT];
+} latency_hist_t;
+
+static latency_hist_t hists[SOURCE_COUNT][LATENCY_STAGE_COUNT];
+
+static int bucket_index(uint32_t us) {
+    if (us < SUB_BUCKETS) {
+        return (int)us;
+    }
+    int msb = 31 - __builtin_clz(us);
+    int sub = (us >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+    int idx = SUB_BUCKETS * (msb - SUB_BITS + 1) + sub;
+    return (idx < BUCKET_COUNT) ? idx : BUCKET_COUNT - 1;
+}
+
+static uint32_t bucket_upper_us(int idx) {
+    if (idx < SUB_BUCKETS) {
+        return (uint32_t)idx;
+    }
+    int msb = idx / SUB_BUCKETS + SUB_BITS - 1;
+    int sub = idx % SUB_BUCKETS;
+    uint32_t width = 1u << (msb - SUB_BITS);
+    return ((uint32_t)(SUB_BUCKETS + sub) << (msb - SUB_BITS)) + width - 1;
+}
+
+static latency_hist_t *hist_for(control_source_t source, latency_stage_t stage) {
+    if (source <= CONTROL_SOURCE_NONE || source > SOURCE_COUNT ||
+        stage < 0 || stage >= LATENCY_STAGE_COUNT) {
+        return NULL;
+    }
+    return &hists[source - 1][stage];
+}
+
+void latency_trace_record(control_source_t source, latency_stage_t stage,
+                          int64_t ingress_us, int64_t now_us) {
+    latency_hist_t *h = hist_for(source, stage);
+    if (h == NULL || ingress_us <= 0 || now_us < ingress_us) {
+        return;
+    }
+
+    int64_t elapsed = now_us - ingress_us;
+    uint32_t us = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+
+    atomic_fetch_add_explicit(&h->buckets[bucket_index(us)], 1, memory_order_relaxed);
+    if (us > atomic_load_explicit(&h->max_us, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max_us, us, memory_order_relaxed);
+    }
+}
+
+void latency_trace_get(control_source_t source, latency_stage_t stage,
+                       latency_summary_t *out) {
+    if (out == NULL) return;
+    *out = (latency_summary_t){0};
+
+    latency_hist_t *h = hist_for(source, stage);
+    if (h == NULL) return;
+
+    uint32_t counts[BUCKET_COUNT];
+    uint32_t total = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    out->count  = total;
+    out->max_us = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+    if (total == 0) return;
+
+    // Ceil so small sample counts still report a real bucket
+    uint32_t p50_rank = (total + 1) / 2;
+    uint32_t p99_rank = total - total / 100;
+    uint32_t seen = 0;
+    bool have_p50 = false;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (!have_p50 && seen >= p50_rank) {
+            out->p50_us = bucket_upper_us(i);
+            have_p50 = true;
+        }
+        if (seen >= p99_rank) {
+            out->p99_us = bucket_upper_us(i);
+            break;
+        }
+    }
+    // Bucket edges can overshoot the exact maximum
+    if (out->p50_us > out->max_us) out->p50_us = out->max_us;
+    if (out->p99_us > out->max_us) out->p99_us = out->max_us;
+}
+
+void latency_trace_reset(void) {
+    for (int s = 0; s < SOURCE_COUNT; s++) {
+        for (int st = 0; st < LATENCY_STAGE_COUNT; st++) {
+            latency_hist_t *h = &hists[s][st];
+            for (int i = 0; i < BUCKET_COUNT; i++) {
+                atomic_store_explicit(&h->buckets[i], 0, memory_order_relaxed);
+            }
+            atomic_store_explicit(&h->max_us, 0, memory_order_relaxed);
+        }
+    }
+}
+
+const char *latency_trace_stage_name(latency_stage_t stage) {
+    switch (stage) {
+        case LATENCY_STAGE_PICKUP: return "pickup";
+        case LATENCY_STAGE_MIX:    return "mix";
+        case LATENCY_STAGE_PWM:    return "pwm";
+        default:                   return "?";
+    }
+}
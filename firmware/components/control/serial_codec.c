@@ -0,0 +1,244 @@
+/**
+ * @file serial_codec.c
+ * @brief Binary drive frames and serial stream parser implementation
+ */
+
+#include "serial_codec.h"
+#include <string.h>
+
+uint16_t serial_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t serial_cobs_encode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t code_pos = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] != 0) {
+            out[o++] = in[i];
+            code++;
+        }
+        if (in[i] == 0 || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+size_t serial_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t out_max) {
+    size_t i = 0;
+    size_t o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0) {
+            return 0;
+        }
+        for (uint8_t j = 1; j < code; j++) {
+            if (i >= len || in[i] == 0 || o >= out_max) {
+                return 0;
+            }
+            out[o++] = in[i++];
+        }
+        if (code != 0xFF && i < len) {
+            if (o >= out_max) {
+                return 0;
+            }
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+size_t serial_drive_encode(const serial_drive_t *drive, uint8_t *out) {
+    uint8_t raw[SERIAL_DRIVE_LEN] = {
+        SERIAL_FRAME_DRIVE,
+        drive->seq,
+        (uint8_t)((uint16_t)drive->throttle & 0xFF), (uint8_t)((uint16_t)drive->throttle >> 8),
+        (uint8_t)((uint16_t)drive->steering & 0xFF), (uint8_t)((uint16_t)drive->steering >> 8),
+        drive->flags,
+    };
+    uint16_t crc = serial_crc16(raw, SERIAL_DRIVE_LEN - 2);
+    raw[7] = (uint8_t)(crc & 0xFF);
+    raw[8] = (uint8_t)(crc >> 8);
+
+    // 9 bytes never need a second code byte: always 10 encoded + delimiter
+    size_t n = serial_cobs_encode(raw, SERIAL_DRIVE_LEN, out);
+    out[n++] = 0x00;
+    return n;
+}
+
+serial_rx_result_t serial_drive_decode(const uint8_t *in, size_t len, serial_drive_t *drive,
+                                       serial_rx_stats_t *stats) {
+    uint8_t raw[SERIAL_BINARY_MAX];
+    size_t n = serial_cobs_decode(in, len, raw, sizeof(raw));
+    if (n != SERIAL_DRIVE_LEN) {
+        if (stats) stats->bad_frames++;
+        return SERIAL_RX_ERROR;
+    }
+    uint16_t crc = (uint16_t)(raw[7] | (raw[8] << 8));
+    if (crc != serial_crc16(raw, SERIAL_DRIVE_LEN - 2)) {
+        if (stats) stats->crc_errors++;
+        return SERIAL_RX_ERROR;
+    }
+    if (raw[0] != SERIAL_FRAME_DRIVE) {
+        if (stats) stats->bad_frames++;
+        return SERIAL_RX_ERROR;
+    }
+    drive->seq      = raw[1];
+    drive->throttle = (int16_t)(uint16_t)(raw[2] | (raw[3] << 8));
+    drive->steering = (int16_t)(uint16_t)(raw[4] | (raw[5] << 8));
+    drive->flags    = raw[6];
+    return SERIAL_RX_DRIVE;
+}
+
+void serial_rx_reset(serial_rx_t *rx) {
+    memset(rx, 0, sizeof(*rx));
+}
+
+static serial_rx_result_t overflow(serial_rx_t *rx) {
+    rx->overflow = true;
+    rx->len = 0;
+    rx->stats.overflows++;
+    return SERIAL_RX_ERROR;
+}
+
+static bool is_line_end(uint8_t byte) {
+    return byte == '\n' || byte == '\r';
+}
+
+/**
+ * @brief Number of line-end bytes at the start of the buffer
+ */
+static size_t leading_line_ends(const serial_rx_t *rx) {
+    size_t n = 0;
+    while (n < rx->len && is_line_end(rx->buf[n])) n++;
+    return n;
+}
+
+/**
+ * @brief True while the bytes so far can still be a drive frame
+ *
+ * On the wire a drive frame is a COBS code byte of 2..10, the frame type and
+ * at most SERIAL_DRIVE_WIRE_LEN - 1 bytes in all. A line end in front of it
+ * is left over from a JSON line, unless it is the code byte (0x0A) itself.
+ */
+static bool frame_prefix(const serial_rx_t *rx) {
+    size_t skip = 0;
+    do {
+        const uint8_t *p = rx->buf + skip;
+        size_t n = rx->len - skip;
+        if (n <= SERIAL_DRIVE_WIRE_LEN - 1 &&
+            (n < 1 || (p[0] >= 2 && p[0] <= SERIAL_DRIVE_WIRE_LEN - 1)) &&
+            (n < 2 || p[1] == SERIAL_FRAME_DRIVE)) {
+            return true;
+        }
+    } while (skip < rx->len && is_line_end(rx->buf[skip++]));
+    return false;
+}
+
+/**
+ * @brief A 0x00 ends a binary frame, or cuts a partial JSON line
+ */
+static serial_rx_result_t end_of_frame(serial_rx_t *rx, serial_drive_t *drive) {
+    serial_rx_result_t res = SERIAL_RX_NONE;
+    if (rx->len > 0 && !rx->overflow) {
+        if (!rx->text) {
+            // Drop "\r\n" left over from a JSON line, but only bytes beyond a
+            // frame's length: its own COBS code byte may be 0x0A. Nothing but
+            // line ends (a spare 0x00 after a line) is not a frame at all.
+            size_t skip = leading_line_ends(rx);
+            if (skip < rx->len) {
+                size_t excess = (rx->len > SERIAL_DRIVE_WIRE_LEN - 1)
+                              ? rx->len - (SERIAL_DRIVE_WIRE_LEN - 1) : 0;
+                if (skip > excess) skip = excess;
+                res = serial_drive_decode(rx->buf + skip, rx->len - skip, drive, &rx->stats);
+            }
+        } else {
+            rx->stats.bad_frames++;
+            res = SERIAL_RX_ERROR;
+        }
+    }
+    if (res == SERIAL_RX_DRIVE) {
+        uint8_t gap = (uint8_t)(drive->seq - rx->last_seq - 1);
+        if (rx->have_seq && gap < 128) {   // larger: sender restarted or resent
+            rx->stats.seq_gaps += gap;
+        }
+        rx->have_seq = true;
+        rx->last_seq = drive->seq;
+        rx->stats.drive_frames++;
+    }
+    rx->text = false;
+    rx->overflow = false;
+    rx->len = 0;
+    return res;
+}
+
+serial_rx_result_t serial_rx_push(serial_rx_t *rx, uint8_t byte, serial_drive_t *drive,
+                                  const char **line) {
+    if (byte == 0x00) {
+        return end_of_frame(rx, drive);
+    }
+
+    if (!rx->text) {
+        size_t ends = leading_line_ends(rx);
+        if (ends == rx->len && byte == '{') {
+            rx->text = true;      // a JSON line, after any leftover line ends
+            rx->len = 0;
+        } else if (ends == rx->len && is_line_end(byte)) {
+            // Blank lines: keep the last line end, it may be a code byte
+            rx->buf[0] = byte;
+            rx->len = 1;
+            return SERIAL_RX_NONE;
+        } else {
+            rx->buf[rx->len++] = byte;
+            if (frame_prefix(rx)) {
+                return SERIAL_RX_NONE;
+            }
+            rx->len--;
+            if (rx->len > ends) {
+                // A frame cut short: drop it and look at this byte afresh
+                rx->stats.bad_frames++;
+                rx->len = 0;
+                return serial_rx_push(rx, byte, drive, line);
+            }
+            // Neither a frame nor JSON: text up to the next line end
+            rx->text = true;
+            rx->len = 0;
+        }
+    }
+
+    if (is_line_end(byte)) {
+        // Whatever comes next is told apart by its first byte again
+        bool dropped = rx->overflow;
+        size_t len = rx->len;
+        rx->text = false;
+        rx->overflow = false;
+        rx->len = 0;
+        if (dropped || len == 0) {
+            return SERIAL_RX_NONE;
+        }
+        rx->buf[len] = '\0';
+        *line = (const char *)rx->buf;
+        rx->stats.json_lines++;
+        return SERIAL_RX_JSON;
+    }
+    if (rx->overflow) {
+        return SERIAL_RX_NONE;
+    }
+    if (rx->len >= SERIAL_LINE_MAX - 1) {
+        return overflow(rx);
+    }
+    rx->buf[rx->len++] = byte;
+    return SERIAL_RX_NONE;
+}
@@ -0,0 +1,368 @@
+/**
+ * @file event_log.c
+ * @brief Persistent binary event log implementation
+ */
+
+#include "event_log.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "event_log";
+
+#define STAGE_LEN        64            // records staged in RTC memory (2 KB)
+#define STAGE_MAGIC      0x45564C31u   // "EVL1"
+#define SECTOR_SIZE      4096
+#define RECS_PER_SECTOR  (SECTOR_SIZE / sizeof(event_log_record_t))
+#define IO_RECS          16            // records per flash read / write
+#define SEQ_ERASED       0xFFFFFFFFu
+#define CRC_LEN          offsetof(event_log_record_t, crc)
+#define TASK_STACK_SIZE  3072
+#define TASK_PRIORITY    1
+
+_Static_assert(sizeof(event_log_record_t) == 32, "event_log_record_t must stay 32 bytes");
+_Static_assert(sizeof(event_log_header_t) == 16, "event_log_header_t must stay 16 bytes");
+_Static_assert(SECTOR_SIZE % sizeof(event_log_record_t) == 0, "records must tile a sector");
+
+// Staging ring in RTC slow memory, left alone by soft resets. head is only
+// written by the producer and tail only by whoever holds flash_lock; the
+// free-running counts index rec[] modulo STAGE_LEN.
+typedef struct {
+    uint32_t           magic;
+    _Atomic uint32_t   head;   // records appended
+    _Atomic uint32_t   tail;   // records written to flash
+    event_log_record_t rec[STAGE_LEN];
+} stage_t;
+static RTC_NOINIT_ATTR stage_t stage;
+
+static event_log_config_t cfg;
+static const esp_partition_t *part;
+static uint32_t total_slots;       // records in the flash ring
+static uint32_t write_slot;        // next flash slot; its sector is erased on entry
+static SemaphoreHandle_t flash_lock;
+static event_log_record_t io_buf[IO_RECS];  // flash bounce buffer (flash_lock)
+static atomic_int exporting;       // exports running: the flush task holds off
+static TaskHandle_t flush_task_handle;
+static bool ready;
+
+// Producer only
+static uint32_t next_seq;
+static uint16_t boot;
+
+static atomic_uint appended = 0;
+static atomic_uint flushed = 0;
+static atomic_uint dropped = 0;
+static atomic_uint errors = 0;
+static uint32_t recovered;
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ */
+static uint16_t crc16(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool record_valid(const event_log_record_t *r) {
+    return r->seq != SEQ_ERASED && r->crc == crc16(r, CRC_LEN);
+}
+
+/**
+ * @brief Find the write position and the newest record in flash
+ *
+ * The newest sector is the one whose first record has the highest seq; the
+ * write position is its first erased slot. A torn first record hides its
+ * sector, which then is erased and reused as if it were the oldest.
+ *
+ * @return true if any record was found (*last filled)
+ */
+static bool scan_flash(event_log_record_t *last) {
+    uint32_t sectors = total_slots / RECS_PER_SECTOR;
+    uint32_t newest = 0;
+    bool found = false;
+    event_log_record_t r;
+
+    for (uint32_t s = 0; s < sectors; s++) {
+        if (esp_partition_read(part, s * SECTOR_SIZE, &r, sizeof(r)) != ESP_OK) continue;
+        if (record_valid(&r) && (!found || r.seq > last->seq)) {
+            found = true;
+            newest = s;
+            *last = r;
+        }
+    }
+    if (!found) {
+        write_slot = 0;
+        return false;
+    }
+
+    uint32_t used = 1;
+    for (; used < RECS_PER_SECTOR; used++) {
+        uint32_t slot = newest * RECS_PER_SECTOR + used;
+        if (esp_partition_read(part, slot * sizeof(r), &r, sizeof(r)) != ESP_OK ||
+            r.seq == SEQ_ERASED) {
+            break;
+        }
+        if (record_valid(&r)) *last = r;
+    }
+    write_slot = (newest * RECS_PER_SECTOR + used) % total_slots;
+    return true;
+}
+
+/**
+ * @brief Write every staged record to flash; caller holds flash_lock
+ */
+static void flush_stage(void) {
+    uint32_t tail = atomic_load_explicit(&stage.tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&stage.head, memory_order_acquire);
+
+    while (tail != head) {
+        uint32_t in_sector = write_slot % RECS_PER_SECTOR;
+        if (in_sector == 0) {
+            // Entering a sector: it holds the oldest records, if any
+            esp_err_t err = esp_partition_erase_range(part, write_slot * sizeof(event_log_record_t),
+                                                      SECTOR_SIZE);
+            if (err != ESP_OK) {
+                atomic_fetch_add(&errors, 1);
+                ESP_LOGE(TAG, "Sector erase failed: %s", esp_err_to_name(err));
+                return;
+            }
+        }
+
+        // One contiguous run: within the stage ring, the sector and io_buf
+        uint32_t idx = tail % STAGE_LEN;
+        uint32_t n = head - tail;
+        if (n > STAGE_LEN - idx) n = STAGE_LEN - idx;
+        if (n > RECS_PER_SECTOR - in_sector) n = RECS_PER_SECTOR - in_sector;
+        if (n > IO_RECS) n = IO_RECS;
+
+        memcpy(io_buf, &stage.rec[idx], n * sizeof(event_log_record_t));
+        esp_err_t err = esp_partition_write(part, write_slot * sizeof(event_log_record_t),
+                                            io_buf, n * sizeof(event_log_record_t));
+        if (err != ESP_OK) {
+            atomic_fetch_add(&errors, 1);
+            ESP_LOGE(TAG, "Flash write failed: %s", esp_err_to_name(err));
+            return;
+        }
+        write_slot = (write_slot + n) % total_slots;
+        tail += n;
+        atomic_store_explicit(&stage.tail, tail, memory_order_release);
+        atomic_fetch_add(&flushed, n);
+    }
+}
+
+/**
+ * @brief Flush task — periodic, or woken early when the stage fills up
+ */
+static void flush_task(void *arg) {
+    TickType_t period = pdMS_TO_TICKS(cfg.flush_ms);
+    if (period == 0) period = 1;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, period);
+        uint32_t pending = atomic_load(&stage.head) - atomic_load(&stage.tail);
+        if (pending == 0) {
+            continue;
+        }
+        if (cfg.hold && cfg.hold() && pending < STAGE_LEN / 2) {
+            continue;  // flash work would stall the control loop
+        }
+        xSemaphoreTake(flash_lock, portMAX_DELAY);
+        if (atomic_load(&exporting) == 0) {
+            flush_stage();
+        }
+        xSemaphoreGive(flash_lock);
+    }
+}
+
+esp_err_t event_log_init(const event_log_config_t *config) {
+    if (config == NULL || config->partition == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg = *config;
+
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                    cfg.partition);
+    if (part == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition — event log disabled", cfg.partition);
+        return ESP_ERR_NOT_FOUND;
+    }
+    total_slots = (part->size / SECTOR_SIZE) * RECS_PER_SECTOR;
+    if (total_slots < 2 * RECS_PER_SECTOR) {
+        ESP_LOGE(TAG, "Partition '%s' too small for a ring", cfg.partition);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    flash_lock = xSemaphoreCreateMutex();
+    if (flash_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    event_log_record_t last;
+    bool have_last = scan_flash(&last);
+
+    // Records staged before a soft reset; RTC memory is undefined after power-on
+    esp_reset_reason_t reason = esp_reset_reason();
+    uint32_t pending = stage.head - stage.tail;
+    if (stage.magic == STAGE_MAGIC && pending <= STAGE_LEN && reason != ESP_RST_POWERON) {
+        recovered = pending;
+        for (uint32_t i = stage.tail; i != stage.head; i++) {
+            const event_log_record_t *r = &stage.rec[i % STAGE_LEN];
+            if (record_valid(r) && (!have_last || r->seq > last.seq)) {
+                last = *r;
+                have_last = true;
+            }
+        }
+    } else {
+        stage.magic = STAGE_MAGIC;
+        atomic_store(&stage.head, 0);
+        atomic_store(&stage.tail, 0);
+    }
+    next_seq = have_last ? last.seq + 1 : 0;
+    boot     = have_last ? (uint16_t)(last.boot + 1) : 0;
+
+    flush_stage();
+    ready = true;
+
+    event_log_record_t rec = {
+        .event = EVENT_LOG_BOOT,
+        .arg   = (uint8_t)reason,
+        .value = recovered,
+    };
+    event_log_append(&rec);
+
+    BaseType_t ok = xTaskCreatePinnedToCore(flush_task, "evlog_flush", TASK_STACK_SIZE, NULL,
+                                            TASK_PRIORITY, &flush_task_handle, cfg.task_core);
+    if (ok != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create flush task");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Event log on '%s': %lu records, boot %u, next seq %lu, "
+             "%lu recovered from RTC (reset reason %d)", cfg.partition, total_slots,
+             boot, next_seq, recovered, (int)reason);
+    return ESP_OK;
+}
+
+void event_log_append(event_log_record_t *rec) {
+    if (!ready) {
+        return;
+    }
+    uint32_t head = atomic_load_explicit(&stage.head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&stage.tail, memory_order_acquire);
+
+    // A dropped record still uses up its seq, so the gap shows in the log
+    rec->seq = next_seq++;
+    if (head - tail >= STAGE_LEN) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+    rec->time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    rec->boot = boot;
+    memset(rec->reserved, 0, sizeof(rec->reserved));
+    rec->crc = crc16(rec, CRC_LEN);
+
+    memcpy(&stage.rec[head % STAGE_LEN], rec, sizeof(*rec));
+    atomic_store_explicit(&stage.head, head + 1, memory_order_release);
+    atomic_fetch_add_explicit(&appended, 1, memory_order_relaxed);
+
+    if (head + 1 - tail == STAGE_LEN / 2 && flush_task_handle != NULL) {
+        xTaskNotifyGive(flush_task_handle);
+    }
+}
+
+/**
+ * @brief Send the valid records of buf[0..n)
+ */
+static esp_err_t send_valid(event_log_record_t *buf, uint32_t n, event_log_sink_t sink,
+                            void *ctx) {
+    uint32_t keep = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (record_valid(&buf[i])) {
+            if (keep != i) buf[keep] = buf[i];
+            keep++;
+        }
+    }
+    return keep ? sink(buf, keep * sizeof(event_log_record_t), ctx) : ESP_OK;
+}
+
+esp_err_t event_log_export(event_log_sink_t sink, void *ctx) {
+    if (!ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    event_log_header_t hdr = {
+        .magic       = {'E', 'V', 'L', 'G'},
+        .version     = EVENT_LOG_VERSION,
+        .record_size = sizeof(event_log_record_t),
+        .boot        = boot,
+        .dropped     = atomic_load(&dropped),
+    };
+    esp_err_t ret = sink(&hdr, sizeof(hdr), ctx);
+
+    // The flush task holds off from here on, so neither the flash ring nor
+    // the stage tail moves. flash_lock is only held to copy each block, never
+    // while the sink runs: a slow client does not hold up the flush task.
+    event_log_record_t buf[IO_RECS];
+    atomic_fetch_add(&exporting, 1);
+    xSemaphoreTake(flash_lock, portMAX_DELAY);  // wait out a flush in progress
+
+    // Oldest first: the write sector holds the newest records, unless the
+    // write position sits at its start, when it still holds the oldest
+    uint32_t sectors = total_slots / RECS_PER_SECTOR;
+    uint32_t ws = write_slot / RECS_PER_SECTOR;
+    uint32_t first = (write_slot % RECS_PER_SECTOR == 0) ? ws : (ws + 1) % sectors;
+    uint32_t tail = atomic_load(&stage.tail);
+    xSemaphoreGive(flash_lock);
+
+    for (uint32_t i = 0; i < sectors && ret == ESP_OK; i++) {
+        uint32_t base = ((first + i) % sectors) * RECS_PER_SECTOR;
+        for (uint32_t r = 0; r < RECS_PER_SECTOR && ret == ESP_OK; r += IO_RECS) {
+            xSemaphoreTake(flash_lock, portMAX_DELAY);
+            ret = esp_partition_read(part, (base + r) * sizeof(event_log_record_t),
+                                     buf, sizeof(buf));
+            xSemaphoreGive(flash_lock);
+            if (ret == ESP_OK) ret = send_valid(buf, IO_RECS, sink, ctx);
+        }
+    }
+
+    // Then what is still staged, up to the head as it is now
+    uint32_t head = atomic_load_explicit(&stage.head, memory_order_acquire);
+    while (tail != head && ret == ESP_OK) {
+        uint32_t n = 0;
+        xSemaphoreTake(flash_lock, portMAX_DELAY);
+        while (n < IO_RECS && tail != head) {
+            buf[n++] = stage.rec[tail++ % STAGE_LEN];
+        }
+        xSemaphoreGive(flash_lock);
+        ret = send_valid(buf, n, sink, ctx);
+    }
+
+    atomic_fetch_sub(&exporting, 1);
+    if (flush_task_handle != NULL) {
+        xTaskNotifyGive(flush_task_handle);  // catch up on what was staged meanwhile
+    }
+    return ret;
+}
+
+void event_log_get_stats(event_log_stats_t *out) {
+    if (!out) return;
+    out->appended  = atomic_load(&appended);
+    out->flushed   = atomic_load(&flushed);
+    out->dropped   = atomic_load(&dropped);
+    out->recovered = recovered;
+    out->errors    = atomic_load(&errors);
+    out->capacity  = total_slots;
+    out->boot      = boot;
+}
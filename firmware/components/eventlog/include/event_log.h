@@ -0,0 +1,151 @@
+/**
+ * @file event_log.h
+ * @brief Persistent binary event log: RTC staging, flash ring
+ *
+ * Fixed 32-byte records are appended to a small ring in RTC slow memory,
+ * which survives soft resets (panic, watchdogs, esp_restart()), and
+ * a background task flushes them in batches to a ring of sectors in a
+ * dedicated flash partition. Records still staged when the chip resets are
+ * flushed at the next boot, so the events leading up to a crash are kept.
+ *
+ * Appending copies one record into RTC memory: no allocation, no lock and
+ * no flash access, so it can run in the control loop. There is a single
+ * producer: event_log_init() writes the boot record, then only the control
+ * task appends. When the stage is full, new records are dropped and counted.
+ *
+ * Flash program and erase stall both cores' caches (an erase for tens of
+ * milliseconds), so while the hold callback reports the robot as busy the
+ * flush waits, unless the stage is at least half full.
+ *
+ * GET /eventlog streams the log; tools/eventlog_decode.py decodes it.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EVENT_LOG_VERSION 1
+
+/**
+ * @brief Event ids (the meaning of arg / source / value per event)
+ */
+typedef enum {
+    EVENT_LOG_BOOT = 1,   ///< arg = esp_reset_reason_t, value = records recovered from RTC
+    EVENT_LOG_SAFETY,     ///< Safety transition: arg = safety_cause_t, source = origin,
+                          ///< value = previous state
+    EVENT_LOG_SOURCE,     ///< Control owner changed: source = new owner, arg = previous owner
+    EVENT_LOG_THERMAL,    ///< Thermal state changed: arg = thermal_state_t, value = scale in ‰
+    EVENT_LOG_SAMPLE,     ///< Periodic snapshot while armed
+    EVENT_LOG_BATTERY,    ///< Battery state changed: arg = battery_state_t, value = pack mV
+} event_log_id_t;
+
+/**
+ * @brief One record, as stored in RTC memory, in flash and in the export
+ *
+ * Little endian, every field naturally aligned. seq 0xFFFFFFFF is an erased
+ * flash slot.
+ */
+typedef struct {
+    uint32_t seq;         ///< Record number, increasing across boots
+    uint32_t time_ms;     ///< Milliseconds since this boot
+    uint32_t value;       ///< Event-specific, see event_log_id_t
+    uint16_t boot;        ///< Boot number (0 = first boot with this log)
+    uint8_t  event;       ///< event_log_id_t
+    uint8_t  source;      ///< Control source / safety origin
+    uint8_t  state;       ///< Safety state after the event
+    uint8_t  arg;         ///< Event-specific, see event_log_id_t
+    int16_t  throttle;    ///< Input, thousandths (-1000..1000)
+    int16_t  steering;
+    int16_t  left;        ///< Track output, thousandths
+    int16_t  right;
+    uint8_t  reserved[4];
+    uint16_t crc;         ///< CRC-16/CCITT-FALSE over the preceding 30 bytes
+} event_log_record_t;
+
+/**
+ * @brief Header of the exported stream, followed by records oldest first
+ */
+typedef struct {
+    char     magic[4];      ///< "EVLG"
+    uint16_t version;       ///< EVENT_LOG_VERSION
+    uint16_t record_size;   ///< sizeof(event_log_record_t)
+    uint16_t boot;          ///< Current boot number
+    uint16_t reserved;
+    uint32_t dropped;       ///< Records dropped this boot (stage full)
+} event_log_header_t;
+
+/**
+ * @brief Log configuration
+ */
+typedef struct {
+    const char *partition;     ///< Flash partition label
+    uint32_t    flush_ms;      ///< Flush period
+    bool      (*hold)(void);   ///< Defer flash work while true (NULL = never)
+    int         task_core;     ///< Core for the flush task, or tskNO_AFFINITY
+} event_log_config_t;
+
+/**
+ * @brief Log counters
+ */
+typedef struct {
+    uint32_t appended;    ///< Records appended this boot
+    uint32_t flushed;     ///< Records written to flash this boot
+    uint32_t dropped;     ///< Records dropped this boot (stage full)
+    uint32_t recovered;   ///< Staged records carried over from before the reset
+    uint32_t errors;      ///< Flash errors
+    uint32_t capacity;    ///< Records the flash ring holds
+    uint16_t boot;        ///< Current boot number
+} event_log_stats_t;
+
+/**
+ * @brief Output callback of event_log_export()
+ */
+typedef esp_err_t (*event_log_sink_t)(const void *data, size_t len, void *ctx);
+
+/**
+ * @brief Mount the flash ring, flush records staged before the reset, and
+ *        log the boot; starts the flush task
+ *
+ * @param config Configuration
+ * @return esp_err_t ESP_OK, or ESP_ERR_NOT_FOUND without the partition
+ */
+esp_err_t event_log_init(const event_log_config_t *config);
+
+/**
+ * @brief Append a record (single producer: the control task)
+ *
+ * Fills in seq, time_ms, boot and crc; the caller sets the rest. Does
+ * nothing before event_log_init() succeeded.
+ *
+ * @param rec Record to append; updated with the filled-in fields
+ */
+void event_log_append(event_log_record_t *rec);
+
+/**
+ * @brief Stream the header and every record, oldest first
+ *
+ * Records with a bad CRC (torn writes, foreign data) are skipped. Flushing
+ * waits until the export is done.
+ *
+ * @param sink Called with consecutive pieces of the stream
+ * @param ctx  Passed to @p sink
+ * @return esp_err_t ESP_OK, or the first error from @p sink or the flash
+ */
+esp_err_t event_log_export(event_log_sink_t sink, void *ctx);
+
+/**
+ * @brief Get the log counters
+ */
+void event_log_get_stats(event_log_stats_t *out);
+
+/**
+ * @brief Scale -1.0..1.0 to the record's thousandths
+ */
+static inline int16_t event_log_milli(float v) {
+    if (v > 1.0f) v = 1.0f;
+    if (v < -1.0f) v = -1.0f;
+    return (int16_t)(v * 1000.0f);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file battery_guard.c
+ * @brief Battery monitor and output limit implementation
+ */
+
+#include "battery_guard.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+static const char *TAG = "battery";
+
+#define DT_MAX_S 0.1f  // cap after a stall, as in thermal_guard
+
+static battery_guard_config_t cfg;
+static battery_est_t          est;        // control task only
+static battery_state_t        last_state; // control task only
+static float                  scale = 1.0f;
+static _Atomic(const battery_source_t *) source;
+
+// Snapshot for readers on other tasks
+static battery_guard_status_t status;
+static portMUX_TYPE           status_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t battery_guard_init(const battery_guard_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const battery_params_t *p = &config->params;
+    if (p->cells < 1 || p->min_v <= 0.0f || p->r_init_ohm <= 0.0f ||
+        p->low_soc < 0.0f || p->low_soc > 1.0f || p->full_duty_a <= 0.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg = *config;
+    battery_est_reset(&est, p);
+    status.enabled = cfg.enabled;
+    status.scale   = 1.0f;
+
+    ESP_LOGI(TAG, "Battery limit %s: %dS, floor %.2f V, initial R %.0f mOhm",
+             cfg.enabled ? "enabled" : "disabled (monitor only)",
+             p->cells, p->min_v, p->r_init_ohm * 1000.0f);
+    return ESP_OK;
+}
+
+void battery_guard_set_source(const battery_source_t *src) {
+    atomic_store(&source, src);
+    ESP_LOGI(TAG, "Voltage source: %s", src ? src->name : "none");
+}
+
+void battery_guard_update(float left_duty, float right_duty, float dt_s) {
+    const battery_params_t *p = &cfg.params;
+    const battery_source_t *src = atomic_load(&source);
+    if (src == NULL) {
+        return;
+    }
+    float volts, amps;
+    if (src->read(src->ctx, &volts, &amps) != ESP_OK) {
+        portENTER_CRITICAL(&status_lock);
+        status.errors++;
+        portEXIT_CRITICAL(&status_lock);
+        return;  // hold the last estimate and limit
+    }
+    bool measured = amps >= 0.0f;
+    if (!measured) {
+        amps = battery_amps_from_duty(p, left_duty, right_duty);
+    }
+    if (dt_s > DT_MAX_S) dt_s = DT_MAX_S;
+
+    battery_est_update(&est, p, volts, amps, dt_s);
+    scale = cfg.enabled ? est.scale : 1.0f;
+
+    battery_state_t state = battery_est_state(&est, p, cfg.enabled);
+    bool entered_limit = (state == BATTERY_LIMIT && last_state != BATTERY_LIMIT);
+    if (state != last_state) {
+        if (entered_limit) {
+            ESP_LOGW(TAG, "Battery sag: limiting output to %.0f%% (%.2f V, %.1f A, R %.0f mOhm)",
+                     est.scale * 100.0f, est.volts, est.amps, est.r_ohm * 1000.0f);
+        } else if (state == BATTERY_LOW) {
+            ESP_LOGW(TAG, "Battery low: %.0f%% (%.2f V open circuit)", est.soc * 100.0f, est.ocv);
+        } else {
+            ESP_LOGI(TAG, "Battery state: %s", battery_state_name(state));
+        }
+        last_state = state;
+    }
+
+    portENTER_CRITICAL(&status_lock);
+    status.present   = true;
+    status.measured  = measured;
+    status.state     = state;
+    status.source    = src->name;
+    status.volts     = est.volts;
+    status.amps      = est.amps;
+    status.ocv       = est.ocv;
+    status.r_ohm     = est.r_ohm;
+    status.soc       = est.soc;
+    status.limit_a   = est.limit_a;
+    status.scale     = scale;
+    status.min_volts = est.min_volts;
+    if (entered_limit) status.limits++;
+    portEXIT_CRITICAL(&status_lock);
+}
+
+float battery_guard_get_scale(void) {
+    return scale;
+}
+
+void battery_guard_get_status(battery_guard_status_t *out) {
+    portENTER_CRITICAL(&status_lock);
+    *out = status;
+    portEXIT_CRITICAL(&status_lock);
+}
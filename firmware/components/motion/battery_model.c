@@ -0,0 +1,153 @@
+/**
+ * @file battery_model.c
+ * @brief Battery estimator implementation
+ */
+
+#include "battery_model.h"
+
+#define TAU_FILTER_S    0.01f   // terminal voltage / current smoothing
+#define TAU_REGRESS_S   5.0f    // memory of the V-I regression
+#define TAU_R_S         2.0f    // R follows the regression slope
+#define TAU_OCV_S       1.0f
+#define TAU_SOC_S       30.0f
+#define MIN_VAR_A2      1.0f    // current variance needed to trust the slope
+#define R_MIN_OHM       0.005f
+#define R_MAX_OHM       1.0f
+#define RECOVER_PER_S   0.5f    // scale regained per second below the limit
+#define MIN_LOAD_A      0.1f    // below this the pack is taken as unloaded
+#define TAU_SLOPE_S     0.02f   // voltage slope smoothing
+#define LOOKAHEAD_S     0.04f   // a falling voltage is checked this far ahead
+#define SENSE_LAG_S     0.03f   // age of the readings vs the scale (sense filters)
+
+// Li-ion rest voltage per cell vs state of charge
+static const float soc_curve[][2] = {
+    {3.00f, 0.00f}, {3.30f, 0.05f}, {3.45f, 0.10f}, {3.60f, 0.25f}, {3.70f, 0.45f},
+    {3.80f, 0.65f}, {3.90f, 0.78f}, {4.00f, 0.88f}, {4.10f, 0.96f}, {4.20f, 1.00f},
+};
+#define SOC_POINTS (sizeof(soc_curve) / sizeof(soc_curve[0]))
+
+static float smooth(float dt_s, float tau_s) {
+    return dt_s / (tau_s + dt_s);
+}
+
+float battery_soc_from_cell(float cell_v) {
+    if (cell_v <= soc_curve[0][0]) {
+        return 0.0f;
+    }
+    for (unsigned i = 1; i < SOC_POINTS; i++) {
+        if (cell_v < soc_curve[i][0]) {
+            float frac = (cell_v - soc_curve[i - 1][0]) / (soc_curve[i][0] - soc_curve[i - 1][0]);
+            return soc_curve[i - 1][1] + frac * (soc_curve[i][1] - soc_curve[i - 1][1]);
+        }
+    }
+    return 1.0f;
+}
+
+void battery_est_reset(battery_est_t *b, const battery_params_t *p) {
+    *b = (battery_est_t){
+        .r_ohm = p->r_init_ohm,
+        .scale = 1.0f,
+        .scale_seen = 1.0f,
+    };
+}
+
+static void prime(battery_est_t *b, const battery_params_t *p, float volts, float amps) {
+    b->primed    = true;
+    b->volts     = volts;
+    b->amps      = amps;
+    b->ocv       = volts + b->r_ohm * amps;
+    b->soc       = battery_soc_from_cell(b->ocv / p->cells);
+    b->min_volts = volts;
+    b->m_i  = amps;
+    b->m_v  = volts;
+    b->m_ii = amps * amps;
+    b->m_iv = amps * volts;
+}
+
+/**
+ * @brief Output scale: cut at once to what the limits allow, recover slowly
+ *
+ * Load current and voltage drop are both taken as proportional to the
+ * scale in effect when they were measured (scale_seen, lagged like the
+ * readings). The current limit anticipates the floor from the estimated R;
+ * the voltage limit needs no estimate and catches the sag when R is off,
+ * looking ahead while the voltage is falling.
+ */
+static void update_scale(battery_est_t *b, const battery_params_t *p, float dt_s) {
+    float ceiling = 1.0f;
+    if (b->ocv <= p->min_v) {
+        ceiling = 0.0f;   // flat: any load pulls the pack below the floor
+    } else {
+        if (b->amps > MIN_LOAD_A) {
+            ceiling = b->scale_seen * b->limit_a / b->amps;
+        }
+        float v = b->volts + (b->slope < 0.0f ? b->slope * LOOKAHEAD_S : 0.0f);
+        if (v < p->min_v) {
+            float v_ceiling = (v < b->ocv) ? b->scale_seen * (b->ocv - p->min_v) / (b->ocv - v)
+                                           : 0.0f;
+            if (v_ceiling < ceiling) ceiling = v_ceiling;
+        }
+    }
+
+    float s = b->scale + RECOVER_PER_S * dt_s;
+    if (s > ceiling) s = ceiling;
+    if (s > 1.0f) s = 1.0f;
+    if (s < 0.0f) s = 0.0f;
+    b->scale = s;
+    b->scale_seen += (s - b->scale_seen) * smooth(dt_s, SENSE_LAG_S);
+}
+
+void battery_est_update(battery_est_t *b, const battery_params_t *p,
+                        float volts, float amps, float dt_s) {
+    if (amps < 0.0f) amps = 0.0f;   // regenerative current is not modelled
+    if (!b->primed) {
+        prime(b, p, volts, amps);
+        return;
+    }
+    if (dt_s <= 0.0f) {
+        return;
+    }
+
+    float k = smooth(dt_s, TAU_FILTER_S);
+    float prev = b->volts;
+    b->volts += (volts - b->volts) * k;
+    b->slope += ((b->volts - prev) / dt_s - b->slope) * smooth(dt_s, TAU_SLOPE_S);
+    b->amps  += (amps - b->amps) * k;
+    if (b->volts < b->min_volts) b->min_volts = b->volts;
+
+    // Slope of V against I over the last few seconds
+    k = smooth(dt_s, TAU_REGRESS_S);
+    b->m_i  += (b->amps - b->m_i) * k;
+    b->m_v  += (b->volts - b->m_v) * k;
+    b->m_ii += (b->amps * b->amps - b->m_ii) * k;
+    b->m_iv += (b->amps * b->volts - b->m_iv) * k;
+    float var = b->m_ii - b->m_i * b->m_i;
+    if (var > MIN_VAR_A2) {
+        float r = -(b->m_iv - b->m_i * b->m_v) / var;
+        if (r < R_MIN_OHM) r = R_MIN_OHM;
+        if (r > R_MAX_OHM) r = R_MAX_OHM;
+        b->r_ohm += (r - b->r_ohm) * smooth(dt_s, TAU_R_S);
+    }
+
+    b->ocv += (b->volts + b->r_ohm * b->amps - b->ocv) * smooth(dt_s, TAU_OCV_S);
+    b->soc += (battery_soc_from_cell(b->ocv / p->cells) - b->soc) * smooth(dt_s, TAU_SOC_S);
+
+    b->limit_a = (b->ocv > p->min_v) ? (b->ocv - p->min_v) / b->r_ohm : 0.0f;
+    update_scale(b, p, dt_s);
+}
+
+battery_state_t battery_est_state(const battery_est_t *b, const battery_params_t *p,
+                                  bool limiting) {
+    if (limiting && b->scale < 0.999f) {
+        return BATTERY_LIMIT;
+    }
+    return (b->primed && b->soc < p->low_soc) ? BATTERY_LOW : BATTERY_OK;
+}
+
+const char *battery_state_name(battery_state_t state) {
+    switch (state) {
+        case BATTERY_LOW:   return "low";
+        case BATTERY_LIMIT: return "limit";
+        default:            return "ok";
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * @file battery_guard.h
+ * @brief Battery monitor and load-aware output limit (after thermal derating)
+ *
+ * Runs a battery_model estimator inside the control tick on the pack
+ * voltage (and current, where measured) from a registered source. When a
+ * load would pull the pack below the voltage floor, where the regulator
+ * feeding the ESP32 browns out, the output of both tracks is scaled down by
+ * the same factor, like thermal derating, and released gradually once the
+ * load allows. The scale is combined with the thermal one and applied by
+ * speed_ctrl_run() as a duty limit, so closed-loop speed control cannot
+ * wind a stalled track back up past it.
+ *
+ * Without a source the stage reports "not present" and passes the output
+ * through unchanged.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "battery_model.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Pack voltage source
+ *
+ * read() is called from the control task once per tick and must not block.
+ * Sets *amps to the pack current, or to a negative value when the current is
+ * not measured (it is then estimated from the duty).
+ */
+typedef struct {
+    const char *name;  ///< Shown in logs and /status
+    esp_err_t (*read)(void *ctx, float *volts, float *amps);
+    void *ctx;         ///< Passed to read()
+} battery_source_t;
+
+/**
+ * @brief Stage configuration
+ */
+typedef struct {
+    bool             enabled;  ///< Limit output (the estimator runs and reports either way)
+    battery_params_t params;
+} battery_guard_config_t;
+
+/**
+ * @brief Stage snapshot
+ */
+typedef struct {
+    bool             enabled;
+    bool             present;      ///< Source registered and read successfully
+    bool             measured;     ///< Current measured (else estimated from duty)
+    battery_state_t  state;
+    const char      *source;       ///< Source name, or NULL
+    float            volts;        ///< Filtered terminal voltage
+    float            amps;         ///< Filtered pack current
+    float            ocv;          ///< Open-circuit voltage estimate
+    float            r_ohm;        ///< Internal resistance estimate
+    float            soc;          ///< State of charge (0 to 1)
+    float            limit_a;      ///< Current that holds the floor
+    float            scale;        ///< Output scale applied to both tracks
+    float            min_volts;    ///< Lowest voltage since boot
+    uint32_t         limits;       ///< Entries into BATTERY_LIMIT
+    uint32_t         errors;       ///< Failed source reads
+} battery_guard_status_t;
+
+/**
+ * @brief Initialise the stage
+ *
+ * @param config Configuration (copied)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for NULL or
+ *         parameters out of range
+ */
+esp_err_t battery_guard_init(const battery_guard_config_t *config);
+
+/**
+ * @brief Register (or with NULL, remove) the pack voltage source
+ *
+ * @param source Source; must stay valid while registered
+ */
+void battery_guard_set_source(const battery_source_t *source);
+
+/**
+ * @brief Feed one tick
+ *
+ * Called by the control task every tick, armed or not.
+ *
+ * @param left_duty  Duty applied to the left track over the last tick
+ * @param right_duty Duty applied to the right track over the last tick
+ * @param dt_s       Time since the previous tick, seconds
+ */
+void battery_guard_update(float left_duty, float right_duty, float dt_s);
+
+/**
+ * @brief Current limit, for speed_ctrl_run()'s output limit
+ *
+ * @return float Output scale, 1.0 (none) down to 0.0
+ */
+float battery_guard_get_scale(void);
+
+/**
+ * @brief Get a consistent snapshot of the stage
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void battery_guard_get_status(battery_guard_status_t *out);
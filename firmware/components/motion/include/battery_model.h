@@ -0,0 +1,112 @@
+/**
+ * @file battery_model.h
+ * @brief Battery estimator: internal resistance, open-circuit voltage, SoC
+ *        and the output limit that holds the pack above a voltage floor
+ *
+ * Pure C with no RTOS or IDF dependencies, so it can be run on the host
+ * against recorded voltage traces (tools/battery_sim.c).
+ *
+ * The pack is modelled as an open-circuit voltage E behind an internal
+ * resistance R (cells, wiring, connectors):
+ *
+ *   V = E - R * I
+ *
+ * R is the slope of an exponentially weighted regression of V against I,
+ * updated only while the current varies enough to make the slope
+ * meaningful. E follows V + R * I, and state of charge is looked up from
+ * E per cell on a Li-ion rest-voltage curve.
+ *
+ * The current that keeps the terminal voltage at the floor is
+ * (E - min_v) / R. The output scale is cut at once when the pack draws
+ * more (the load current is taken as proportional to the scale) and
+ * recovers slowly otherwise. As a backstop against a wrong estimate, a
+ * voltage below the floor (extrapolated a little ahead while it falls)
+ * also cuts the scale, in proportion to how far the sag overshoots the
+ * allowed drop E - min_v.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Estimator parameters
+ */
+typedef struct {
+    int   cells;          ///< Series Li-ion cells (3 for a 12 V pack)
+    float min_v;          ///< Pack voltage to hold under load (brownout floor)
+    float r_init_ohm;     ///< Internal resistance until the estimate converges
+    float low_soc;        ///< State of charge reported as low (0 to 1)
+    float full_duty_a;    ///< Assumed current per track at full duty when none is measured
+} battery_params_t;
+
+/**
+ * @brief Battery state
+ */
+typedef enum {
+    BATTERY_OK = 0,   ///< Full output
+    BATTERY_LOW,      ///< State of charge below low_soc
+    BATTERY_LIMIT,    ///< Output limited to hold the voltage floor
+} battery_state_t;
+
+/**
+ * @brief Estimator state
+ */
+typedef struct {
+    bool  primed;       ///< First sample seen
+    float volts;        ///< Filtered terminal voltage
+    float amps;         ///< Filtered pack current
+    float ocv;          ///< Open-circuit voltage estimate E
+    float r_ohm;        ///< Internal resistance estimate R
+    float soc;          ///< State of charge (0 to 1)
+    float limit_a;      ///< Current that holds the floor
+    float scale;        ///< Output scale (1 = no limiting)
+    float scale_seen;   ///< Scale lagged to match the readings
+    float slope;        ///< Voltage slope, V/s
+    float min_volts;    ///< Lowest filtered voltage seen
+    // Exponentially weighted moments of I and V for the regression
+    float m_i, m_v, m_ii, m_iv;
+} battery_est_t;
+
+/**
+ * @brief Pack current assumed for the track duties when none is measured
+ */
+static inline float battery_amps_from_duty(const battery_params_t *p, float left, float right) {
+    return ((left < 0.0f ? -left : left) + (right < 0.0f ? -right : right)) * p->full_duty_a;
+}
+
+/**
+ * @brief Reset the estimator; the first update primes it
+ */
+void battery_est_reset(battery_est_t *b, const battery_params_t *p);
+
+/**
+ * @brief Feed one sample
+ *
+ * @param b     Estimator state
+ * @param p     Parameters
+ * @param volts Pack terminal voltage
+ * @param amps  Pack current (measured, or battery_amps_from_duty())
+ * @param dt_s  Time since the previous sample, seconds
+ */
+void battery_est_update(battery_est_t *b, const battery_params_t *p,
+                        float volts, float amps, float dt_s);
+
+/**
+ * @brief State for the current estimate
+ *
+ * @param limiting The output is scaled by b->scale; without that the state
+ *                 is never BATTERY_LIMIT, however deep the sag
+ */
+battery_state_t battery_est_state(const battery_est_t *b, const battery_params_t *p,
+                                  bool limiting);
+
+/**
+ * @brief State of charge (0 to 1) for a rested cell voltage
+ */
+float battery_soc_from_cell(float cell_v);
+
+/**
+ * @brief Name of a state ("ok", "low", "limit")
+ */
+const char *battery_state_name(battery_state_t state);
@@ -7,6 +7,30 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MIXER_DEADZONE_MAX       0.5f  ///< Upper bound accepted for mixer_config_t.deadzone
+#define MIXER_PIVOT_THROTTLE_MAX 0.5f  ///< Upper bound accepted for mixer_config_t.pivot_throttle
+
+/**
+ * @brief What to do when throttle + steering exceeds full speed on a track
+ */
+typedef enum {
+    MIXER_DESAT_CLAMP = 0,       ///< Clamp each track independently (turn flattens at speed)
+    MIXER_DESAT_NORMALIZE,       ///< Scale both tracks by the larger one (keeps the turn ratio)
+    MIXER_DESAT_STEER_PRIORITY,  ///< Give up throttle before steering (keeps the track speed difference)
+    MIXER_DESAT_COUNT,
+} mixer_desat_t;
+
+/**
+ * @brief How steering maps to the track speed difference
+ */
+typedef enum {
+    MIXER_TURN_ARCADE = 0,  ///< Steering adds a fixed difference; pivots whenever throttle is zero
+    MIXER_TURN_CURVATURE,   ///< Steering sets curvature (scaled by |throttle|); tank pivot only below pivot_throttle
+    MIXER_TURN_COUNT,
+} mixer_turn_t;
 
 /**
  * @brief Mixer configuration
@@ -16,6 +40,9 @@ typedef struct {
     float expo;             ///< Expo curve (0.0 to 1.0, e.g., 0.3 = 30%)
     float max_speed;        ///< Max speed limit (0.0 to 1.0)
     float slow_mode_factor; ///< Slow mode multiplier (0.0 to 1.0)
+    mixer_desat_t desat;    ///< Saturation handling
+    mixer_turn_t  turn;     ///< Steering model
+    float pivot_throttle;   ///< MIXER_TURN_CURVATURE: |throttle| below which pivoting fades in (0.0 to 0.5)
 } mixer_config_t;
 
 /**
@@ -26,8 +53,68 @@ typedef struct {
  */
 esp_err_t mixer_diffdrive_init(const mixer_config_t *config);
 
+/**
+ * @brief Replace the mixer configuration at runtime
+ *
+ * Builds the new configuration (and Q15 table) off to the side and swaps it
+ * in atomically; the next mixer_diffdrive_mix() uses it. Mixing is never
+ * blocked, but this call may sleep for a tick while mixes that started on
+ * the old configuration finish. Call from a task, not an ISR.
+ *
+ * @param config New configuration
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for an
+ *         out-of-range value, ESP_ERR_INVALID_STATE before init
+ */
+esp_err_t mixer_diffdrive_set_config(const mixer_config_t *config);
+
+/**
+ * @brief Copy the configuration currently in use
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void mixer_diffdrive_get_config(mixer_config_t *out);
+
+/**
+ * @brief Desaturation mode name for logs and JSON
+ */
+const char *mixer_diffdrive_desat_name(mixer_desat_t mode);
+
+/**
+ * @brief Turn model name for logs and JSON
+ */
+const char *mixer_diffdrive_turn_name(mixer_turn_t mode);
+
+/**
+ * @brief Number of runtime configuration swaps since init
+ */
+uint32_t mixer_diffdrive_get_generation(void);
+
+/**
+ * @brief Per-axis response curve: deadzone, then expo (no max_speed)
+ *
+ * @param value  Stick value (-1.0 to +1.0)
+ * @param config Mixer configuration
+ * @return float Shaped value (-1.0 to +1.0)
+ */
+float mixer_diffdrive_response(float value, const mixer_config_t *config);
+
+/**
+ * @brief Steering gain applied in MIXER_TURN_CURVATURE mode
+ *
+ * |throttle| at or above @p pivot_throttle; below it the gain rises
+ * linearly to 1.0 at zero throttle, so the robot can still pivot in place.
+ *
+ * @param abs_throttle   |throttle| after deadzone and expo (0.0 to 1.0)
+ * @param pivot_throttle Pivot band (0 disables pivoting)
+ */
+float mixer_diffdrive_curvature_gain(float abs_throttle, float pivot_throttle);
+
 /**
  * @brief Mix throttle and steering into left/right motor speeds
+ *
+ * Deadzone and expo, then the turn model, then desaturation, then
+ * max_speed and slow mode. Uses the float path, or the Q15 lookup-table
+ * path (mixer_q15.h) when CONFIG_ROBOT_MIXER_BACKEND_Q15 is set.
  * 
  * @param throttle Throttle input (-1.0 to +1.0)
  * @param steering Steering input (-1.0 to +1.0)
@@ -38,3 +125,44 @@ esp_err_t mixer_diffdrive_init(const mixer_config_t *config);
  */
 esp_err_t mixer_diffdrive_mix(float throttle, float steering, bool slow_mode,
                                float *left_out, float *right_out);
+
+/**
+ * @brief Float transfer function for an explicit configuration
+ *
+ * What mixer_diffdrive_mix() runs on the float backend, without the active
+ * configuration lookup or argument checks. Pure; safe on the host.
+ *
+ * @param config    Mixer configuration
+ * @param throttle  Throttle input (-1.0 to +1.0)
+ * @param steering  Steering input (-1.0 to +1.0)
+ * @param slow_mode Enable slow mode
+ * @param left_out  Output: left motor speed
+ * @param right_out Output: right motor speed
+ */
+void mixer_diffdrive_mix_float(const mixer_config_t *config, float throttle, float steering,
+                               bool slow_mode, float *left_out, float *right_out);
+
+/**
+ * @brief Mix a batch of samples, structure-of-arrays in and out
+ *
+ * Same transfer function as mixer_diffdrive_mix_float() (to float rounding),
+ * written branch-free so the loop auto-vectorises on the host (build with
+ * -O3 -fno-trapping-math, plus -march for AVX; without -fno-trapping-math
+ * GCC only vectorises the selects where it has masked stores, e.g.
+ * AVX-512). Meant for replaying recorded drives and
+ * sweeping tuning grids; runs as a plain loop on Xtensa. The arrays must not
+ * overlap. Pure; safe on the host.
+ *
+ * @param config    Mixer configuration
+ * @param throttle  Throttle inputs (-1.0 to +1.0), @p count entries
+ * @param steering  Steering inputs (-1.0 to +1.0), @p count entries
+ * @param slow_mode Per-sample slow mode flags (0 or 1), or NULL for none
+ * @param count     Number of samples
+ * @param left_out  Output: left motor speeds, @p count entries
+ * @param right_out Output: right motor speeds, @p count entries
+ */
+void mixer_diffdrive_mix_batch(const mixer_config_t *config,
+                               const float *restrict throttle,
+                               const float *restrict steering,
+                               const uint8_t *restrict slow_mode, size_t count,
+                               float *restrict left_out, float *restrict right_out);
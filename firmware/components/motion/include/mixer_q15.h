@@ -0,0 +1,94 @@
+/**
+ * @file mixer_q15.h
+ * @brief Fixed-point (Q15) differential drive mixer
+ *
+ * Same transfer function as mixer_diffdrive_mix(), but deadzone and expo are
+ * baked into an interpolated lookup table when the mixer is configured, so a
+ * mix is a handful of integer operations: no floats, no logging, and one
+ * integer division only when MIXER_DESAT_NORMALIZE has to scale. Safe to
+ * call from an ISR or a 1 kHz loop.
+ *
+ * Q15: 32768 = 1.0. Inputs and outputs are clamped to [-32767, +32767].
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "mixer_diffdrive.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MIXER_Q15_ONE 32768
+
+#ifdef CONFIG_ROBOT_MIXER_Q15_LUT_BITS
+#define MIXER_Q15_LUT_BITS CONFIG_ROBOT_MIXER_Q15_LUT_BITS
+#else
+#define MIXER_Q15_LUT_BITS 8
+#endif
+#define MIXER_Q15_LUT_SIZE (1 << MIXER_Q15_LUT_BITS)  ///< Intervals in the response table
+
+/**
+ * @brief Precomputed Q15 mixer table
+ *
+ * Read-only once built, so a table can be shared between tasks and ISRs as
+ * long as it is not rebuilt underneath them.
+ */
+typedef struct {
+    int16_t lut[MIXER_Q15_LUT_SIZE + 1]; ///< response(|x|)
+    int32_t deadzone_q15;                ///< |x| below this is zero
+    int32_t scale_q15[2];                ///< Output scale, Q15: [0] max_speed, [1] max_speed * slow_mode_factor
+    int32_t pivot_q15;                   ///< pivot_throttle, Q15
+    int32_t pivot_slope_q15;             ///< Curvature gain slope inside the pivot band, Q15
+    mixer_desat_t desat;                 ///< Saturation handling
+    mixer_turn_t  turn;                  ///< Steering model
+} mixer_q15_table_t;
+
+/**
+ * @brief Build a response-curve table from a float configuration
+ *
+ * @param table  Table to fill; must not be in use by mixer_q15_mix()
+ * @param config Mixer configuration
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for NULL
+ */
+esp_err_t mixer_q15_build(mixer_q15_table_t *table, const mixer_config_t *config);
+
+/**
+ * @brief Mix Q15 throttle and steering into Q15 left/right speeds
+ *
+ * @param table     Table from mixer_q15_build()
+ * @param throttle  Throttle, Q15
+ * @param steering  Steering, Q15
+ * @param slow_mode Apply the slow-mode factor
+ * @param left_out  Output: left speed, Q15
+ * @param right_out Output: right speed, Q15
+ */
+void mixer_q15_mix(const mixer_q15_table_t *table, int32_t throttle, int32_t steering,
+                   bool slow_mode, int32_t *left_out, int32_t *right_out);
+
+/**
+ * @brief Convert a float in [-1.0, +1.0] to Q15 (clamped)
+ */
+static inline int32_t mixer_q15_from_float(float value) {
+    int32_t q = (int32_t)(value * (float)MIXER_Q15_ONE + (value >= 0.0f ? 0.5f : -0.5f));
+    if (q > MIXER_Q15_ONE - 1) q = MIXER_Q15_ONE - 1;
+    if (q < -(MIXER_Q15_ONE - 1)) q = -(MIXER_Q15_ONE - 1);
+    return q;
+}
+
+/**
+ * @brief Convert a Q15 speed to a float
+ */
+static inline float mixer_q15_to_float(int32_t q) {
+    return (float)q / (float)MIXER_Q15_ONE;
+}
+
+/**
+ * @brief Convert a Q15 speed to a signed LEDC duty
+ *
+ * @param q        Speed, Q15
+ * @param max_duty Full-scale duty (pwm_ledc_get_max_duty())
+ * @return Duty magnitude with the sign of @p q
+ */
+static inline int32_t mixer_q15_to_duty(int32_t q, uint32_t max_duty) {
+    return (int32_t)(((int64_t)q * (int64_t)max_duty) >> 15);
+}
@@ -0,0 +1,103 @@
+/**
+ * @file speed_ctrl.h
+ * @brief Closed-loop track speed stage (between the mixer and the motor layer)
+ *
+ * Runs one speed_pid controller per track inside the control tick. The mixer
+ * output is taken as a target track speed and replaced by the duty command.
+ * Measured speed comes from a registered feedback source (encoders, a
+ * current-sense estimate, ...). With the stage disabled, or no source
+ * registered, or a failed read, targets pass through unchanged: the same
+ * open-loop behaviour as without this stage.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "speed_pid.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Velocity feedback source
+ *
+ * read() is called from the control task once per tick and must not block.
+ * Speeds use the controller's normalisation (1.0 = no-load speed at full
+ * duty), positive forward.
+ */
+typedef struct {
+    const char *name;  ///< Shown in logs and /status
+    esp_err_t (*read)(void *ctx, float *left, float *right);
+    void *ctx;         ///< Passed to read()
+} speed_feedback_t;
+
+/**
+ * @brief Stage configuration
+ */
+typedef struct {
+    bool              enabled;  ///< Close the loop when a feedback source is registered
+    speed_pid_gains_t gains;    ///< Gains, shared by both tracks
+} speed_ctrl_config_t;
+
+/**
+ * @brief Per-track snapshot
+ */
+typedef struct {
+    float target;    ///< Target speed from the mixer
+    float measured;  ///< Last measured speed (0 when open loop)
+    float output;    ///< Duty command sent to the motor layer
+    float integ;     ///< Integral term
+} speed_ctrl_track_t;
+
+/**
+ * @brief Stage snapshot
+ */
+typedef struct {
+    bool               closed_loop;    ///< Last tick ran the controllers
+    const char        *feedback;       ///< Registered source name, or NULL
+    uint32_t           read_errors;    ///< Feedback reads that failed (tick ran open loop)
+    uint32_t           saturated;      ///< Ticks with a track output at the limit
+    speed_ctrl_track_t left;
+    speed_ctrl_track_t right;
+} speed_ctrl_status_t;
+
+/**
+ * @brief Initialise the stage
+ *
+ * @param config Configuration (copied)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for NULL
+ */
+esp_err_t speed_ctrl_init(const speed_ctrl_config_t *config);
+
+/**
+ * @brief Register (or with NULL, remove) the velocity feedback source
+ *
+ * @param source Source; must stay valid while registered
+ */
+void speed_ctrl_set_feedback(const speed_feedback_t *source);
+
+/**
+ * @brief Turn target speeds into duty commands, in place
+ *
+ * Called by the control task once per tick while armed. @p limit is the
+ * output scale from the thermal and battery guards. Open loop it scales the
+ * targets; closed loop it also caps the PID output (see
+ * speed_pid_update_limited()), so either way |duty| <= limit.
+ *
+ * @param left  In: target speed, out: duty command
+ * @param right In: target speed, out: duty command
+ * @param limit Output scale for this tick (0.0 to 1.0)
+ * @param dt_s  Time since the previous tick, seconds
+ */
+void speed_ctrl_run(float *left, float *right, float limit, float dt_s);
+
+/**
+ * @brief Clear controller state (called while disarmed)
+ */
+void speed_ctrl_reset(void);
+
+/**
+ * @brief Get a consistent snapshot of the stage
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void speed_ctrl_get_status(speed_ctrl_status_t *out);
@@ -0,0 +1,91 @@
+/**
+ * @file speed_pid.h
+ * @brief Per-track PI(D) velocity controller with feed-forward
+ *
+ * Pure C with no RTOS or IDF dependencies, so it can be tuned on the host
+ * against a simulated motor (tools/speed_ctrl_sim.c).
+ *
+ * Speeds and outputs are normalised: 1.0 is the no-load track speed at full
+ * duty, and the output is the duty command fed to the motor layer.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Controller gains
+ */
+typedef struct {
+    float kp;           ///< Proportional gain (duty per unit speed error)
+    float ki;           ///< Integral gain (duty per unit speed error per second)
+    float kd;           ///< Derivative gain on measurement (duty per unit speed per second)
+    float kff;          ///< Feed-forward: duty per unit target speed (1.0 = ideal unloaded motor)
+    float kstatic;      ///< Static-friction offset added in the direction of a non-zero target
+    float d_cutoff_hz;  ///< Derivative low-pass cutoff (0 = unfiltered)
+    float out_limit;    ///< Output clamp (normally 1.0)
+} speed_pid_gains_t;
+
+/**
+ * @brief Controller state for one track
+ */
+typedef struct {
+    float integ;      ///< Integral term (already scaled by ki)
+    float prev_meas;  ///< Previous measurement, for the derivative
+    float d_filt;     ///< Filtered derivative term
+    float output;     ///< Last output
+    bool  primed;     ///< prev_meas is valid
+    bool  saturated;  ///< Last output hit out_limit
+} speed_pid_t;
+
+/**
+ * @brief Clear the integrator and derivative history
+ */
+void speed_pid_reset(speed_pid_t *pid);
+
+/**
+ * @brief Run one controller step
+ *
+ * Anti-windup: the integrator does not move further into saturation while
+ * the output is clamped, and is itself bounded by out_limit.
+ *
+ * @param pid      Controller state
+ * @param gains    Gains
+ * @param target   Target speed (-1.0 to +1.0)
+ * @param measured Measured speed
+ * @param dt_s     Time since the previous step, seconds (> 0)
+ * @return float   Duty command (-out_limit to +out_limit)
+ */
+float speed_pid_update(speed_pid_t *pid, const speed_pid_gains_t *gains,
+                       float target, float measured, float dt_s);
+
+/**
+ * @brief Run one controller step under an output limit for this step
+ *
+ * For the thermal and battery guards. The target is scaled by @p limit, so
+ * both tracks slow by the same factor and the path is kept, and the output
+ * clamp (with its anti-windup) is lowered to limit * out_limit. A stalled
+ * track therefore cannot wind the integrator up past the limit and drive
+ * full duty anyway.
+ *
+ * @param limit Output scale for this step (0.0 to 1.0; 0 = output off)
+ * @return float Duty command (-limit * out_limit to +limit * out_limit)
+ */
+float speed_pid_update_limited(speed_pid_t *pid, const speed_pid_gains_t *gains,
+                               float target, float measured, float limit, float dt_s);
+
+/**
+ * @brief Track speed estimated from the applied duty and the track current
+ *
+ * The back-EMF is the applied voltage less the armature's I * R drop, so
+ * speed = duty - amps * r_ohm / volts in the direction of the duty. The
+ * current sense reads magnitude only, so the drop is taken to oppose the
+ * drive (motoring, not braking), and the estimate never crosses zero.
+ *
+ * @param duty   Duty applied (-1.0 to +1.0)
+ * @param amps   Track current magnitude, A
+ * @param r_ohm  Armature resistance, plus bridge and wiring
+ * @param volts  Supply voltage (<= 0 returns @p duty)
+ * @return float Normalised speed
+ */
+float speed_pid_emf_estimate(float duty, float amps, float r_ohm, float volts);
@@ -0,0 +1,100 @@
+/**
+ * @file thermal_guard.h
+ * @brief Thermal derating stage (between the mixer and speed control)
+ *
+ * Runs a thermal_model per track inside the control tick. Load is the
+ * measured track current from a registered source (current sense), or an
+ * estimate from the applied duty without one. As either track heats up the
+ * mixer output of both tracks is scaled down by the same factor, which
+ * keeps the robot's path while it slows: the effect of lowering max_speed.
+ * At the cutoff the output is zero until the hot track has cooled.
+ *
+ * The scale is applied by speed_ctrl_run() as an output limit rather than
+ * to the mixer output alone: with speed control closed, a scaled target on
+ * a stalled track would just wind the integrator up to full duty.
+ *
+ * The model keeps integrating while disarmed or stopped, so parts cool
+ * down in the background.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "thermal_model.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Track current source
+ *
+ * read() is called from the control task once per tick and must not block.
+ * Currents are in amps, either sign.
+ */
+typedef struct {
+    const char *name;  ///< Shown in logs and /status
+    esp_err_t (*read)(void *ctx, float *left_a, float *right_a);
+    void *ctx;         ///< Passed to read()
+} thermal_current_t;
+
+/**
+ * @brief Stage configuration
+ */
+typedef struct {
+    bool             enabled;  ///< Derate (the model runs and reports either way)
+    thermal_params_t params;
+} thermal_guard_config_t;
+
+/**
+ * @brief Stage snapshot
+ */
+typedef struct {
+    bool             enabled;
+    thermal_state_t  state;        ///< Worse of the two tracks
+    float            scale;        ///< Output scale applied to both tracks
+    const char      *source;       ///< Current source name, or NULL (duty estimate)
+    thermal_track_t  left;
+    thermal_track_t  right;
+    uint32_t         warnings;     ///< Entries into THERMAL_WARN
+    uint32_t         cutoffs;      ///< Entries into THERMAL_CUTOFF
+} thermal_guard_status_t;
+
+/**
+ * @brief Initialise the stage
+ *
+ * @param config Configuration (copied)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG for NULL or
+ *         parameters out of range
+ */
+esp_err_t thermal_guard_init(const thermal_guard_config_t *config);
+
+/**
+ * @brief Register (or with NULL, remove) the track current source
+ *
+ * @param source Source; must stay valid while registered
+ */
+void thermal_guard_set_current(const thermal_current_t *source);
+
+/**
+ * @brief Integrate one tick of load
+ *
+ * Called by the control task every tick, armed or not.
+ *
+ * @param left_duty  Duty applied to the left track over the last tick
+ * @param right_duty Duty applied to the right track over the last tick
+ * @param dt_s       Time since the previous tick, seconds
+ */
+void thermal_guard_update(float left_duty, float right_duty, float dt_s);
+
+/**
+ * @brief Current derating, for speed_ctrl_run()'s output limit
+ *
+ * @return float Output scale, 1.0 (none) down to 0.0 (cutoff)
+ */
+float thermal_guard_get_scale(void);
+
+/**
+ * @brief Get a consistent snapshot of the stage
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void thermal_guard_get_status(thermal_guard_status_t *out);
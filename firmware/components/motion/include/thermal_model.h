@@ -0,0 +1,86 @@
+/**
+ * @file thermal_model.h
+ * @brief First-order I²t thermal model for one track (motor + H-bridge)
+ *
+ * Pure C with no RTOS or IDF dependencies, so the derating curve can be
+ * checked on the host (tools/thermal_sim.c).
+ *
+ * Each part is a single thermal mass heated by I² and cooling towards
+ * ambient with time constant tau:
+ *
+ *   heat += ((I / limit_a)² - heat) * dt / tau
+ *
+ * heat is normalised so that running continuously at limit_a settles at
+ * 1.0, the cutoff. The motor (wiper motor windings, minutes) and the bridge
+ * (BTS7960 die and board, tens of seconds) each have their own limit and
+ * time constant; the hotter of the two sets the derating.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @brief Model parameters (shared by both tracks)
+ */
+typedef struct {
+    float motor_tau_s;     ///< Motor thermal time constant
+    float motor_limit_a;   ///< Motor current that settles at the cutoff
+    float bridge_tau_s;    ///< H-bridge thermal time constant
+    float bridge_limit_a;  ///< H-bridge current that settles at the cutoff
+    float full_duty_a;     ///< Assumed current at full duty when none is measured
+    float derate_start;    ///< Heat where derating starts (0 to 1)
+    float min_scale;       ///< Output scale just below the cutoff (0 to 1)
+    float resume;          ///< Heat a cutoff must cool below to release (0 to derate_start)
+} thermal_params_t;
+
+/**
+ * @brief Thermal state of a track
+ */
+typedef enum {
+    THERMAL_OK = 0,   ///< Below derate_start: full output
+    THERMAL_WARN,     ///< Derating
+    THERMAL_CUTOFF,   ///< Heat reached 1.0: output 0 until cooled below resume
+} thermal_state_t;
+
+/**
+ * @brief Model state for one track
+ */
+typedef struct {
+    float motor;    ///< Motor heat (1.0 = cutoff)
+    float bridge;   ///< Bridge heat (1.0 = cutoff)
+    bool  cutoff;   ///< Cutoff latched
+} thermal_track_t;
+
+/**
+ * @brief Current assumed for a duty when no measurement is available
+ */
+static inline float thermal_amps_from_duty(const thermal_params_t *p, float duty) {
+    return (duty < 0.0f ? -duty : duty) * p->full_duty_a;
+}
+
+/**
+ * @brief Integrate one step of load
+ *
+ * @param t     Track state
+ * @param p     Parameters
+ * @param amps  Track current (measured, or thermal_amps_from_duty())
+ * @param dt_s  Time since the previous step, seconds
+ */
+void thermal_track_update(thermal_track_t *t, const thermal_params_t *p,
+                          float amps, float dt_s);
+
+/**
+ * @brief Output scale for the track's current heat (1.0 = no derating, 0 = cutoff)
+ */
+float thermal_track_scale(const thermal_track_t *t, const thermal_params_t *p);
+
+/**
+ * @brief State of the track for its current heat
+ */
+thermal_state_t thermal_track_state(const thermal_track_t *t, const thermal_params_t *p);
+
+/**
+ * @brief Name of a state ("ok", "warn", "cutoff")
+ */
+const char *thermal_state_name(thermal_state_t state);
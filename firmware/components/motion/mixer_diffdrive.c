@@ -1,102 +1,147 @@
 /**
  * @file mixer_diffdrive.c
  * @brief Differential drive mixer implementation
+ *
+ * The configuration and its Q15 table live in one of two state buffers. The
+ * mixer reads whichever one `active` points at; mixer_diffdrive_set_config()
+ * fills the other, publishes it with a single pointer store and then waits
+ * until no mix started before the swap is still running (RCU grace period),
+ * after which the old buffer is free for the next update. Mixing never takes
+ * a lock and never sees a half-written configuration.
  */
 
 #include "mixer_diffdrive.h"
+#include "mixer_q15.h"
 #include "esp_log.h"
-#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdatomic.h>
 
 static const char *TAG = "mixer";
 
-static mixer_config_t mixer_cfg;
+typedef struct {
+    mixer_config_t    cfg;
+    mixer_q15_table_t q15;
+} mixer_state_t;
 
-/**
- * @brief Apply deadzone
- */
-static float apply_deadzone(float value, float deadzone) {
-    if (fabsf(value) < deadzone) {
-        return 0.0f;
-    }
-    // Scale remaining range
-    float sign = (value > 0.0f) ? 1.0f : -1.0f;
-    return sign * (fabsf(value) - deadzone) / (1.0f - deadzone);
-}
+static mixer_state_t states[2];
+static _Atomic(mixer_state_t *) active;
+static atomic_uint mix_readers;            // mixes in progress
+static atomic_uint config_generation;
+static SemaphoreHandle_t writer_lock;      // serialises set_config callers
 
-/**
- * @brief Apply expo curve
- * 
- * Expo gives finer control near center, more aggressive at extremes.
- * Formula: output = expo * value^3 + (1 - expo) * value
- */
-static float apply_expo(float value, float expo) {
-    float cubic = value * value * value;
-    return expo * cubic + (1.0f - expo) * value;
-}
-
-/**
- * @brief Clamp value to [-1.0, +1.0]
- */
-static float clamp(float value) {
-    if (value > 1.0f) return 1.0f;
-    if (value < -1.0f) return -1.0f;
-    return value;
+static bool config_valid(const mixer_config_t *c) {
+    return c->deadzone >= 0.0f && c->deadzone <= MIXER_DEADZONE_MAX &&
+           c->expo >= 0.0f && c->expo <= 1.0f &&
+           c->max_speed >= 0.0f && c->max_speed <= 1.0f &&
+           c->slow_mode_factor >= 0.0f && c->slow_mode_factor <= 1.0f &&
+           (unsigned)c->desat < MIXER_DESAT_COUNT &&
+           (unsigned)c->turn < MIXER_TURN_COUNT &&
+           c->pivot_throttle >= 0.0f && c->pivot_throttle <= MIXER_PIVOT_THROTTLE_MAX;
 }
 
 esp_err_t mixer_diffdrive_init(const mixer_config_t *config) {
-    if (config == NULL) {
-        ESP_LOGE(TAG, "NULL config");
+    if (config == NULL || !config_valid(config)) {
+        ESP_LOGE(TAG, "Invalid config");
         return ESP_ERR_INVALID_ARG;
     }
-    
-    mixer_cfg = *config;
+
+    writer_lock = xSemaphoreCreateMutex();
+    if (writer_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    mixer_state_t *st = &states[0];
+    st->cfg = *config;
+    mixer_q15_build(&st->q15, &st->cfg);
+    atomic_init(&mix_readers, 0);
+    atomic_init(&config_generation, 0);
+    atomic_store(&active, st);
+    const mixer_config_t *mixer_cfg = &st->cfg;
     
     ESP_LOGI(TAG, "Differential drive mixer initialized");
-    ESP_LOGI(TAG, "  Deadzone: %.1f%%", mixer_cfg.deadzone * 100.0f);
-    ESP_LOGI(TAG, "  Expo: %.1f%%", mixer_cfg.expo * 100.0f);
-    ESP_LOGI(TAG, "  Max speed: %.1f%%", mixer_cfg.max_speed * 100.0f);
-    ESP_LOGI(TAG, "  Slow mode factor: %.1f%%", mixer_cfg.slow_mode_factor * 100.0f);
+#ifdef CONFIG_ROBOT_MIXER_BACKEND_Q15
+    ESP_LOGI(TAG, "  Backend: Q15 lookup table (%d entries)", MIXER_Q15_LUT_SIZE);
+#else
+    ESP_LOGI(TAG, "  Backend: float");
+#endif
+    ESP_LOGI(TAG, "  Deadzone: %.1f%%", mixer_cfg->deadzone * 100.0f);
+    ESP_LOGI(TAG, "  Expo: %.1f%%", mixer_cfg->expo * 100.0f);
+    ESP_LOGI(TAG, "  Max speed: %.1f%%", mixer_cfg->max_speed * 100.0f);
+    ESP_LOGI(TAG, "  Slow mode factor: %.1f%%", mixer_cfg->slow_mode_factor * 100.0f);
+    ESP_LOGI(TAG, "  Desaturation: %s", mixer_diffdrive_desat_name(mixer_cfg->desat));
+    ESP_LOGI(TAG, "  Turn model: %s (pivot below %.0f%%)", mixer_diffdrive_turn_name(mixer_cfg->turn),
+             mixer_cfg->pivot_throttle * 100.0f);
     
     return ESP_OK;
 }
 
+esp_err_t mixer_diffdrive_set_config(const mixer_config_t *config) {
+    if (config == NULL || !config_valid(config)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (writer_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(writer_lock, portMAX_DELAY);
+
+    // The spare buffer is unused: the previous update waited out its readers
+    mixer_state_t *old = atomic_load(&active);
+    mixer_state_t *next = (old == &states[0]) ? &states[1] : &states[0];
+    next->cfg = *config;
+    mixer_q15_build(&next->q15, &next->cfg);
+
+    atomic_store(&active, next);
+    atomic_fetch_add(&config_generation, 1);
+
+    // Grace period: a mix that loaded `old` has bumped mix_readers first
+    while (atomic_load(&mix_readers) != 0) {
+        vTaskDelay(1);
+    }
+
+    xSemaphoreGive(writer_lock);
+
+    ESP_LOGI(TAG, "Config applied: deadzone=%.0f%% expo=%.0f%% max_speed=%.0f%% slow=%.0f%% "
+             "desat=%s turn=%s pivot=%.0f%%",
+             config->deadzone * 100.0f, config->expo * 100.0f,
+             config->max_speed * 100.0f, config->slow_mode_factor * 100.0f,
+             mixer_diffdrive_desat_name(config->desat), mixer_diffdrive_turn_name(config->turn),
+             config->pivot_throttle * 100.0f);
+    return ESP_OK;
+}
+
+void mixer_diffdrive_get_config(mixer_config_t *out) {
+    atomic_fetch_add(&mix_readers, 1);
+    *out = atomic_load(&active)->cfg;
+    atomic_fetch_sub(&mix_readers, 1);
+}
+
+uint32_t mixer_diffdrive_get_generation(void) {
+    return atomic_load(&config_generation);
+}
+
 esp_err_t mixer_diffdrive_mix(float throttle, float steering, bool slow_mode,
                                float *left_out, float *right_out) {
     if (left_out == NULL || right_out == NULL) {
         ESP_LOGE(TAG, "NULL output pointers");
         return ESP_ERR_INVALID_ARG;
     }
-    
-    // Apply deadzone
-    throttle = apply_deadzone(throttle, mixer_cfg.deadzone);
-    steering = apply_deadzone(steering, mixer_cfg.deadzone);
-    
-    // Apply expo
-    throttle = apply_expo(throttle, mixer_cfg.expo);
-    steering = apply_expo(steering, mixer_cfg.expo);
-    
-    // Differential drive mixing
-    // Left = throttle + steering
-    // Right = throttle - steering
-    float left = throttle + steering;
-    float right = throttle - steering;
-    
-    // Clamp to [-1.0, +1.0]
-    left = clamp(left);
-    right = clamp(right);
-    
-    // Apply max speed limit
-    left *= mixer_cfg.max_speed;
-    right *= mixer_cfg.max_speed;
-    
-    // Apply slow mode
-    if (slow_mode) {
-        left *= mixer_cfg.slow_mode_factor;
-        right *= mixer_cfg.slow_mode_factor;
-    }
-    
-    *left_out = left;
-    *right_out = right;
-    
+
+    atomic_fetch_add(&mix_readers, 1);
+    const mixer_state_t *st = atomic_load(&active);
+
+#ifdef CONFIG_ROBOT_MIXER_BACKEND_Q15
+    int32_t left_q15, right_q15;
+    mixer_q15_mix(&st->q15, mixer_q15_from_float(throttle), mixer_q15_from_float(steering),
+                  slow_mode, &left_q15, &right_q15);
+    *left_out  = mixer_q15_to_float(left_q15);
+    *right_out = mixer_q15_to_float(right_q15);
+#else
+    mixer_diffdrive_mix_float(&st->cfg, throttle, steering, slow_mode, left_out, right_out);
+#endif
+
+    atomic_fetch_sub(&mix_readers, 1);
     return ESP_OK;
 }
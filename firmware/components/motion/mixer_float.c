@@ -0,0 +1,253 @@
+/**
+ * @file mixer_float.c
+ * @brief Float differential drive transfer function, scalar and batch
+ *
+ * Pure functions of an explicit mixer_config_t: no state, no logging, no
+ * RTOS calls. mixer_diffdrive_mix() runs the scalar path on the active
+ * configuration; host-side replay and tuning tools can link this file on
+ * its own.
+ */
+
+#include "mixer_diffdrive.h"
+#include <math.h>
+#include <stddef.h>
+
+/**
+ * @brief Apply deadzone
+ */
+static float apply_deadzone(float value, float deadzone) {
+    if (fabsf(value) < deadzone) {
+        return 0.0f;
+    }
+    // Scale remaining range
+    float sign = (value > 0.0f) ? 1.0f : -1.0f;
+    return sign * (fabsf(value) - deadzone) / (1.0f - deadzone);
+}
+
+/**
+ * @brief Apply expo curve
+ * 
+ * Expo gives finer control near center, more aggressive at extremes.
+ * Formula: output = expo * value^3 + (1 - expo) * value
+ */
+static float apply_expo(float value, float expo) {
+    float cubic = value * value * value;
+    return expo * cubic + (1.0f - expo) * value;
+}
+
+float mixer_diffdrive_response(float value, const mixer_config_t *config) {
+    return apply_expo(apply_deadzone(value, config->deadzone), config->expo);
+}
+
+/**
+ * @brief Clamp value to [-1.0, +1.0]
+ */
+static float clamp(float value) {
+    if (value > 1.0f) return 1.0f;
+    if (value < -1.0f) return -1.0f;
+    return value;
+}
+
+float mixer_diffdrive_curvature_gain(float abs_throttle, float pivot_throttle) {
+    if (pivot_throttle <= 0.0f || abs_throttle >= pivot_throttle) {
+        return abs_throttle;
+    }
+    // pivot_throttle at the band edge (continuous), 1.0 at standstill
+    return pivot_throttle + (1.0f - pivot_throttle) * (pivot_throttle - abs_throttle) / pivot_throttle;
+}
+
+/**
+ * @brief Mix and bring both tracks into [-1.0, +1.0]
+ */
+static void desaturate(float throttle, float steering, mixer_desat_t mode,
+                       float *left, float *right) {
+    switch (mode) {
+    case MIXER_DESAT_NORMALIZE: {
+        float l = throttle + steering;
+        float r = throttle - steering;
+        float peak = fmaxf(fabsf(l), fabsf(r));
+        if (peak > 1.0f) {
+            l /= peak;
+            r /= peak;
+        }
+        *left = l;
+        *right = r;
+        break;
+    }
+    case MIXER_DESAT_STEER_PRIORITY: {
+        steering = clamp(steering);
+        float headroom = 1.0f - fabsf(steering);
+        if (fabsf(throttle) > headroom) {
+            throttle = copysignf(headroom, throttle);
+        }
+        *left = throttle + steering;
+        *right = throttle - steering;
+        break;
+    }
+    case MIXER_DESAT_CLAMP:
+    default:
+        *left = clamp(throttle + steering);
+        *right = clamp(throttle - steering);
+        break;
+    }
+}
+
+const char *mixer_diffdrive_desat_name(mixer_desat_t mode) {
+    switch (mode) {
+    case MIXER_DESAT_CLAMP:          return "clamp";
+    case MIXER_DESAT_NORMALIZE:      return "normalize";
+    case MIXER_DESAT_STEER_PRIORITY: return "steer_priority";
+    default:                         return "unknown";
+    }
+}
+
+const char *mixer_diffdrive_turn_name(mixer_turn_t mode) {
+    switch (mode) {
+    case MIXER_TURN_ARCADE:    return "arcade";
+    case MIXER_TURN_CURVATURE: return "curvature";
+    default:                   return "unknown";
+    }
+}
+
+void mixer_diffdrive_mix_float(const mixer_config_t *config, float throttle, float steering,
+                               bool slow_mode, float *left_out, float *right_out) {
+    // Apply deadzone
+    throttle = apply_deadzone(throttle, config->deadzone);
+    steering = apply_deadzone(steering, config->deadzone);
+    
+    // Apply expo
+    throttle = apply_expo(throttle, config->expo);
+    steering = apply_expo(steering, config->expo);
+    
+    // Turn model
+    if (config->turn == MIXER_TURN_CURVATURE) {
+        steering *= mixer_diffdrive_curvature_gain(fabsf(throttle), config->pivot_throttle);
+    }
+
+    // Differential drive mixing
+    // Left = throttle + steering
+    // Right = throttle - steering
+    float left, right;
+    desaturate(throttle, steering, config->desat, &left, &right);
+    
+    // Apply max speed limit
+    left *= config->max_speed;
+    right *= config->max_speed;
+    
+    // Apply slow mode
+    if (slow_mode) {
+        left *= config->slow_mode_factor;
+        right *= config->slow_mode_factor;
+    }
+    
+    *left_out = left;
+    *right_out = right;
+}
+
+// ---------------------------------------------------------------------------
+//  Batch path
+//
+//  Same transfer function, written without data-dependent branches so the
+//  compiler can vectorise the loop: a ? b : c selects and min/max instead of
+//  ifs, and one loop body per desaturation mode and slow-mode presence
+//  (both are constants after inlining). On Xtensa the loops simply run scalar.
+// ---------------------------------------------------------------------------
+
+#define BATCH_INLINE static inline __attribute__((always_inline))
+
+BATCH_INLINE float vmax(float a, float b) { return a > b ? a : b; }
+BATCH_INLINE float vmin(float a, float b) { return a < b ? a : b; }
+
+/**
+ * @brief mixer_diffdrive_response() without branches
+ */
+BATCH_INLINE float shape(float v, float deadzone, float inv_span, float expo) {
+    float x = copysignf(vmax(fabsf(v) - deadzone, 0.0f) * inv_span, v);
+    return expo * x * x * x + (1.0f - expo) * x;
+}
+
+BATCH_INLINE void mix_batch_mode(const mixer_config_t *config, mixer_desat_t mode,
+                                 bool has_slow, const float *restrict throttle,
+                                 const float *restrict steering,
+                                 const uint8_t *restrict slow_mode, size_t count,
+                                 float *restrict left_out, float *restrict right_out) {
+    const float deadzone = config->deadzone;
+    const float inv_span = 1.0f / (1.0f - deadzone);
+    const float expo     = config->expo;
+    const float curv_on  = (config->turn == MIXER_TURN_CURVATURE) ? 1.0f : 0.0f;
+    const float pivot    = config->pivot_throttle;
+    const float pivot_k  = (pivot > 0.0f) ? (1.0f - pivot) / pivot : 0.0f;
+    const float full     = config->max_speed;
+    const float slow     = config->max_speed * config->slow_mode_factor;
+
+    for (size_t i = 0; i < count; i++) {
+        float t = shape(throttle[i], deadzone, inv_span, expo);
+        float s = shape(steering[i], deadzone, inv_span, expo);
+
+        // mixer_diffdrive_curvature_gain(): inside the pivot band the ramp
+        // is above |t|, outside it is below, so max() picks the right branch
+        float abs_t = fabsf(t);
+        float gain  = vmax(abs_t, pivot + pivot_k * (pivot - abs_t));
+        s *= curv_on * gain + (1.0f - curv_on);
+
+        float l, r;
+        if (mode == MIXER_DESAT_NORMALIZE) {
+            l = t + s;
+            r = t - s;
+            float k = 1.0f / vmax(vmax(fabsf(l), fabsf(r)), 1.0f);
+            l *= k;
+            r *= k;
+        } else if (mode == MIXER_DESAT_STEER_PRIORITY) {
+            s = vmax(vmin(s, 1.0f), -1.0f);
+            float headroom = 1.0f - fabsf(s);
+            t = vmax(vmin(t, headroom), -headroom);
+            l = t + s;
+            r = t - s;
+        } else {
+            l = vmax(vmin(t + s, 1.0f), -1.0f);
+            r = vmax(vmin(t - s, 1.0f), -1.0f);
+        }
+
+        // Arithmetic blend rather than a select, so the flag load vectorises
+        float scale = has_slow ? full + (float)(slow_mode[i] != 0) * (slow - full) : full;
+        left_out[i]  = l * scale;
+        right_out[i] = r * scale;
+    }
+}
+
+/**
+ * @brief Instantiate the loop per desaturation mode and slow-mode presence
+ */
+BATCH_INLINE void mix_batch_slow(const mixer_config_t *config, bool has_slow,
+                                 const float *restrict throttle,
+                                 const float *restrict steering,
+                                 const uint8_t *restrict slow_mode, size_t count,
+                                 float *restrict left_out, float *restrict right_out) {
+    switch (config->desat) {
+    case MIXER_DESAT_NORMALIZE:
+        mix_batch_mode(config, MIXER_DESAT_NORMALIZE, has_slow, throttle, steering,
+                       slow_mode, count, left_out, right_out);
+        break;
+    case MIXER_DESAT_STEER_PRIORITY:
+        mix_batch_mode(config, MIXER_DESAT_STEER_PRIORITY, has_slow, throttle, steering,
+                       slow_mode, count, left_out, right_out);
+        break;
+    case MIXER_DESAT_CLAMP:
+    default:
+        mix_batch_mode(config, MIXER_DESAT_CLAMP, has_slow, throttle, steering,
+                       slow_mode, count, left_out, right_out);
+        break;
+    }
+}
+
+void mixer_diffdrive_mix_batch(const mixer_config_t *config,
+                               const float *restrict throttle,
+                               const float *restrict steering,
+                               const uint8_t *restrict slow_mode, size_t count,
+                               float *restrict left_out, float *restrict right_out) {
+    if (slow_mode != NULL) {
+        mix_batch_slow(config, true, throttle, steering, slow_mode, count, left_out, right_out);
+    } else {
+        mix_batch_slow(config, false, throttle, steering, NULL, count, left_out, right_out);
+    }
+}
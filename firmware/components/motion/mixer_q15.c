@@ -0,0 +1,126 @@
+/**
+ * @file mixer_q15.c
+ * @brief Fixed-point differential drive mixer implementation
+ *
+ * The table samples response(|x|) at MIXER_Q15_LUT_SIZE + 1 evenly spaced
+ * points on [0, 1]; lookups interpolate linearly between them. Inputs inside
+ * the deadzone are zeroed before the lookup, since interpolating across the
+ * deadzone corner would otherwise leak a little output there. The turn model
+ * and desaturation run on the normalised values exactly as in the float path,
+ * and max_speed (times slow_mode_factor) is applied last as one multiply.
+ */
+
+#include "mixer_q15.h"
+#include "esp_attr.h"
+#include <math.h>
+#include <stddef.h>
+
+#define LUT_BITS    MIXER_Q15_LUT_BITS
+#define LUT_SIZE    MIXER_Q15_LUT_SIZE
+#define FRAC_BITS   (15 - LUT_BITS)
+#define FRAC_MASK   ((1 << FRAC_BITS) - 1)
+#define Q15_MAX     (MIXER_Q15_ONE - 1)
+
+/**
+ * @brief Response curve, odd-symmetric
+ */
+static inline IRAM_ATTR int32_t curve(const mixer_q15_table_t *table, int32_t x) {
+    int32_t ax = (x < 0) ? -x : x;
+    if (ax < table->deadzone_q15) return 0;
+    if (ax > Q15_MAX) ax = Q15_MAX;
+
+    const int16_t *lut = table->lut;
+    int32_t i    = ax >> FRAC_BITS;
+    int32_t frac = ax & FRAC_MASK;
+    int32_t y    = lut[i] + (((lut[i + 1] - lut[i]) * frac) >> FRAC_BITS);
+
+    return (x < 0) ? -y : y;
+}
+
+static inline IRAM_ATTR int32_t clamp_q15(int32_t v, int32_t limit) {
+    if (v > limit) return limit;
+    if (v < -limit) return -limit;
+    return v;
+}
+
+static inline IRAM_ATTR int32_t abs_q15(int32_t v) {
+    return (v < 0) ? -v : v;
+}
+
+/**
+ * @brief mixer_diffdrive_curvature_gain() in Q15
+ */
+static inline IRAM_ATTR int32_t curvature_gain(const mixer_q15_table_t *table, int32_t abs_t) {
+    int32_t pivot = table->pivot_q15;
+    if (pivot <= 0 || abs_t >= pivot) {
+        return abs_t;
+    }
+    // (pivot - abs_t) * slope <= (ONE - pivot) * ONE, fits in int32
+    return pivot + (((pivot - abs_t) * table->pivot_slope_q15) >> 15);
+}
+
+esp_err_t mixer_q15_build(mixer_q15_table_t *table, const mixer_config_t *config) {
+    if (table == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i <= LUT_SIZE; i++) {
+        float y = mixer_diffdrive_response((float)i / LUT_SIZE, config);
+        table->lut[i] = (int16_t)mixer_q15_from_float(y);
+    }
+    // Smallest code the float path does not zero: |x| < deadzone is dead
+    table->deadzone_q15 = (int32_t)ceilf(config->deadzone * (float)MIXER_Q15_ONE);
+    table->scale_q15[0] = mixer_q15_from_float(config->max_speed);
+    table->scale_q15[1] = mixer_q15_from_float(config->max_speed * config->slow_mode_factor);
+
+    table->pivot_q15 = mixer_q15_from_float(config->pivot_throttle);
+    table->pivot_slope_q15 = (table->pivot_q15 > 0)
+        ? (int32_t)(((int64_t)(Q15_MAX - table->pivot_q15) << 15) / table->pivot_q15)
+        : 0;
+    table->desat = config->desat;
+    table->turn  = config->turn;
+
+    return ESP_OK;
+}
+
+void IRAM_ATTR mixer_q15_mix(const mixer_q15_table_t *table, int32_t throttle,
+                             int32_t steering, bool slow_mode,
+                             int32_t *left_out, int32_t *right_out) {
+    int32_t t = curve(table, throttle);
+    int32_t s = curve(table, steering);
+
+    if (table->turn == MIXER_TURN_CURVATURE) {
+        s = (s * curvature_gain(table, abs_q15(t))) >> 15;
+    }
+
+    int32_t left, right;
+    switch (table->desat) {
+    case MIXER_DESAT_NORMALIZE: {
+        left  = t + s;
+        right = t - s;
+        int32_t peak = abs_q15(left) > abs_q15(right) ? abs_q15(left) : abs_q15(right);
+        if (peak > Q15_MAX) {
+            // |left| <= 2 * Q15_MAX, so left * Q15_MAX still fits in int32
+            left  = left  * Q15_MAX / peak;
+            right = right * Q15_MAX / peak;
+        }
+        break;
+    }
+    case MIXER_DESAT_STEER_PRIORITY: {
+        s = clamp_q15(s, Q15_MAX);
+        t = clamp_q15(t, Q15_MAX - abs_q15(s));
+        left  = t + s;
+        right = t - s;
+        break;
+    }
+    case MIXER_DESAT_CLAMP:
+    default:
+        left  = clamp_q15(t + s, Q15_MAX);
+        right = clamp_q15(t - s, Q15_MAX);
+        break;
+    }
+
+    int32_t scale = table->scale_q15[slow_mode ? 1 : 0];
+    *left_out  = (left  * scale) >> 15;
+    *right_out = (right * scale) >> 15;
+}
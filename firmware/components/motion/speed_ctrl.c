@@ -0,0 +1,101 @@
+/**
+ * @file speed_ctrl.c
+ * @brief Closed-loop track speed stage implementation
+ */
+
+#include "speed_ctrl.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+static const char *TAG = "speed_ctrl";
+
+#define DT_MAX_S 0.1f  // cap after a stall so one step cannot dump a huge integral
+
+static speed_ctrl_config_t cfg;
+static speed_pid_t         pid_left;
+static speed_pid_t         pid_right;
+static _Atomic(const speed_feedback_t *) feedback;
+static bool                was_closed;  // control task only
+
+// Snapshot for readers on other tasks
+static speed_ctrl_status_t status;
+static portMUX_TYPE        status_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t speed_ctrl_init(const speed_ctrl_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg = *config;
+    if (cfg.gains.out_limit <= 0.0f) {
+        cfg.gains.out_limit = 1.0f;
+    }
+    speed_pid_reset(&pid_left);
+    speed_pid_reset(&pid_right);
+
+    ESP_LOGI(TAG, "Speed control %s: kp=%.3f ki=%.3f kd=%.3f kff=%.2f kstatic=%.2f",
+             cfg.enabled ? "enabled" : "disabled (open loop)",
+             cfg.gains.kp, cfg.gains.ki, cfg.gains.kd, cfg.gains.kff, cfg.gains.kstatic);
+    return ESP_OK;
+}
+
+void speed_ctrl_set_feedback(const speed_feedback_t *source) {
+    atomic_store(&feedback, source);
+    ESP_LOGI(TAG, "Feedback source: %s", source ? source->name : "none");
+}
+
+void speed_ctrl_reset(void) {
+    speed_pid_reset(&pid_left);
+    speed_pid_reset(&pid_right);
+    was_closed = false;
+}
+
+static void publish(bool closed, const speed_feedback_t *src, bool read_failed,
+                    float tl, float tr, float ml, float mr, float ol, float or_) {
+    portENTER_CRITICAL(&status_lock);
+    status.closed_loop = closed;
+    status.feedback    = src ? src->name : NULL;
+    if (read_failed) status.read_errors++;
+    if (closed && (pid_left.saturated || pid_right.saturated)) status.saturated++;
+    status.left  = (speed_ctrl_track_t){tl, ml, ol, pid_left.integ};
+    status.right = (speed_ctrl_track_t){tr, mr, or_, pid_right.integ};
+    portEXIT_CRITICAL(&status_lock);
+}
+
+void speed_ctrl_run(float *left, float *right, float limit, float dt_s) {
+    const speed_feedback_t *src = atomic_load(&feedback);
+    float target_l = *left;
+    float target_r = *right;
+    float meas_l = 0.0f, meas_r = 0.0f;
+
+    bool read_failed = false;
+    bool closed = cfg.enabled && src != NULL && dt_s > 0.0f;
+    if (closed && src->read(src->ctx, &meas_l, &meas_r) != ESP_OK) {
+        read_failed = true;
+        closed = false;
+    }
+
+    if (closed) {
+        if (!was_closed) {
+            // Entering closed loop: start from a clean integrator
+            speed_pid_reset(&pid_left);
+            speed_pid_reset(&pid_right);
+        }
+        if (dt_s > DT_MAX_S) dt_s = DT_MAX_S;
+        *left  = speed_pid_update_limited(&pid_left,  &cfg.gains, target_l, meas_l, limit, dt_s);
+        *right = speed_pid_update_limited(&pid_right, &cfg.gains, target_r, meas_r, limit, dt_s);
+    } else {
+        *left  = target_l * limit;
+        *right = target_r * limit;
+    }
+    was_closed = closed;
+
+    publish(closed, src, read_failed, target_l, target_r, meas_l, meas_r, *left, *right);
+}
+
+void speed_ctrl_get_status(speed_ctrl_status_t *out) {
+    portENTER_CRITICAL(&status_lock);
+    *out = status;
+    portEXIT_CRITICAL(&status_lock);
+}
@@ -0,0 +1,91 @@
+/**
+ * @file speed_pid.c
+ * @brief Per-track PI(D) velocity controller implementation
+ */
+
+#include "speed_pid.h"
+#include <math.h>
+#include <stddef.h>
+
+#define TARGET_EPS 1e-3f         // below this |target| counts as stopped (no static offset)
+#define TWO_PI     6.28318531f
+
+static float clampf(float v, float limit) {
+    if (v > limit) return limit;
+    if (v < -limit) return -limit;
+    return v;
+}
+
+void speed_pid_reset(speed_pid_t *pid) {
+    pid->integ     = 0.0f;
+    pid->prev_meas = 0.0f;
+    pid->d_filt    = 0.0f;
+    pid->output    = 0.0f;
+    pid->primed    = false;
+    pid->saturated = false;
+}
+
+float speed_pid_update(speed_pid_t *pid, const speed_pid_gains_t *gains,
+                       float target, float measured, float dt_s) {
+    const float limit = gains->out_limit;
+    float err = target - measured;
+
+    // Feed-forward: what an ideal motor needs, plus breakaway friction
+    float ff = gains->kff * target;
+    if (fabsf(target) > TARGET_EPS) {
+        ff += copysignf(gains->kstatic, target);
+    }
+
+    // Derivative on measurement (no kick on target steps), first-order filtered
+    float d = 0.0f;
+    if (gains->kd != 0.0f && pid->primed && dt_s > 0.0f) {
+        float raw = -gains->kd * (measured - pid->prev_meas) / dt_s;
+        if (gains->d_cutoff_hz > 0.0f) {
+            float rc = 1.0f / (TWO_PI * gains->d_cutoff_hz);
+            float alpha = dt_s / (rc + dt_s);
+            pid->d_filt += alpha * (raw - pid->d_filt);
+        } else {
+            pid->d_filt = raw;
+        }
+        d = pid->d_filt;
+    }
+    pid->prev_meas = measured;
+    pid->primed = true;
+
+    float p = gains->kp * err;
+
+    // Conditional integration: hold the integrator while the output is
+    // saturated and the error would push it further out. The bound is
+    // applied either way, so a limit lowered since the last step takes hold
+    float unsat = ff + p + pid->integ + d;
+    bool pushing_out = (unsat >= limit && err > 0.0f) || (unsat <= -limit && err < 0.0f);
+    if (!pushing_out) {
+        pid->integ += gains->ki * err * dt_s;
+    }
+    pid->integ = clampf(pid->integ, limit);
+
+    float out = ff + p + pid->integ + d;
+    pid->saturated = fabsf(out) >= limit;
+    pid->output = clampf(out, limit);
+    return pid->output;
+}
+
+float speed_pid_update_limited(speed_pid_t *pid, const speed_pid_gains_t *gains,
+                               float target, float measured, float limit, float dt_s) {
+    if (limit > 1.0f) limit = 1.0f;
+    if (limit < 0.0f) limit = 0.0f;
+    speed_pid_gains_t g = *gains;
+    g.out_limit *= limit;
+    return speed_pid_update(pid, &g, target * limit, measured, dt_s);
+}
+
+float speed_pid_emf_estimate(float duty, float amps, float r_ohm, float volts) {
+    if (volts <= 0.0f) {
+        return duty;
+    }
+    float drop = fabsf(amps) * r_ohm / volts;
+    if (drop >= fabsf(duty)) {
+        return 0.0f;
+    }
+    return (duty > 0.0f) ? duty - drop : duty + drop;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file thermal_guard.c
+ * @brief Thermal derating stage implementation
+ */
+
+#include "thermal_guard.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+static const char *TAG = "thermal";
+
+#define DT_MAX_S 0.1f  // cap after a stall, as in speed_ctrl
+
+static thermal_guard_config_t cfg;
+static thermal_track_t        track[2];   // control task only
+static thermal_state_t        last_state; // control task only
+static float                  scale = 1.0f;
+static _Atomic(const thermal_current_t *) current;
+
+// Snapshot for readers on other tasks
+static thermal_guard_status_t status;
+static portMUX_TYPE           status_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t thermal_guard_init(const thermal_guard_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const thermal_params_t *p = &config->params;
+    if (p->motor_tau_s <= 0.0f || p->bridge_tau_s <= 0.0f ||
+        p->motor_limit_a <= 0.0f || p->bridge_limit_a <= 0.0f ||
+        p->derate_start <= 0.0f || p->derate_start >= 1.0f ||
+        p->min_scale < 0.0f || p->min_scale > 1.0f ||
+        p->resume < 0.0f || p->resume > p->derate_start) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg = *config;
+    status.enabled = cfg.enabled;
+    status.scale   = 1.0f;
+
+    ESP_LOGI(TAG, "Thermal derating %s: motor %.1f A / %.0f s, bridge %.1f A / %.0f s, "
+             "derate from %.0f%% to %.0f%% output",
+             cfg.enabled ? "enabled" : "disabled (model only)",
+             p->motor_limit_a, p->motor_tau_s, p->bridge_limit_a, p->bridge_tau_s,
+             p->derate_start * 100.0f, p->min_scale * 100.0f);
+    return ESP_OK;
+}
+
+void thermal_guard_set_current(const thermal_current_t *source) {
+    atomic_store(&current, source);
+    ESP_LOGI(TAG, "Current source: %s", source ? source->name : "none (duty estimate)");
+}
+
+void thermal_guard_update(float left_duty, float right_duty, float dt_s) {
+    const thermal_params_t *p = &cfg.params;
+    const thermal_current_t *src = atomic_load(&current);
+    float amps[2];
+    if (src == NULL || src->read(src->ctx, &amps[0], &amps[1]) != ESP_OK) {
+        src = NULL;
+        amps[0] = thermal_amps_from_duty(p, left_duty);
+        amps[1] = thermal_amps_from_duty(p, right_duty);
+    }
+    if (dt_s > DT_MAX_S) dt_s = DT_MAX_S;
+
+    thermal_state_t state = THERMAL_OK;
+    float s = 1.0f;
+    for (int t = 0; t < 2; t++) {
+        thermal_track_update(&track[t], p, amps[t], dt_s);
+        thermal_state_t ts = thermal_track_state(&track[t], p);
+        float sc = thermal_track_scale(&track[t], p);
+        if (ts > state) state = ts;
+        if (sc < s) s = sc;
+    }
+    scale = cfg.enabled ? s : 1.0f;
+
+    bool entered_warn   = (state == THERMAL_WARN   && last_state == THERMAL_OK);
+    bool entered_cutoff = (state == THERMAL_CUTOFF && last_state != THERMAL_CUTOFF);
+    if (state != last_state) {
+        if (entered_cutoff) {
+            ESP_LOGE(TAG, "Thermal cutoff (motor L %.2f R %.2f, bridge L %.2f R %.2f)",
+                     track[0].motor, track[1].motor, track[0].bridge, track[1].bridge);
+        } else if (state == THERMAL_WARN) {
+            ESP_LOGW(TAG, "Thermal derating active (%.0f%% output)", s * 100.0f);
+        } else {
+            ESP_LOGI(TAG, "Thermal state: %s", thermal_state_name(state));
+        }
+        last_state = state;
+    }
+
+    portENTER_CRITICAL(&status_lock);
+    status.state  = state;
+    status.scale  = scale;
+    status.source = src ? src->name : NULL;
+    status.left   = track[0];
+    status.right  = track[1];
+    if (entered_warn) status.warnings++;
+    if (entered_cutoff) status.cutoffs++;
+    portEXIT_CRITICAL(&status_lock);
+}
+
+float thermal_guard_get_scale(void) {
+    return scale;
+}
+
+void thermal_guard_get_status(thermal_guard_status_t *out) {
+    portENTER_CRITICAL(&status_lock);
+    *out = status;
+    portEXIT_CRITICAL(&status_lock);
+}
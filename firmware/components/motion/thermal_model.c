@@ -0,0 +1,65 @@
+/**
+ * @file thermal_model.c
+ * @brief First-order I²t thermal model implementation
+ */
+
+#include "thermal_model.h"
+
+static float heat_step(float heat, float amps, float limit_a, float tau_s, float dt_s) {
+    if (limit_a <= 0.0f || tau_s <= 0.0f) {
+        return 0.0f;
+    }
+    float load = amps / limit_a;
+    float k = dt_s / tau_s;
+    if (k > 1.0f) k = 1.0f;
+    return heat + (load * load - heat) * k;
+}
+
+static float hottest(const thermal_track_t *t) {
+    return (t->motor > t->bridge) ? t->motor : t->bridge;
+}
+
+void thermal_track_update(thermal_track_t *t, const thermal_params_t *p,
+                          float amps, float dt_s) {
+    if (dt_s <= 0.0f) {
+        return;
+    }
+    if (amps < 0.0f) amps = -amps;
+    t->motor  = heat_step(t->motor,  amps, p->motor_limit_a,  p->motor_tau_s,  dt_s);
+    t->bridge = heat_step(t->bridge, amps, p->bridge_limit_a, p->bridge_tau_s, dt_s);
+
+    float heat = hottest(t);
+    if (heat >= 1.0f) {
+        t->cutoff = true;
+    } else if (t->cutoff && heat < p->resume) {
+        t->cutoff = false;
+    }
+}
+
+float thermal_track_scale(const thermal_track_t *t, const thermal_params_t *p) {
+    if (t->cutoff) {
+        return 0.0f;
+    }
+    float heat = hottest(t);
+    if (heat <= p->derate_start || p->derate_start >= 1.0f) {
+        return 1.0f;
+    }
+    // Linear from 1.0 at derate_start down to min_scale at the cutoff
+    float frac = (heat - p->derate_start) / (1.0f - p->derate_start);
+    return 1.0f - (1.0f - p->min_scale) * frac;
+}
+
+thermal_state_t thermal_track_state(const thermal_track_t *t, const thermal_params_t *p) {
+    if (t->cutoff) {
+        return THERMAL_CUTOFF;
+    }
+    return (hottest(t) > p->derate_start) ? THERMAL_WARN : THERMAL_OK;
+}
+
+const char *thermal_state_name(thermal_state_t state) {
+    switch (state) {
+        case THERMAL_WARN:   return "warn";
+        case THERMAL_CUTOFF: return "cutoff";
+        default:             return "ok";
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file battery_sense.c
+ * @brief Battery divider voltage implementation
+ */
+
+#include "battery_sense.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stddef.h>
+
+static const char *TAG = "battery_sense";
+
+#define SAMPLES             4       // conversions averaged per read
+#define MIN_INTERVAL_US     5000    // cached between reads closer than this
+#define ADC_FULL_SCALE_MV   3100    // nominal at 11 dB, used without calibration
+#define ADC_MAX_RAW         4095
+
+static battery_sense_config_t cfg;
+static adc_oneshot_unit_handle_t adc;
+static adc_cali_handle_t cali;
+static adc_channel_t channel;
+static int64_t last_us;
+static float last_volts;
+
+esp_err_t battery_sense_init(const battery_sense_config_t *config) {
+    if (config == NULL || config->scale <= 0.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg = *config;
+
+    adc_unit_t unit;
+    if (adc_oneshot_io_to_channel(cfg.pin, &unit, &channel) != ESP_OK || unit != ADC_UNIT_1) {
+        ESP_LOGE(TAG, "GPIO %d is not an ADC1 pin", cfg.pin);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    adc_oneshot_unit_init_cfg_t unit_cfg = { .unit_id = ADC_UNIT_1 };
+    esp_err_t ret = adc_oneshot_new_unit(&unit_cfg, &adc);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ADC unit failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    adc_oneshot_chan_cfg_t chan_cfg = {
+        .atten    = ADC_ATTEN_DB_11,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ret = adc_oneshot_config_channel(adc, channel, &chan_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ADC channel config failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_cfg = {
+        .unit_id  = ADC_UNIT_1,
+        .atten    = ADC_ATTEN_DB_11,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    if (adc_cali_create_scheme_line_fitting(&cali_cfg, &cali) != ESP_OK) {
+        ESP_LOGW(TAG, "No ADC calibration in eFuse, using nominal scale");
+        cali = NULL;
+    }
+#endif
+
+    ESP_LOGI(TAG, "Battery sense on GPIO %d, divider %.2f", cfg.pin, cfg.scale);
+    return ESP_OK;
+}
+
+esp_err_t battery_sense_read(float *volts) {
+    if (adc == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t now = esp_timer_get_time();
+    if (last_us != 0 && now - last_us < MIN_INTERVAL_US) {
+        *volts = last_volts;
+        return ESP_OK;
+    }
+
+    int sum = 0;
+    for (int i = 0; i < SAMPLES; i++) {
+        int raw;
+        esp_err_t ret = adc_oneshot_read(adc, channel, &raw);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        sum += raw;
+    }
+    int raw = sum / SAMPLES;
+    int mv;
+    if (cali == NULL || adc_cali_raw_to_voltage(cali, raw, &mv) != ESP_OK) {
+        mv = raw * ADC_FULL_SCALE_MV / ADC_MAX_RAW;
+    }
+
+    last_us = now;
+    last_volts = mv * cfg.scale / 1000.0f;
+    *volts = last_volts;
+    return ESP_OK;
+}
@@ -0,0 +1,286 @@
+/**
+ * @file current_sense.c
+ * @brief BTS7960 current sensing implementation
+ */
+
+#include "current_sense.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "current_sense";
+
+#define NUM_LINES           4       // left R_IS, left L_IS, right R_IS, right L_IS
+#define VBAT_LINE           NUM_LINES   // optional battery divider, after the IS lines
+#define NUM_ADC_CHANNELS    8
+#define FRAME_BYTES         128     // 64 conversions: 16 per line, 3.2 ms at 20 kHz
+#define POOL_BYTES          (FRAME_BYTES * 8)
+#define FILTER_FRAMES       8       // moving average over the last 8 frame means
+#define ADC_FULL_SCALE_MV   3100    // nominal at 11 dB, used without calibration
+#define ADC_MAX_RAW         4095
+#define TASK_STACK_SIZE     3072
+#define TASK_PRIORITY       4       // below control_task, above the input side
+
+static current_sense_config_t cfg;
+static adc_continuous_handle_t adc;
+static adc_cali_handle_t cali;
+static TaskHandle_t task_handle;
+static int8_t line_of_channel[NUM_ADC_CHANNELS];
+static int num_lines;               // NUM_LINES, plus one with the battery divider
+static uint32_t frame_us;           // time covered by one frame
+
+// Ring of frame means per line (sense task only)
+static float ring[NUM_LINES][FILTER_FRAMES];
+static float ring_sum[NUM_LINES];
+static int ring_pos;
+static int ring_fill;
+
+// Trip state per track (sense task only)
+static bool tripped[2];
+static uint32_t stall_us[2];
+
+static atomic_uint overflows = 0;
+static current_sense_status_t status = { .last_trip_track = -1 };
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+
+const char *current_sense_trip_name(current_trip_t reason) {
+    switch (reason) {
+        case CURRENT_TRIP_OVERCURRENT: return "overcurrent";
+        case CURRENT_TRIP_STALL:       return "stall";
+        default:                       return "none";
+    }
+}
+
+static bool IRAM_ATTR on_conv_done(adc_continuous_handle_t handle,
+                                   const adc_continuous_evt_data_t *edata, void *ctx) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task_handle, &woken);
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR on_pool_ovf(adc_continuous_handle_t handle,
+                                  const adc_continuous_evt_data_t *edata, void *ctx) {
+    atomic_fetch_add(&overflows, 1);
+    return false;
+}
+
+static int raw_to_mv(uint32_t raw) {
+    int mv;
+    if (cali == NULL || adc_cali_raw_to_voltage(cali, (int)raw, &mv) != ESP_OK) {
+        mv = (int)(raw * ADC_FULL_SCALE_MV / ADC_MAX_RAW);
+    }
+    return mv;
+}
+
+static float raw_to_amps(uint32_t raw) {
+    return (float)raw_to_mv(raw) / cfg.mv_per_amp;
+}
+
+/**
+ * @brief Trip on overcurrent or stall; re-arm once the track drops below stall_a
+ */
+static void check_trip(int track, float amps) {
+    if (tripped[track]) {
+        if (amps < cfg.stall_a) tripped[track] = false;
+        return;
+    }
+
+    current_trip_t reason = CURRENT_TRIP_NONE;
+    if (amps > cfg.limit_a) {
+        reason = CURRENT_TRIP_OVERCURRENT;
+    } else if (amps > cfg.stall_a) {
+        stall_us[track] += frame_us;
+        if (stall_us[track] >= cfg.stall_ms * 1000u) {
+            reason = CURRENT_TRIP_STALL;
+        }
+    } else {
+        stall_us[track] = 0;
+    }
+    if (reason == CURRENT_TRIP_NONE) {
+        return;
+    }
+
+    tripped[track] = true;
+    stall_us[track] = 0;
+    portENTER_CRITICAL(&status_lock);
+    status.trips++;
+    status.last_trip = reason;
+    status.last_trip_track = track;
+    portEXIT_CRITICAL(&status_lock);
+
+    ESP_LOGE(TAG, "%s trip on %s track: %.1f A", current_sense_trip_name(reason),
+             track ? "right" : "left", amps);
+    if (cfg.on_trip) {
+        cfg.on_trip(reason, track);
+    }
+}
+
+/**
+ * @brief Average one DMA frame per line, filter, and check the trip limits
+ */
+static void process_frame(const uint8_t *buf, uint32_t len) {
+    uint32_t sum[NUM_LINES + 1] = {0};
+    uint32_t count[NUM_LINES + 1] = {0};
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&buf[i];
+        unsigned ch = p->type1.channel;
+        int line = (ch < NUM_ADC_CHANNELS) ? line_of_channel[ch] : -1;
+        if (line >= 0) {
+            sum[line] += p->type1.data;
+            count[line]++;
+        }
+    }
+
+    for (int l = 0; l < NUM_LINES; l++) {
+        int prev = (ring_pos + FILTER_FRAMES - 1) % FILTER_FRAMES;
+        float amps = count[l] ? raw_to_amps(sum[l] / count[l]) : ring[l][prev];
+        ring_sum[l] += amps - ring[l][ring_pos];
+        ring[l][ring_pos] = amps;
+    }
+    ring_pos = (ring_pos + 1) % FILTER_FRAMES;
+    if (ring_fill < FILTER_FRAMES) ring_fill++;
+
+    float track_a[2];
+    for (int t = 0; t < 2; t++) {
+        track_a[t] = (ring_sum[t * 2] + ring_sum[t * 2 + 1]) / ring_fill;
+        if (track_a[t] < 0.0f) track_a[t] = 0.0f;  // float drift in the running sum
+    }
+
+    // The battery line skips the ring: the limiter needs the sag without delay
+    float vbat_v = status.vbat_v;
+    if (count[VBAT_LINE]) {
+        vbat_v = raw_to_mv(sum[VBAT_LINE] / count[VBAT_LINE]) * cfg.vbat_scale / 1000.0f;
+    }
+
+    portENTER_CRITICAL(&status_lock);
+    status.left_a  = track_a[0];
+    status.right_a = track_a[1];
+    if (track_a[0] > status.left_peak_a)  status.left_peak_a  = track_a[0];
+    if (track_a[1] > status.right_peak_a) status.right_peak_a = track_a[1];
+    status.vbat_v  = vbat_v;
+    status.frames++;
+    portEXIT_CRITICAL(&status_lock);
+
+    check_trip(0, track_a[0]);
+    check_trip(1, track_a[1]);
+}
+
+static void current_sense_task(void *arg) {
+    static uint8_t frame[FRAME_BYTES];
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t got = 0;
+        while (adc_continuous_read(adc, frame, FRAME_BYTES, &got, 0) == ESP_OK) {
+            process_frame(frame, got);
+        }
+    }
+}
+
+esp_err_t current_sense_init(const current_sense_config_t *config) {
+    if (config == NULL || config->mv_per_amp <= 0.0f || config->sample_hz == 0 ||
+        (config->vbat_pin >= 0 && config->vbat_scale <= 0.0f)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg = *config;
+
+    const int pins[NUM_LINES + 1] = {cfg.left_ris, cfg.left_lis, cfg.right_ris, cfg.right_lis,
+                                     cfg.vbat_pin};
+    num_lines = (cfg.vbat_pin >= 0) ? NUM_LINES + 1 : NUM_LINES;
+    adc_digi_pattern_config_t pattern[NUM_LINES + 1];
+    memset(line_of_channel, -1, sizeof(line_of_channel));
+    for (int l = 0; l < num_lines; l++) {
+        adc_unit_t unit;
+        adc_channel_t ch;
+        esp_err_t ret = adc_continuous_io_to_channel(pins[l], &unit, &ch);
+        if (ret != ESP_OK || unit != ADC_UNIT_1) {
+            ESP_LOGE(TAG, "GPIO %d is not an ADC1 pin", pins[l]);
+            return ESP_ERR_INVALID_ARG;
+        }
+        line_of_channel[ch] = (int8_t)l;
+        pattern[l] = (adc_digi_pattern_config_t){
+            .atten     = ADC_ATTEN_DB_11,
+            .channel   = ch,
+            .unit      = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+    }
+
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = POOL_BYTES,
+        .conv_frame_size    = FRAME_BYTES,
+    };
+    esp_err_t ret = adc_continuous_new_handle(&handle_cfg, &adc);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ADC handle failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    adc_continuous_config_t adc_cfg = {
+        .pattern_num    = num_lines,
+        .adc_pattern    = pattern,
+        .sample_freq_hz = cfg.sample_hz,
+        .conv_mode      = ADC_CONV_SINGLE_UNIT_1,
+        .format         = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    ret = adc_continuous_config(adc, &adc_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ADC config failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_cfg = {
+        .unit_id  = ADC_UNIT_1,
+        .atten    = ADC_ATTEN_DB_11,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    if (adc_cali_create_scheme_line_fitting(&cali_cfg, &cali) != ESP_OK) {
+        ESP_LOGW(TAG, "No ADC calibration in eFuse, using nominal scale");
+        cali = NULL;
+    }
+#endif
+
+    uint32_t per_frame = FRAME_BYTES / SOC_ADC_DIGI_RESULT_BYTES;
+    frame_us = (uint32_t)((uint64_t)per_frame * 1000000u / cfg.sample_hz);
+    status.rate_hz = cfg.sample_hz / num_lines;
+
+    BaseType_t ok = xTaskCreatePinnedToCore(current_sense_task, "cur_sense", TASK_STACK_SIZE,
+                                            NULL, TASK_PRIORITY, &task_handle, cfg.task_core);
+    if (ok != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create current-sense task");
+        return ESP_FAIL;
+    }
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = on_conv_done,
+        .on_pool_ovf  = on_pool_ovf,
+    };
+    ret = adc_continuous_register_event_callbacks(adc, &cbs, NULL);
+    if (ret == ESP_OK) {
+        ret = adc_continuous_start(adc);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ADC start failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Current sense: %lu Hz per line, %lu us frames, limit %.1f A, "
+             "stall %.1f A for %lu ms%s", status.rate_hz, frame_us, cfg.limit_a,
+             cfg.stall_a, cfg.stall_ms, cfg.vbat_pin >= 0 ? ", battery line" : "");
+    return ESP_OK;
+}
+
+void current_sense_get_status(current_sense_status_t *out) {
+    if (!out) return;
+    portENTER_CRITICAL(&status_lock);
+    *out = status;
+    portEXIT_CRITICAL(&status_lock);
+    out->overflows = atomic_load(&overflows);
+}
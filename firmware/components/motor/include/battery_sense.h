@@ -0,0 +1,41 @@
+/**
+ * @file battery_sense.h
+ * @brief Battery divider voltage by ADC1 oneshot reads
+ *
+ * Used when current sense is off. With current sense on, ADC1 runs in
+ * continuous mode and the divider is sampled as a fifth line of its
+ * pattern instead (current_sense_config_t::vbat_pin); the two cannot share
+ * the unit. ADC2 is not an option either, as WiFi owns it.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+/**
+ * @brief Battery sense configuration
+ */
+typedef struct {
+    int   pin;      ///< GPIO of the divider (ADC1 pins 32-39)
+    float scale;    ///< Divider ratio: battery volts per ADC volt
+} battery_sense_config_t;
+
+/**
+ * @brief Configure the ADC1 channel for the divider
+ *
+ * @param config Configuration
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if the pin is not
+ *         on ADC1
+ */
+esp_err_t battery_sense_init(const battery_sense_config_t *config);
+
+/**
+ * @brief Battery voltage, averaged over a few conversions
+ *
+ * Converts at most once per few milliseconds and returns the cached value
+ * in between, so it can be called from the control tick at any loop rate.
+ *
+ * @param volts Battery voltage out
+ * @return esp_err_t ESP_OK, or ESP_ERR_INVALID_STATE before init
+ */
+esp_err_t battery_sense_read(float *volts);
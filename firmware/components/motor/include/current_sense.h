@@ -0,0 +1,94 @@
+/**
+ * @file current_sense.h
+ * @brief BTS7960 current sensing and overcurrent / stall trip
+ *
+ * Samples the four IS lines (R_IS and L_IS per IBT-2 module) with the ADC
+ * continuous (DMA) driver, filters each over a short ring of frame means,
+ * and trips when a track draws too much current: immediately above the
+ * overcurrent limit, or after a hold time above the stall threshold.
+ *
+ * Each BTS7960 half-bridge reports the current through its own high side,
+ * so only the side that is driving reads non-zero; a track's current is the
+ * sum of its two IS lines.
+ *
+ * A battery voltage divider on a fifth ADC1 pin can share the conversion
+ * pattern; it is reported per frame, unfiltered, for the battery limiter.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+
+/**
+ * @brief Why the last trip happened
+ */
+typedef enum {
+    CURRENT_TRIP_NONE = 0,
+    CURRENT_TRIP_OVERCURRENT,   ///< Filtered current above limit_a
+    CURRENT_TRIP_STALL,         ///< Above stall_a for stall_ms
+} current_trip_t;
+
+/**
+ * @brief Trip callback, run on the current-sense task
+ *
+ * @param reason Trip reason
+ * @param track  0 = left, 1 = right
+ */
+typedef void (*current_trip_cb_t)(current_trip_t reason, int track);
+
+/**
+ * @brief Current sense configuration
+ */
+typedef struct {
+    int      left_ris;       ///< GPIO of the left module's R_IS (ADC1 pins 32-39)
+    int      left_lis;
+    int      right_ris;
+    int      right_lis;
+    int      vbat_pin;       ///< GPIO of the battery divider (ADC1), or -1 for none
+    float    vbat_scale;     ///< Divider ratio: battery volts per ADC volt
+    uint32_t sample_hz;      ///< Total conversion rate, shared by all lines
+    float    mv_per_amp;     ///< IS voltage per amp of load current
+    float    limit_a;        ///< Overcurrent trip (filtered)
+    float    stall_a;        ///< Stall threshold
+    uint32_t stall_ms;       ///< Time above stall_a before tripping
+    current_trip_cb_t on_trip;
+    int      task_core;      ///< Core for the current-sense task, or tskNO_AFFINITY
+} current_sense_config_t;
+
+/**
+ * @brief Current sense snapshot
+ */
+typedef struct {
+    float          left_a;         ///< Filtered left track current
+    float          right_a;        ///< Filtered right track current
+    float          left_peak_a;    ///< Highest filtered left current since boot
+    float          right_peak_a;   ///< Highest filtered right current since boot
+    float          vbat_v;         ///< Battery voltage, latest frame (0 without vbat_pin)
+    uint32_t       rate_hz;        ///< Samples per second per line
+    uint32_t       frames;         ///< DMA frames processed
+    uint32_t       overflows;      ///< Frames lost because the task fell behind
+    uint32_t       trips;          ///< Trips since boot
+    current_trip_t last_trip;      ///< Reason of the most recent trip
+    int            last_trip_track;///< Track of the most recent trip (-1 = none)
+} current_sense_status_t;
+
+/**
+ * @brief Start sampling and the current-sense task
+ *
+ * @param config Configuration
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t current_sense_init(const current_sense_config_t *config);
+
+/**
+ * @brief Get the current snapshot (zeros if current sensing is not running)
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void current_sense_get_status(current_sense_status_t *out);
+
+/**
+ * @brief Name of a trip reason ("none", "overcurrent", "stall")
+ */
+const char *current_sense_trip_name(current_trip_t reason);
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "esp_err.h"
+#include "pwm_backend.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -28,13 +29,65 @@ typedef struct {
     // PWM settings
     uint32_t pwm_freq_hz;
     uint8_t pwm_resolution;
-    uint32_t ramp_rate_ms;
+    uint32_t ramp_rate_ms;   ///< Accel: ms per 0-100% while speeding up (0 = instant)
+    uint32_t decel_ms;       ///< ms per 100% change while slowing down (0 = instant)
+    uint32_t reverse_ms;     ///< ms per 100% change while braking for a reversal (0 = instant)
+    uint32_t jerk_ms;        ///< S-curve: time for the slew rate to build up (0 = linear)
+    uint32_t loop_rate_hz;   ///< motor_ramp task rate (two-stage pipeline only)
     
     // Motor inversion
     bool invert_left;
     bool invert_right;
+
+    // PWM output backend (NULL = LEDC) and its power-stage protection
+    const pwm_backend_t *pwm_backend;
+    uint32_t dead_time_ns;                  ///< Rising-edge delay per output (MCPWM only)
+    int  fault_gpio[PWM_BACKEND_FAULTS];    ///< Fault inputs, -1 = unused (MCPWM only)
+    bool fault_active_high;
+
+    // Ramp backend: true = hardware fade (backends with fade support), false = software steps
+    bool hw_fade;
+
+    // Pipeline: true = no ramp task; the control loop calls motor_bts7960_tick()
+    bool external_tick;
+    int  ramp_task_core;     ///< Core for the motor_ramp task, or tskNO_AFFINITY
 } motor_config_t;
 
+/**
+ * @brief Target-to-PWM latency of the motor pipeline
+ *
+ * Measured from motor_set_speeds() receiving a changed target to the first
+ * PWM write that includes it.
+ */
+typedef struct {
+    uint32_t last_us;   ///< Most recent latency
+    uint32_t avg_us;    ///< Mean latency since boot
+    uint32_t max_us;    ///< Worst latency since boot
+    uint32_t samples;   ///< Number of measured targets
+} motor_pipeline_stats_t;
+
+/**
+ * @brief Execution time of the most recent ramp stage run
+ */
+typedef struct {
+    uint32_t ramp_us;   ///< Ramp step computation
+    uint32_t pwm_us;    ///< PWM duty writes
+    uint32_t runs;      ///< Ramp stage runs since boot (changes on every run)
+} motor_tick_timing_t;
+
+/**
+ * @brief PWM channel write counters
+ *
+ * Each ramp stage run asks for four channel updates; those that would not
+ * change the duty already in the channel are skipped.
+ */
+typedef struct {
+    uint32_t writes;    ///< Channel duty updates issued to the PWM backend
+    uint32_t skipped;   ///< Updates skipped because the duty was unchanged
+    uint32_t errors;    ///< Issued updates the PWM backend rejected
+    uint32_t faults;    ///< Hardware fault trips (backends with fault inputs)
+} motor_pwm_stats_t;
+
 /**
  * @brief Initialize motor driver
  * 
@@ -52,13 +105,83 @@ esp_err_t motor_bts7960_init(const motor_config_t *config);
  */
 esp_err_t motor_set_speeds(float left_speed, float right_speed);
 
+/**
+ * @brief Set motor speeds and tag them with a trace stamp
+ *
+ * Same as motor_set_speeds(), but the stamp (typically the ingress time of
+ * the control frame) is handed back by motor_take_applied_trace() once the
+ * PWM write that includes these targets has happened. A newer stamp replaces
+ * one that was not applied yet.
+ *
+ * @param trace_us Trace stamp, or 0 for none
+ */
+esp_err_t motor_set_speeds_traced(float left_speed, float right_speed, int64_t trace_us);
+
+/**
+ * @brief Fetch the stamp of the last traced target that reached the PWM
+ *
+ * Each applied stamp is returned once.
+ *
+ * @param trace_us   Stamp passed to motor_set_speeds_traced()
+ * @param applied_us esp_timer time of the PWM write
+ * @return true if a stamp was applied since the previous call
+ */
+bool motor_take_applied_trace(int64_t *trace_us, int64_t *applied_us);
+
+/**
+ * @brief Run one ramp step and write PWM (single-stage pipeline)
+ *
+ * Only valid when the driver was initialised with external_tick = true.
+ * Call once per control cycle, right after motor_set_speeds().
+ */
+void motor_bts7960_tick(void);
+
+/**
+ * @brief Get the timing of the most recent ramp stage run
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void motor_get_tick_timing(motor_tick_timing_t *out);
+
+/**
+ * @brief Get target-to-PWM latency statistics
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void motor_get_pipeline_stats(motor_pipeline_stats_t *out);
+
+/**
+ * @brief Get PWM write/skip counters
+ *
+ * @param out Caller-allocated struct to fill
+ */
+void motor_get_pwm_stats(motor_pwm_stats_t *out);
+
+/**
+ * @brief Number of hardware fault trips since boot
+ *
+ * A trip has already forced every output low in hardware. Cheap enough to
+ * poll every control cycle.
+ */
+uint32_t motor_get_pwm_fault_count(void);
+
+/**
+ * @brief Re-enable the outputs after a hardware fault trip
+ *
+ * @return esp_err_t ESP_OK if the outputs are enabled (or the backend has no
+ *         fault inputs), an error while a fault input is still active
+ */
+esp_err_t motor_clear_pwm_fault(void);
+
 /**
  * @brief Get current motor speeds
  *
  * @param left_target  Target left speed (set by control loop)
  * @param right_target Target right speed (set by control loop)
- * @param left_actual  Actual left speed (after slew-rate ramp)
- * @param right_actual Actual right speed (after slew-rate ramp)
+ * @param left_actual  Actual left speed (after slew-rate ramp; read back
+ *                     from the LEDC duty with the hardware-fade backend)
+ * @param right_actual Actual right speed (after slew-rate ramp; read back
+ *                     from the LEDC duty with the hardware-fade backend)
  */
 void motor_get_speeds(float *left_target, float *right_target,
                       float *left_actual, float *right_actual);
@@ -66,6 +189,36 @@ void motor_get_speeds(float *left_target, float *right_target,
 /**
  * @brief Emergency stop (immediate, bypasses slew-rate ramp)
  *
+ * Safe to call from any task, concurrently with the ramp stage.
+ *
  * @return esp_err_t ESP_OK on success
  */
 esp_err_t motor_emergency_stop(void);
+
+/**
+ * @brief Disable both H-bridges through their enable pins (ISR safe)
+ *
+ * Drops R_EN and L_EN on both modules with direct register writes, so it
+ * can run from an interrupt handler while the control loop is stuck. The
+ * BTS7960 outputs go high impedance and the motors coast; unlike a zero
+ * duty, PWM writes made afterwards cannot undo it. Stays in effect until
+ * motor_enable_outputs().
+ */
+void motor_cut_outputs(void);
+
+/**
+ * @brief Raise the bridge enable pins again (task context only)
+ */
+void motor_enable_outputs(void);
+
+/**
+ * @brief True unless motor_cut_outputs() ran since the last enable
+ */
+bool motor_outputs_enabled(void);
+
+/**
+ * @brief esp_timer time at which the last emergency stop finished zeroing PWM
+ *
+ * @return int64_t Microseconds since boot, or 0 if no stop has happened
+ */
+int64_t motor_get_last_stop_time_us(void);
@@ -0,0 +1,55 @@
+/**
+ * @file motor_ramp.h
+ * @brief Slew-rate / S-curve ramp engine for one track
+ *
+ * Pure C with no RTOS or IDF dependencies. Speeds are -1.0 to +1.0; rates
+ * are full-scale changes per second.
+ *
+ * The limit depends on what the step does to the track:
+ * - accel:   |speed| grows (including starting off from 0)
+ * - decel:   |speed| shrinks towards a target of the same sign or 0
+ * - reverse: |speed| shrinks towards a target of the opposite sign; once
+ *            through zero the track accelerates again under accel
+ *
+ * With a jerk limit the rate itself changes gradually, and is brought back
+ * down early enough to arrive at the target without overshoot: an S-curve.
+ */
+
+#pragma once
+
+/**
+ * @brief Ramp limits (0 = unlimited for that limit)
+ */
+typedef struct {
+    float accel;     ///< Full scale per second while speeding up
+    float decel;     ///< Full scale per second while slowing down
+    float reverse;   ///< Full scale per second while braking for a reversal
+    float jerk;      ///< Full scale per second² (0 = linear ramps)
+} motor_ramp_limits_t;
+
+/**
+ * @brief Ramp state for one track
+ */
+typedef struct {
+    float speed;     ///< Current output
+    float rate;      ///< Current slew rate (full scale per second, signed)
+} motor_ramp_t;
+
+/**
+ * @brief Convert "ms per full-scale change" to a rate (0 ms = unlimited)
+ */
+static inline float motor_ramp_rate_from_ms(unsigned ms) {
+    return ms ? 1000.0f / (float)ms : 0.0f;
+}
+
+/**
+ * @brief Advance the ramp by @p dt_s towards @p target
+ *
+ * @param ramp   Ramp state
+ * @param limits Limits
+ * @param target Target speed
+ * @param dt_s   Measured time since the previous step, seconds
+ * @return float New speed
+ */
+float motor_ramp_step(motor_ramp_t *ramp, const motor_ramp_limits_t *limits,
+                      float target, float dt_s);
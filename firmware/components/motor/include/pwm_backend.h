@@ -0,0 +1,86 @@
+/**
+ * @file pwm_backend.h
+ * @brief PWM output backend interface used by the motor driver
+ *
+ * The motor driver addresses four logical channels, two per H-bridge, and
+ * leaves the peripheral to a backend:
+ *
+ * - LEDC   (pwm_ledc.c):  one shared timer, optional hardware fade
+ * - MCPWM  (pwm_mcpwm.c): one timer per bridge, synchronised, hardware dead
+ *                         time and fault inputs
+ * - Stub   (pwm_stub.c):  no outputs, records every duty write (host
+ *                         builds and bench runs without a power stage)
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Logical channels, in this order
+#define PWM_BACKEND_CHANNELS 4
+#define PWM_CH_LEFT_RPWM     0
+#define PWM_CH_LEFT_LPWM     1
+#define PWM_CH_RIGHT_RPWM    2
+#define PWM_CH_RIGHT_LPWM    3
+
+/// Fault inputs a backend may support (-1 in fault_gpio = unused)
+#define PWM_BACKEND_FAULTS   2
+
+/**
+ * @brief Backend configuration (all four channels at once)
+ */
+typedef struct {
+    int      gpio[PWM_BACKEND_CHANNELS];      ///< Output pin per logical channel
+    uint32_t freq_hz;                         ///< PWM frequency
+    uint8_t  resolution;                      ///< Duty range 0 to 2^resolution - 1
+    uint32_t dead_time_ns;                    ///< Rising-edge delay per output (0 = none)
+    int      fault_gpio[PWM_BACKEND_FAULTS];  ///< Fault inputs that cut all outputs
+    bool     fault_active_high;               ///< Fault input polarity
+    bool     fade;                            ///< Prepare hardware fade (backends with fade_to)
+} pwm_backend_config_t;
+
+/**
+ * @brief Backend operations
+ *
+ * write_duty() and get_duty() are required. The motor layer serialises the
+ * write and fade calls with its pwm_io_lock mutex and never calls them inside
+ * a critical section, so they may block on driver locks. The optional
+ * operations are NULL when the backend does not support them.
+ */
+typedef struct {
+    const char *name;
+
+    /// Configure the peripheral for all four channels, outputs at duty 0
+    esp_err_t (*init)(const pwm_backend_config_t *config);
+
+    /// Set a channel's duty (0 to 2^resolution - 1)
+    esp_err_t (*write_duty)(uint8_t channel, uint32_t duty);
+
+    /// Duty currently in the channel (including fade progress), UINT32_MAX on error
+    uint32_t  (*get_duty)(uint8_t channel);
+
+    /// Hardware fade to @p duty over @p time_ms (optional)
+    esp_err_t (*fade_to)(uint8_t channel, uint32_t duty, uint32_t time_ms);
+
+    /// Stop a running fade (optional, present with fade_to)
+    esp_err_t (*fade_stop)(uint8_t channel);
+
+    /// Number of fault trips since boot (optional)
+    uint32_t  (*fault_count)(void);
+
+    /// Re-enable outputs after a fault; fails while a fault input is still active (optional)
+    esp_err_t (*fault_clear)(void);
+} pwm_backend_t;
+
+extern const pwm_backend_t pwm_backend_ledc;
+extern const pwm_backend_t pwm_backend_mcpwm;
+extern const pwm_backend_t pwm_backend_stub;
+
+/**
+ * @brief Maximum duty value for a resolution
+ */
+static inline uint32_t pwm_backend_max_duty(uint8_t resolution) {
+    return (1u << resolution) - 1;
+}
@@ -35,6 +35,55 @@ esp_err_t pwm_ledc_init(const pwm_ledc_config_t *config);
  */
 esp_err_t pwm_ledc_set_duty(uint8_t channel, uint32_t duty);
 
+/**
+ * @brief Set PWM duty cycle without logging
+ *
+ * Same as pwm_ledc_set_duty(), but the caller counts and reports errors.
+ * Not for a critical section: the LEDC driver may block on its own
+ * semaphore. The motor layer calls it under its pwm_io_lock mutex.
+ *
+ * @param channel LEDC channel
+ * @param duty Duty cycle (0 to 2^resolution - 1)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t pwm_ledc_write_duty(uint8_t channel, uint32_t duty);
+
+/**
+ * @brief Install the LEDC fade service (once, before any fade call)
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t pwm_ledc_fade_init(void);
+
+/**
+ * @brief Fade a channel to @p duty in hardware
+ *
+ * Stops any fade already running on the channel, then starts a new one from
+ * the current duty without waiting for it. Not for critical sections.
+ *
+ * @param channel LEDC channel
+ * @param duty    Final duty
+ * @param time_ms Fade duration (the driver steps once per PWM period)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t pwm_ledc_fade_to(uint8_t channel, uint32_t duty, uint32_t time_ms);
+
+/**
+ * @brief Stop a running fade; the duty holds within one PWM period
+ *
+ * @param channel LEDC channel
+ * @return esp_err_t ESP_OK on success (also when no fade was running)
+ */
+esp_err_t pwm_ledc_fade_stop(uint8_t channel);
+
+/**
+ * @brief Read back the duty currently in the channel, including fade progress
+ *
+ * @param channel LEDC channel
+ * @return uint32_t Duty, or UINT32_MAX on error
+ */
+uint32_t pwm_ledc_get_duty(uint8_t channel);
+
 /**
  * @brief Get maximum duty value for current resolution
  * 
@@ -0,0 +1,51 @@
+/**
+ * @file pwm_stub.h
+ * @brief Recording PWM backend (no outputs)
+ *
+ * Selected as the motor PWM backend, it accepts every write without touching
+ * a peripheral and keeps the duties and a log of the writes. It has no IDF
+ * dependencies beyond esp_err.h, so host builds can link the motor layer's
+ * callers against it and check what would have reached the pins.
+ */
+
+#pragma once
+
+#include "pwm_backend.h"
+#include <stddef.h>
+
+#define PWM_STUB_LOG_LEN 256
+
+/**
+ * @brief One recorded duty write
+ */
+typedef struct {
+    uint32_t seq;      ///< Write number since the last reset (from 0)
+    uint8_t  channel;  ///< Logical channel (PWM_CH_*)
+    uint32_t duty;     ///< Duty written
+} pwm_stub_write_t;
+
+/**
+ * @brief Copy the most recent writes, oldest first
+ *
+ * The log keeps the last PWM_STUB_LOG_LEN writes.
+ *
+ * @param out Destination
+ * @param max Capacity of @p out
+ * @return size_t Number of entries copied
+ */
+size_t pwm_stub_get_writes(pwm_stub_write_t *out, size_t max);
+
+/**
+ * @brief Total writes since init or the last reset (including overwritten ones)
+ */
+uint32_t pwm_stub_write_count(void);
+
+/**
+ * @brief Clear the write log (duties are kept)
+ */
+void pwm_stub_reset(void);
+
+/**
+ * @brief Configuration passed to the last init
+ */
+const pwm_backend_config_t *pwm_stub_get_config(void);
@@ -4,12 +4,18 @@
  */
 
 #include "motor_bts7960.h"
-#include "pwm_ledc.h"
+#include "motor_ramp.h"
+#include "pwm_backend.h"
 #include "driver/gpio.h"
+#include "hal/gpio_ll.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <math.h>
+#include <stdatomic.h>
 
 static const char *TAG = "motor_bts7960";
 
@@ -21,76 +27,367 @@ static float current_right_speed = 0.0f;
 static float target_left_speed = 0.0f;
 static float target_right_speed = 0.0f;
 
-// LEDC channels
-#define CH_LEFT_RPWM 0
-#define CH_LEFT_LPWM 1
-#define CH_RIGHT_RPWM 2
-#define CH_RIGHT_LPWM 3
+// Target hand-off between motor_set_speeds() and the ramp stage
+static portMUX_TYPE motor_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Target-to-PWM latency: stamped when a new target arrives, measured when
+// the ramp stage first applies it
+static int64_t target_set_us = 0;   // 0 = no target waiting to be applied
+static motor_pipeline_stats_t pipeline_stats = {0};
+static uint64_t latency_sum_us = 0;
+
+// Caller trace stamps: pending until the ramp stage writes PWM, then parked
+// for motor_take_applied_trace()
+static int64_t trace_pending_us = 0;
+static int64_t trace_applied_us = 0;
+static int64_t trace_applied_at_us = 0;
+
+// Emergency stop generation: odd while a stop is writing PWM. The ramp stage
+// re-zeroes its output if a stop overlapped its PWM write, so a stale ramp
+// value can never land after the stop's zero duty.
+static atomic_uint stop_gen = 0;
+static atomic_llong last_stop_us = 0;
+
+// Bridge enable pins (R_EN / L_EN). Dropped from ISR context by
+// motor_cut_outputs(); only motor_enable_outputs() raises them again.
+static uint8_t en_pins[4];
+static atomic_bool outputs_enabled = false;
+
+// Ramp stage timing. The slew step is derived from the measured time since
+// the previous run, so the ramp rate does not depend on the loop rate.
+#define RAMP_DT_MAX_US 100000  // cap after a stall so one step cannot jump
+static int64_t last_ramp_us = 0;
+static motor_tick_timing_t tick_timing = {0};
+
+// Software ramp engine state (ramp stage only). The speeds mirror
+// current_*_speed; the slew rates are dropped whenever an e-stop ran.
+static motor_ramp_limits_t ramp_limits;
+static motor_ramp_t ramp[2];
+static unsigned ramp_gen = 0;
+
+// PWM channels (logical; the backend maps them to its peripheral)
+static const pwm_backend_t *pwm;
+#define CH_LEFT_RPWM  PWM_CH_LEFT_RPWM
+#define CH_LEFT_LPWM  PWM_CH_LEFT_LPWM
+#define CH_RIGHT_RPWM PWM_CH_RIGHT_RPWM
+#define CH_RIGHT_LPWM PWM_CH_RIGHT_LPWM
+
+// Shadow of the duty last written to each channel. Writes that would not
+// change it are skipped, so a parked robot costs no PWM register traffic.
+// pwm_lock guards only the shadow and counters; no driver call is made
+// under it, since the LEDC calls take driver semaphores and may block.
+#define NUM_CHANNELS   PWM_BACKEND_CHANNELS
+#define SHADOW_UNKNOWN UINT32_MAX   // forces the next write (after an error)
+static uint32_t shadow_duty[NUM_CHANNELS] = {0};  // channels start at duty 0
+static motor_pwm_stats_t pwm_stats = {0};
+static portMUX_TYPE pwm_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Serialises every PWM driver sequence (writes, fades, fade stops), so the
+// ramp stage and an e-stop on the other core never interleave on a bridge.
+// A mutex, not a spinlock: the holder may block inside the driver.
+static SemaphoreHandle_t pwm_io_lock;
+
+static inline void pwm_io_take(void) {
+    xSemaphoreTake(pwm_io_lock, portMAX_DELAY);
+}
+
+static inline void pwm_io_give(void) {
+    xSemaphoreGive(pwm_io_lock);
+}
 
 /**
- * @brief Apply motor speed to hardware
+ * @brief Account for one channel update in the shadow and counters
  */
-static void apply_motor_speed(float left, float right, bool inverted_left, bool inverted_right) {
+static void note_write(uint8_t ch, uint32_t duty, esp_err_t ret) {
+    portENTER_CRITICAL(&pwm_lock);
+    pwm_stats.writes++;
+    if (ret == ESP_OK) {
+        shadow_duty[ch] = duty;
+    } else {
+        shadow_duty[ch] = SHADOW_UNKNOWN;
+        pwm_stats.errors++;
+    }
+    portEXIT_CRITICAL(&pwm_lock);
+}
+
+/**
+ * @brief Whether the shadow says @p ch already holds @p duty (counts a skip)
+ */
+static bool shadow_matches(uint8_t ch, uint32_t duty) {
+    portENTER_CRITICAL(&pwm_lock);
+    bool same = (shadow_duty[ch] == duty);
+    if (same) pwm_stats.skipped++;
+    portEXIT_CRITICAL(&pwm_lock);
+    return same;
+}
+
+/**
+ * @brief Update one H-bridge: on_ch drives @p duty, off_ch is held at 0
+ *
+ * The lowering side is written first, so RPWM and LPWM are never both
+ * driven during a direction change. Caller holds pwm_io_lock.
+ *
+ * @param force Write even if the shadow says the channel is already there
+ * @return esp_err_t First backend error, or ESP_OK
+ */
+static esp_err_t bridge_write(uint8_t on_ch, uint8_t off_ch, uint32_t duty, bool force) {
+    esp_err_t err = ESP_OK;
+    const uint8_t  ch[2]   = {off_ch, on_ch};
+    const uint32_t want[2] = {0, duty};
+    for (int i = 0; i < 2; i++) {
+        if (!force && shadow_matches(ch[i], want[i])) {
+            continue;
+        }
+        esp_err_t ret = pwm->write_duty(ch[i], want[i]);
+        note_write(ch[i], want[i], ret);
+        if (ret != ESP_OK && err == ESP_OK) err = ret;
+    }
+    return err;
+}
+
+/**
+ * @brief Apply motor speed to hardware (caller holds pwm_io_lock)
+ */
+static void apply_motor_speed(float left, float right, bool inverted_left, bool inverted_right,
+                              bool force) {
     if (inverted_left) left = -left;
     if (inverted_right) right = -right;
     
     // Left motor
     uint32_t left_duty = (uint32_t)(fabsf(left) * max_duty);
-    if (left >= 0.0f) {
-        pwm_ledc_set_duty(CH_LEFT_LPWM, left_duty);
-        pwm_ledc_set_duty(CH_LEFT_RPWM, 0);
-    } else {
-        pwm_ledc_set_duty(CH_LEFT_LPWM, 0);
-        pwm_ledc_set_duty(CH_LEFT_RPWM, left_duty);
+    esp_err_t ret = (left >= 0.0f)
+        ? bridge_write(CH_LEFT_LPWM, CH_LEFT_RPWM, left_duty, force)
+        : bridge_write(CH_LEFT_RPWM, CH_LEFT_LPWM, left_duty, force);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Left PWM write failed: %s", esp_err_to_name(ret));
     }
     
     // Right motor
     uint32_t right_duty = (uint32_t)(fabsf(right) * max_duty);
-    if (right >= 0.0f) {
-        pwm_ledc_set_duty(CH_RIGHT_LPWM, right_duty);
-        pwm_ledc_set_duty(CH_RIGHT_RPWM, 0);
-    } else {
-        pwm_ledc_set_duty(CH_RIGHT_LPWM, 0);
-        pwm_ledc_set_duty(CH_RIGHT_RPWM, right_duty);
+    ret = (right >= 0.0f)
+        ? bridge_write(CH_RIGHT_LPWM, CH_RIGHT_RPWM, right_duty, force)
+        : bridge_write(CH_RIGHT_RPWM, CH_RIGHT_LPWM, right_duty, force);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Right PWM write failed: %s", esp_err_to_name(ret));
     }
 }
 
+// Hardware-fade backend: forward drives LPWM, reverse drives RPWM
+static const struct {
+    uint8_t fwd_ch;
+    uint8_t rev_ch;
+} bridges[2] = {
+    {CH_LEFT_LPWM,  CH_LEFT_RPWM},
+    {CH_RIGHT_LPWM, CH_RIGHT_RPWM},
+};
+
 /**
- * @brief Motor ramping task
+ * @brief Hardware-fade counterpart of bridge_write()
+ *
+ * The shadow holds the duty each channel is fading to. Caller holds
+ * pwm_io_lock, so an e-stop cannot zero the bridge between the fade stop and
+ * the new fade and then have the fade overwrite its zero.
  */
-static void motor_ramp_task(void *arg) {
-    const uint32_t loop_rate_ms = 20; // 50Hz
-    
-    while (1) {
-        if (motor_cfg.ramp_rate_ms > 0) {
-            // Calculate ramp step per loop iteration
-            float max_change = (1.0f / motor_cfg.ramp_rate_ms) * loop_rate_ms;
-            
-            // Ramp left motor
-            float left_diff = target_left_speed - current_left_speed;
-            if (fabsf(left_diff) > max_change) {
-                current_left_speed += (left_diff > 0.0f) ? max_change : -max_change;
-            } else {
-                current_left_speed = target_left_speed;
-            }
-            
-            // Ramp right motor
-            float right_diff = target_right_speed - current_right_speed;
-            if (fabsf(right_diff) > max_change) {
-                current_right_speed += (right_diff > 0.0f) ? max_change : -max_change;
-            } else {
-                current_right_speed = target_right_speed;
-            }
+static esp_err_t bridge_fade(uint8_t on_ch, uint8_t off_ch, uint32_t duty, uint32_t time_ms) {
+    bool off_done = shadow_matches(off_ch, 0);
+    bool on_done  = shadow_matches(on_ch, duty);
+
+    esp_err_t err = ESP_OK;
+    if (!off_done) {
+        err = pwm->fade_stop(off_ch);
+        if (err == ESP_OK) err = pwm->write_duty(off_ch, 0);
+        note_write(off_ch, 0, err);
+    }
+    if (err == ESP_OK && !on_done) {
+        if (time_ms > 0) {
+            err = pwm->fade_to(on_ch, duty, time_ms);
         } else {
-            // No ramping
-            current_left_speed = target_left_speed;
-            current_right_speed = target_right_speed;
+            err = pwm->fade_stop(on_ch);
+            if (err == ESP_OK) err = pwm->write_duty(on_ch, duty);
+        }
+        note_write(on_ch, duty, err);
+    }
+    return err;
+}
+
+/**
+ * @brief Signed speed of a bridge read back from the PWM backend
+ *
+ * Includes fade progress. Hardware orientation (before un-inverting).
+ */
+static float read_bridge(int b) {
+    uint32_t fwd = pwm->get_duty(bridges[b].fwd_ch);
+    uint32_t rev = pwm->get_duty(bridges[b].rev_ch);
+    if (fwd > max_duty) fwd = 0;  // read error
+    if (rev > max_duty) rev = 0;
+    return ((float)fwd - (float)rev) / (float)max_duty;
+}
+
+/**
+ * @brief One hardware-fade ramp step for a bridge
+ *
+ * Same-direction changes become a single LEDC fade at the accel or decel
+ * rate. A reversal must pass through zero on one channel before the other
+ * may rise, so while the read-back speed and the target have opposite signs
+ * the bridge is stepped in software at the reverse rate. LEDC fades are
+ * linear: the jerk limit does not apply here. Caller holds pwm_io_lock.
+ *
+ * @param b      Bridge index (0 = left, 1 = right)
+ * @param target Target speed (-1.0 to +1.0)
+ * @param dt_us  Time since the previous ramp step
+ * @return float Speed read back at the start of this step
+ */
+static float fade_bridge(int b, float target, int64_t dt_us) {
+    bool invert = b ? motor_cfg.invert_right : motor_cfg.invert_left;
+    if (invert) target = -target;
+    float actual = read_bridge(b);
+    esp_err_t ret;
+
+    if (actual * target < 0.0f) {
+        float step = (ramp_limits.reverse > 0.0f)
+                   ? ramp_limits.reverse * (float)dt_us / 1e6f : 2.0f;
+        float diff = target - actual;
+        float next = (fabsf(diff) > step) ? actual + copysignf(step, diff) : target;
+        pwm->fade_stop(bridges[b].fwd_ch);
+        pwm->fade_stop(bridges[b].rev_ch);
+        uint32_t duty = (uint32_t)(fabsf(next) * max_duty);
+        ret = (next >= 0.0f)
+            ? bridge_write(bridges[b].fwd_ch, bridges[b].rev_ch, duty, true)
+            : bridge_write(bridges[b].rev_ch, bridges[b].fwd_ch, duty, true);
+    } else {
+        // Fading to zero keeps the side that is currently driven
+        bool fwd = (target != 0.0f) ? (target > 0.0f) : (actual >= 0.0f);
+        uint32_t duty = (uint32_t)(fabsf(target) * max_duty);
+        uint32_t now  = (uint32_t)(fabsf(actual) * max_duty + 0.5f);
+        uint32_t delta = (duty > now) ? duty - now : now - duty;
+        uint32_t ms_full = (duty > now) ? motor_cfg.ramp_rate_ms : motor_cfg.decel_ms;
+        uint32_t time_ms = delta * ms_full / max_duty;
+        ret = fwd ? bridge_fade(bridges[b].fwd_ch, bridges[b].rev_ch, duty, time_ms)
+                  : bridge_fade(bridges[b].rev_ch, bridges[b].fwd_ch, duty, time_ms);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%s PWM fade failed: %s", b ? "Right" : "Left", esp_err_to_name(ret));
+    }
+    return invert ? -actual : actual;
+}
+
+/**
+ * @brief Zero all four channels, stopping any hardware fades first
+ *
+ * Takes pwm_io_lock, so it waits for a ramp step that is mid-write and no
+ * fade can be restarted between the fade stop and the zero.
+ *
+ * @param force Write even if the shadow says the channel is already at 0
+ */
+static void zero_outputs(bool force) {
+    pwm_io_take();
+    if (motor_cfg.hw_fade) {
+        // A running fade would overwrite the zero; the shadow holds fade targets
+        for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++) {
+            pwm->fade_stop(ch);
+        }
+        force = true;
+    }
+    apply_motor_speed(0.0f, 0.0f, false, false, force);
+    pwm_io_give();
+}
+
+/**
+ * @brief Record how long the newest target waited before reaching the PWM
+ */
+static void record_apply_latency(int64_t set_us, int64_t now_us) {
+    uint32_t latency_us = (uint32_t)(now_us - set_us);
+    portENTER_CRITICAL(&motor_lock);
+    pipeline_stats.last_us = latency_us;
+    if (latency_us > pipeline_stats.max_us) pipeline_stats.max_us = latency_us;
+    pipeline_stats.samples++;
+    latency_sum_us += latency_us;
+    pipeline_stats.avg_us = (uint32_t)(latency_sum_us / pipeline_stats.samples);
+    portEXIT_CRITICAL(&motor_lock);
+}
+
+/**
+ * @brief One ramp step toward the targets, then write PWM
+ */
+static void ramp_and_apply(void) {
+    unsigned gen = atomic_load(&stop_gen);
+    int64_t start_us = esp_timer_get_time();
+    int64_t dt_us = (last_ramp_us != 0) ? start_us - last_ramp_us
+                                        : 1000000 / motor_cfg.loop_rate_hz;
+    if (dt_us > RAMP_DT_MAX_US) dt_us = RAMP_DT_MAX_US;
+    last_ramp_us = start_us;
+
+    portENTER_CRITICAL(&motor_lock);
+    float left_target  = target_left_speed;
+    float right_target = target_right_speed;
+    int64_t set_us     = target_set_us;
+    int64_t trace_us   = trace_pending_us;
+    target_set_us      = 0;
+    trace_pending_us   = 0;
+    portEXIT_CRITICAL(&motor_lock);
+
+    int64_t pwm_start_us;
+    if (motor_cfg.hw_fade) {
+        // The LEDC steps the duty; the ramp stage only retargets fades
+        pwm_start_us = esp_timer_get_time();
+        pwm_io_take();
+        current_left_speed  = fade_bridge(0, left_target, dt_us);
+        current_right_speed = fade_bridge(1, right_target, dt_us);
+        pwm_io_give();
+    } else {
+        if (gen != ramp_gen) {
+            // An e-stop zeroed the speeds; restart the S-curve from rest
+            ramp[0].rate = ramp[1].rate = 0.0f;
+            ramp_gen = gen;
         }
-        
+        float dt_s = (float)dt_us / 1e6f;
+        ramp[0].speed = current_left_speed;
+        ramp[1].speed = current_right_speed;
+        current_left_speed  = motor_ramp_step(&ramp[0], &ramp_limits, left_target, dt_s);
+        current_right_speed = motor_ramp_step(&ramp[1], &ramp_limits, right_target, dt_s);
+
+        pwm_start_us = esp_timer_get_time();
+        pwm_io_take();
         apply_motor_speed(current_left_speed, current_right_speed,
-                          motor_cfg.invert_left, motor_cfg.invert_right);
-        
-        vTaskDelay(pdMS_TO_TICKS(loop_rate_ms));
+                          motor_cfg.invert_left, motor_cfg.invert_right, false);
+        pwm_io_give();
+    }
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&motor_lock);
+    tick_timing.ramp_us = (uint32_t)(pwm_start_us - start_us);
+    tick_timing.pwm_us  = (uint32_t)(now_us - pwm_start_us);
+    tick_timing.runs++;
+    portEXIT_CRITICAL(&motor_lock);
+
+    if ((gen & 1u) || atomic_load(&stop_gen) != gen) {
+        current_left_speed = 0.0f;
+        current_right_speed = 0.0f;
+        zero_outputs(false);
+        return;
+    }
+
+    if (set_us != 0) {
+        record_apply_latency(set_us, now_us);
+    }
+    if (trace_us != 0) {
+        portENTER_CRITICAL(&motor_lock);
+        trace_applied_us    = trace_us;
+        trace_applied_at_us = now_us;
+        portEXIT_CRITICAL(&motor_lock);
+    }
+}
+
+/**
+ * @brief Motor ramping task (two-stage pipeline only)
+ */
+static void motor_ramp_task(void *arg) {
+    TickType_t period = pdMS_TO_TICKS(1000 / motor_cfg.loop_rate_hz);
+    if (period == 0) period = 1;
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        ramp_and_apply();
+        vTaskDelayUntil(&last_wake, period);
     }
 }
 
@@ -101,34 +398,63 @@ esp_err_t motor_bts7960_init(const motor_config_t *config) {
     }
     
     motor_cfg = *config;
-    max_duty = pwm_ledc_get_max_duty(config->pwm_resolution);
+    pwm = config->pwm_backend ? config->pwm_backend : &pwm_backend_ledc;
+    if (motor_cfg.hw_fade && pwm->fade_to == NULL) {
+        ESP_LOGW(TAG, "PWM backend '%s' cannot fade; using the software ramp", pwm->name);
+        motor_cfg.hw_fade = false;
+    }
+    if (motor_cfg.loop_rate_hz == 0) {
+        motor_cfg.loop_rate_hz = 50;
+    }
+    max_duty = pwm_backend_max_duty(config->pwm_resolution);
+
+    ramp_limits = (motor_ramp_limits_t){
+        .accel   = motor_ramp_rate_from_ms(config->ramp_rate_ms),
+        .decel   = motor_ramp_rate_from_ms(config->decel_ms),
+        .reverse = motor_ramp_rate_from_ms(config->reverse_ms),
+    };
+    if (config->jerk_ms > 0 && ramp_limits.accel > 0.0f) {
+        // S-curve: the slew rate builds up to the accel limit over jerk_ms
+        ramp_limits.jerk = ramp_limits.accel * 1000.0f / (float)config->jerk_ms;
+    }
     
     ESP_LOGI(TAG, "Initializing BTS7960 motor driver");
     ESP_LOGI(TAG, "  PWM: %lu Hz @ %d-bit (%lu max duty)", 
              config->pwm_freq_hz, config->pwm_resolution, max_duty);
-    ESP_LOGI(TAG, "  Ramp rate: %lu ms", config->ramp_rate_ms);
+    ESP_LOGI(TAG, "  PWM backend: %s", pwm->name);
+    ESP_LOGI(TAG, "  Ramp: accel %lu ms, decel %lu ms, reverse %lu ms, jerk %lu ms (%s)",
+             config->ramp_rate_ms, config->decel_ms, config->reverse_ms, config->jerk_ms,
+             motor_cfg.hw_fade ? "LEDC hardware fade" : "software");
+    if (motor_cfg.hw_fade && config->jerk_ms > 0) {
+        ESP_LOGW(TAG, "Hardware fades are linear; jerk limit ignored");
+    }
+    ESP_LOGI(TAG, "  Pipeline: %s", config->external_tick ? "single stage" : "two stage");
+    if (!config->external_tick) {
+        ESP_LOGI(TAG, "  Ramp task rate: %lu Hz", motor_cfg.loop_rate_hz);
+    }
     
+    pwm_io_lock = xSemaphoreCreateMutex();
+    if (pwm_io_lock == NULL) {
+        ESP_LOGE(TAG, "Failed to create PWM lock");
+        return ESP_ERR_NO_MEM;
+    }
+
     // Initialize PWM channels
-    pwm_ledc_config_t pwm_cfg = {
+    pwm_backend_config_t pwm_cfg = {
+        .gpio = {
+            [CH_LEFT_RPWM]  = config->left_rpwm,
+            [CH_LEFT_LPWM]  = config->left_lpwm,
+            [CH_RIGHT_RPWM] = config->right_rpwm,
+            [CH_RIGHT_LPWM] = config->right_lpwm,
+        },
         .freq_hz = config->pwm_freq_hz,
         .resolution = config->pwm_resolution,
+        .dead_time_ns = config->dead_time_ns,
+        .fault_gpio = {config->fault_gpio[0], config->fault_gpio[1]},
+        .fault_active_high = config->fault_active_high,
+        .fade = motor_cfg.hw_fade,
     };
-    
-    pwm_cfg.gpio_num = config->left_rpwm;
-    pwm_cfg.ledc_channel = CH_LEFT_RPWM;
-    ESP_ERROR_CHECK(pwm_ledc_init(&pwm_cfg));
-    
-    pwm_cfg.gpio_num = config->left_lpwm;
-    pwm_cfg.ledc_channel = CH_LEFT_LPWM;
-    ESP_ERROR_CHECK(pwm_ledc_init(&pwm_cfg));
-    
-    pwm_cfg.gpio_num = config->right_rpwm;
-    pwm_cfg.ledc_channel = CH_RIGHT_RPWM;
-    ESP_ERROR_CHECK(pwm_ledc_init(&pwm_cfg));
-    
-    pwm_cfg.gpio_num = config->right_lpwm;
-    pwm_cfg.ledc_channel = CH_RIGHT_LPWM;
-    ESP_ERROR_CHECK(pwm_ledc_init(&pwm_cfg));
+    ESP_ERROR_CHECK(pwm->init(&pwm_cfg));
     
     // Initialize enable pins
     gpio_config_t io_conf = {
@@ -142,17 +468,21 @@ esp_err_t motor_bts7960_init(const motor_config_t *config) {
     ESP_ERROR_CHECK(gpio_config(&io_conf));
     
     // Enable all outputs
-    gpio_set_level(config->left_ren, 1);
-    gpio_set_level(config->left_len, 1);
-    gpio_set_level(config->right_ren, 1);
-    gpio_set_level(config->right_len, 1);
+    en_pins[0] = config->left_ren;
+    en_pins[1] = config->left_len;
+    en_pins[2] = config->right_ren;
+    en_pins[3] = config->right_len;
+    motor_enable_outputs();
     
-    // Start ramping task
-    BaseType_t ret = xTaskCreate(motor_ramp_task, "motor_ramp",
-                                  2048, NULL, 4, NULL);
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create ramp task");
-        return ESP_FAIL;
+    // Start ramping task unless the control loop drives motor_bts7960_tick()
+    if (!config->external_tick) {
+        BaseType_t ret = xTaskCreatePinnedToCore(motor_ramp_task, "motor_ramp",
+                                                 2048, NULL, 4, NULL,
+                                                 config->ramp_task_core);
+        if (ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create ramp task");
+            return ESP_FAIL;
+        }
     }
     
     ESP_LOGI(TAG, "Motor driver initialized");
@@ -160,35 +490,147 @@ esp_err_t motor_bts7960_init(const motor_config_t *config) {
 }
 
 esp_err_t motor_set_speeds(float left_speed, float right_speed) {
+    return motor_set_speeds_traced(left_speed, right_speed, 0);
+}
+
+esp_err_t motor_set_speeds_traced(float left_speed, float right_speed, int64_t trace_us) {
     // Clamp speeds
     if (left_speed > 1.0f) left_speed = 1.0f;
     if (left_speed < -1.0f) left_speed = -1.0f;
     if (right_speed > 1.0f) right_speed = 1.0f;
     if (right_speed < -1.0f) right_speed = -1.0f;
     
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&motor_lock);
+    if (left_speed != target_left_speed || right_speed != target_right_speed) {
+        // Keep the oldest stamp if the previous target was never applied
+        if (target_set_us == 0) {
+            target_set_us = now_us;
+        }
+    }
     target_left_speed = left_speed;
     target_right_speed = right_speed;
+    if (trace_us != 0) {
+        trace_pending_us = trace_us;
+    }
+    portEXIT_CRITICAL(&motor_lock);
     
     return ESP_OK;
 }
 
+void motor_bts7960_tick(void) {
+    ramp_and_apply();
+}
+
+bool motor_take_applied_trace(int64_t *trace_us, int64_t *applied_us) {
+    portENTER_CRITICAL(&motor_lock);
+    bool have = (trace_applied_us != 0);
+    if (have) {
+        if (trace_us)   *trace_us   = trace_applied_us;
+        if (applied_us) *applied_us = trace_applied_at_us;
+        trace_applied_us = 0;
+    }
+    portEXIT_CRITICAL(&motor_lock);
+    return have;
+}
+
+void motor_get_tick_timing(motor_tick_timing_t *out) {
+    if (!out) return;
+    portENTER_CRITICAL(&motor_lock);
+    *out = tick_timing;
+    portEXIT_CRITICAL(&motor_lock);
+}
+
+void motor_get_pipeline_stats(motor_pipeline_stats_t *out) {
+    if (!out) return;
+    portENTER_CRITICAL(&motor_lock);
+    *out = pipeline_stats;
+    portEXIT_CRITICAL(&motor_lock);
+}
+
+void motor_get_pwm_stats(motor_pwm_stats_t *out) {
+    if (!out) return;
+    portENTER_CRITICAL(&pwm_lock);
+    *out = pwm_stats;
+    portEXIT_CRITICAL(&pwm_lock);
+    out->faults = motor_get_pwm_fault_count();
+}
+
+uint32_t motor_get_pwm_fault_count(void) {
+    return (pwm && pwm->fault_count) ? pwm->fault_count() : 0;
+}
+
+esp_err_t motor_clear_pwm_fault(void) {
+    if (!pwm || !pwm->fault_clear) {
+        return ESP_OK;
+    }
+    esp_err_t ret = pwm->fault_clear();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "PWM fault still active: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
 void motor_get_speeds(float *left_target, float *right_target,
                       float *left_actual, float *right_actual) {
     if (left_target)  *left_target  = target_left_speed;
     if (right_target) *right_target = target_right_speed;
+    if (motor_cfg.hw_fade) {
+        // Mid-fade duty lives only in the peripheral
+        if (left_actual) {
+            float v = read_bridge(0);
+            *left_actual = motor_cfg.invert_left ? -v : v;
+        }
+        if (right_actual) {
+            float v = read_bridge(1);
+            *right_actual = motor_cfg.invert_right ? -v : v;
+        }
+        return;
+    }
     if (left_actual)  *left_actual  = current_left_speed;
     if (right_actual) *right_actual = current_right_speed;
 }
 
 esp_err_t motor_emergency_stop(void) {
     // Immediate stop (bypass ramping)
+    atomic_fetch_add(&stop_gen, 1);
+    portENTER_CRITICAL(&motor_lock);
     target_left_speed = 0.0f;
     target_right_speed = 0.0f;
+    target_set_us = 0;
+    trace_pending_us = 0;
+    portEXIT_CRITICAL(&motor_lock);
     current_left_speed = 0.0f;
     current_right_speed = 0.0f;
     
-    apply_motor_speed(0.0f, 0.0f, false, false);
+    zero_outputs(true);  // never trust the shadow here
+    atomic_store(&last_stop_us, esp_timer_get_time());
+    atomic_fetch_add(&stop_gen, 1);
     
     ESP_LOGW(TAG, "EMERGENCY STOP");
     return ESP_OK;
 }
+
+int64_t motor_get_last_stop_time_us(void) {
+    return atomic_load(&last_stop_us);
+}
+
+void IRAM_ATTR motor_cut_outputs(void) {
+    // Straight to the GPIO registers: no driver lock, nothing in flash
+    for (int i = 0; i < 4; i++) {
+        gpio_ll_set_level(&GPIO, en_pins[i], 0);
+    }
+    atomic_store(&outputs_enabled, false);
+}
+
+void motor_enable_outputs(void) {
+    for (int i = 0; i < 4; i++) {
+        gpio_set_level(en_pins[i], 1);
+    }
+    atomic_store(&outputs_enabled, true);
+}
+
+bool motor_outputs_enabled(void) {
+    return atomic_load(&outputs_enabled);
+}
@@ -0,0 +1,55 @@
+/**
+ * @file motor_ramp.c
+ * @brief Slew-rate / S-curve ramp engine implementation
+ */
+
+#include "motor_ramp.h"
+#include <math.h>
+
+float motor_ramp_step(motor_ramp_t *ramp, const motor_ramp_limits_t *limits,
+                      float target, float dt_s) {
+    float speed = ramp->speed;
+    float dist  = target - speed;
+    if (dist == 0.0f || dt_s <= 0.0f) {
+        ramp->rate = 0.0f;
+        return speed;
+    }
+
+    // Which limit applies to this step
+    float limit;
+    if (speed == 0.0f || (dist > 0.0f) == (speed > 0.0f)) {
+        limit = limits->accel;
+    } else if (target * speed < 0.0f) {
+        limit = limits->reverse;
+    } else {
+        limit = limits->decel;
+    }
+    if (limit <= 0.0f) {
+        ramp->speed = target;
+        ramp->rate  = 0.0f;
+        return target;
+    }
+
+    float dir = (dist > 0.0f) ? 1.0f : -1.0f;
+    float rate;
+    if (limits->jerk > 0.0f) {
+        // Fastest rate that can still be wound down to 0 by the target
+        float stop_rate = sqrtf(2.0f * limits->jerk * fabsf(dist));
+        float want = dir * fminf(limit, stop_rate);
+        float dj   = limits->jerk * dt_s;
+        float diff = want - ramp->rate;
+        rate = ramp->rate + fmaxf(-dj, fminf(dj, diff));
+    } else {
+        rate = dir * limit;
+    }
+
+    float step = rate * dt_s;
+    if ((dir > 0.0f && step >= dist) || (dir < 0.0f && step <= dist)) {
+        ramp->speed = target;
+        ramp->rate  = 0.0f;
+        return target;
+    }
+    ramp->speed = speed + step;
+    ramp->rate  = rate;
+    return ramp->speed;
+}
@@ -4,44 +4,56 @@
  */
 
 #include "pwm_ledc.h"
+#include "pwm_backend.h"
 #include "driver/ledc.h"
 #include "esp_log.h"
 
 static const char *TAG = "pwm_ledc";
 
-esp_err_t pwm_ledc_init(const pwm_ledc_config_t *config) {
-    if (config == NULL) {
-        ESP_LOGE(TAG, "NULL config");
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    // Configure timer
+static esp_err_t config_timer(uint32_t freq_hz, uint8_t resolution) {
     ledc_timer_config_t timer_conf = {
         .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = config->resolution,
+        .duty_resolution = resolution,
         .timer_num = LEDC_TIMER_0,
-        .freq_hz = config->freq_hz,
+        .freq_hz = freq_hz,
         .clk_cfg = LEDC_AUTO_CLK,
     };
     esp_err_t ret = ledc_timer_config(&timer_conf);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure timer: %s", esp_err_to_name(ret));
-        return ret;
     }
-    
-    // Configure channel
+    return ret;
+}
+
+static esp_err_t config_channel(int gpio_num, uint8_t channel) {
     ledc_channel_config_t ch_conf = {
-        .gpio_num = config->gpio_num,
+        .gpio_num = gpio_num,
         .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = config->ledc_channel,
+        .channel = channel,
         .intr_type = LEDC_INTR_DISABLE,
         .timer_sel = LEDC_TIMER_0,
         .duty = 0,
         .hpoint = 0,
     };
-    ret = ledc_channel_config(&ch_conf);
+    esp_err_t ret = ledc_channel_config(&ch_conf);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure channel: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t pwm_ledc_init(const pwm_ledc_config_t *config) {
+    if (config == NULL) {
+        ESP_LOGE(TAG, "NULL config");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = config_timer(config->freq_hz, config->resolution);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = config_channel(config->gpio_num, config->ledc_channel);
+    if (ret != ESP_OK) {
         return ret;
     }
     
@@ -66,3 +78,77 @@ esp_err_t pwm_ledc_set_duty(uint8_t channel, uint32_t duty) {
     
     return ESP_OK;
 }
+
+esp_err_t pwm_ledc_write_duty(uint8_t channel, uint32_t duty) {
+    esp_err_t ret = ledc_set_duty(LEDC_LOW_SPEED_MODE, channel, duty);
+    if (ret == ESP_OK) {
+        ret = ledc_update_duty(LEDC_LOW_SPEED_MODE, channel);
+    }
+    return ret;
+}
+
+esp_err_t pwm_ledc_fade_init(void) {
+    esp_err_t ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install fade service: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t pwm_ledc_fade_to(uint8_t channel, uint32_t duty, uint32_t time_ms) {
+    // A new fade on a busy channel would block until the old one finishes
+    esp_err_t ret = ledc_fade_stop(LEDC_LOW_SPEED_MODE, channel);
+    if (ret == ESP_OK) {
+        ret = ledc_set_fade_with_time(LEDC_LOW_SPEED_MODE, channel, duty, (int)time_ms);
+    }
+    if (ret == ESP_OK) {
+        ret = ledc_fade_start(LEDC_LOW_SPEED_MODE, channel, LEDC_FADE_NO_WAIT);
+    }
+    return ret;
+}
+
+esp_err_t pwm_ledc_fade_stop(uint8_t channel) {
+    return ledc_fade_stop(LEDC_LOW_SPEED_MODE, channel);
+}
+
+uint32_t pwm_ledc_get_duty(uint8_t channel) {
+    return ledc_get_duty(LEDC_LOW_SPEED_MODE, channel);
+}
+
+// ---------------------------------------------------------------------------
+//  Motor PWM backend: logical channel n = LEDC channel n, one shared timer
+// ---------------------------------------------------------------------------
+
+static esp_err_t backend_init(const pwm_backend_config_t *config) {
+    // One timer for all four channels: configure it once
+    esp_err_t ret = config_timer(config->freq_hz, config->resolution);
+    for (uint8_t ch = 0; ch < PWM_BACKEND_CHANNELS && ret == ESP_OK; ch++) {
+        ret = config_channel(config->gpio[ch], ch);
+    }
+    if (ret == ESP_OK && config->fade) {
+        ret = pwm_ledc_fade_init();
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (config->dead_time_ns > 0) {
+        ESP_LOGW(TAG, "LEDC has no dead-time generator; dead time ignored");
+    }
+    for (int i = 0; i < PWM_BACKEND_FAULTS; i++) {
+        if (config->fault_gpio[i] >= 0) {
+            ESP_LOGW(TAG, "LEDC has no fault inputs; GPIO %d ignored", config->fault_gpio[i]);
+        }
+    }
+    ESP_LOGI(TAG, "LEDC backend: %lu Hz @ %d-bit, timer 0, channels 0-3",
+             config->freq_hz, config->resolution);
+    return ESP_OK;
+}
+
+const pwm_backend_t pwm_backend_ledc = {
+    .name       = "ledc",
+    .init       = backend_init,
+    .write_duty = pwm_ledc_write_duty,
+    .get_duty   = pwm_ledc_get_duty,
+    .fade_to    = pwm_ledc_fade_to,
+    .fade_stop  = pwm_ledc_fade_stop,
+};
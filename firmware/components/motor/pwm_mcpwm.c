@@ -0,0 +1,246 @@
+/**
+ * @file pwm_mcpwm.c
+ * @brief MCPWM motor PWM backend
+ *
+ * One MCPWM timer and operator per H-bridge, both in group 0. The operator's
+ * generator A drives RPWM and generator B drives LPWM. The right bridge's
+ * timer is synced to the left one's TEZ with a half-period phase offset,
+ * so the two bridges switch at fixed, interleaved points: their current
+ * pulses do not line up on the battery.
+ *
+ * Dead time is a rising-edge delay on every output. A direction change
+ * lowers one side and raises the other in the same period; the delay keeps
+ * RPWM and LPWM from being high at the same time while the half-bridges
+ * switch over. An operator has one rising-edge delay (RED) unit and one
+ * falling-edge delay (FED) unit, not one per generator. Generator A takes
+ * RED. Generator B is generated inverted and takes FED with the output
+ * inverted back, which at the pin is again a delayed rising edge.
+ * tools/mcpwm_deadtime_check.c runs this file against a model of the
+ * operator and checks the edges.
+ *
+ * GPIO fault inputs trip a one-shot brake on both operators, which forces
+ * all four outputs low in hardware, with no software in the path. The brake
+ * latches until fault_clear() succeeds after the input goes inactive.
+ */
+
+#include "pwm_backend.h"
+#include "driver/mcpwm_prelude.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+
+static const char *TAG = "pwm_mcpwm";
+
+#define MCPWM_GROUP          0
+#define MCPWM_RESOLUTION_HZ  40000000  // 2000 ticks per period at 20 kHz
+#define NUM_BRIDGES          2
+
+static mcpwm_timer_handle_t timers[NUM_BRIDGES];
+static mcpwm_oper_handle_t  opers[NUM_BRIDGES];
+static mcpwm_cmpr_handle_t  cmprs[PWM_BACKEND_CHANNELS];
+static mcpwm_gen_handle_t   gens[PWM_BACKEND_CHANNELS];
+static mcpwm_sync_handle_t  sync_src;
+static mcpwm_fault_handle_t faults[PWM_BACKEND_FAULTS];
+
+static uint32_t period_ticks;
+static uint32_t max_duty;
+static uint32_t duty_now[PWM_BACKEND_CHANNELS];  // read-back (the comparators are write-only)
+static bool     gen_inverted[PWM_BACKEND_CHANNELS];  // generated active low (B legs with dead time)
+static atomic_uint fault_trips = 0;
+
+static bool IRAM_ATTR on_fault_enter(mcpwm_fault_handle_t fault,
+                                     const mcpwm_fault_event_data_t *edata, void *ctx) {
+    atomic_fetch_add(&fault_trips, 1);
+    return false;
+}
+
+/**
+ * @brief Timer, operator, comparators and generators for one bridge
+ */
+static esp_err_t init_bridge(int b, const pwm_backend_config_t *config, uint32_t dead_ticks) {
+    mcpwm_timer_config_t timer_cfg = {
+        .group_id      = MCPWM_GROUP,
+        .clk_src       = MCPWM_TIMER_CLK_SRC_DEFAULT,
+        .resolution_hz = MCPWM_RESOLUTION_HZ,
+        .count_mode    = MCPWM_TIMER_COUNT_MODE_UP,
+        .period_ticks  = period_ticks,
+    };
+    esp_err_t ret = mcpwm_new_timer(&timer_cfg, &timers[b]);
+    if (ret != ESP_OK) return ret;
+
+    mcpwm_operator_config_t oper_cfg = { .group_id = MCPWM_GROUP };
+    ret = mcpwm_new_operator(&oper_cfg, &opers[b]);
+    if (ret == ESP_OK) ret = mcpwm_operator_connect_timer(opers[b], timers[b]);
+
+    for (int g = 0; g < 2 && ret == ESP_OK; g++) {
+        int ch = b * 2 + g;
+        bool inv = (g == 1 && dead_ticks > 0);
+        gen_inverted[ch] = inv;
+        mcpwm_generator_action_t on  = inv ? MCPWM_GEN_ACTION_LOW : MCPWM_GEN_ACTION_HIGH;
+        mcpwm_generator_action_t off = inv ? MCPWM_GEN_ACTION_HIGH : MCPWM_GEN_ACTION_LOW;
+
+        // Compare updates land on the period boundary, so both sides of a
+        // bridge change in the same period
+        mcpwm_comparator_config_t cmpr_cfg = { .flags.update_cmp_on_tez = true };
+        ret = mcpwm_new_comparator(opers[b], &cmpr_cfg, &cmprs[ch]);
+        if (ret == ESP_OK) ret = mcpwm_comparator_set_compare_value(cmprs[ch], 0);
+
+        mcpwm_generator_config_t gen_cfg = { .gen_gpio_num = config->gpio[ch] };
+        if (ret == ESP_OK) ret = mcpwm_new_generator(opers[b], &gen_cfg, &gens[ch]);
+        if (ret == ESP_OK) {
+            ret = mcpwm_generator_set_action_on_timer_event(gens[ch],
+                MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP,
+                                             MCPWM_TIMER_EVENT_EMPTY, on));
+        }
+        if (ret == ESP_OK) {
+            ret = mcpwm_generator_set_action_on_compare_event(gens[ch],
+                MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP,
+                                               cmprs[ch], off));
+        }
+        // Duty 0 is a forced low level; a zero compare would still glitch at TEZ
+        if (ret == ESP_OK) ret = mcpwm_generator_set_force_level(gens[ch], inv ? 1 : 0, true);
+        if (ret == ESP_OK && dead_ticks > 0) {
+            // A: delay the rising edge. B (inverted): delay the falling edge,
+            // then invert, which delays the rising edge at the pin
+            mcpwm_dead_time_config_t dt = (g == 0)
+                ? (mcpwm_dead_time_config_t){ .posedge_delay_ticks = dead_ticks }
+                : (mcpwm_dead_time_config_t){ .negedge_delay_ticks = dead_ticks,
+                                              .flags.invert_output = true };
+            ret = mcpwm_generator_set_dead_time(gens[ch], gens[ch], &dt);
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Fault inputs: one-shot brake on every operator, outputs forced low
+ */
+static esp_err_t init_faults(const pwm_backend_config_t *config) {
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < PWM_BACKEND_FAULTS && ret == ESP_OK; i++) {
+        if (config->fault_gpio[i] < 0) continue;
+
+        mcpwm_gpio_fault_config_t fault_cfg = {
+            .group_id = MCPWM_GROUP,
+            .gpio_num = config->fault_gpio[i],
+            .flags.active_level = config->fault_active_high ? 1 : 0,
+        };
+        ret = mcpwm_new_gpio_fault(&fault_cfg, &faults[i]);
+        if (ret == ESP_OK) {
+            mcpwm_fault_event_callbacks_t cbs = { .on_fault_enter = on_fault_enter };
+            ret = mcpwm_fault_register_event_callbacks(faults[i], &cbs, NULL);
+        }
+        for (int b = 0; b < NUM_BRIDGES && ret == ESP_OK; b++) {
+            mcpwm_brake_config_t brake = {
+                .fault      = faults[i],
+                .brake_mode = MCPWM_OPER_BRAKE_MODE_OST,
+            };
+            ret = mcpwm_operator_set_brake_on_fault(opers[b], &brake);
+        }
+        ESP_LOGI(TAG, "Fault input %d on GPIO %d (active %s)", i, config->fault_gpio[i],
+                 config->fault_active_high ? "high" : "low");
+    }
+    for (int ch = 0; ch < PWM_BACKEND_CHANNELS && ret == ESP_OK; ch++) {
+        ret = mcpwm_generator_set_action_on_brake_event(gens[ch],
+            MCPWM_GEN_BRAKE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP,
+                                         MCPWM_OPER_BRAKE_MODE_OST, MCPWM_GEN_ACTION_LOW));
+    }
+    return ret;
+}
+
+static esp_err_t backend_init(const pwm_backend_config_t *config) {
+    if (config->freq_hz == 0 || MCPWM_RESOLUTION_HZ / config->freq_hz < 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    period_ticks = MCPWM_RESOLUTION_HZ / config->freq_hz;
+    max_duty     = pwm_backend_max_duty(config->resolution);
+    uint32_t dead_ticks = (uint32_t)((uint64_t)config->dead_time_ns * MCPWM_RESOLUTION_HZ
+                                     / 1000000000u);
+
+    esp_err_t ret = ESP_OK;
+    for (int b = 0; b < NUM_BRIDGES && ret == ESP_OK; b++) {
+        ret = init_bridge(b, config, dead_ticks);
+    }
+
+    // Right bridge follows the left one's period, half a period behind
+    if (ret == ESP_OK) {
+        mcpwm_timer_sync_src_config_t src_cfg = { .timer_event = MCPWM_TIMER_EVENT_EMPTY };
+        ret = mcpwm_new_timer_sync_src(timers[0], &src_cfg, &sync_src);
+    }
+    if (ret == ESP_OK) {
+        mcpwm_timer_sync_phase_config_t phase = {
+            .sync_src    = sync_src,
+            .count_value = period_ticks / 2,
+            .direction   = MCPWM_TIMER_DIRECTION_UP,
+        };
+        ret = mcpwm_timer_set_phase_on_sync(timers[1], &phase);
+    }
+
+    if (ret == ESP_OK) ret = init_faults(config);
+
+    for (int b = 0; b < NUM_BRIDGES && ret == ESP_OK; b++) {
+        ret = mcpwm_timer_enable(timers[b]);
+        if (ret == ESP_OK) ret = mcpwm_timer_start_stop(timers[b], MCPWM_TIMER_START_NO_STOP);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "MCPWM init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (config->fade) {
+        ESP_LOGW(TAG, "MCPWM has no fade engine; using the software ramp");
+    }
+    ESP_LOGI(TAG, "MCPWM backend: %lu Hz, %lu ticks/period, dead time %lu ns (%lu ticks)",
+             config->freq_hz, period_ticks, config->dead_time_ns, dead_ticks);
+    return ESP_OK;
+}
+
+static esp_err_t backend_write_duty(uint8_t channel, uint32_t duty) {
+    if (channel >= PWM_BACKEND_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (duty > max_duty) duty = max_duty;
+
+    // Scale the motor layer's duty range to timer ticks; full duty = period
+    // never matches the compare, so the output stays high
+    uint32_t cmp = (uint32_t)((uint64_t)duty * period_ticks / max_duty);
+    esp_err_t ret = mcpwm_comparator_set_compare_value(cmprs[channel], cmp);
+    if (ret == ESP_OK) {
+        int low = gen_inverted[channel] ? 1 : 0;
+        ret = mcpwm_generator_set_force_level(gens[channel], duty ? -1 : low, true);
+    }
+    if (ret == ESP_OK) {
+        duty_now[channel] = duty;
+    }
+    return ret;
+}
+
+static uint32_t backend_get_duty(uint8_t channel) {
+    return (channel < PWM_BACKEND_CHANNELS) ? duty_now[channel] : UINT32_MAX;
+}
+
+static uint32_t backend_fault_count(void) {
+    return atomic_load(&fault_trips);
+}
+
+static esp_err_t backend_fault_clear(void) {
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < PWM_BACKEND_FAULTS; i++) {
+        if (faults[i] == NULL) continue;
+        for (int b = 0; b < NUM_BRIDGES; b++) {
+            // Refused while the input is still active
+            esp_err_t r = mcpwm_operator_recover_from_fault(opers[b], faults[i]);
+            if (r != ESP_OK && ret == ESP_OK) ret = r;
+        }
+    }
+    return ret;
+}
+
+const pwm_backend_t pwm_backend_mcpwm = {
+    .name        = "mcpwm",
+    .init        = backend_init,
+    .write_duty  = backend_write_duty,
+    .get_duty    = backend_get_duty,
+    .fault_count = backend_fault_count,
+    .fault_clear = backend_fault_clear,
+};
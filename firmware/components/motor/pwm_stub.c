@@ -0,0 +1,65 @@
+/**
+ * @file pwm_stub.c
+ * @brief Recording PWM backend implementation
+ *
+ * Not thread-safe by itself: the motor layer calls write_duty() under its
+ * pwm_io_lock, and readers are expected to look once the writers are idle.
+ */
+
+#include "pwm_stub.h"
+#include <string.h>
+
+static pwm_backend_config_t stub_cfg;
+static uint32_t duty[PWM_BACKEND_CHANNELS];
+static pwm_stub_write_t log_buf[PWM_STUB_LOG_LEN];
+static uint32_t writes;
+
+static esp_err_t stub_init(const pwm_backend_config_t *config) {
+    stub_cfg = *config;
+    memset(duty, 0, sizeof(duty));
+    writes = 0;
+    return ESP_OK;
+}
+
+static esp_err_t stub_write_duty(uint8_t channel, uint32_t value) {
+    if (channel >= PWM_BACKEND_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    duty[channel] = value;
+    log_buf[writes % PWM_STUB_LOG_LEN] = (pwm_stub_write_t){writes, channel, value};
+    writes++;
+    return ESP_OK;
+}
+
+static uint32_t stub_get_duty(uint8_t channel) {
+    return (channel < PWM_BACKEND_CHANNELS) ? duty[channel] : UINT32_MAX;
+}
+
+size_t pwm_stub_get_writes(pwm_stub_write_t *out, size_t max) {
+    uint32_t kept  = (writes < PWM_STUB_LOG_LEN) ? writes : PWM_STUB_LOG_LEN;
+    size_t   count = (kept < max) ? kept : max;
+    uint32_t first = writes - (uint32_t)count;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = log_buf[(first + i) % PWM_STUB_LOG_LEN];
+    }
+    return count;
+}
+
+uint32_t pwm_stub_write_count(void) {
+    return writes;
+}
+
+void pwm_stub_reset(void) {
+    writes = 0;
+}
+
+const pwm_backend_config_t *pwm_stub_get_config(void) {
+    return &stub_cfg;
+}
+
+const pwm_backend_t pwm_backend_stub = {
+    .name       = "stub",
+    .init       = stub_init,
+    .write_duty = stub_write_duty,
+    .get_duty   = stub_get_duty,
+};
@@ -23,6 +23,13 @@
 
 static const char *TAG = "gamepad";
 
+// The Bluepad32/BTstack run loop stays on the radio core with the BT controller
+#ifdef CONFIG_ROBOT_TASK_PINNING
+#define BLUEPAD_TASK_CORE CONFIG_ROBOT_CORE_INPUT
+#else
+#define BLUEPAD_TASK_CORE tskNO_AFFINITY
+#endif
+
 static ps4_callback_t s_callback = NULL;
 static SemaphoreHandle_t s_mutex = NULL;
 static ps4_gamepad_t s_state = {0};
@@ -204,13 +211,14 @@ esp_err_t ps4_init(const uint8_t *host_mac, ps4_callback_t callback) {
         return ESP_OK;
     }
 
-    BaseType_t ret = xTaskCreate(
+    BaseType_t ret = xTaskCreatePinnedToCore(
         bluepad_task,
         "bluepad32",
         12288,
         NULL,
         5,
-        NULL
+        NULL,
+        BLUEPAD_TASK_CORE
     );
 
     if (ret != pdPASS) {
@@ -3,21 +3,47 @@
  * @brief Safety and failsafe system
  * 
  * Manages arming state, emergency stop, and failsafe timeout.
+ *
+ * All functions are safe to call from any task. State changes go through
+ * the lock-free state machine in safety_state.h: concurrent requests are
+ * serialised by compare-and-swap, ESTOP wins every race, and each
+ * transition is journaled with its cause and origin.
  */
 
 #pragma once
 
 #include "esp_err.h"
+#include "safety_state.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Journal counters
+ */
+typedef struct {
+    uint32_t transitions;  ///< Transitions since boot
+    uint32_t waits;        ///< Journal writes that waited for their slot
+    uint32_t skips;        ///< Transitions left out rather than wait (e-stop, failsafe)
+} safety_journal_stats_t;
 
 /**
- * @brief Safety state
+ * @brief Failsafe reaction statistics
+ *
+ * Times run from the failsafe deadline (last control input + timeout).
  */
-typedef enum {
-    SAFETY_STATE_DISARMED = 0,  ///< Motors disabled (default at boot)
-    SAFETY_STATE_ARMED = 1,     ///< Motors enabled
-    SAFETY_STATE_ESTOP = 2,     ///< Emergency stop (latched)
-} safety_state_t;
+typedef struct {
+    uint32_t timeout_ms;       ///< Failsafe timeout
+    bool     hw_deadline;      ///< Hardware deadline timer in use
+    bool     outputs_enabled;  ///< Bridge enable pins high
+    uint32_t hw_trips;         ///< Deadline timer ISR cut the outputs
+    uint32_t hw_last_us;       ///< Deadline to enable pins low, most recent
+    uint32_t hw_max_us;        ///< Deadline to enable pins low, worst
+    uint32_t sw_trips;         ///< Failsafe timer disarms after a timeout
+    uint32_t sw_last_us;       ///< Deadline to PWM zeroed and disarmed, most recent
+    uint32_t sw_max_us;        ///< Deadline to PWM zeroed and disarmed, worst
+    uint32_t twdt_trips;       ///< Task watchdog timeouts (outputs cut)
+} safety_failsafe_stats_t;
 
 /**
  * @brief Initialize safety system
@@ -40,6 +66,13 @@ bool safety_is_armed(void);
  */
 esp_err_t safety_arm(void);
 
+/**
+ * @brief Arm on behalf of @p origin (journaled as such)
+ *
+ * @return esp_err_t ESP_OK when armed, ESP_ERR_INVALID_STATE in ESTOP
+ */
+esp_err_t safety_arm_from(safety_origin_t origin);
+
 /**
  * @brief Disarm the system (disable motors)
  * 
@@ -54,9 +87,21 @@ esp_err_t safety_disarm(void);
  */
 esp_err_t safety_emergency_stop(void);
 
+/**
+ * @brief Trigger emergency stop with a cause and origin for the journal
+ *
+ * Always wins against a concurrent arm, disarm or reset.
+ *
+ * @return esp_err_t ESP_OK
+ */
+esp_err_t safety_emergency_stop_from(safety_cause_t cause, safety_origin_t origin);
+
 /**
  * @brief Update failsafe watchdog (call on valid control input)
  *
+ * Also restarts the hardware deadline timer, and disarms if the deadline
+ * timer or the task watchdog has cut the outputs since the last call.
+ *
  * @return esp_err_t ESP_OK on success
  */
 esp_err_t safety_update_watchdog(void);
@@ -76,3 +121,29 @@ safety_state_t safety_get_state(void);
  * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if not in ESTOP
  */
 esp_err_t safety_estop_reset(void);
+
+/**
+ * @brief Reset emergency stop on behalf of @p origin
+ *
+ * @return esp_err_t As safety_estop_reset()
+ */
+esp_err_t safety_estop_reset_from(safety_origin_t origin);
+
+/**
+ * @brief Copy the transition journal, oldest first
+ *
+ * @param out Caller-allocated array (SAFETY_JOURNAL_LEN entries hold all)
+ * @param max Capacity of @p out
+ * @return size_t Entries copied
+ */
+size_t safety_get_journal(safety_transition_t *out, size_t max);
+
+/**
+ * @brief Get the journal counters
+ */
+void safety_get_journal_stats(safety_journal_stats_t *out);
+
+/**
+ * @brief Get failsafe reaction statistics
+ */
+void safety_get_failsafe_stats(safety_failsafe_stats_t *out);
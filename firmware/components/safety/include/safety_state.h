@@ -0,0 +1,188 @@
+/**
+ * @file safety_state.h
+ * @brief Lock-free safety state machine with a transition journal
+ *
+ * Pure C11 atomics with no RTOS or IDF dependencies, so the concurrency can
+ * be checked on the host (tools/safety_torture.c). safety_failsafe.c owns
+ * one instance and performs the side effects (motors, failsafe timer, LED).
+ *
+ * The state and a transition counter share one 32-bit word, and every
+ * transition is a compare-and-swap on it from the state it was decided on.
+ * A transition that lost a race fails instead of overwriting the winner.
+ * ESTOP is entered from any state and retries until it lands, while every
+ * other transition requires a specific non-ESTOP start state, so ESTOP
+ * always wins. Only an explicit reset leaves it.
+ *
+ * The counter value a transition produced is its sequence number, and the
+ * transition is recorded in slot seq % SAFETY_JOURNAL_LEN of a ring. Each
+ * slot is a small seqlock that writers claim with a CAS. A writer whose slot
+ * is still being written by a writer one lap behind (a full lap of
+ * transitions while that one was preempted) waits for it to finish through
+ * the instance's wait_slot hook, so every transition in the window is
+ * recorded, unless the hook gives the slot up: then that one transition is
+ * left out of the journal and counted. Writers only ever wait for older
+ * writers, never the other way round, so the waits cannot form a cycle.
+ * Readers copy slots and discard torn copies.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SAFETY_JOURNAL_LEN
+#define SAFETY_JOURNAL_LEN 32
+#endif
+
+/**
+ * @brief Safety state
+ */
+typedef enum {
+    SAFETY_STATE_DISARMED = 0,  ///< Motors disabled (default at boot)
+    SAFETY_STATE_ARMED = 1,     ///< Motors enabled
+    SAFETY_STATE_ESTOP = 2,     ///< Emergency stop (latched)
+} safety_state_t;
+
+/**
+ * @brief Why a transition happened
+ */
+typedef enum {
+    SAFETY_CAUSE_ARM = 0,       ///< Arm request
+    SAFETY_CAUSE_DISARM,        ///< Disarm request
+    SAFETY_CAUSE_WATCHDOG,      ///< Failsafe timeout
+    SAFETY_CAUSE_ESTOP,         ///< E-stop command
+    SAFETY_CAUSE_PWM_FAULT,     ///< Motor fault input tripped
+    SAFETY_CAUSE_OVERCURRENT,   ///< Current-sense overcurrent or stall trip
+    SAFETY_CAUSE_ESTOP_RESET,   ///< E-stop cleared
+    SAFETY_CAUSE_COUNT
+} safety_cause_t;
+
+/**
+ * @brief Who asked (same numbering as control_source_t)
+ */
+typedef enum {
+    SAFETY_ORIGIN_SYSTEM = 0,   ///< The firmware itself (timers, fault monitors)
+    SAFETY_ORIGIN_PS4,
+    SAFETY_ORIGIN_SERIAL,
+    SAFETY_ORIGIN_HTTP,
+    SAFETY_ORIGIN_COUNT
+} safety_origin_t;
+
+/**
+ * @brief Outcome of a transition request
+ */
+typedef enum {
+    SAFETY_SM_DONE = 0,   ///< Transition made (and journaled)
+    SAFETY_SM_ALREADY,    ///< Already in the target state, nothing to do
+    SAFETY_SM_REFUSED,    ///< Not allowed from the current state, or lost a race
+} safety_sm_result_t;
+
+/**
+ * @brief One journaled transition
+ */
+typedef struct {
+    uint32_t        seq;      ///< Transition number (1 = first since boot)
+    int64_t         time_us;  ///< Time the transition was requested
+    safety_state_t  from;
+    safety_state_t  to;
+    safety_cause_t  cause;
+    safety_origin_t origin;
+} safety_transition_t;
+
+/**
+ * @brief Journal slot (internal)
+ */
+typedef struct {
+    atomic_uint ver;      ///< 2 * seq when complete, odd while being written
+    atomic_uint info;     ///< from | to << 4 | cause << 8 | origin << 16
+    atomic_uint time_lo;
+    atomic_uint time_hi;
+} safety_journal_slot_t;
+
+/**
+ * @brief State machine instance
+ */
+typedef struct {
+    atomic_uint           word;     ///< seq << 2 | state
+    atomic_uint           waits;    ///< Journal writes that waited for their slot
+    atomic_uint           skips;    ///< Journal writes that gave their slot up
+    safety_journal_slot_t journal[SAFETY_JOURNAL_LEN];
+    /**
+     * Called in a loop while the writer of a transition to @p to waits for
+     * a writer one lap behind. Return true after waiting, or false to give
+     * the slot up and leave this transition out of the journal. On FreeRTOS
+     * the older writer may be a lower-priority task on the same core, so a
+     * hook that waits must block (e.g. vTaskDelay(1)), not just yield.
+     * NULL spins.
+     */
+    bool (*wait_slot)(safety_state_t to, safety_cause_t cause);
+} safety_sm_t;
+
+/**
+ * @brief Reset to DISARMED with an empty journal (not thread-safe)
+ *
+ * Clears wait_slot; set it afterwards.
+ */
+void safety_sm_init(safety_sm_t *sm);
+
+/**
+ * @brief Current state word: seq << 2 | state
+ *
+ * Pass it to safety_sm_disarm() as @p expect to disarm only if nothing
+ * changed since it was read.
+ */
+static inline uint32_t safety_sm_word(safety_sm_t *sm) {
+    return atomic_load_explicit(&sm->word, memory_order_acquire);
+}
+
+static inline safety_state_t safety_sm_state_of(uint32_t word) {
+    return (safety_state_t)(word & 3u);
+}
+
+static inline uint32_t safety_sm_seq_of(uint32_t word) {
+    return word >> 2;
+}
+
+/**
+ * @brief DISARMED → ARMED (refused from ESTOP)
+ */
+safety_sm_result_t safety_sm_arm(safety_sm_t *sm, safety_origin_t origin, int64_t now_us);
+
+/**
+ * @brief ARMED → DISARMED (refused from ESTOP)
+ *
+ * @param expect State word the decision was based on, or 0 to disarm from
+ *               any ARMED word
+ */
+safety_sm_result_t safety_sm_disarm(safety_sm_t *sm, safety_cause_t cause,
+                                    safety_origin_t origin, uint32_t expect, int64_t now_us);
+
+/**
+ * @brief Any state → ESTOP; retries until it lands
+ */
+safety_sm_result_t safety_sm_estop(safety_sm_t *sm, safety_cause_t cause,
+                                   safety_origin_t origin, int64_t now_us);
+
+/**
+ * @brief ESTOP → DISARMED
+ */
+safety_sm_result_t safety_sm_estop_reset(safety_sm_t *sm, safety_origin_t origin,
+                                         int64_t now_us);
+
+/**
+ * @brief Copy the journaled transitions still in the ring, oldest first
+ *
+ * Entries being written or overwritten during the copy are left out.
+ *
+ * @param sm  Instance
+ * @param out Caller-allocated array
+ * @param max Capacity of @p out
+ * @return size_t Entries copied
+ */
+size_t safety_sm_journal(safety_sm_t *sm, safety_transition_t *out, size_t max);
+
+const char *safety_state_name(safety_state_t state);
+const char *safety_cause_name(safety_cause_t cause);
+const char *safety_origin_name(safety_origin_t origin);
@@ -5,16 +5,48 @@
 
 #include "safety_failsafe.h"
 #include "motor_bts7960.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
+#include "driver/gptimer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <stdatomic.h>
 
 static const char *TAG = "safety";
 
-// State
-static safety_state_t current_state = SAFETY_STATE_DISARMED;
-static uint32_t last_watchdog_tick = 0;
+#define FAILSAFE_TIMEOUT_US ((int64_t)CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS * 1000)
+
+// State: lock-free CAS state machine and journal (safety_state.c). The
+// functions below act on the transition they won, never on a state they
+// read earlier.
+static safety_sm_t sm;
+static atomic_llong last_watchdog_us = 0;
+
+// Failsafe: one-shot timer aimed at last_watchdog_us + timeout. Feeding only
+// stores a timestamp; if the timer fires early because the robot was fed in
+// the meantime, it re-arms itself for the remaining time.
+static esp_timer_handle_t watchdog_timer = NULL;
+
+// Hardware deadline: a 1 MHz gptimer counting microseconds since the last
+// feed, with its alarm at the timeout while armed. The alarm ISR cuts the
+// bridge enable pins without waiting for any task, and the task watchdog
+// hook does the same; each sets its bit in outputs_cut, and the next
+// failsafe timer run or control cycle turns the cut into a journaled disarm.
+#ifdef CONFIG_ROBOT_FAILSAFE_HW_DEADLINE
+static gptimer_handle_t deadline_timer = NULL;
+static const gptimer_alarm_config_t deadline_alarm = {
+    .alarm_count = FAILSAFE_TIMEOUT_US,
+};
+#endif
+#define CUT_DEADLINE (1u << 0)
+#define CUT_TWDT     (1u << 1)
+static atomic_uint outputs_cut = 0;
+
+static safety_failsafe_stats_t stats = {0};
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
 
 // LED patterns
 typedef enum {
@@ -24,17 +56,77 @@ typedef enum {
     LED_PATTERN_ESTOP,
 } led_pattern_t;
 
-static led_pattern_t current_led_pattern = LED_PATTERN_BOOT;
+/**
+ * @brief On/off phase lengths; off_ms = 0 means solid on
+ */
+static const struct {
+    uint32_t on_ms;
+    uint32_t off_ms;
+} led_patterns[] = {
+    [LED_PATTERN_BOOT]     = { 100,  100 },   // Fast blink during boot
+    [LED_PATTERN_DISARMED] = { 1000, 1000 },  // Slow blink when disarmed
+    [LED_PATTERN_ARMED]    = { 0,    0 },     // Solid ON when armed
+    [LED_PATTERN_ESTOP]    = { 50,   50 },    // Very fast blink on e-stop
+};
+
+static esp_timer_handle_t led_timer = NULL;
+static portMUX_TYPE       led_lock = portMUX_INITIALIZER_UNLOCKED;
+static led_pattern_t      current_led_pattern = LED_PATTERN_BOOT;
+static bool               led_on = false;
+
+/**
+ * @brief LED timer callback — toggle and schedule the next phase
+ */
+static void led_timer_cb(void *arg) {
+    portENTER_CRITICAL(&led_lock);
+    led_pattern_t pattern = current_led_pattern;
+    led_on = !led_on;
+    bool on = led_on;
+    portEXIT_CRITICAL(&led_lock);
+
+    gpio_set_level(CONFIG_ROBOT_STATUS_LED_PIN, on);
+    if (led_patterns[pattern].off_ms > 0) {
+        uint32_t ms = on ? led_patterns[pattern].on_ms : led_patterns[pattern].off_ms;
+        esp_timer_start_once(led_timer, (uint64_t)ms * 1000);
+    }
+}
+
+static led_pattern_t pattern_for_state(safety_state_t state) {
+    switch (state) {
+        case SAFETY_STATE_ARMED: return LED_PATTERN_ARMED;
+        case SAFETY_STATE_ESTOP: return LED_PATTERN_ESTOP;
+        default:                 return LED_PATTERN_DISARMED;
+    }
+}
 
 /**
- * @brief LED task
+ * @brief Switch the LED to the pattern of the current state
+ *
+ * The state is read under led_lock, so whichever of two racing transitions
+ * syncs last leaves the LED showing the final state.
  */
-static void led_task(void *arg) {
+static void sync_led(void) {
+    portENTER_CRITICAL(&led_lock);
+    led_pattern_t pattern = pattern_for_state(safety_sm_state_of(safety_sm_word(&sm)));
+    bool changed = (pattern != current_led_pattern);
+    current_led_pattern = pattern;
+    if (changed) {
+        led_on = false;  // the restarted callback turns the LED on
+    }
+    portEXIT_CRITICAL(&led_lock);
+
+    if (!changed || led_timer == NULL) {
+        return;
+    }
+    esp_timer_stop(led_timer);
+    esp_timer_start_once(led_timer, 0);
+}
+
+static void led_init(void) {
     if (CONFIG_ROBOT_STATUS_LED_PIN < 0) {
-        vTaskDelete(NULL);
         return;
     }
-    
+
     gpio_config_t io_conf = {
         .pin_bit_mask = (1ULL << CONFIG_ROBOT_STATUS_LED_PIN),
         .mode = GPIO_MODE_OUTPUT,
@@ -43,145 +135,340 @@ static void led_task(void *arg) {
         .intr_type = GPIO_INTR_DISABLE,
     };
     gpio_config(&io_conf);
-    
-    while (1) {
-        switch (current_led_pattern) {
-            case LED_PATTERN_BOOT:
-                // Fast blink during boot
-                gpio_set_level(CONFIG_ROBOT_STATUS_LED_PIN, 1);
-                vTaskDelay(pdMS_TO_TICKS(100));
-                gpio_set_level(CONFIG_ROBOT_STATUS_LED_PIN, 0);
-                vTaskDelay(pdMS_TO_TICKS(100));
-                break;
-                
-            case LED_PATTERN_DISARMED:
-                // Slow blink when disarmed
-                gpio_set_level(CONFIG_ROBOT_STATUS_LED_PIN, 1);
-                vTaskDelay(pdMS_TO_TICKS(1000));
-                gpio_set_level(CONFIG_ROBOT_STATUS_LED_PIN, 0);
-                vTaskDelay(pdMS_TO_TICKS(1000));
-                break;
-                
-            case LED_PATTERN_ARMED:
-                // Solid ON when armed
-                gpio_set_level(CONFIG_ROBOT_STATUS_LED_PIN, 1);
-                vTaskDelay(pdMS_TO_TICKS(100));
-                break;
-                
-            case LED_PATTERN_ESTOP:
-                // Very fast blink on e-stop
-                gpio_set_level(CONFIG_ROBOT_STATUS_LED_PIN, 1);
-                vTaskDelay(pdMS_TO_TICKS(50));
-                gpio_set_level(CONFIG_ROBOT_STATUS_LED_PIN, 0);
-                vTaskDelay(pdMS_TO_TICKS(50));
-                break;
-        }
+
+    esp_timer_create_args_t args = {
+        .callback = &led_timer_cb,
+        .name = "status_led",
+    };
+    if (esp_timer_create(&args, &led_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create LED timer — status LED disabled");
+        led_timer = NULL;
+        return;
+    }
+    esp_timer_start_once(led_timer, 0);
+}
+
+// Called from deadline_isr() as well as the task, so it must stay in IRAM
+static void IRAM_ATTR record_reaction(uint32_t *trips, uint32_t *last, uint32_t *max, uint32_t us) {
+    (*trips)++;
+    *last = us;
+    if (us > *max) *max = us;
+}
+
+#ifdef CONFIG_ROBOT_FAILSAFE_HW_DEADLINE
+/**
+ * @brief Deadline alarm ISR — nothing fed the failsafe for a full timeout
+ */
+static bool IRAM_ATTR deadline_isr(gptimer_handle_t timer,
+                                   const gptimer_alarm_event_data_t *edata, void *ctx) {
+    int64_t entry_us = esp_timer_get_time();
+    motor_cut_outputs();
+    atomic_fetch_or(&outputs_cut, CUT_DEADLINE);
+
+    // Interrupt latency in timer ticks, plus the time to drop the pins
+    uint32_t us = (uint32_t)(edata->count_value - edata->alarm_value) +
+                  (uint32_t)(esp_timer_get_time() - entry_us);
+    portENTER_CRITICAL_ISR(&stats_lock);
+    record_reaction(&stats.hw_trips, &stats.hw_last_us, &stats.hw_max_us, us);
+    portEXIT_CRITICAL_ISR(&stats_lock);
+    return false;
+}
+#endif
+
+#ifdef CONFIG_ROBOT_CONTROL_TASK_WDT
+/**
+ * @brief Task watchdog timeout hook (runs in the TWDT interrupt)
+ *
+ * Overrides the weak default in ESP-IDF. Whichever watched task is stuck,
+ * the control path can no longer be trusted to stop the motors.
+ */
+void IRAM_ATTR esp_task_wdt_isr_user_handler(void) {
+    motor_cut_outputs();
+    atomic_fetch_or(&outputs_cut, CUT_TWDT);
+    portENTER_CRITICAL_ISR(&stats_lock);
+    stats.twdt_trips++;
+    portEXIT_CRITICAL_ISR(&stats_lock);
+}
+#endif
+
+/**
+ * @brief Restart the deadline count (every fed control cycle)
+ */
+static void deadline_feed(void) {
+#ifdef CONFIG_ROBOT_FAILSAFE_HW_DEADLINE
+    gptimer_set_raw_count(deadline_timer, 0);
+#endif
+}
+
+/**
+ * @brief Start or stop the deadline alarm (arm / leaving ARMED)
+ */
+static void deadline_enable(bool enable) {
+#ifdef CONFIG_ROBOT_FAILSAFE_HW_DEADLINE
+    if (enable) {
+        gptimer_set_raw_count(deadline_timer, 0);
+        gptimer_set_alarm_action(deadline_timer, &deadline_alarm);
+    } else {
+        gptimer_set_alarm_action(deadline_timer, NULL);
     }
+#endif
+}
+
+static esp_err_t deadline_init(void) {
+#ifdef CONFIG_ROBOT_FAILSAFE_HW_DEADLINE
+    gptimer_config_t cfg = {
+        .clk_src       = GPTIMER_CLK_SRC_DEFAULT,
+        .direction     = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,
+    };
+    esp_err_t err = gptimer_new_timer(&cfg, &deadline_timer);
+    if (err == ESP_OK) {
+        gptimer_event_callbacks_t cbs = { .on_alarm = deadline_isr };
+        err = gptimer_register_event_callbacks(deadline_timer, &cbs, NULL);
+    }
+    // Counts from boot; the alarm is only set while armed
+    if (err == ESP_OK) err = gptimer_enable(deadline_timer);
+    if (err == ESP_OK) err = gptimer_start(deadline_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start deadline timer: %s", esp_err_to_name(err));
+        return err;
+    }
+    stats.hw_deadline = true;
+#endif
+    return ESP_OK;
 }
 
 /**
- * @brief Failsafe watchdog task
+ * @brief Disarm the arming in @p word after a timeout or an output cut
+ *
+ * Only the arming that timed out is disarmed: a re-arm or e-stop since
+ * @p word was read wins, and this disarm is refused.
+ *
+ * @param deadline Failsafe deadline for the reaction time, 0 = not a timeout
+ * @param cut      CUT_* bits of whatever already cut the outputs
  */
-static void watchdog_task(void *arg) {
-    while (1) {
-        uint32_t now = xTaskGetTickCount();
-        uint32_t timeout_ticks = pdMS_TO_TICKS(CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS);
-        
-        if (current_state == SAFETY_STATE_ARMED) {
-            if ((now - last_watchdog_tick) > timeout_ticks) {
-                ESP_LOGW(TAG, "Watchdog timeout! Auto-disarming...");
-                safety_disarm();
-            }
-        }
-        
-        vTaskDelay(pdMS_TO_TICKS(100)); // Check every 100ms
+static void failsafe_disarm(uint32_t word, int64_t deadline, unsigned cut) {
+    int64_t now = esp_timer_get_time();
+    if (safety_sm_disarm(&sm, SAFETY_CAUSE_WATCHDOG, SAFETY_ORIGIN_SYSTEM, word, now)
+            != SAFETY_SM_DONE) {
+        return;
+    }
+    motor_emergency_stop();
+    deadline_enable(false);
+    if (deadline != 0) {
+        uint32_t us = (uint32_t)(esp_timer_get_time() - deadline);
+        portENTER_CRITICAL(&stats_lock);
+        record_reaction(&stats.sw_trips, &stats.sw_last_us, &stats.sw_max_us, us);
+        portEXIT_CRITICAL(&stats_lock);
+    }
+    sync_led();
+    if (cut & CUT_TWDT) {
+        ESP_LOGW(TAG, "Task watchdog timeout cut the outputs! Auto-disarmed");
+    } else if (cut & CUT_DEADLINE) {
+        ESP_LOGW(TAG, "Deadline timer cut the outputs! Auto-disarmed");
+    } else {
+        ESP_LOGW(TAG, "Watchdog timeout! Auto-disarmed");
     }
 }
 
+/**
+ * @brief Failsafe timer callback — disarm if the deadline really passed
+ */
+static void watchdog_timer_cb(void *arg) {
+    uint32_t word = safety_sm_word(&sm);
+    if (safety_sm_state_of(word) != SAFETY_STATE_ARMED) {
+        return;
+    }
+
+    int64_t deadline = atomic_load(&last_watchdog_us) + FAILSAFE_TIMEOUT_US;
+    int64_t remaining = deadline - esp_timer_get_time();
+    unsigned cut = atomic_load(&outputs_cut);
+    if (remaining > 0 && !cut) {
+        // Fed since the timer was armed; aim at the new deadline
+        esp_timer_start_once(watchdog_timer, (uint64_t)remaining);
+        return;
+    }
+    failsafe_disarm(word, remaining > 0 ? 0 : deadline, cut);
+}
+
+/**
+ * @brief Journal slot wait: block so a preempted lower-priority writer can finish
+ *
+ * E-stops and failsafe disarms (the latter in the esp_timer task) never
+ * wait a tick for the journal: they give the slot up and are counted instead.
+ */
+static bool journal_wait(safety_state_t to, safety_cause_t cause) {
+    if (to == SAFETY_STATE_ESTOP || cause == SAFETY_CAUSE_WATCHDOG) {
+        return false;
+    }
+    vTaskDelay(1);
+    return true;
+}
+
 esp_err_t safety_failsafe_init(void) {
-    current_state = SAFETY_STATE_DISARMED;
-    last_watchdog_tick = xTaskGetTickCount();
+    safety_sm_init(&sm);
+    sm.wait_slot = journal_wait;
+    atomic_store(&last_watchdog_us, esp_timer_get_time());
     current_led_pattern = LED_PATTERN_BOOT;
-    
-    // Start LED task
-    xTaskCreate(led_task, "led_task", 2048, NULL, 3, NULL);
-    
-    // Start watchdog task
-    xTaskCreate(watchdog_task, "watchdog_task", 2048, NULL, 5, NULL);
-    
+
+    esp_timer_create_args_t args = {
+        .callback = &watchdog_timer_cb,
+        .name = "failsafe",
+    };
+    esp_err_t err = esp_timer_create(&args, &watchdog_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create failsafe timer: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = deadline_init();
+    if (err != ESP_OK) {
+        return err;
+    }
+    stats.timeout_ms = CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS;
+
+    led_init();
+
     // Set LED to disarmed after boot
     vTaskDelay(pdMS_TO_TICKS(2000)); // 2 second boot pattern
-    current_led_pattern = LED_PATTERN_DISARMED;
+    sync_led();
     
     ESP_LOGI(TAG, "Safety system initialized");
     ESP_LOGI(TAG, "  Initial state: DISARMED");
-    ESP_LOGI(TAG, "  Failsafe timeout: %d ms", CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS);
+    ESP_LOGI(TAG, "  Failsafe timeout: %d ms (%s)", CONFIG_ROBOT_FAILSAFE_TIMEOUT_MS,
+             stats.hw_deadline ? "hardware deadline timer" : "software timer only");
     
     return ESP_OK;
 }
 
 bool safety_is_armed(void) {
-    return current_state == SAFETY_STATE_ARMED;
+    return safety_sm_state_of(safety_sm_word(&sm)) == SAFETY_STATE_ARMED;
 }
 
-esp_err_t safety_arm(void) {
-    if (current_state == SAFETY_STATE_ESTOP) {
-        ESP_LOGW(TAG, "Cannot arm: E-STOP active");
-        return ESP_ERR_INVALID_STATE;
-    }
-    
-    if (current_state != SAFETY_STATE_ARMED) {
-        current_state = SAFETY_STATE_ARMED;
-        current_led_pattern = LED_PATTERN_ARMED;
-        last_watchdog_tick = xTaskGetTickCount();
-        ESP_LOGI(TAG, "System ARMED");
+esp_err_t safety_arm_from(safety_origin_t origin) {
+    // Fresh deadline before the state flips, so the timer cannot see a stale one
+    int64_t now = esp_timer_get_time();
+    atomic_store(&last_watchdog_us, now);
+
+    switch (safety_sm_arm(&sm, origin, now)) {
+        case SAFETY_SM_DONE:
+            // Outputs back on only with a fresh deadline behind them
+            atomic_store(&outputs_cut, 0);
+            deadline_enable(true);
+            motor_enable_outputs();
+            esp_timer_stop(watchdog_timer);
+            esp_timer_start_once(watchdog_timer, FAILSAFE_TIMEOUT_US);
+            sync_led();
+            ESP_LOGI(TAG, "System ARMED (%s)", safety_origin_name(origin));
+            return ESP_OK;
+        case SAFETY_SM_ALREADY:
+            return ESP_OK;
+        default:
+            ESP_LOGW(TAG, "Cannot arm: E-STOP active");
+            return ESP_ERR_INVALID_STATE;
     }
-    
-    return ESP_OK;
+}
+
+esp_err_t safety_arm(void) {
+    return safety_arm_from(SAFETY_ORIGIN_SYSTEM);
 }
 
 esp_err_t safety_disarm(void) {
-    if (current_state == SAFETY_STATE_ESTOP) {
-        ESP_LOGW(TAG, "Cannot disarm: E-STOP active (use arm to clear)");
-        return ESP_ERR_INVALID_STATE;
+    switch (safety_sm_disarm(&sm, SAFETY_CAUSE_DISARM, SAFETY_ORIGIN_SYSTEM, 0,
+                             esp_timer_get_time())) {
+        case SAFETY_SM_DONE:
+            motor_emergency_stop();
+            deadline_enable(false);
+            esp_timer_stop(watchdog_timer);
+            sync_led();
+            ESP_LOGI(TAG, "System DISARMED");
+            return ESP_OK;
+        case SAFETY_SM_ALREADY:
+            return ESP_OK;
+        default:
+            ESP_LOGW(TAG, "Cannot disarm: E-STOP active (use /estop-reset to clear)");
+            return ESP_ERR_INVALID_STATE;
     }
-    
-    if (current_state != SAFETY_STATE_DISARMED) {
-        current_state = SAFETY_STATE_DISARMED;
-        current_led_pattern = LED_PATTERN_DISARMED;
-        motor_emergency_stop();
-        ESP_LOGI(TAG, "System DISARMED");
-    }
-    
-    return ESP_OK;
 }
 
-esp_err_t safety_emergency_stop(void) {
-    current_state = SAFETY_STATE_ESTOP;
-    current_led_pattern = LED_PATTERN_ESTOP;
+esp_err_t safety_emergency_stop_from(safety_cause_t cause, safety_origin_t origin) {
+    // Outputs off first, then latch; once more after the latch, for a ramp
+    // step that checked the state before it flipped (even if already latched)
+    motor_emergency_stop();
+    safety_sm_result_t r = safety_sm_estop(&sm, cause, origin, esp_timer_get_time());
     motor_emergency_stop();
+    if (r != SAFETY_SM_DONE) {
+        return ESP_OK;
+    }
+    deadline_enable(false);
+    esp_timer_stop(watchdog_timer);
+    sync_led();
 
-    ESP_LOGE(TAG, "!!! EMERGENCY STOP !!!");
+    ESP_LOGE(TAG, "!!! EMERGENCY STOP !!! (%s, %s)", safety_cause_name(cause),
+             safety_origin_name(origin));
     ESP_LOGE(TAG, "Use /estop-reset (HTTP) or reboot to clear");
-
     return ESP_OK;
 }
 
-esp_err_t safety_estop_reset(void) {
-    if (current_state != SAFETY_STATE_ESTOP) {
+esp_err_t safety_emergency_stop(void) {
+    return safety_emergency_stop_from(SAFETY_CAUSE_ESTOP, SAFETY_ORIGIN_SYSTEM);
+}
+
+esp_err_t safety_estop_reset_from(safety_origin_t origin) {
+    if (safety_sm_state_of(safety_sm_word(&sm)) != SAFETY_STATE_ESTOP) {
         return ESP_ERR_INVALID_STATE;
     }
-    current_state = SAFETY_STATE_DISARMED;
-    current_led_pattern = LED_PATTERN_DISARMED;
+    // A latched PWM fault stays latched while its input is active
+    esp_err_t ret = motor_clear_pwm_fault();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot clear E-STOP: motor fault input still active");
+        return ret;
+    }
+    if (safety_sm_estop_reset(&sm, origin, esp_timer_get_time()) != SAFETY_SM_DONE) {
+        return ESP_ERR_INVALID_STATE;  // cleared by someone else meanwhile
+    }
+    sync_led();
     ESP_LOGI(TAG, "E-STOP cleared — system DISARMED (re-arm to continue)");
     return ESP_OK;
 }
 
+esp_err_t safety_estop_reset(void) {
+    return safety_estop_reset_from(SAFETY_ORIGIN_SYSTEM);
+}
+
 esp_err_t safety_update_watchdog(void) {
-    last_watchdog_tick = xTaskGetTickCount();
+    // Cheap enough for every control cycle: the esp_timer is not touched here
+    atomic_store_explicit(&last_watchdog_us, esp_timer_get_time(), memory_order_relaxed);
+    deadline_feed();
+
+    // Cut while fed (task watchdog, or a frame just after the deadline):
+    // the failsafe timer will not fire
+    unsigned cut = atomic_load_explicit(&outputs_cut, memory_order_relaxed);
+    if (cut) {
+        uint32_t word = safety_sm_word(&sm);
+        if (safety_sm_state_of(word) == SAFETY_STATE_ARMED) {
+            failsafe_disarm(word, 0, cut);
+        }
+    }
     return ESP_OK;
 }
 
 safety_state_t safety_get_state(void) {
-    return current_state;
+    return safety_sm_state_of(safety_sm_word(&sm));
+}
+
+size_t safety_get_journal(safety_transition_t *out, size_t max) {
+    return safety_sm_journal(&sm, out, max);
+}
+
+void safety_get_journal_stats(safety_journal_stats_t *out) {
+    out->transitions = safety_sm_seq_of(safety_sm_word(&sm));
+    out->waits       = atomic_load_explicit(&sm.waits, memory_order_relaxed);
+    out->skips       = atomic_load_explicit(&sm.skips, memory_order_relaxed);
+}
+
+void safety_get_failsafe_stats(safety_failsafe_stats_t *out) {
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+    out->outputs_enabled = motor_outputs_enabled();
 }
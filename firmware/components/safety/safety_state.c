@@ -0,0 +1,191 @@
+/**
+ * @file safety_state.c
+ * @brief Lock-free safety state machine implementation
+ */
+
+#include "safety_state.h"
+#include <string.h>
+
+#define WORD(seq, state) (((seq) << 2) | (uint32_t)(state))
+
+void safety_sm_init(safety_sm_t *sm) {
+    memset(sm, 0, sizeof(*sm));
+    atomic_init(&sm->word, WORD(0u, SAFETY_STATE_DISARMED));
+}
+
+/**
+ * @brief Journal transition @p seq, waiting for an older writer of its slot
+ *        unless the wait_slot hook gives the slot up
+ */
+static void journal_record(safety_sm_t *sm, uint32_t seq, safety_state_t from,
+                           safety_state_t to, safety_cause_t cause,
+                           safety_origin_t origin, int64_t now_us) {
+    safety_journal_slot_t *slot = &sm->journal[seq % SAFETY_JOURNAL_LEN];
+
+    // Claim the slot from a finished, older entry
+    unsigned ver = atomic_load_explicit(&slot->ver, memory_order_relaxed);
+    bool waited = false;
+    for (;;) {
+        if (ver / 2 >= seq) {
+            return;  // reused a lap later: seq is already out of the window
+        }
+        if (ver & 1u) {
+            // A writer one lap behind is mid-write: let it finish, or give up
+            if (sm->wait_slot && !sm->wait_slot(to, cause)) {
+                atomic_fetch_add_explicit(&sm->skips, 1, memory_order_relaxed);
+                return;
+            }
+            if (!waited) {
+                atomic_fetch_add_explicit(&sm->waits, 1, memory_order_relaxed);
+                waited = true;
+            }
+            ver = atomic_load_explicit(&slot->ver, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&slot->ver, &ver, 2 * seq + 1,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            break;
+        }
+    }
+    atomic_thread_fence(memory_order_release);
+
+    uint32_t info = (uint32_t)from | (uint32_t)to << 4 | (uint32_t)cause << 8 |
+                    (uint32_t)origin << 16;
+    atomic_store_explicit(&slot->info, info, memory_order_relaxed);
+    atomic_store_explicit(&slot->time_lo, (uint32_t)now_us, memory_order_relaxed);
+    atomic_store_explicit(&slot->time_hi, (uint32_t)((uint64_t)now_us >> 32),
+                          memory_order_relaxed);
+    atomic_store_explicit(&slot->ver, 2 * seq, memory_order_release);
+}
+
+/**
+ * @brief CAS @p expect to @p to; journal on success
+ */
+static bool try_transition(safety_sm_t *sm, uint32_t *expect, safety_state_t to,
+                           safety_cause_t cause, safety_origin_t origin, int64_t now_us) {
+    uint32_t seq = safety_sm_seq_of(*expect) + 1;
+    if (!atomic_compare_exchange_strong_explicit(&sm->word, expect, WORD(seq, to),
+                                                 memory_order_acq_rel,
+                                                 memory_order_acquire)) {
+        return false;  // *expect now holds the winner's word
+    }
+    journal_record(sm, seq, safety_sm_state_of(*expect), to, cause, origin, now_us);
+    return true;
+}
+
+safety_sm_result_t safety_sm_arm(safety_sm_t *sm, safety_origin_t origin, int64_t now_us) {
+    uint32_t w = safety_sm_word(sm);
+    for (;;) {
+        switch (safety_sm_state_of(w)) {
+            case SAFETY_STATE_ARMED: return SAFETY_SM_ALREADY;
+            case SAFETY_STATE_ESTOP: return SAFETY_SM_REFUSED;
+            default: break;
+        }
+        if (try_transition(sm, &w, SAFETY_STATE_ARMED, SAFETY_CAUSE_ARM, origin, now_us)) {
+            return SAFETY_SM_DONE;
+        }
+    }
+}
+
+safety_sm_result_t safety_sm_disarm(safety_sm_t *sm, safety_cause_t cause,
+                                    safety_origin_t origin, uint32_t expect, int64_t now_us) {
+    uint32_t w = expect ? expect : safety_sm_word(sm);
+    for (;;) {
+        switch (safety_sm_state_of(w)) {
+            case SAFETY_STATE_DISARMED: return SAFETY_SM_ALREADY;
+            case SAFETY_STATE_ESTOP:    return SAFETY_SM_REFUSED;
+            default: break;
+        }
+        if (try_transition(sm, &w, SAFETY_STATE_DISARMED, cause, origin, now_us)) {
+            return SAFETY_SM_DONE;
+        }
+        if (expect) {
+            return SAFETY_SM_REFUSED;  // something changed since the caller decided
+        }
+    }
+}
+
+safety_sm_result_t safety_sm_estop(safety_sm_t *sm, safety_cause_t cause,
+                                   safety_origin_t origin, int64_t now_us) {
+    uint32_t w = safety_sm_word(sm);
+    for (;;) {
+        if (safety_sm_state_of(w) == SAFETY_STATE_ESTOP) {
+            return SAFETY_SM_ALREADY;
+        }
+        if (try_transition(sm, &w, SAFETY_STATE_ESTOP, cause, origin, now_us)) {
+            return SAFETY_SM_DONE;
+        }
+    }
+}
+
+safety_sm_result_t safety_sm_estop_reset(safety_sm_t *sm, safety_origin_t origin,
+                                         int64_t now_us) {
+    uint32_t w = safety_sm_word(sm);
+    if (safety_sm_state_of(w) != SAFETY_STATE_ESTOP) {
+        return SAFETY_SM_REFUSED;
+    }
+    return try_transition(sm, &w, SAFETY_STATE_DISARMED, SAFETY_CAUSE_ESTOP_RESET,
+                          origin, now_us) ? SAFETY_SM_DONE : SAFETY_SM_REFUSED;
+}
+
+size_t safety_sm_journal(safety_sm_t *sm, safety_transition_t *out, size_t max) {
+    uint32_t head = safety_sm_seq_of(safety_sm_word(sm));
+    uint32_t first = (head > SAFETY_JOURNAL_LEN) ? head - SAFETY_JOURNAL_LEN + 1 : 1;
+    size_t n = 0;
+
+    for (uint32_t seq = first; seq <= head && n < max; seq++) {
+        safety_journal_slot_t *slot = &sm->journal[seq % SAFETY_JOURNAL_LEN];
+        unsigned ver = atomic_load_explicit(&slot->ver, memory_order_acquire);
+        if (ver != 2 * seq) {
+            continue;  // not written yet, or already overwritten
+        }
+        uint32_t info = atomic_load_explicit(&slot->info, memory_order_relaxed);
+        uint32_t lo   = atomic_load_explicit(&slot->time_lo, memory_order_relaxed);
+        uint32_t hi   = atomic_load_explicit(&slot->time_hi, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->ver, memory_order_relaxed) != ver) {
+            continue;  // overwritten while copying
+        }
+        out[n++] = (safety_transition_t){
+            .seq     = seq,
+            .time_us = (int64_t)((uint64_t)hi << 32 | lo),
+            .from    = (safety_state_t)(info & 0xF),
+            .to      = (safety_state_t)((info >> 4) & 0xF),
+            .cause   = (safety_cause_t)((info >> 8) & 0xFF),
+            .origin  = (safety_origin_t)((info >> 16) & 0xFF),
+        };
+    }
+    return n;
+}
+
+const char *safety_state_name(safety_state_t state) {
+    switch (state) {
+        case SAFETY_STATE_ARMED: return "ARMED";
+        case SAFETY_STATE_ESTOP: return "ESTOP";
+        default:                 return "DISARMED";
+    }
+}
+
+const char *safety_cause_name(safety_cause_t cause) {
+    static const char *const names[SAFETY_CAUSE_COUNT] = {
+        [SAFETY_CAUSE_ARM]         = "arm",
+        [SAFETY_CAUSE_DISARM]      = "disarm",
+        [SAFETY_CAUSE_WATCHDOG]    = "watchdog",
+        [SAFETY_CAUSE_ESTOP]       = "estop",
+        [SAFETY_CAUSE_PWM_FAULT]   = "pwm_fault",
+        [SAFETY_CAUSE_OVERCURRENT] = "overcurrent",
+        [SAFETY_CAUSE_ESTOP_RESET] = "estop_reset",
+    };
+    return ((unsigned)cause < SAFETY_CAUSE_COUNT) ? names[cause] : "?";
+}
+
+const char *safety_origin_name(safety_origin_t origin) {
+    static const char *const names[SAFETY_ORIGIN_COUNT] = {
+        [SAFETY_ORIGIN_SYSTEM] = "SYSTEM",
+        [SAFETY_ORIGIN_PS4]    = "PS4",
+        [SAFETY_ORIGIN_SERIAL] = "SERIAL",
+        [SAFETY_ORIGIN_HTTP]   = "HTTP",
+    };
+    return ((unsigned)origin < SAFETY_ORIGIN_COUNT) ? names[origin] : "?";
+}
@@ -21,8 +21,14 @@
 #include "controller_serial.h"
 #include "controller_http.h"
 #include "motor_bts7960.h"
-#include "mixer_diffdrive.h"
+#include "current_sense.h"
+#include "drive_config.h"
+#include "speed_ctrl.h"
+#include "thermal_guard.h"
+#include "battery_guard.h"
+#include "battery_sense.h"
 #include "safety_failsafe.h"
+#include "event_log.h"
 #ifdef CONFIG_ROBOT_ENABLE_PS4
 #include "controller_ps4.h"
 #endif
@@ -46,6 +52,43 @@ static int nvs_cfg_int(const char *key, int default_val) {
 #ifndef CONFIG_ROBOT_MOTOR_INVERT_RIGHT
 #define CONFIG_ROBOT_MOTOR_INVERT_RIGHT 0
 #endif
+#ifndef CONFIG_ROBOT_CONTROL_PIPELINE_SINGLE_STAGE
+#define CONFIG_ROBOT_CONTROL_PIPELINE_SINGLE_STAGE 0
+#endif
+#ifndef CONFIG_ROBOT_MOTOR_RAMP_LEDC_FADE
+#define CONFIG_ROBOT_MOTOR_RAMP_LEDC_FADE 0
+#endif
+
+#if defined(CONFIG_ROBOT_MOTOR_PWM_MCPWM)
+#define MOTOR_PWM_BACKEND        (&pwm_backend_mcpwm)
+#define MOTOR_DEAD_TIME_NS       CONFIG_ROBOT_MOTOR_DEAD_TIME_NS
+#define MOTOR_FAULT1_GPIO        CONFIG_ROBOT_MOTOR_FAULT1_GPIO
+#define MOTOR_FAULT2_GPIO        CONFIG_ROBOT_MOTOR_FAULT2_GPIO
+#ifdef CONFIG_ROBOT_MOTOR_FAULT_ACTIVE_HIGH
+#define MOTOR_FAULT_ACTIVE_HIGH  true
+#else
+#define MOTOR_FAULT_ACTIVE_HIGH  false
+#endif
+#else
+#if defined(CONFIG_ROBOT_MOTOR_PWM_STUB)
+#define MOTOR_PWM_BACKEND        (&pwm_backend_stub)
+#else
+#define MOTOR_PWM_BACKEND        (&pwm_backend_ledc)
+#endif
+#define MOTOR_DEAD_TIME_NS       0
+#define MOTOR_FAULT1_GPIO        (-1)
+#define MOTOR_FAULT2_GPIO        (-1)
+#define MOTOR_FAULT_ACTIVE_HIGH  false
+#endif
+
+// Task layout: control path on one core, radio stacks and input on the other
+#ifdef CONFIG_ROBOT_TASK_PINNING
+#define CONTROL_CORE CONFIG_ROBOT_CORE_CONTROL
+#define INPUT_CORE   CONFIG_ROBOT_CORE_INPUT
+#else
+#define CONTROL_CORE tskNO_AFFINITY
+#define INPUT_CORE   tskNO_AFFINITY
+#endif
 
 #ifdef CONFIG_ROBOT_ENABLE_PS4
 static void ps4_init_task(void *arg) {
@@ -80,6 +123,90 @@ static void init_nvs(void) {
     ESP_LOGI(TAG, "NVS initialized");
 }
 
+#ifdef CONFIG_ROBOT_CURRENT_SENSE
+/**
+ * @brief Current-sense trip: latch E-STOP (zeroes PWM on the sense task)
+ */
+static void on_current_trip(current_trip_t reason, int track) {
+    safety_emergency_stop_from(SAFETY_CAUSE_OVERCURRENT, SAFETY_ORIGIN_SYSTEM);
+}
+
+/**
+ * @brief Measured track currents for the thermal model
+ */
+static esp_err_t read_track_current(void *ctx, float *left_a, float *right_a) {
+    current_sense_status_t cs;
+    current_sense_get_status(&cs);
+    if (cs.frames == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *left_a  = cs.left_a;
+    *right_a = cs.right_a;
+    return ESP_OK;
+}
+
+static const thermal_current_t thermal_current = {
+    .name = "current_sense",
+    .read = read_track_current,
+};
+
+#ifdef CONFIG_ROBOT_SPEED_CTRL_CURRENT_FEEDBACK
+/**
+ * @brief Track speeds from the applied duty less the armature I * R drop
+ */
+static esp_err_t read_emf_speed(void *ctx, float *left, float *right) {
+    current_sense_status_t cs;
+    current_sense_get_status(&cs);
+    if (cs.frames == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    float target_l, target_r, duty_l, duty_r;
+    motor_get_speeds(&target_l, &target_r, &duty_l, &duty_r);
+    // Nominal 3.7 V per cell without the battery divider
+    float volts = (cs.vbat_v > 0.0f) ? cs.vbat_v : CONFIG_ROBOT_BATTERY_CELLS * 3.7f;
+    float r_ohm = CONFIG_ROBOT_SPEED_CTRL_MOTOR_R_MOHM / 1000.0f;
+    *left  = speed_pid_emf_estimate(duty_l, cs.left_a, r_ohm, volts);
+    *right = speed_pid_emf_estimate(duty_r, cs.right_a, r_ohm, volts);
+    return ESP_OK;
+}
+
+static const speed_feedback_t emf_speed = {
+    .name = "current_sense",
+    .read = read_emf_speed,
+};
+#endif
+#endif
+
+#if CONFIG_ROBOT_BATTERY_PIN >= 0
+/**
+ * @brief Pack voltage, plus the pack current when current sense measures it
+ */
+static esp_err_t read_battery(void *ctx, float *volts, float *amps) {
+#ifdef CONFIG_ROBOT_CURRENT_SENSE
+    current_sense_status_t cs;
+    current_sense_get_status(&cs);
+    if (cs.frames == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *volts = cs.vbat_v;
+    *amps  = cs.left_a + cs.right_a;
+    return ESP_OK;
+#else
+    *amps = -1.0f;  // estimated from the duty
+    return battery_sense_read(volts);
+#endif
+}
+
+static const battery_source_t battery_source = {
+#ifdef CONFIG_ROBOT_CURRENT_SENSE
+    .name = "current_sense",
+#else
+    .name = "adc",
+#endif
+    .read = read_battery,
+};
+#endif
+
 /**
  * @brief Main application entry point
  */
@@ -96,6 +223,26 @@ void app_main(void) {
     ESP_LOGI(TAG, "Initializing safety system...");
     ESP_ERROR_CHECK(safety_failsafe_init());
 
+#ifdef CONFIG_ROBOT_EVENTLOG
+    // Event log next, so records staged before a crash reach flash early
+    ESP_LOGI(TAG, "Initializing event log...");
+    event_log_config_t log_cfg = {
+        .partition = "eventlog",
+        .flush_ms  = CONFIG_ROBOT_EVENTLOG_FLUSH_MS,
+        .hold      = safety_is_armed,
+        .task_core = INPUT_CORE,
+    };
+    if (event_log_init(&log_cfg) != ESP_OK) {
+        ESP_LOGW(TAG, "Event log unavailable, continuing without it");
+    }
+#endif
+
+    // Control loop rate — NVS value overrides the Kconfig default
+    int loop_hz = nvs_cfg_int("loop_hz", CONFIG_ROBOT_CONTROL_LOOP_HZ);
+    if (loop_hz < CONTROL_LOOP_RATE_MIN_HZ) loop_hz = CONTROL_LOOP_RATE_MIN_HZ;
+    if (loop_hz > CONTROL_LOOP_RATE_MAX_HZ) loop_hz = CONTROL_LOOP_RATE_MAX_HZ;
+    ESP_LOGI(TAG, "Control loop rate: %d Hz", loop_hz);
+
     // Initialize motor control
     ESP_LOGI(TAG, "Initializing motor control...");
     motor_config_t motor_cfg = {
@@ -110,30 +257,120 @@ void app_main(void) {
         .pwm_freq_hz = CONFIG_ROBOT_MOTOR_PWM_FREQ_HZ,
         .pwm_resolution = CONFIG_ROBOT_MOTOR_PWM_RESOLUTION,
         .ramp_rate_ms = CONFIG_ROBOT_MOTOR_RAMP_RATE_MS,
+        .decel_ms     = CONFIG_ROBOT_MOTOR_DECEL_MS,
+        .reverse_ms   = CONFIG_ROBOT_MOTOR_REVERSE_MS,
+        .jerk_ms      = CONFIG_ROBOT_MOTOR_JERK_MS,
+        .loop_rate_hz = (uint32_t)loop_hz,
         .invert_left  = CONFIG_ROBOT_MOTOR_INVERT_LEFT,
         .invert_right = CONFIG_ROBOT_MOTOR_INVERT_RIGHT,
+        .pwm_backend = MOTOR_PWM_BACKEND,
+        .dead_time_ns = MOTOR_DEAD_TIME_NS,
+        .fault_gpio = {MOTOR_FAULT1_GPIO, MOTOR_FAULT2_GPIO},
+        .fault_active_high = MOTOR_FAULT_ACTIVE_HIGH,
+        .hw_fade = CONFIG_ROBOT_MOTOR_RAMP_LEDC_FADE,
+        .external_tick = CONFIG_ROBOT_CONTROL_PIPELINE_SINGLE_STAGE,
+        .ramp_task_core = CONTROL_CORE,
     };
     ESP_ERROR_CHECK(motor_bts7960_init(&motor_cfg));
 
-    // Initialize differential drive mixer — NVS values override Kconfig defaults
+#ifdef CONFIG_ROBOT_CURRENT_SENSE
+    ESP_LOGI(TAG, "Initializing current sense...");
+    current_sense_config_t cs_cfg = {
+        .left_ris   = CONFIG_ROBOT_MOTOR_LEFT_RIS,
+        .left_lis   = CONFIG_ROBOT_MOTOR_LEFT_LIS,
+        .right_ris  = CONFIG_ROBOT_MOTOR_RIGHT_RIS,
+        .right_lis  = CONFIG_ROBOT_MOTOR_RIGHT_LIS,
+        .sample_hz  = CONFIG_ROBOT_CURRENT_SENSE_SAMPLE_HZ,
+        .mv_per_amp = CONFIG_ROBOT_CURRENT_SENSE_MV_PER_A,
+        .limit_a    = CONFIG_ROBOT_CURRENT_LIMIT_A,
+        .stall_a    = CONFIG_ROBOT_CURRENT_STALL_A,
+        .stall_ms   = CONFIG_ROBOT_CURRENT_STALL_MS,
+        .vbat_pin   = CONFIG_ROBOT_BATTERY_PIN,
+        .vbat_scale = CONFIG_ROBOT_BATTERY_DIVIDER_X100 / 100.0f,
+        .on_trip    = on_current_trip,
+        .task_core  = CONTROL_CORE,
+    };
+    ESP_ERROR_CHECK(current_sense_init(&cs_cfg));
+#elif CONFIG_ROBOT_BATTERY_PIN >= 0
+    battery_sense_config_t bs_cfg = {
+        .pin   = CONFIG_ROBOT_BATTERY_PIN,
+        .scale = CONFIG_ROBOT_BATTERY_DIVIDER_X100 / 100.0f,
+    };
+    ESP_ERROR_CHECK(battery_sense_init(&bs_cfg));
+#endif
+
+    // Initialize differential drive mixer — NVS values override Kconfig defaults,
+    // and HTTP/serial can change them live afterwards
     ESP_LOGI(TAG, "Initializing differential drive...");
-    int deadzone_pct    = nvs_cfg_int("deadzone",   CONFIG_ROBOT_DRIVE_DEADZONE);
-    int expo_pct        = nvs_cfg_int("expo",        CONFIG_ROBOT_DRIVE_EXPO);
-    int max_speed_pct   = nvs_cfg_int("max_speed",  CONFIG_ROBOT_DRIVE_MAX_SPEED);
-    int slow_factor_pct = nvs_cfg_int("slow_factor", CONFIG_ROBOT_DRIVE_SLOW_MODE_FACTOR);
-    ESP_LOGI(TAG, "  drive config: deadzone=%d%% expo=%d%% max_speed=%d%% slow=%d%%",
-             deadzone_pct, expo_pct, max_speed_pct, slow_factor_pct);
-    mixer_config_t mixer_cfg = {
-        .deadzone         = deadzone_pct    / 100.0f,
-        .expo             = expo_pct        / 100.0f,
-        .max_speed        = max_speed_pct   / 100.0f,
-        .slow_mode_factor = slow_factor_pct / 100.0f,
+    ESP_ERROR_CHECK(drive_config_init());
+
+    // Closed-loop track speed control (open loop until a feedback source registers)
+#ifdef CONFIG_ROBOT_SPEED_CTRL
+    speed_ctrl_config_t speed_cfg = {
+        .enabled = true,
+        .gains = {
+            .kp          = CONFIG_ROBOT_SPEED_CTRL_KP / 1000.0f,
+            .ki          = CONFIG_ROBOT_SPEED_CTRL_KI / 1000.0f,
+            .kd          = CONFIG_ROBOT_SPEED_CTRL_KD / 1000.0f,
+            .kff         = CONFIG_ROBOT_SPEED_CTRL_KFF / 100.0f,
+            .kstatic     = CONFIG_ROBOT_SPEED_CTRL_KSTATIC / 100.0f,
+            .d_cutoff_hz = CONFIG_ROBOT_SPEED_CTRL_D_CUTOFF_HZ,
+            .out_limit   = 1.0f,
+        },
     };
-    ESP_ERROR_CHECK(mixer_diffdrive_init(&mixer_cfg));
+#else
+    speed_ctrl_config_t speed_cfg = { .enabled = false };
+#endif
+    ESP_ERROR_CHECK(speed_ctrl_init(&speed_cfg));
+#ifdef CONFIG_ROBOT_SPEED_CTRL_CURRENT_FEEDBACK
+    speed_ctrl_set_feedback(&emf_speed);
+#endif
+
+    // Thermal derating (duty estimate unless current sense measures the load)
+    thermal_guard_config_t thermal_cfg = {
+#ifdef CONFIG_ROBOT_THERMAL_DERATE
+        .enabled = true,
+#endif
+        .params = {
+            .motor_tau_s    = CONFIG_ROBOT_THERMAL_MOTOR_TAU_S,
+            .motor_limit_a  = CONFIG_ROBOT_THERMAL_MOTOR_LIMIT_A,
+            .bridge_tau_s   = CONFIG_ROBOT_THERMAL_BRIDGE_TAU_S,
+            .bridge_limit_a = CONFIG_ROBOT_THERMAL_BRIDGE_LIMIT_A,
+            .full_duty_a    = CONFIG_ROBOT_THERMAL_FULL_DUTY_A,
+            .derate_start   = CONFIG_ROBOT_THERMAL_DERATE_START / 100.0f,
+            .min_scale      = CONFIG_ROBOT_THERMAL_MIN_SCALE / 100.0f,
+            .resume         = CONFIG_ROBOT_THERMAL_RESUME / 100.0f,
+        },
+    };
+    ESP_ERROR_CHECK(thermal_guard_init(&thermal_cfg));
+#ifdef CONFIG_ROBOT_CURRENT_SENSE
+    thermal_guard_set_current(&thermal_current);
+#endif
+
+    // Battery limit (not present without a divider pin)
+    battery_guard_config_t battery_cfg = {
+#ifdef CONFIG_ROBOT_BATTERY_LIMIT
+        .enabled = true,
+#endif
+        .params = {
+            .cells       = CONFIG_ROBOT_BATTERY_CELLS,
+            .min_v       = CONFIG_ROBOT_BATTERY_MIN_MV / 1000.0f,
+            .r_init_ohm  = CONFIG_ROBOT_BATTERY_R_INIT_MOHM / 1000.0f,
+            .low_soc     = CONFIG_ROBOT_BATTERY_LOW_PCT / 100.0f,
+            .full_duty_a = CONFIG_ROBOT_THERMAL_FULL_DUTY_A,
+        },
+    };
+    ESP_ERROR_CHECK(battery_guard_init(&battery_cfg));
+#if CONFIG_ROBOT_BATTERY_PIN >= 0
+    battery_guard_set_source(&battery_source);
+#endif
 
     // Initialize control manager (arbitration logic)
     ESP_LOGI(TAG, "Initializing control manager...");
-    ESP_ERROR_CHECK(control_manager_init());
+    control_manager_config_t control_cfg = {
+        .loop_rate_hz = (uint32_t)loop_hz,
+    };
+    ESP_ERROR_CHECK(control_manager_init(&control_cfg));
 
 #ifdef CONFIG_ROBOT_ENABLE_SERIAL
     // Initialize Serial controller
@@ -155,7 +392,8 @@ void app_main(void) {
     // Run PS4 HID host initialization in a separate task so a BT/HID issue
     // cannot block WiFi fallback, web UI, serial control, or system heartbeat.
     ESP_LOGI(TAG, "Starting PS4 controller init task...");
-    BaseType_t ps4_task = xTaskCreate(ps4_init_task, "ps4_init", 6144, NULL, 4, NULL);
+    BaseType_t ps4_task = xTaskCreatePinnedToCore(ps4_init_task, "ps4_init", 6144, NULL, 4, NULL,
+                                                  INPUT_CORE);
     if (ps4_task != pdPASS) {
         ESP_LOGE(TAG, "Failed to create PS4 init task");
     }
@@ -0,0 +1,313 @@
+/**
+ * @file arbiter_sim.c
+ * @brief Host check: control arbitration under interleaved sources and handovers
+ *
+ * Drives the firmware's control_arbiter.c the way control_step() does: the
+ * sources submit frames on their own schedules (1 ms resolution), and every
+ * control cycle hands each source's batch to the arbiter in source order,
+ * newest submit order and count, then ticks it. Checks:
+ *
+ *   names      handover targets: the three sources and "none" / "NONE"
+ *              parse, anything else is refused (not taken as a release)
+ *   lease      lease numbers: whole numbers 0..UINT32_MAX only; negative,
+ *              fractional, NaN and too large values are refused
+ *   handover   stale, replayed, self and dead-target handovers are refused;
+ *              a valid one moves ownership and bumps the lease; "none"
+ *              releases control until the next frame claims it
+ *   interleave each policy, three sources with different rates, jitter and
+ *              drop-outs for 10 min of simulated time. After every cycle:
+ *              the owner is alive (or no source is), the lease counts every
+ *              ownership change, and the owner is the one the policy names:
+ *              newest frame (last wins), highest priority then newest
+ *              (priority), unchanged unless it died (sticky lease)
+ *
+ * The exit status is the number of failed checks. Build and run from the
+ * repository root:
+ *
+ *   gcc -O2 -std=gnu17 -Ifirmware/components/control/include \
+ *       tools/arbiter_sim.c firmware/components/control/control_arbiter.c \
+ *       -o arbiter_sim && ./arbiter_sim [-s seed] [-c cycle_ms]
+ */
+
+#include "control_arbiter.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NSRC      CONTROL_ARBITER_MAX_SOURCES
+#define SIM_MS    (10u * 60u * 1000u)
+
+static int failures = 0;
+
+static void check(const char *phase, const char *what, int ok) {
+    printf("  %s  %s: %s\n", ok ? "PASS" : "FAIL", phase, what);
+    if (!ok) failures++;
+}
+
+static uint32_t rng_state = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) % n;
+}
+
+static const control_arbiter_source_cfg_t cfg[NSRC] = {
+    [CONTROL_SOURCE_PS4]    = { 3, 500 },
+    [CONTROL_SOURCE_SERIAL] = { 2, 500 },
+    [CONTROL_SOURCE_HTTP]   = { 1, 300 },
+};
+
+static void check_names(void) {
+    printf("\nnames\n");
+    static const struct { const char *name; int ok; control_source_t want; } cases[] = {
+        {"PS4", 1, CONTROL_SOURCE_PS4},   {"SERIAL", 1, CONTROL_SOURCE_SERIAL},
+        {"HTTP", 1, CONTROL_SOURCE_HTTP}, {"none", 1, CONTROL_SOURCE_NONE},
+        {"NONE", 1, CONTROL_SOURCE_NONE}, {"ps5", 0, 0}, {"", 0, 0},
+        {"HTTPS", 0, 0},                  {"PS", 0, 0},  {"None ", 0, 0},
+    };
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        control_source_t out = (control_source_t)99;
+        bool got = control_arbiter_target_from_name(cases[i].name, &out);
+        if (got != (bool)cases[i].ok || (got && out != cases[i].want)) {
+            printf("    \"%s\": got %d (%d)\n", cases[i].name, got, (int)out);
+            ok = 0;
+        }
+    }
+    check("names", "known targets parse, unknown ones are refused", ok);
+    control_source_t out;
+    check("names", "NULL is refused", !control_arbiter_target_from_name(NULL, &out));
+}
+
+static void check_lease(void) {
+    printf("\nlease\n");
+    static const struct { double v; int ok; uint32_t want; } cases[] = {
+        {0.0, 1, 0}, {12.0, 1, 12}, {4294967295.0, 1, UINT32_MAX},
+        {-1.0, 0, 0}, {-0.5, 0, 0}, {1.5, 0, 0}, {4294967296.0, 0, 0}, {1e20, 0, 0},
+        {-1e20, 0, 0},
+    };
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint32_t out = 77;
+        bool got = control_arbiter_lease_from_number(cases[i].v, &out);
+        if (got != (bool)cases[i].ok || (got && out != cases[i].want)) {
+            printf("    %g: got %d (%lu)\n", cases[i].v, got, (unsigned long)out);
+            ok = 0;
+        }
+    }
+    uint32_t out;
+    ok &= !control_arbiter_lease_from_number(NAN, &out);
+    ok &= !control_arbiter_lease_from_number(INFINITY, &out);
+    check("lease", "whole numbers 0..UINT32_MAX only (NaN and inf refused)", ok);
+}
+
+static void check_handover(void) {
+    printf("\nhandover\n");
+    control_arbiter_t arb;
+    control_arbiter_init(&arb, CONTROL_POLICY_STICKY_LEASE, cfg);
+    uint32_t order = 0;
+
+    control_arbiter_on_frame(&arb, CONTROL_SOURCE_PS4, order++, 0, 1);
+    control_arbiter_on_frame(&arb, CONTROL_SOURCE_SERIAL, order++, 0, 1);
+    control_arbiter_tick(&arb, 10);
+    uint32_t lease = arb.lease;
+    check("handover", "first frame claims ownership",
+          arb.owner == CONTROL_SOURCE_PS4 && lease == 1);
+    check("handover", "sticky owner keeps control against a newer source",
+          arb.owner == CONTROL_SOURCE_PS4);
+
+    check("handover", "stale lease refused",
+          !control_arbiter_handover(&arb, lease - 1, CONTROL_SOURCE_SERIAL) &&
+          arb.owner == CONTROL_SOURCE_PS4 && arb.lease == lease);
+    check("handover", "never-seen target refused",
+          !control_arbiter_handover(&arb, lease, CONTROL_SOURCE_HTTP) &&
+          arb.owner == CONTROL_SOURCE_PS4);
+    check("handover", "handover to the owner itself refused",
+          !control_arbiter_handover(&arb, lease, CONTROL_SOURCE_PS4) && arb.lease == lease);
+    check("handover", "out-of-range target refused",
+          !control_arbiter_handover(&arb, lease, (control_source_t)7) &&
+          arb.owner == CONTROL_SOURCE_PS4);
+
+    check("handover", "valid handover moves ownership and bumps the lease",
+          control_arbiter_handover(&arb, lease, CONTROL_SOURCE_SERIAL) &&
+          arb.owner == CONTROL_SOURCE_SERIAL && arb.lease == lease + 1);
+    check("handover", "replayed request refused (lease now stale)",
+          !control_arbiter_handover(&arb, lease, CONTROL_SOURCE_PS4) &&
+          arb.owner == CONTROL_SOURCE_SERIAL);
+
+    // SERIAL goes quiet: a handover to it once dead is refused
+    control_arbiter_on_frame(&arb, CONTROL_SOURCE_PS4, order++, 400, 1);
+    control_arbiter_tick(&arb, 520);
+    check("handover", "dead owner falls back to the live source",
+          arb.owner == CONTROL_SOURCE_PS4);
+    lease = arb.lease;
+    check("handover", "handover to a dead source refused",
+          !control_arbiter_handover(&arb, lease, CONTROL_SOURCE_SERIAL) &&
+          arb.owner == CONTROL_SOURCE_PS4);
+
+    check("handover", "\"none\" releases control and bumps the lease",
+          control_arbiter_handover(&arb, lease, CONTROL_SOURCE_NONE) &&
+          arb.owner == CONTROL_SOURCE_NONE && arb.lease == lease + 1);
+    control_arbiter_tick(&arb, 530);
+    check("handover", "released control stays released until a frame",
+          arb.owner == CONTROL_SOURCE_NONE);
+    control_arbiter_on_frame(&arb, CONTROL_SOURCE_PS4, order++, 540, 1);
+    check("handover", "next frame claims the released control",
+          arb.owner == CONTROL_SOURCE_PS4 && arb.lease == lease + 2);
+}
+
+typedef struct {
+    uint32_t period_ms;
+    uint32_t jitter_ms;
+    uint32_t next_ms;
+    uint32_t quiet_until;   // drop-out in progress
+    // Batch since the last control cycle, as drained from the ring
+    uint32_t count;
+    uint32_t order;
+    uint32_t submit_ms;
+    // Reference model
+    bool     seen;
+    uint32_t last_ms;
+    uint32_t last_order;
+} sim_src_t;
+
+static bool ref_alive(const sim_src_t *s, int i, uint32_t now) {
+    return s->seen && now - s->last_ms <= cfg[i].timeout_ms;
+}
+
+/**
+ * @brief Who the policy says should own control, or NONE if no constraint
+ */
+static control_source_t ref_owner(control_policy_t policy, const sim_src_t src[NSRC],
+                                  uint32_t now) {
+    control_source_t best = CONTROL_SOURCE_NONE;
+    for (int i = CONTROL_SOURCE_PS4; i < NSRC; i++) {
+        if (!ref_alive(&src[i], i, now)) continue;
+        if (best == CONTROL_SOURCE_NONE) { best = (control_source_t)i; continue; }
+        if (policy == CONTROL_POLICY_PRIORITY && cfg[i].priority != cfg[best].priority) {
+            if (cfg[i].priority > cfg[best].priority) best = (control_source_t)i;
+        } else if ((int32_t)(src[i].last_order - src[best].last_order) > 0) {
+            best = (control_source_t)i;
+        }
+    }
+    return best;
+}
+
+static void check_interleave(control_policy_t policy, uint32_t cycle_ms) {
+    const char *name = control_arbiter_policy_name(policy);
+    printf("\ninterleave: %s, %lu ms cycle\n", name, (unsigned long)cycle_ms);
+    control_arbiter_t arb;
+    control_arbiter_init(&arb, policy, cfg);
+
+    sim_src_t src[NSRC] = {
+        [CONTROL_SOURCE_PS4]    = { .period_ms = 20,  .jitter_ms = 8 },
+        [CONTROL_SOURCE_SERIAL] = { .period_ms = 10,  .jitter_ms = 3 },
+        [CONTROL_SOURCE_HTTP]   = { .period_ms = 100, .jitter_ms = 60 },
+    };
+    uint32_t order = 0;
+    uint32_t changes = 0, cycles = 0;
+    uint32_t bad_alive = 0, bad_lease = 0, bad_owner = 0, owned = 0;
+    uint32_t seen_owner[NSRC] = {0};
+    control_source_t last_owner = CONTROL_SOURCE_NONE;
+
+    for (uint32_t now = 0; now < SIM_MS; now++) {
+        for (int i = CONTROL_SOURCE_PS4; i < NSRC; i++) {
+            sim_src_t *s = &src[i];
+            if (now < s->quiet_until || now < s->next_ms) continue;
+            // About one drop-out a minute per source, 0.2 to 2 s long
+            if (rnd(60000 / s->period_ms) == 0) {
+                s->quiet_until = now + 200 + rnd(1800);
+                continue;
+            }
+            s->count++;
+            s->order     = order++;
+            s->submit_ms = now;
+            s->next_ms   = now + s->period_ms - s->jitter_ms / 2 + rnd(s->jitter_ms + 1);
+        }
+        if (now % cycle_ms != 0) continue;
+
+        // One control cycle: drain in source order, then tick
+        for (int i = CONTROL_SOURCE_PS4; i < NSRC; i++) {
+            sim_src_t *s = &src[i];
+            if (s->count == 0) continue;
+            control_source_t prev = arb.owner;
+            control_arbiter_on_frame(&arb, (control_source_t)i, s->order, s->submit_ms, s->count);
+            if (arb.owner != prev) changes++;
+            s->seen       = true;
+            s->last_ms    = s->submit_ms;
+            s->last_order = s->order;
+            s->count      = 0;
+        }
+        control_source_t prev = arb.owner;
+        control_source_t owner = control_arbiter_tick(&arb, now);
+        if (owner != prev) changes++;
+        cycles++;
+
+        control_source_t want = ref_owner(policy, src, now);
+        bool any_alive = (want != CONTROL_SOURCE_NONE);
+        if (owner == CONTROL_SOURCE_NONE ? any_alive : !ref_alive(&src[owner], owner, now)) {
+            bad_alive++;
+        }
+        if (arb.lease != changes) bad_lease++;
+        if (policy == CONTROL_POLICY_STICKY_LEASE) {
+            // Only a dead owner may lose control
+            if (last_owner != CONTROL_SOURCE_NONE && owner != last_owner &&
+                ref_alive(&src[last_owner], last_owner, now)) {
+                bad_owner++;
+            }
+        } else if (owner != want) {
+            bad_owner++;
+        }
+        if (owner != CONTROL_SOURCE_NONE) owned++;
+        seen_owner[owner]++;
+        last_owner = owner;
+    }
+
+    printf("  %lu cycles, %lu ownership changes, owned %.1f%% (PS4 %lu, SERIAL %lu, HTTP %lu)\n",
+           (unsigned long)cycles, (unsigned long)changes, 100.0 * owned / cycles,
+           (unsigned long)seen_owner[CONTROL_SOURCE_PS4],
+           (unsigned long)seen_owner[CONTROL_SOURCE_SERIAL],
+           (unsigned long)seen_owner[CONTROL_SOURCE_HTTP]);
+    char what[96];
+    snprintf(what, sizeof(what), "%s: owner always alive, NONE only with no live source", name);
+    check("interleave", what, bad_alive == 0);
+    snprintf(what, sizeof(what), "%s: lease counts every ownership change", name);
+    check("interleave", what, bad_lease == 0);
+    snprintf(what, sizeof(what), "%s: owner matches the policy", name);
+    check("interleave", what, bad_owner == 0);
+    if (bad_alive || bad_lease || bad_owner) {
+        printf("    bad cycles: alive %lu, lease %lu, owner %lu\n", (unsigned long)bad_alive,
+               (unsigned long)bad_lease, (unsigned long)bad_owner);
+    }
+    // HTTP only wins under priority / sticky when both others are quiet at
+    // once, which depends on the seed; PS4 and SERIAL must both get a turn
+    snprintf(what, sizeof(what), "%s: control changed hands between sources", name);
+    check("interleave", what, seen_owner[CONTROL_SOURCE_PS4] && seen_owner[CONTROL_SOURCE_SERIAL] &&
+                              (policy != CONTROL_POLICY_LAST_WINS || seen_owner[CONTROL_SOURCE_HTTP]));
+}
+
+int main(int argc, char **argv) {
+    uint32_t cycle_ms = 20;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:c:")) != -1) {
+        switch (opt) {
+            case 's': rng_state = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'c': cycle_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-s seed] [-c cycle_ms]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (cycle_ms == 0) cycle_ms = 1;
+
+    check_names();
+    check_lease();
+    check_handover();
+    check_interleave(CONTROL_POLICY_LAST_WINS, cycle_ms);
+    check_interleave(CONTROL_POLICY_PRIORITY, cycle_ms);
+    check_interleave(CONTROL_POLICY_STICKY_LEASE, cycle_ms);
+
+    printf("\n%s (%d failed)\n", failures ? "FAIL" : "PASS", failures);
+    return failures;
+}
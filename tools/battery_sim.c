@@ -0,0 +1,307 @@
+/**
+ * @file battery_sim.c
+ * @brief Host check: battery estimator against simulated and recorded traces
+ *
+ * Runs the firmware's battery_model.c at the control loop rate. Without -t
+ * it drives a simulated pack (open-circuit voltage behind a resistance)
+ * feeding two wiper motors through the output scale and the motor accel /
+ * decel ramp, the way control_manager and the motor driver apply them, and
+ * checks:
+ *
+ *   rest     no load: SoC matches the rest-voltage curve
+ *   drive    on/off driving: the resistance estimate converges
+ *   stall    both tracks stalled at full throttle: with limiting the pack
+ *            dips less than 1 V below the floor while the limit catches up
+ *            and then holds it; without it, it sags far below
+ *   flat     pack below the floor: output is held at zero
+ *   blind    resistance guessed 10x low, no driving before the stall: the
+ *            voltage backstop still catches the sag
+ *   pid      the stall again with closed-loop speed control (default
+ *            speed_ctrl gains) between the limit and the ramp, as
+ *            speed_ctrl_run() does: the integrator must not wind the duty
+ *            past the limit, so the pack is held as in open loop
+ *
+ * Each profile prints a timeline and PASS/FAIL lines; the exit status is
+ * the number of failed checks.
+ *
+ * The 1 V onset bound holds from the 50 Hz default loop rate up. At 20 Hz
+ * and below, the coarser ticks let the first dip reach about 1 V.
+ *
+ * With -t the estimator replays a recorded trace instead: one
+ * "time_s,volts,amps" line per sample (amps may be left empty, then it is
+ * estimated from the duty columns "…,left,right" if present, else 0). Lines
+ * starting with '#' are skipped. -w writes the simulated drive + stall
+ * trace in that format.
+ *
+ * Build and run from the repository root:
+ *
+ *   gcc -O2 -std=gnu17 -Ifirmware/components/motion/include \
+ *       tools/battery_sim.c firmware/components/motion/battery_model.c \
+ *       firmware/components/motion/speed_pid.c -lm -o battery_sim && ./battery_sim [options]
+ *
+ * Options (Kconfig units, defaults match Kconfig):
+ *   -c cells  -m min_mV  -r r_init_mohm  -l low_soc%  -f full_duty_A
+ *   -a accel_ms  -d decel_ms  -R true_r_mohm  -H loop_hz  -t trace.csv  -w out.csv
+ */
+
+#include "battery_model.h"
+#include "speed_pid.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Wiper motor, per track
+#define MOTOR_R_OHM   0.48f   // winding + bridge: 25 A stall at 12 V
+#define MOTOR_KE      0.12f   // V per rad/s
+#define MOTOR_LOAD    0.8f    // running speed as a share of no-load speed
+#define MOTOR_TAU_S   0.3f    // speed response
+#define SENSE_TAU_S   0.025f  // current sense moving average
+#define NOISE_V       0.02f
+
+typedef struct {
+    const char *name;
+    double duration_s;
+    float  ocv;           // pack open-circuit voltage
+    float  r_init;        // estimator's starting resistance (0 = Kconfig)
+    bool   limit;         // apply the scale
+    double drive_until_s; // on/off driving before this
+    double stall_from_s;  // both tracks stalled at full throttle after this (<0 = never)
+    bool   pid;           // closed-loop speed control on the measured track speed
+} profile_t;
+
+typedef struct {
+    float v_min;          // lowest pack voltage during the stall
+    float v_hold;         // mean pack voltage over the last 5 s
+    float r_est;
+    float soc;
+    float scale_min;
+    float v_cmd_max;      // highest commanded output at the end
+    float max_excess;     // largest duty command above the limit in force
+} result_t;
+
+// Kconfig speed_ctrl defaults
+static const speed_pid_gains_t pid_gains = {
+    .kp = 0.8f, .ki = 6.0f, .kd = 0.0f,
+    .kff = 1.0f, .kstatic = 0.0f, .d_cutoff_hz = 20.0f, .out_limit = 1.0f,
+};
+
+static battery_params_t params = {
+    .cells       = 3,
+    .min_v       = 9.0f,
+    .r_init_ohm  = 0.12f,
+    .low_soc     = 0.15f,
+    .full_duty_a = 8.0f,
+};
+static float true_r = 0.15f;
+static int   loop_hz = 50;
+static int   accel_ms = 200;
+static int   decel_ms = 150;
+static int   failures = 0;
+
+static void check(const char *profile, const char *what, int ok) {
+    printf("  %s  %s: %s\n", ok ? "PASS" : "FAIL", profile, what);
+    if (!ok) failures++;
+}
+
+static float noise(void) {
+    static uint32_t s = 12345;
+    s = s * 1664525u + 1013904223u;
+    return ((float)(s >> 8) / 16777216.0f - 0.5f) * 2.0f * NOISE_V;
+}
+
+static result_t run(const profile_t *pr, FILE *trace) {
+    battery_params_t p = params;
+    if (pr->r_init > 0.0f) p.r_init_ohm = pr->r_init;
+    battery_est_t b;
+    battery_est_reset(&b, &p);
+    speed_pid_t pid;
+    speed_pid_reset(&pid);
+
+    result_t r = { .v_min = 99.0f, .scale_min = 1.0f };
+    double dt = 1.0 / loop_hz;
+    long steps = (long)(pr->duration_s * loop_hz);
+    float w[2] = {0}, sensed = 0.0f, volts = pr->ocv, duty = 0.0f;
+    double v_sum = 0.0;
+    long v_n = 0;
+
+    printf("\n%s\n  %6s %6s %6s %6s %6s %6s %6s %5s\n", pr->name,
+           "t_s", "cmd", "V", "I", "ocv", "R_mohm", "soc%", "scale");
+    for (long i = 0; i <= steps; i++) {
+        double t = i * dt;
+        bool stalled = pr->stall_from_s >= 0 && t >= pr->stall_from_s;
+        float cmd = 0.0f;
+        if (stalled) {
+            cmd = 1.0f;
+        } else if (t < pr->drive_until_s) {
+            cmd = (fmod(t, 4.0) >= 2.0) ? 0.8f : 0.0f;
+        }
+        // Limit (inside speed control when closed), then the motor driver's
+        // slew-rate ramp
+        float limit = pr->limit ? b.scale : 1.0f;
+        float target = cmd * limit;
+        if (pr->pid) {
+            float meas = w[0] * MOTOR_KE / pr->ocv;  // 1.0 = no-load speed at full duty
+            target = speed_pid_update_limited(&pid, &pid_gains, cmd, meas, limit, (float)dt);
+        }
+        if (target - limit > r.max_excess) r.max_excess = target - limit;
+        int ramp_ms = (target > duty) ? accel_ms : decel_ms;
+        float step = ramp_ms ? (float)(dt * 1000.0 / ramp_ms) : 1.0f;
+        if (target > duty + step) {
+            duty += step;
+        } else if (target < duty - step) {
+            duty -= step;
+        } else {
+            duty = target;
+        }
+
+        // Pack: V = E - R * I, with each motor drawing duty * (duty V - back EMF) / Rm
+        float amps = 0.0f;
+        for (int k = 0; k < 2; k++) {
+            float w_ss = stalled ? 0.0f : MOTOR_LOAD * duty * volts / MOTOR_KE;
+            w[k] += (w_ss - w[k]) * (float)(dt / (MOTOR_TAU_S + dt));
+            if (stalled) w[k] = 0.0f;
+            float im = (duty * volts - MOTOR_KE * w[k]) / MOTOR_R_OHM;
+            amps += duty * (im > 0.0f ? im : 0.0f);
+        }
+        volts = pr->ocv - true_r * amps;
+        if (volts < 0.0f) volts = 0.0f;
+        sensed += (amps - sensed) * (float)(dt / (SENSE_TAU_S + dt));
+
+        float v_meas = volts + noise();
+        battery_est_update(&b, &p, v_meas, sensed, (float)dt);
+        if (trace) fprintf(trace, "%.3f,%.3f,%.2f\n", t, v_meas, sensed);
+
+        if (stalled && volts < r.v_min) r.v_min = volts;
+        if (t > pr->duration_s - 5.0) v_sum += volts, v_n++;
+        if (b.scale < r.scale_min) r.scale_min = b.scale;
+        if (i % loop_hz == 0 && (long)t % 5 == 0) {
+            printf("  %6.0f %6.2f %6.2f %6.1f %6.2f %6.0f %6.1f %5.2f\n", t, cmd, volts, amps,
+                   b.ocv, b.r_ohm * 1000.0f, b.soc * 100.0f, b.scale);
+        }
+        r.v_cmd_max = duty;
+    }
+    r.v_hold = v_n ? (float)(v_sum / v_n) : volts;
+    r.r_est = b.r_ohm;
+    r.soc   = b.soc;
+    printf("  stall min %.2f V, last 5 s %.2f V, R %.0f mOhm, SoC %.0f%%, lowest scale %.2f\n",
+           r.v_min < 99.0f ? r.v_min : volts, r.v_hold, r.r_est * 1000.0f, r.soc * 100.0f,
+           r.scale_min);
+    return r;
+}
+
+static int replay(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    battery_est_t b;
+    battery_est_reset(&b, &params);
+    char line[256];
+    double last_t = -1.0, next_print = 0.0;
+    long n = 0;
+    printf("%8s %6s %6s %6s %6s %6s %5s %6s\n",
+           "t_s", "V", "I", "ocv", "R_mohm", "soc%", "scale", "lim_A");
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        double t;
+        float v, a = 0.0f, left = 0.0f, right = 0.0f;
+        char amps_col[32] = "";
+        if (sscanf(line, "%lf,%f,%31[^,\n],%f,%f", &t, &v, amps_col, &left, &right) < 2) continue;
+        if (amps_col[0] != '\0') {
+            a = strtof(amps_col, NULL);
+        } else {
+            a = battery_amps_from_duty(&params, left, right);
+        }
+        float dt = (last_t < 0.0) ? 0.0f : (float)(t - last_t);
+        last_t = t;
+        battery_est_update(&b, &params, v, a, dt);
+        n++;
+        if (t >= next_print) {
+            next_print = t + 1.0;
+            printf("%8.2f %6.2f %6.1f %6.2f %6.0f %6.1f %5.2f %6.1f\n", t, b.volts, b.amps,
+                   b.ocv, b.r_ohm * 1000.0f, b.soc * 100.0f, b.scale, b.limit_a);
+        }
+    }
+    fclose(f);
+    printf("\n%ld samples: R %.0f mOhm, OCV %.2f V, SoC %.0f%%, min %.2f V, state %s\n",
+           n, b.r_ohm * 1000.0f, b.ocv, b.soc * 100.0f, b.min_volts,
+           battery_state_name(battery_est_state(&b, &params, true)));
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *trace_in = NULL, *trace_out = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:m:r:l:f:a:d:R:H:t:w:")) != -1) {
+        switch (opt) {
+            case 'c': params.cells = atoi(optarg); break;
+            case 'm': params.min_v = atoi(optarg) / 1000.0f; break;
+            case 'r': params.r_init_ohm = atoi(optarg) / 1000.0f; break;
+            case 'l': params.low_soc = atoi(optarg) / 100.0f; break;
+            case 'f': params.full_duty_a = (float)atof(optarg); break;
+            case 'a': accel_ms = atoi(optarg); break;
+            case 'd': decel_ms = atoi(optarg); break;
+            case 'R': true_r = atoi(optarg) / 1000.0f; break;
+            case 'H': loop_hz = atoi(optarg); break;
+            case 't': trace_in = optarg; break;
+            case 'w': trace_out = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-c cells] [-m min_mV] [-r r_init_mohm] [-l low_soc%%] "
+                        "[-f full_duty_A] [-a accel_ms] [-d decel_ms] [-R true_r_mohm] [-H loop_hz] [-t trace.csv] "
+                        "[-w out.csv]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (trace_in) {
+        return replay(trace_in);
+    }
+
+    printf("pack %d cells, floor %.2f V, R true %.0f mOhm / initial %.0f mOhm, %d Hz, "
+           "ramp %d / %d ms\n", params.cells, params.min_v, true_r * 1000.0f,
+           params.r_init_ohm * 1000.0f, loop_hz, accel_ms, decel_ms);
+
+    profile_t rest = {"rest", 60, 11.1f, 0, true, 0, -1, false};
+    result_t r = run(&rest, NULL);
+    check("rest", "SoC within 3% of the curve at 3.70 V/cell",
+          fabsf(r.soc - battery_soc_from_cell(3.70f)) < 0.03f);
+
+    profile_t drive = {"drive", 60, 12.0f, 0, true, 60, -1, false};
+    r = run(&drive, NULL);
+    check("drive", "R estimate within 20% of the pack", fabsf(r.r_est - true_r) < 0.2f * true_r);
+
+    FILE *out = trace_out ? fopen(trace_out, "w") : NULL;
+    if (out) fprintf(out, "# time_s,volts,amps — simulated drive then stall\n");
+    profile_t stall = {"stall (limiting)", 40, 11.4f, 0, true, 20, 25, false};
+    r = run(&stall, out);
+    if (out) fclose(out);
+    check("stall", "pack never sags 1 V below the floor", r.v_min > params.min_v - 1.0f);
+    check("stall", "pack held within 0.2 V of the floor", r.v_hold > params.min_v - 0.2f);
+    check("stall", "motors still get output", r.v_cmd_max > 0.2f);
+
+    profile_t stall_off = {"stall (no limiting)", 40, 11.4f, 0, false, 20, 25, false};
+    r = run(&stall_off, NULL);
+    check("stall", "without limiting the pack sags below the floor", r.v_min < params.min_v - 1.0f);
+
+    profile_t flat = {"flat", 20, 8.8f, 0, true, 20, 10, false};
+    r = run(&flat, NULL);
+    check("flat", "output held at zero", r.v_cmd_max < 0.01f);
+
+    profile_t blind = {"blind", 20, 11.4f, 0.012f, true, 0, 5, false};
+    r = run(&blind, NULL);
+    check("blind", "backstop keeps the pack within 1 V of the floor", r.v_min > params.min_v - 1.0f);
+    check("blind", "pack held within 0.2 V of the floor", r.v_hold > params.min_v - 0.2f);
+
+    profile_t pid = {"stall (closed loop, limiting)", 40, 11.4f, 0, true, 20, 25, true};
+    r = run(&pid, NULL);
+    check("pid", "duty command never exceeds the limit", r.max_excess < 1e-4f);
+    check("pid", "pack never sags 1 V below the floor", r.v_min > params.min_v - 1.0f);
+    check("pid", "pack held within 0.2 V of the floor", r.v_hold > params.min_v - 0.2f);
+    check("pid", "motors still get output", r.v_cmd_max > 0.2f);
+
+    printf("\n%d failure(s)\n", failures);
+    return failures;
+}
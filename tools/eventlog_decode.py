@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Decode the persistent event log downloaded from GET /eventlog.
+
+The stream is a 16-byte header followed by 32-byte records, oldest first
+(firmware/components/eventlog/include/event_log.h). Every record's
+CRC-16/CCITT-FALSE is checked; records are sorted by seq and gaps in seq
+(records dropped because the RTC stage was full, or overwritten by the flash
+ring) are reported.
+
+  curl -o eventlog.bin http://192.168.4.1/eventlog
+  tools/eventlog_decode.py eventlog.bin [--csv] [--boot N]
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+HEADER = struct.Struct("<4sHHHHI")
+RECORD = struct.Struct("<IIIHBBBBhhhh4sH")
+
+EVENTS = {1: "BOOT", 2: "SAFETY", 3: "SOURCE", 4: "THERMAL", 5: "SAMPLE", 6: "BATTERY"}
+STATES = ["DISARMED", "ARMED", "ESTOP"]
+CAUSES = ["ARM", "DISARM", "WATCHDOG", "ESTOP", "PWM_FAULT", "OVERCURRENT", "ESTOP_RESET"]
+SOURCES = ["NONE", "PS4", "SERIAL", "HTTP"]
+THERMAL = ["OK", "WARN", "CUTOFF"]
+BATTERY = ["OK", "LOW", "LIMIT"]
+RESET_REASONS = ["UNKNOWN", "POWERON", "EXT", "SW", "PANIC", "INT_WDT", "TASK_WDT",
+                 "WDT", "DEEPSLEEP", "BROWNOUT", "SDIO"]
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def name(table, i):
+    return table[i] if 0 <= i < len(table) else str(i)
+
+
+def describe(r):
+    ev = r["event"]
+    if ev == 1:
+        return "reset=%s recovered=%d" % (name(RESET_REASONS, r["arg"]), r["value"])
+    if ev == 2:
+        return "%s -> %s cause=%s origin=%s" % (
+            name(STATES, r["value"]), name(STATES, r["state"]),
+            name(CAUSES, r["arg"]), name(SOURCES, r["source"]))
+    if ev == 3:
+        return "%s -> %s" % (name(SOURCES, r["arg"]), name(SOURCES, r["source"]))
+    if ev == 4:
+        return "%s scale=%.3f" % (name(THERMAL, r["arg"]), r["value"] / 1000.0)
+    if ev == 6:
+        return "%s pack=%.2f V" % (name(BATTERY, r["arg"]), r["value"] / 1000.0)
+    return ""
+
+
+def parse(blob):
+    if len(blob) < HEADER.size:
+        sys.exit("file too short for a header")
+    magic, version, rsize, boot, _, dropped = HEADER.unpack_from(blob)
+    if magic != b"EVLG":
+        sys.exit("bad magic %r" % magic)
+    if version != 1 or rsize != RECORD.size:
+        sys.exit("unsupported log version %d / record size %d" % (version, rsize))
+
+    records, bad = [], 0
+    for off in range(HEADER.size, len(blob) - RECORD.size + 1, RECORD.size):
+        raw = blob[off:off + RECORD.size]
+        f = RECORD.unpack(raw)
+        if f[-1] != crc16(raw[:RECORD.size - 2]):
+            bad += 1
+            continue
+        records.append({
+            "seq": f[0], "time_ms": f[1], "value": f[2], "boot": f[3],
+            "event": f[4], "source": f[5], "state": f[6], "arg": f[7],
+            "throttle": f[8] / 1000.0, "steering": f[9] / 1000.0,
+            "left": f[10] / 1000.0, "right": f[11] / 1000.0,
+        })
+    records.sort(key=lambda r: r["seq"])
+    return {"boot": boot, "dropped": dropped, "bad": bad}, records
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("file")
+    ap.add_argument("--csv", action="store_true", help="write CSV to stdout")
+    ap.add_argument("--boot", type=int, help="only records from this boot")
+    args = ap.parse_args()
+
+    with open(args.file, "rb") as fh:
+        hdr, records = parse(fh.read())
+    if args.boot is not None:
+        records = [r for r in records if r["boot"] == args.boot]
+
+    if args.csv:
+        w = csv.writer(sys.stdout)
+        w.writerow(["seq", "boot", "time_ms", "event", "state", "source", "throttle",
+                    "steering", "left", "right", "detail"])
+        for r in records:
+            w.writerow([r["seq"], r["boot"], r["time_ms"], EVENTS.get(r["event"], str(r["event"])),
+                        name(STATES, r["state"]), name(SOURCES, r["source"]),
+                        r["throttle"], r["steering"], r["left"], r["right"], describe(r)])
+        return
+
+    print("current boot %d, %d records, %d dropped this boot, %d bad CRC"
+          % (hdr["boot"], len(records), hdr["dropped"], hdr["bad"]))
+    print("%8s %4s %10s  %-8s %-8s %-6s %6s %6s %6s %6s  %s" % (
+        "seq", "boot", "time_ms", "event", "state", "source",
+        "thr", "str", "left", "right", "detail"))
+    prev = None
+    for r in records:
+        if prev is not None and r["seq"] != prev + 1:
+            print("  ... %d record(s) missing" % (r["seq"] - prev - 1))
+        prev = r["seq"]
+        print("%8d %4d %10d  %-8s %-8s %-6s %+6.2f %+6.2f %+6.2f %+6.2f  %s" % (
+            r["seq"], r["boot"], r["time_ms"], EVENTS.get(r["event"], str(r["event"])),
+            name(STATES, r["state"]), name(SOURCES, r["source"]),
+            r["throttle"], r["steering"], r["left"], r["right"], describe(r)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,139 @@
+/**
+ * @file mcpwm_prelude.h
+ * @brief Host build shim: the IDF 5.1 MCPWM API used by pwm_mcpwm.c
+ *
+ * Types and prototypes only, with the IDF names and fields. The host tool
+ * that links pwm_mcpwm.c (tools/mcpwm_deadtime_check.c) defines the
+ * functions and the handle structs.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct mcpwm_timer_t *mcpwm_timer_handle_t;
+typedef struct mcpwm_oper_t  *mcpwm_oper_handle_t;
+typedef struct mcpwm_cmpr_t  *mcpwm_cmpr_handle_t;
+typedef struct mcpwm_gen_t   *mcpwm_gen_handle_t;
+typedef struct mcpwm_sync_t  *mcpwm_sync_handle_t;
+typedef struct mcpwm_fault_t *mcpwm_fault_handle_t;
+
+typedef enum { MCPWM_TIMER_CLK_SRC_DEFAULT } mcpwm_timer_clock_source_t;
+typedef enum { MCPWM_TIMER_COUNT_MODE_UP } mcpwm_timer_count_mode_t;
+typedef enum { MCPWM_TIMER_DIRECTION_UP, MCPWM_TIMER_DIRECTION_DOWN } mcpwm_timer_direction_t;
+typedef enum { MCPWM_TIMER_EVENT_EMPTY, MCPWM_TIMER_EVENT_FULL } mcpwm_timer_event_t;
+typedef enum { MCPWM_TIMER_START_NO_STOP } mcpwm_timer_start_stop_cmd_t;
+typedef enum {
+    MCPWM_GEN_ACTION_KEEP, MCPWM_GEN_ACTION_LOW, MCPWM_GEN_ACTION_HIGH, MCPWM_GEN_ACTION_TOGGLE,
+} mcpwm_generator_action_t;
+typedef enum { MCPWM_OPER_BRAKE_MODE_CBC, MCPWM_OPER_BRAKE_MODE_OST } mcpwm_operator_brake_mode_t;
+
+typedef struct {
+    int                        group_id;
+    mcpwm_timer_clock_source_t clk_src;
+    uint32_t                   resolution_hz;
+    mcpwm_timer_count_mode_t   count_mode;
+    uint32_t                   period_ticks;
+} mcpwm_timer_config_t;
+
+typedef struct { int group_id; } mcpwm_operator_config_t;
+
+typedef struct {
+    struct { uint32_t update_cmp_on_tez: 1; } flags;
+} mcpwm_comparator_config_t;
+
+typedef struct { int gen_gpio_num; } mcpwm_generator_config_t;
+
+typedef struct {
+    uint32_t posedge_delay_ticks;
+    uint32_t negedge_delay_ticks;
+    struct { uint32_t invert_output: 1; } flags;
+} mcpwm_dead_time_config_t;
+
+typedef struct { mcpwm_timer_event_t timer_event; } mcpwm_timer_sync_src_config_t;
+
+typedef struct {
+    mcpwm_sync_handle_t     sync_src;
+    uint32_t                count_value;
+    mcpwm_timer_direction_t direction;
+} mcpwm_timer_sync_phase_config_t;
+
+typedef struct {
+    int group_id;
+    int gpio_num;
+    struct { uint32_t active_level: 1; } flags;
+} mcpwm_gpio_fault_config_t;
+
+typedef struct {
+    mcpwm_fault_handle_t        fault;
+    mcpwm_operator_brake_mode_t brake_mode;
+} mcpwm_brake_config_t;
+
+typedef struct {
+    mcpwm_timer_direction_t  direction;
+    mcpwm_timer_event_t      event;
+    mcpwm_generator_action_t action;
+} mcpwm_gen_timer_event_action_t;
+
+typedef struct {
+    mcpwm_timer_direction_t  direction;
+    mcpwm_cmpr_handle_t      comparator;
+    mcpwm_generator_action_t action;
+} mcpwm_gen_compare_event_action_t;
+
+typedef struct {
+    mcpwm_timer_direction_t     direction;
+    mcpwm_operator_brake_mode_t brake_mode;
+    mcpwm_generator_action_t    action;
+} mcpwm_gen_brake_event_action_t;
+
+#define MCPWM_GEN_TIMER_EVENT_ACTION(dir, ev, act) \
+    ((mcpwm_gen_timer_event_action_t){ .direction = (dir), .event = (ev), .action = (act) })
+#define MCPWM_GEN_COMPARE_EVENT_ACTION(dir, cmp, act) \
+    ((mcpwm_gen_compare_event_action_t){ .direction = (dir), .comparator = (cmp), .action = (act) })
+#define MCPWM_GEN_BRAKE_EVENT_ACTION(dir, mode, act) \
+    ((mcpwm_gen_brake_event_action_t){ .direction = (dir), .brake_mode = (mode), .action = (act) })
+
+typedef struct { int unused; } mcpwm_fault_event_data_t;
+typedef bool (*mcpwm_fault_event_cb_t)(mcpwm_fault_handle_t fault,
+                                       const mcpwm_fault_event_data_t *edata, void *user_ctx);
+typedef struct {
+    mcpwm_fault_event_cb_t on_fault_enter;
+    mcpwm_fault_event_cb_t on_fault_exit;
+} mcpwm_fault_event_callbacks_t;
+
+esp_err_t mcpwm_new_timer(const mcpwm_timer_config_t *config, mcpwm_timer_handle_t *ret_timer);
+esp_err_t mcpwm_timer_enable(mcpwm_timer_handle_t timer);
+esp_err_t mcpwm_timer_start_stop(mcpwm_timer_handle_t timer, mcpwm_timer_start_stop_cmd_t command);
+esp_err_t mcpwm_new_timer_sync_src(mcpwm_timer_handle_t timer,
+                                   const mcpwm_timer_sync_src_config_t *config,
+                                   mcpwm_sync_handle_t *ret_sync);
+esp_err_t mcpwm_timer_set_phase_on_sync(mcpwm_timer_handle_t timer,
+                                        const mcpwm_timer_sync_phase_config_t *config);
+esp_err_t mcpwm_new_operator(const mcpwm_operator_config_t *config, mcpwm_oper_handle_t *ret_oper);
+esp_err_t mcpwm_operator_connect_timer(mcpwm_oper_handle_t oper, mcpwm_timer_handle_t timer);
+esp_err_t mcpwm_operator_set_brake_on_fault(mcpwm_oper_handle_t oper,
+                                            const mcpwm_brake_config_t *config);
+esp_err_t mcpwm_operator_recover_from_fault(mcpwm_oper_handle_t oper, mcpwm_fault_handle_t fault);
+esp_err_t mcpwm_new_comparator(mcpwm_oper_handle_t oper, const mcpwm_comparator_config_t *config,
+                               mcpwm_cmpr_handle_t *ret_cmpr);
+esp_err_t mcpwm_comparator_set_compare_value(mcpwm_cmpr_handle_t cmpr, uint32_t cmp_ticks);
+esp_err_t mcpwm_new_generator(mcpwm_oper_handle_t oper, const mcpwm_generator_config_t *config,
+                              mcpwm_gen_handle_t *ret_gen);
+esp_err_t mcpwm_generator_set_action_on_timer_event(mcpwm_gen_handle_t gen,
+                                                    mcpwm_gen_timer_event_action_t ev_act);
+esp_err_t mcpwm_generator_set_action_on_compare_event(mcpwm_gen_handle_t gen,
+                                                      mcpwm_gen_compare_event_action_t ev_act);
+esp_err_t mcpwm_generator_set_action_on_brake_event(mcpwm_gen_handle_t gen,
+                                                    mcpwm_gen_brake_event_action_t ev_act);
+esp_err_t mcpwm_generator_set_force_level(mcpwm_gen_handle_t gen, int level, bool hold_on);
+esp_err_t mcpwm_generator_set_dead_time(mcpwm_gen_handle_t in_generator,
+                                        mcpwm_gen_handle_t out_generator,
+                                        const mcpwm_dead_time_config_t *config);
+esp_err_t mcpwm_new_gpio_fault(const mcpwm_gpio_fault_config_t *config,
+                               mcpwm_fault_handle_t *ret_fault);
+esp_err_t mcpwm_fault_register_event_callbacks(mcpwm_fault_handle_t fault,
+                                               const mcpwm_fault_event_callbacks_t *cbs,
+                                               void *user_data);
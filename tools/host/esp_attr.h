@@ -0,0 +1,9 @@
+/**
+ * @file esp_attr.h
+ * @brief Host build shim: placement attributes are no-ops
+ */
+
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
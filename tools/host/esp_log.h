@@ -0,0 +1,18 @@
+/**
+ * @file esp_log.h
+ * @brief Host build shim: logging goes to stdout when HOST_LOG is set
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#ifdef HOST_LOG
+#define HOST_LOG_PRINT(level, tag, fmt, ...) printf(level " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#else
+#define HOST_LOG_PRINT(level, tag, fmt, ...) ((void)(tag))
+#endif
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG_PRINT("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG_PRINT("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG_PRINT("I", tag, fmt, ##__VA_ARGS__)
@@ -0,0 +1,438 @@
+/**
+ * @file mcpwm_deadtime_check.c
+ * @brief Host check: MCPWM backend dead time, edge by edge
+ *
+ * Links the firmware's pwm_mcpwm.c against a model of the ESP32 MCPWM
+ * operator instead of the IDF driver. The model follows the IDF 5.1
+ * mcpwm_generator_set_dead_time() topology: an operator has ONE rising-edge
+ * delay unit (RED, output path 0) and ONE falling-edge delay unit (FED,
+ * path 1). Each call selects the unit's input generator, may invert the
+ * path, and swaps paths when the output generator is not the path's own.
+ * A second call for the same unit silently re-selects its input, as on the
+ * real driver.
+ *
+ * For each PWM frequency and dead time it initialises the backend, then
+ * steps the timers tick by tick and checks at the pins:
+ *
+ *   units      each operator's RED and FED units are set at most once
+ *   edges      every channel at 0, 25%, 50% and full duty: the pin follows
+ *              its own generator, rising edges come dead-time ticks late,
+ *              falling edges are on time
+ *   reverse    a direction change written the way the motor layer does
+ *              (lowering side first, mid-period): RPWM and LPWM are never
+ *              high together, and the rising side waits at least the dead
+ *              time after the other side fell
+ *   brake      a fault brake forces every pin low
+ *
+ * The exit status is the number of failed checks. Build and run from the
+ * repository root (tools/host holds just enough IDF headers):
+ *
+ *   gcc -O2 -std=gnu17 -Itools/host -Ifirmware/components/motor/include \
+ *       tools/mcpwm_deadtime_check.c firmware/components/motor/pwm_mcpwm.c \
+ *       -o mcpwm_deadtime_check && ./mcpwm_deadtime_check
+ */
+
+#include "driver/mcpwm_prelude.h"
+#include "pwm_backend.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_OBJS  8
+#define HIST      256     // tick history per generator, > any dead time checked
+#define RES_BITS  10
+
+// --- Model of the MCPWM objects --------------------------------------------
+
+struct mcpwm_timer_t {
+    uint32_t period;
+};
+
+struct mcpwm_cmpr_t {
+    uint32_t value;
+    uint32_t pending;
+    bool     on_tez;
+};
+
+typedef struct {
+    bool                bypass;   // path passes its own generator through
+    bool                invert;
+    mcpwm_gen_handle_t  sel;      // delay unit input
+    uint32_t            ticks;
+    int                 selects;  // times the unit's input was (re)selected
+} dt_path_t;
+
+struct mcpwm_oper_t {
+    mcpwm_timer_handle_t timer;
+    struct mcpwm_gen_t  *gen[2];
+    dt_path_t            path[2]; // 0 = RED, 1 = FED
+    bool                 swap[2]; // per output generator
+    bool                 braked;
+};
+
+struct mcpwm_gen_t {
+    mcpwm_oper_handle_t      oper;
+    int                      id;  // 0 = A, 1 = B
+    int                      gpio;
+    mcpwm_generator_action_t tez_act;
+    mcpwm_generator_action_t cmp_act;
+    mcpwm_generator_action_t brake_act;
+    mcpwm_cmpr_handle_t      cmpr;
+    int                      force;  // -1 = none
+    int                      level;
+    uint8_t                  raw[HIST];
+};
+
+struct mcpwm_sync_t  { int unused; };
+struct mcpwm_fault_t { int unused; };
+
+static struct mcpwm_timer_t timer_pool[MAX_OBJS];
+static struct mcpwm_oper_t  oper_pool[MAX_OBJS];
+static struct mcpwm_cmpr_t  cmpr_pool[MAX_OBJS];
+static struct mcpwm_gen_t   gen_pool[MAX_OBJS];
+static struct mcpwm_sync_t  sync_obj;
+static int n_timers, n_opers, n_cmprs, n_gens;
+
+static void model_reset(void) {
+    memset(timer_pool, 0, sizeof(timer_pool));
+    memset(oper_pool, 0, sizeof(oper_pool));
+    memset(cmpr_pool, 0, sizeof(cmpr_pool));
+    memset(gen_pool, 0, sizeof(gen_pool));
+    n_timers = n_opers = n_cmprs = n_gens = 0;
+}
+
+esp_err_t mcpwm_new_timer(const mcpwm_timer_config_t *config, mcpwm_timer_handle_t *ret_timer) {
+    if (n_timers == MAX_OBJS) return ESP_ERR_NO_MEM;
+    *ret_timer = &timer_pool[n_timers++];
+    (*ret_timer)->period = config->period_ticks;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_enable(mcpwm_timer_handle_t timer) { (void)timer; return ESP_OK; }
+
+esp_err_t mcpwm_timer_start_stop(mcpwm_timer_handle_t timer, mcpwm_timer_start_stop_cmd_t command) {
+    (void)timer; (void)command;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_timer_sync_src(mcpwm_timer_handle_t timer,
+                                   const mcpwm_timer_sync_src_config_t *config,
+                                   mcpwm_sync_handle_t *ret_sync) {
+    (void)timer; (void)config;
+    *ret_sync = &sync_obj;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_set_phase_on_sync(mcpwm_timer_handle_t timer,
+                                        const mcpwm_timer_sync_phase_config_t *config) {
+    (void)timer; (void)config;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_operator(const mcpwm_operator_config_t *config, mcpwm_oper_handle_t *ret_oper) {
+    (void)config;
+    if (n_opers == MAX_OBJS) return ESP_ERR_NO_MEM;
+    mcpwm_oper_handle_t o = &oper_pool[n_opers++];
+    o->path[0].bypass = o->path[1].bypass = true;
+    *ret_oper = o;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_operator_connect_timer(mcpwm_oper_handle_t oper, mcpwm_timer_handle_t timer) {
+    oper->timer = timer;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_operator_set_brake_on_fault(mcpwm_oper_handle_t oper,
+                                            const mcpwm_brake_config_t *config) {
+    (void)oper; (void)config;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_operator_recover_from_fault(mcpwm_oper_handle_t oper, mcpwm_fault_handle_t fault) {
+    (void)fault;
+    oper->braked = false;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_comparator(mcpwm_oper_handle_t oper, const mcpwm_comparator_config_t *config,
+                               mcpwm_cmpr_handle_t *ret_cmpr) {
+    (void)oper;
+    if (n_cmprs == MAX_OBJS) return ESP_ERR_NO_MEM;
+    *ret_cmpr = &cmpr_pool[n_cmprs++];
+    (*ret_cmpr)->on_tez = config->flags.update_cmp_on_tez;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_comparator_set_compare_value(mcpwm_cmpr_handle_t cmpr, uint32_t cmp_ticks) {
+    cmpr->pending = cmp_ticks;
+    if (!cmpr->on_tez) cmpr->value = cmp_ticks;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_generator(mcpwm_oper_handle_t oper, const mcpwm_generator_config_t *config,
+                              mcpwm_gen_handle_t *ret_gen) {
+    int id = oper->gen[0] ? 1 : 0;
+    if (n_gens == MAX_OBJS || oper->gen[1]) return ESP_ERR_NO_MEM;
+    mcpwm_gen_handle_t g = &gen_pool[n_gens++];
+    g->oper  = oper;
+    g->id    = id;
+    g->gpio  = config->gen_gpio_num;
+    g->force = -1;
+    oper->gen[id] = g;
+    *ret_gen = g;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_generator_set_action_on_timer_event(mcpwm_gen_handle_t gen,
+                                                    mcpwm_gen_timer_event_action_t ev_act) {
+    if (ev_act.event == MCPWM_TIMER_EVENT_EMPTY) gen->tez_act = ev_act.action;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_generator_set_action_on_compare_event(mcpwm_gen_handle_t gen,
+                                                      mcpwm_gen_compare_event_action_t ev_act) {
+    gen->cmpr    = ev_act.comparator;
+    gen->cmp_act = ev_act.action;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_generator_set_action_on_brake_event(mcpwm_gen_handle_t gen,
+                                                    mcpwm_gen_brake_event_action_t ev_act) {
+    gen->brake_act = ev_act.action;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_generator_set_force_level(mcpwm_gen_handle_t gen, int level, bool hold_on) {
+    (void)hold_on;
+    gen->force = level;
+    return ESP_OK;
+}
+
+// Same path selection as the IDF driver: see the file comment
+esp_err_t mcpwm_generator_set_dead_time(mcpwm_gen_handle_t in_generator,
+                                        mcpwm_gen_handle_t out_generator,
+                                        const mcpwm_dead_time_config_t *config) {
+    mcpwm_oper_handle_t o = in_generator->oper;
+    if (out_generator->oper != o) return ESP_ERR_INVALID_ARG;
+    if (config->posedge_delay_ticks && config->negedge_delay_ticks) {
+        return ESP_ERR_INVALID_ARG;  // both-edge mode: not used by the backend
+    }
+    bool bypass = !config->posedge_delay_ticks && !config->negedge_delay_ticks;
+    int path = bypass ? in_generator->id : (config->negedge_delay_ticks ? 1 : 0);
+    dt_path_t *p = &o->path[path];
+    p->bypass = bypass;
+    if (!bypass) {
+        p->sel   = in_generator;
+        p->ticks = config->posedge_delay_ticks ? config->posedge_delay_ticks
+                                               : config->negedge_delay_ticks;
+        p->selects++;
+    }
+    p->invert = config->flags.invert_output;
+    o->swap[out_generator->id] = (path != out_generator->id);
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_gpio_fault(const mcpwm_gpio_fault_config_t *config,
+                               mcpwm_fault_handle_t *ret_fault) {
+    (void)config; (void)ret_fault;
+    return ESP_ERR_INVALID_STATE;  // the checks run without fault inputs
+}
+
+esp_err_t mcpwm_fault_register_event_callbacks(mcpwm_fault_handle_t fault,
+                                               const mcpwm_fault_event_callbacks_t *cbs,
+                                               void *user_data) {
+    (void)fault; (void)cbs; (void)user_data;
+    return ESP_OK;
+}
+
+// --- Simulation -------------------------------------------------------------
+
+static void apply(mcpwm_gen_handle_t g, mcpwm_generator_action_t act) {
+    if (act == MCPWM_GEN_ACTION_HIGH) g->level = 1;
+    else if (act == MCPWM_GEN_ACTION_LOW) g->level = 0;
+    else if (act == MCPWM_GEN_ACTION_TOGGLE) g->level ^= 1;
+}
+
+static int raw_at(mcpwm_gen_handle_t g, long t) {
+    return (t < 0) ? 0 : g->raw[t % HIST];
+}
+
+/**
+ * @brief Output of a dead-time path at tick t
+ */
+static int path_out(mcpwm_oper_handle_t o, int path, long t) {
+    const dt_path_t *p = &o->path[path];
+    int v;
+    if (p->bypass) {
+        v = raw_at(o->gen[path], t);
+    } else if (path == 0) {
+        // RED: high once the input has been high for the whole delay
+        v = 1;
+        for (uint32_t k = 0; k <= p->ticks; k++) v &= raw_at(p->sel, t - (long)k);
+    } else {
+        // FED: stays high for the delay after the input falls
+        v = 0;
+        for (uint32_t k = 0; k <= p->ticks; k++) v |= raw_at(p->sel, t - (long)k);
+    }
+    return p->invert ? !v : v;
+}
+
+static int pin_at(mcpwm_gen_handle_t g, long t) {
+    mcpwm_oper_handle_t o = g->oper;
+    if (o->braked) {
+        return g->brake_act == MCPWM_GEN_ACTION_HIGH;
+    }
+    int path = o->swap[g->id] ? !g->id : g->id;
+    return path_out(o, path, t);
+}
+
+/**
+ * @brief Advance one operator by one timer tick (t counts from 0)
+ */
+static void tick(mcpwm_oper_handle_t o, long t) {
+    uint32_t count = (uint32_t)(t % o->timer->period);
+    for (int i = 0; i < 2; i++) {
+        mcpwm_gen_handle_t g = o->gen[i];
+        if (count == 0) {
+            if (g->cmpr->on_tez) g->cmpr->value = g->cmpr->pending;
+            apply(g, g->tez_act);
+        }
+        // Compare events win over TEZ in the same tick
+        if (count == g->cmpr->value) apply(g, g->cmp_act);
+        g->raw[t % HIST] = (uint8_t)(g->force >= 0 ? g->force : g->level);
+    }
+}
+
+// --- Checks -----------------------------------------------------------------
+
+static int failures = 0;
+
+static void check(const char *what, const char *detail, int ok) {
+    printf("  %s  %s: %s\n", ok ? "PASS" : "FAIL", what, detail);
+    if (!ok) failures++;
+}
+
+/**
+ * @brief Intended (dead-time free) level of a channel at a timer count
+ */
+static int ideal(uint32_t duty, uint32_t max_duty, uint32_t period, uint32_t count) {
+    if (duty == 0) return 0;
+    uint32_t cmp = (uint32_t)((uint64_t)duty * period / max_duty);
+    return count < cmp;
+}
+
+static void run_config(uint32_t freq_hz, uint32_t dead_ns) {
+    model_reset();
+    pwm_backend_config_t cfg = {
+        .gpio = {25, 26, 32, 33},
+        .freq_hz = freq_hz,
+        .resolution = RES_BITS,
+        .dead_time_ns = dead_ns,
+        .fault_gpio = {-1, -1},
+    };
+    printf("\n%lu Hz, dead time %lu ns\n", (unsigned long)freq_hz, (unsigned long)dead_ns);
+    esp_err_t ret = pwm_backend_mcpwm.init(&cfg);
+    check("init", "backend initialises", ret == ESP_OK);
+    if (ret != ESP_OK) return;
+
+    uint32_t max_duty = pwm_backend_max_duty(RES_BITS);
+    int once = 1;
+    for (int b = 0; b < n_opers; b++) {
+        once &= oper_pool[b].path[0].selects <= 1 && oper_pool[b].path[1].selects <= 1;
+    }
+    check("units", "each operator's RED and FED set at most once", once);
+
+    for (int b = 0; b < n_opers; b++) {
+        mcpwm_oper_handle_t o = &oper_pool[b];
+        uint32_t period = o->timer->period;
+        uint32_t dead = o->path[0].bypass ? 0 : o->path[0].ticks;
+        if (!o->path[1].bypass && o->path[1].ticks > dead) dead = o->path[1].ticks;
+        if (dead + 2 >= HIST) {
+            check("edges", "dead time fits the model history", 0);
+            return;
+        }
+
+        // edges: each side alone at a few duties, after two periods to settle
+        int edges_ok = 1;
+        const uint32_t duties[] = {0, max_duty / 4, max_duty / 2, max_duty};
+        for (int side = 0; side < 2; side++) {
+            for (size_t d = 0; d < sizeof(duties) / sizeof(duties[0]); d++) {
+                uint8_t on = (uint8_t)(b * 2 + side), off = (uint8_t)(b * 2 + !side);
+                pwm_backend_mcpwm.write_duty(off, 0);
+                pwm_backend_mcpwm.write_duty(on, duties[d]);
+                for (long t = 0; t < 4L * period; t++) {
+                    tick(o, t);
+                    if (t < 2L * period) continue;
+                    for (int i = 0; i < 2; i++) {
+                        uint32_t duty = (i == side) ? duties[d] : 0;
+                        int want = 1;
+                        for (uint32_t k = 0; k <= dead; k++) {
+                            want &= ideal(duty, max_duty, period, (uint32_t)((t - k) % period));
+                        }
+                        if (pin_at(o->gen[i], t) != want) edges_ok = 0;
+                    }
+                }
+            }
+        }
+        char what[64];
+        snprintf(what, sizeof(what), "bridge %d, both sides at 0/25/50/100%%", b);
+        check("edges", what, edges_ok);
+
+        // reverse: forward at 60%, then lowering side first, mid-period
+        for (int dir = 0; dir < 2; dir++) {
+            uint8_t from = (uint8_t)(b * 2 + dir), to = (uint8_t)(b * 2 + !dir);
+            uint32_t duty = max_duty * 6 / 10;
+            pwm_backend_mcpwm.write_duty(to, 0);
+            pwm_backend_mcpwm.write_duty(from, duty);
+            int overlap = 0;
+            long fell = -1, gap = -1;
+            int prev_from = 0, prev_to = 0;
+            for (long t = 0; t < 6L * period; t++) {
+                if (t == 3L * period + period / 3) {
+                    pwm_backend_mcpwm.write_duty(from, 0);
+                    pwm_backend_mcpwm.write_duty(to, duty);
+                }
+                tick(o, t);
+                int pf = pin_at(o->gen[dir], t);
+                int pt = pin_at(o->gen[!dir], t);
+                if (t >= 2L * period) {
+                    if (pf && pt) overlap = 1;
+                    if (prev_from && !pf) fell = t;
+                    if (!prev_to && pt && fell >= 0 && gap < 0) gap = t - fell;
+                }
+                prev_from = pf;
+                prev_to = pt;
+            }
+            snprintf(what, sizeof(what), "bridge %d %s, RPWM and LPWM never both high",
+                     b, dir ? "LPWM -> RPWM" : "RPWM -> LPWM");
+            check("reverse", what, !overlap);
+            snprintf(what, sizeof(what), "bridge %d %s, rising side waits >= %lu ticks",
+                     b, dir ? "LPWM -> RPWM" : "RPWM -> LPWM", (unsigned long)dead);
+            check("reverse", what, gap >= (long)dead);
+        }
+
+        // brake: both sides driving, then the fault handler takes over
+        pwm_backend_mcpwm.write_duty((uint8_t)(b * 2), max_duty);
+        pwm_backend_mcpwm.write_duty((uint8_t)(b * 2 + 1), max_duty);
+        for (long t = 0; t < 2L * period; t++) tick(o, t);
+        o->braked = true;
+        int low = !pin_at(o->gen[0], 2L * period - 1) && !pin_at(o->gen[1], 2L * period - 1);
+        o->braked = false;
+        pwm_backend_mcpwm.write_duty((uint8_t)(b * 2), 0);
+        pwm_backend_mcpwm.write_duty((uint8_t)(b * 2 + 1), 0);
+        snprintf(what, sizeof(what), "bridge %d, all pins low", b);
+        check("brake", what, low);
+    }
+}
+
+int main(void) {
+    const uint32_t freqs[] = {20000, 25000};
+    const uint32_t deads[] = {0, 500, 1000, 2000};
+    for (size_t f = 0; f < sizeof(freqs) / sizeof(freqs[0]); f++) {
+        for (size_t d = 0; d < sizeof(deads) / sizeof(deads[0]); d++) {
+            run_config(freqs[f], deads[d]);
+        }
+    }
+    printf("\n%s (%d failed)\n", failures ? "FAIL" : "PASS", failures);
+    return failures;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file mixer_bench.c
+ * @brief Host benchmark: scalar vs batch differential drive mixer
+ *
+ * Mixes the same pseudo-random samples through mixer_diffdrive_mix_float()
+ * one call at a time and through mixer_diffdrive_mix_batch() in blocks,
+ * for every desaturation mode and turn model, and reports throughput and the
+ * largest difference between the two.
+ *
+ * Build and run from the repository root (needs only esp_err.h from IDF):
+ *
+ *   gcc -O3 -fno-trapping-math -march=native -std=gnu17 \
+ *       -I$IDF_PATH/components/esp_common/include \
+ *       -Ifirmware/components/motion/include \
+ *       tools/mixer_bench.c firmware/components/motion/mixer_float.c \
+ *       -lm -o mixer_bench && ./mixer_bench [samples] [block]
+ *
+ * Add -fopt-info-vec to see which loops were vectorised.
+ */
+
+#include "mixer_diffdrive.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_SAMPLES (1u << 20)
+#define DEFAULT_BLOCK   4096u
+#define ROUNDS          20
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float rand_unit(void) {
+    return 2.0f * (float)rand() / (float)RAND_MAX - 1.0f;
+}
+
+int main(int argc, char **argv) {
+    size_t n     = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_SAMPLES;
+    size_t block = (argc > 2) ? strtoul(argv[2], NULL, 0) : DEFAULT_BLOCK;
+    if (n == 0 || block == 0) {
+        fprintf(stderr, "usage: %s [samples] [block]\n", argv[0]);
+        return 1;
+    }
+
+    float   *t  = malloc(n * sizeof(float));
+    float   *s  = malloc(n * sizeof(float));
+    uint8_t *sm = malloc(n * sizeof(uint8_t));
+    float   *ls = malloc(n * sizeof(float));
+    float   *rs = malloc(n * sizeof(float));
+    float   *lb = malloc(n * sizeof(float));
+    float   *rb = malloc(n * sizeof(float));
+    if (!t || !s || !sm || !ls || !rs || !lb || !rb) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    srand(1);
+    for (size_t i = 0; i < n; i++) {
+        t[i]  = rand_unit();
+        s[i]  = rand_unit();
+        sm[i] = (rand() & 7) == 0;
+    }
+
+    printf("%zu samples, batch block %zu, best of %d rounds\n", n, block, ROUNDS);
+    printf("%-16s%-11s%14s%14s%9s%12s\n",
+           "desat", "turn", "scalar Ms/s", "batch Ms/s", "speedup", "max diff");
+
+    for (int turn = 0; turn < MIXER_TURN_COUNT; turn++) {
+        for (int desat = 0; desat < MIXER_DESAT_COUNT; desat++) {
+            mixer_config_t cfg = {
+                .deadzone         = 0.05f,
+                .expo             = 0.30f,
+                .max_speed        = 0.80f,
+                .slow_mode_factor = 0.50f,
+                .desat            = (mixer_desat_t)desat,
+                .turn             = (mixer_turn_t)turn,
+                .pivot_throttle   = 0.15f,
+            };
+
+            double best_scalar = 1e9;
+            double best_batch  = 1e9;
+            for (int round = 0; round < ROUNDS; round++) {
+                double a = now_s();
+                for (size_t i = 0; i < n; i++) {
+                    mixer_diffdrive_mix_float(&cfg, t[i], s[i], sm[i], &ls[i], &rs[i]);
+                }
+                double b = now_s();
+                for (size_t off = 0; off < n; off += block) {
+                    size_t len = (n - off < block) ? n - off : block;
+                    mixer_diffdrive_mix_batch(&cfg, t + off, s + off, sm + off, len,
+                                              lb + off, rb + off);
+                }
+                double c = now_s();
+                if (b - a < best_scalar) best_scalar = b - a;
+                if (c - b < best_batch)  best_batch  = c - b;
+            }
+
+            float max_diff = 0.0f;
+            for (size_t i = 0; i < n; i++) {
+                float d = fmaxf(fabsf(ls[i] - lb[i]), fabsf(rs[i] - rb[i]));
+                if (d > max_diff) max_diff = d;
+            }
+
+            printf("%-16s%-11s%14.1f%14.1f%8.1fx%12.2e\n",
+                   mixer_diffdrive_desat_name(cfg.desat), mixer_diffdrive_turn_name(cfg.turn),
+                   n / best_scalar * 1e-6, n / best_batch * 1e-6,
+                   best_scalar / best_batch, max_diff);
+        }
+    }
+
+    free(t); free(s); free(sm); free(ls); free(rs); free(lb); free(rb);
+    return 0;
+}
@@ -0,0 +1,287 @@
+/**
+ * @file mixer_q15_check.c
+ * @brief Host check and benchmark: Q15 lookup-table mixer against the float path
+ *
+ * Runs the firmware's mixer_q15.c and mixer_float.c side by side for every
+ * desaturation mode, turn model and slow-mode setting, on several curve
+ * shapes (including the Kconfig defaults, an identity curve and the extreme
+ * deadzone / expo / pivot corners), and checks:
+ *
+ *   axis     every Q15 code on one stick with the other centred: inside the
+ *            deadzone the output is exactly zero, and the error stays within
+ *            the bound below
+ *   grid     throttle x steering on a grid of every g-th Q15 code (default
+ *            32, so every table interval is hit several times) with both
+ *            sticks at +/-full scale included: max error within the bound,
+ *            outputs in range
+ *   duty     the same grid through mixer_q15_to_duty() at 10- and 13-bit
+ *            LEDC resolution, against the float speed times max_duty
+ *
+ * The bound is derived from the configuration rather than measured: linear
+ * interpolation error of the response curve (h^2/8 * max|f''| over each
+ * interval, plus slope * h/4 at the deadzone corner), a few LSB of rounding,
+ * then amplified by the turn model (pivot ramp slope) and desaturation
+ * (normalize can double it) and scaled by max_speed. It then reports the
+ * cost of one mix on both paths.
+ *
+ * The exit status is the number of failed checks. Build and run from the
+ * repository root (add -DCONFIG_ROBOT_MIXER_Q15_LUT_BITS=10 for the
+ * 1024-entry table):
+ *
+ *   gcc -O2 -std=gnu17 -Itools/host -Ifirmware/components/motion/include \
+ *       tools/mixer_q15_check.c firmware/components/motion/mixer_q15.c \
+ *       firmware/components/motion/mixer_float.c -lm \
+ *       -o mixer_q15_check && ./mixer_q15_check [-g grid_step]
+ */
+
+#include "mixer_diffdrive.h"
+#include "mixer_q15.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define Q15_MAX   (MIXER_Q15_ONE - 1)
+#define LSB       (1.0 / MIXER_Q15_ONE)
+#define BENCH_N   (1u << 20)
+
+static int failures = 0;
+
+static void check(const char *phase, const char *what, int ok) {
+    printf("  %s  %s: %s\n", ok ? "PASS" : "FAIL", phase, what);
+    if (!ok) failures++;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    const char *name;
+    float deadzone, expo, max_speed, slow_mode_factor, pivot_throttle;
+} shape_t;
+
+static const shape_t shapes[] = {
+    {"defaults",  0.05f, 0.30f, 1.00f, 0.50f, 0.15f},
+    {"identity",  0.00f, 0.00f, 1.00f, 1.00f, 0.00f},
+    {"bench",     0.05f, 0.30f, 0.80f, 0.50f, 0.15f},
+    {"extreme",   MIXER_DEADZONE_MAX, 1.00f, 1.00f, 0.25f, 0.05f},
+    {"wide band", 0.20f, 0.60f, 0.90f, 0.40f, MIXER_PIVOT_THROTTLE_MAX},
+};
+
+/**
+ * @brief Worst-case |q15 - float| for one output, in full-scale units
+ */
+static double error_bound(const mixer_config_t *cfg, bool slow_mode) {
+    double h  = 1.0 / MIXER_Q15_LUT_SIZE;
+    double dz = cfg->deadzone, e = cfg->expo;
+    // Response curve: f(u) = e u^3 + (1 - e) u with u = (x - dz) / (1 - dz)
+    double curve = h * h / 8.0 * 6.0 * e / ((1.0 - dz) * (1.0 - dz));
+    if (dz > 0.0) {
+        curve += (1.0 - e) / (1.0 - dz) * h / 4.0;  // corner inside an interval
+    }
+    curve += 2.0 * LSB;  // table rounding, interpolation floor
+
+    double t = curve, s = curve;
+    if (cfg->turn == MIXER_TURN_CURVATURE) {
+        // s * g(|t|): g <= 1, slope 1 above the pivot band, (1 - p) / p inside it
+        double p = cfg->pivot_throttle;
+        double slope = (p > 0.0) ? fmax(1.0, (1.0 - p) / p) : 1.0;
+        s = curve + slope * curve + 3.0 * LSB;
+    }
+    double mix = 2.0 * (t + s) + 2.0 * LSB;  // normalize is 2-Lipschitz, plus the division
+    double scale = cfg->max_speed * (slow_mode ? cfg->slow_mode_factor : 1.0f);
+    return scale * mix + 2.0 * LSB;
+}
+
+typedef struct {
+    double max_err;
+    double sum_sq;
+    long   n;
+    long   over;        // samples beyond the bound
+    long   range;       // outputs outside [-Q15_MAX, Q15_MAX]
+    long   dz_nonzero;  // deadzone inputs that did not give exactly zero
+    long   duty_over;
+} stats_t;
+
+static void compare(const mixer_config_t *cfg, const mixer_q15_table_t *table, int32_t tq,
+                    int32_t sq, bool slow_mode, double bound, stats_t *st) {
+    float lf, rf;
+    int32_t lq, rq;
+    mixer_diffdrive_mix_float(cfg, (float)tq / MIXER_Q15_ONE, (float)sq / MIXER_Q15_ONE,
+                              slow_mode, &lf, &rf);
+    mixer_q15_mix(table, tq, sq, slow_mode, &lq, &rq);
+
+    double el = fabs(mixer_q15_to_float(lq) - (double)lf);
+    double er = fabs(mixer_q15_to_float(rq) - (double)rf);
+    double err = fmax(el, er);
+    if (err > st->max_err) st->max_err = err;
+    st->sum_sq += el * el + er * er;
+    st->n += 2;
+    if (err > bound) st->over++;
+    if (abs(lq) > Q15_MAX || abs(rq) > Q15_MAX) st->range++;
+
+    // LEDC duty at 10 and 13 bits, against float speed * max_duty
+    static const uint32_t max_duty[] = {1023, 8191};
+    for (size_t i = 0; i < sizeof(max_duty) / sizeof(max_duty[0]); i++) {
+        double md = max_duty[i];
+        double dl = fabs(mixer_q15_to_duty(lq, max_duty[i]) - (double)lf * md);
+        double dr = fabs(mixer_q15_to_duty(rq, max_duty[i]) - (double)rf * md);
+        if (fmax(dl, dr) > bound * md + 1.0) st->duty_over++;
+    }
+}
+
+static void run_config(const shape_t *shape, mixer_desat_t desat, mixer_turn_t turn,
+                       int step, double *worst_ratio) {
+    mixer_config_t cfg = {
+        .deadzone         = shape->deadzone,
+        .expo             = shape->expo,
+        .max_speed        = shape->max_speed,
+        .slow_mode_factor = shape->slow_mode_factor,
+        .desat            = desat,
+        .turn             = turn,
+        .pivot_throttle   = shape->pivot_throttle,
+    };
+    mixer_q15_table_t table;
+    if (mixer_q15_build(&table, &cfg) != ESP_OK) {
+        check("build", "mixer_q15_build", 0);
+        return;
+    }
+
+    for (int slow = 0; slow <= 1; slow++) {
+        double bound = error_bound(&cfg, slow);
+        stats_t axis = {0}, grid = {0};
+
+        // Every code on each axis, the other one centred
+        int32_t dz_q = (int32_t)ceilf(shape->deadzone * (float)MIXER_Q15_ONE);
+        for (int32_t x = -Q15_MAX; x <= Q15_MAX; x++) {
+            compare(&cfg, &table, x, 0, slow, bound, &axis);
+            compare(&cfg, &table, 0, x, slow, bound, &axis);
+            if (abs(x) < dz_q) {
+                int32_t l, r;
+                mixer_q15_mix(&table, x, 0, slow, &l, &r);
+                if (l || r) axis.dz_nonzero++;
+                mixer_q15_mix(&table, 0, x, slow, &l, &r);
+                if (l || r) axis.dz_nonzero++;
+            }
+        }
+
+        // Full grid, with both ends included
+        for (int32_t t = -Q15_MAX; ; t = (t + step > Q15_MAX && t < Q15_MAX) ? Q15_MAX : t + step) {
+            for (int32_t s = -Q15_MAX; ; s = (s + step > Q15_MAX && s < Q15_MAX) ? Q15_MAX : s + step) {
+                compare(&cfg, &table, t, s, slow, bound, &grid);
+                if (s == Q15_MAX) break;
+            }
+            if (t == Q15_MAX) break;
+        }
+
+        double max_err = fmax(axis.max_err, grid.max_err);
+        if (bound > 0.0 && max_err / bound > *worst_ratio) *worst_ratio = max_err / bound;
+        printf("  %-9s %-14s %-9s %-4s  max %.4f%%  rms %.4f%%  bound %.4f%%\n", shape->name,
+               mixer_diffdrive_desat_name(desat), mixer_diffdrive_turn_name(turn),
+               slow ? "slow" : "", 100.0 * max_err, 100.0 * sqrt(grid.sum_sq / grid.n),
+               100.0 * bound);
+
+        int ok_axis = axis.over == 0 && axis.range == 0 && axis.dz_nonzero == 0;
+        int ok_grid = grid.over == 0 && grid.range == 0;
+        int ok_duty = axis.duty_over == 0 && grid.duty_over == 0;
+        if (!ok_axis || !ok_grid || !ok_duty) {
+            printf("    over %ld/%ld, range %ld/%ld, deadzone %ld, duty %ld/%ld\n",
+                   axis.over, grid.over, axis.range, grid.range, axis.dz_nonzero,
+                   axis.duty_over, grid.duty_over);
+            char what[128];
+            snprintf(what, sizeof(what), "%s %s %s%s", shape->name,
+                     mixer_diffdrive_desat_name(desat), mixer_diffdrive_turn_name(turn),
+                     slow ? " slow" : "");
+            if (!ok_axis) check("axis", what, 0);
+            if (!ok_grid) check("grid", what, 0);
+            if (!ok_duty) check("duty", what, 0);
+        }
+    }
+}
+
+static void bench(void) {
+    mixer_config_t cfg = {
+        .deadzone = 0.05f, .expo = 0.30f, .max_speed = 0.80f, .slow_mode_factor = 0.50f,
+        .desat = MIXER_DESAT_NORMALIZE, .turn = MIXER_TURN_CURVATURE, .pivot_throttle = 0.15f,
+    };
+    mixer_q15_table_t table;
+    mixer_q15_build(&table, &cfg);
+
+    int32_t *tq = malloc(BENCH_N * sizeof(int32_t));
+    int32_t *sq = malloc(BENCH_N * sizeof(int32_t));
+    float   *tf = malloc(BENCH_N * sizeof(float));
+    float   *sf = malloc(BENCH_N * sizeof(float));
+    if (!tq || !sq || !tf || !sf) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    srand(1);
+    for (size_t i = 0; i < BENCH_N; i++) {
+        tq[i] = rand() % (2 * Q15_MAX + 1) - Q15_MAX;
+        sq[i] = rand() % (2 * Q15_MAX + 1) - Q15_MAX;
+        tf[i] = (float)tq[i] / MIXER_Q15_ONE;
+        sf[i] = (float)sq[i] / MIXER_Q15_ONE;
+    }
+
+    volatile float fsink = 0.0f;
+    volatile int32_t qsink = 0;
+    double best_f = 1e9, best_q = 1e9;
+    for (int round = 0; round < 10; round++) {
+        double a = now_s();
+        for (size_t i = 0; i < BENCH_N; i++) {
+            float l, r;
+            mixer_diffdrive_mix_float(&cfg, tf[i], sf[i], i & 1, &l, &r);
+            fsink += l - r;
+        }
+        double b = now_s();
+        for (size_t i = 0; i < BENCH_N; i++) {
+            int32_t l, r;
+            mixer_q15_mix(&table, tq[i], sq[i], i & 1, &l, &r);
+            qsink += l - r;
+        }
+        double c = now_s();
+        if (b - a < best_f) best_f = b - a;
+        if (c - b < best_q) best_q = c - b;
+    }
+    printf("\nbench: normalize + curvature, %u random mixes, best of 10\n", BENCH_N);
+    printf("  float %.1f ns/mix, q15 %.1f ns/mix (host FPU; the ESP32 gap is wider)\n",
+           best_f / BENCH_N * 1e9, best_q / BENCH_N * 1e9);
+    free(tq); free(sq); free(tf); free(sf);
+}
+
+int main(int argc, char **argv) {
+    int step = 32;
+    int opt;
+    while ((opt = getopt(argc, argv, "g:")) != -1) {
+        switch (opt) {
+            case 'g': step = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-g grid_step]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (step < 1) step = 1;
+
+    printf("Q15 table %d entries, grid every %d codes (%d x %d)\n", MIXER_Q15_LUT_SIZE, step,
+           (2 * Q15_MAX + step - 1) / step + 1, (2 * Q15_MAX + step - 1) / step + 1);
+    double worst_ratio = 0.0;
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        for (int turn = 0; turn < MIXER_TURN_COUNT; turn++) {
+            for (int desat = 0; desat < MIXER_DESAT_COUNT; desat++) {
+                run_config(&shapes[i], (mixer_desat_t)desat, (mixer_turn_t)turn, step,
+                           &worst_ratio);
+            }
+        }
+    }
+    printf("  worst error / bound: %.2f\n", worst_ratio);
+    check("grid", "every configuration within its error bound", failures == 0);
+
+    bench();
+
+    printf("\n%s (%d failed)\n", failures ? "FAIL" : "PASS", failures);
+    return failures;
+}
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""Sweep the differential drive mixer over the full stick grid.
+
+Mirrors the float path of firmware/components/motion/mixer_diffdrive.c
+(deadzone -> expo -> turn model -> desaturation) and reports, for every
+desaturation mode and turn model:
+
+  sat        share of the grid where a track is asked for more than full speed
+  peak       mean peak track speed max(|left|, |right|) over the whole grid
+
+and, over the saturated points only (elsewhere every mode is identical):
+
+  curv err   mean / max angle (degrees) between the commanded track-speed
+             vector (throttle + steering, throttle - steering, before
+             desaturation) and the output; 0 means the turn ratio is kept
+  yaw        mean output (left - right) / commanded (left - right): how much
+             steering authority survives
+  fwd        mean output (left + right) / commanded (left + right): how much
+             forward speed survives
+
+max_speed and slow mode are plain scale factors applied afterwards and do
+not change any of these ratios, so they are left out.
+
+Usage: tools/mixer_sweep.py [--deadzone 5] [--expo 30] [--pivot 15] [--steps 101]
+"""
+
+import argparse
+import math
+
+
+def clamp(v, lo=-1.0, hi=1.0):
+    return max(lo, min(hi, v))
+
+
+def deadzone(v, dz):
+    if abs(v) < dz:
+        return 0.0
+    return math.copysign((abs(v) - dz) / (1.0 - dz), v)
+
+
+def expo(v, e):
+    return e * v * v * v + (1.0 - e) * v
+
+
+def curvature_gain(abs_t, pivot):
+    if pivot <= 0.0 or abs_t >= pivot:
+        return abs_t
+    return pivot + (1.0 - pivot) * (pivot - abs_t) / pivot
+
+
+def desaturate(t, s, mode):
+    if mode == "normalize":
+        l, r = t + s, t - s
+        peak = max(abs(l), abs(r))
+        if peak > 1.0:
+            l, r = l / peak, r / peak
+        return l, r
+    if mode == "steer_priority":
+        s = clamp(s)
+        headroom = 1.0 - abs(s)
+        if abs(t) > headroom:
+            t = math.copysign(headroom, t)
+        return t + s, t - s
+    return clamp(t + s), clamp(t - s)
+
+
+def sweep(desat, turn, dz, ex, pivot, steps):
+    curv = []
+    yaw = []
+    fwd = []
+    peak = []
+    sat = 0
+    for i in range(steps):
+        for j in range(steps):
+            t = expo(deadzone(-1.0 + 2.0 * i / (steps - 1), dz), ex)
+            s = expo(deadzone(-1.0 + 2.0 * j / (steps - 1), dz), ex)
+            if turn == "curvature":
+                s *= curvature_gain(abs(t), pivot)
+            l0, r0 = t + s, t - s
+            l, r = desaturate(t, s, desat)
+            peak.append(max(abs(l), abs(r)))
+            if max(abs(l0), abs(r0)) <= 1.0:
+                continue
+            sat += 1
+            d = math.degrees(math.atan2(r, l) - math.atan2(r0, l0))
+            curv.append(abs((d + 180.0) % 360.0 - 180.0))
+            if abs(l0 - r0) > 1e-6:
+                yaw.append((l - r) / (l0 - r0))
+            if abs(l0 + r0) > 1e-6:
+                fwd.append((l + r) / (l0 + r0))
+
+    def mean(xs):
+        return sum(xs) / len(xs) if xs else 0.0
+
+    return (sat / (steps * steps), mean(peak), mean(curv), max(curv, default=0.0),
+            mean(yaw), mean(fwd))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("--deadzone", type=int, default=5, help="percent")
+    ap.add_argument("--expo", type=int, default=30, help="percent")
+    ap.add_argument("--pivot", type=int, default=15, help="percent throttle")
+    ap.add_argument("--steps", type=int, default=101, help="grid points per axis")
+    args = ap.parse_args()
+
+    print(f"deadzone={args.deadzone}% expo={args.expo}% pivot={args.pivot}% "
+          f"grid={args.steps}x{args.steps}")
+    print(f"{'desat':<16}{'turn':<11}{'sat':>6}{'peak':>7}{'curv err mean/max':>20}"
+          f"{'yaw':>7}{'fwd':>7}")
+    for turn in ("arcade", "curvature"):
+        for desat in ("clamp", "normalize", "steer_priority"):
+            sat, p, c_mean, c_max, y, f = sweep(desat, turn, args.deadzone / 100.0,
+                                                args.expo / 100.0, args.pivot / 100.0,
+                                                args.steps)
+            print(f"{desat:<16}{turn:<11}{sat:>6.0%}{p:>7.3f}{c_mean:>11.2f} / {c_max:<6.1f}"
+                  f"{y:>7.3f}{f:>7.3f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,388 @@
+/**
+ * @file ring_stress.c
+ * @brief Host stress test: source rings (spsc_ring.h) and status seqlock (seqlock.h)
+ *
+ * Runs the firmware's lock-free headers from real threads the way
+ * control_manager.c uses them, and checks:
+ *
+ *   ring       one producer thread per source submits numbered frames into
+ *              its own 32-slot ring (full ring: refuse and count, like
+ *              control_manager_submit()); one consumer drains every ring in
+ *              turn like control_task, sometimes stalling long enough for
+ *              the rings to fill. Every frame is either delivered once, in
+ *              order and intact, or counted as refused. Submit latency is
+ *              measured per call and must stay flat whether the ring is
+ *              being drained or full.
+ *   seqlock    one writer keeps publishing a status-sized struct while
+ *              reader threads copy it with the retry-then-yield loop of
+ *              control_manager_get_status(). No copy that passes
+ *              seqlock_read_valid() is torn, each reader sees generations
+ *              only move forward, and the writer never waits.
+ *
+ * Latency figures come from a desktop scheduler and only the percentiles
+ * are checked; the maximum includes preemption and is printed for
+ * information. The exit status is the number of failed checks. Build and
+ * run from the repository root:
+ *
+ *   gcc -O2 -std=gnu17 -pthread -Ifirmware/components/control/include \
+ *       tools/ring_stress.c -o ring_stress && ./ring_stress [-n frames] [-r readers] [-t seconds]
+ */
+
+#include "seqlock.h"
+#include "spsc_ring.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SOURCES        3
+#define RING_SIZE      32        // SOURCE_RING_SIZE in control_manager.c
+#define PAYLOAD_WORDS  12        // about a control_frame_t
+#define STATUS_WORDS   48        // about a control_status_t
+#define MAX_READERS    16
+#define READ_ATTEMPTS  4         // SEQLOCK_READ_ATTEMPTS in control_manager.c
+#define HIST_BUCKETS   256       // latency histogram, 50 ns buckets, last = overflow
+#define HIST_NS        50
+
+// Percentile limits: generous for a loaded host, far below a context switch
+#define SUBMIT_P99_NS  5000
+#define WRITE_P99_NS   5000
+
+static int failures = 0;
+
+static void check(const char *phase, const char *what, int ok) {
+    printf("  %s  %s: %s\n", ok ? "PASS" : "FAIL", phase, what);
+    if (!ok) failures++;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t pattern(uint32_t n, int word) {
+    return n * 2654435761u + (uint32_t)word * 40503u;
+}
+
+typedef struct {
+    uint64_t count[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max_ns;
+} hist_t;
+
+static void hist_add(hist_t *h, uint64_t ns) {
+    uint64_t b = ns / HIST_NS;
+    h->count[b < HIST_BUCKETS ? b : HIST_BUCKETS - 1]++;
+    h->total++;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+/**
+ * @brief Upper edge of the bucket holding percentile @p p (UINT64_MAX if past the histogram)
+ */
+static uint64_t hist_pct(const hist_t *h, double p) {
+    uint64_t want = (uint64_t)(p / 100.0 * (double)h->total), seen = 0;
+    for (int b = 0; b < HIST_BUCKETS - 1; b++) {
+        seen += h->count[b];
+        if (seen >= want) return (uint64_t)(b + 1) * HIST_NS;
+    }
+    return UINT64_MAX;
+}
+
+static void pct_print(const char *label, uint64_t ns) {
+    if (ns == UINT64_MAX) {
+        printf("  %s >%5d ns", label, HIST_BUCKETS * HIST_NS);
+    } else {
+        printf("  %s %6llu ns", label, (unsigned long long)ns);
+    }
+}
+
+static void hist_print(const char *name, const hist_t *h) {
+    printf("  %-22s n=%-9llu", name, (unsigned long long)h->total);
+    pct_print("p50", hist_pct(h, 50));
+    pct_print("p99", hist_pct(h, 99));
+    pct_print("p99.9", hist_pct(h, 99.9));
+    printf("  max %llu ns\n", (unsigned long long)h->max_ns);
+}
+
+// ---------------------------------------------------------------------------
+//  Ring phase
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint32_t n;                       // per-source frame number
+    uint32_t payload[PAYLOAD_WORDS];  // pattern(n, i)
+} entry_t;
+
+typedef struct {
+    spsc_ring_t ring;
+    entry_t     entries[RING_SIZE];
+    // Producer side
+    long        frames;
+    uint32_t    refused;
+    hist_t      submit_draining;  // ring had room
+    hist_t      submit_full;      // ring was full: refused
+    // Consumer side
+    uint32_t    delivered;
+    uint32_t    next_n;           // lowest frame number still expected
+    uint32_t    out_of_order;
+    uint32_t    torn;
+} source_t;
+
+static source_t sources[SOURCES];
+static atomic_int producers_done;
+
+static void *producer_main(void *arg) {
+    source_t *s = arg;
+    uint32_t rng = 0x2545F491u ^ (uint32_t)(uintptr_t)arg;
+    for (uint32_t n = 0; n < (uint32_t)s->frames; n++) {
+        uint64_t t0 = now_ns();
+        int32_t i = spsc_ring_write_slot(&s->ring);
+        if (i < 0) {
+            s->refused++;
+            hist_add(&s->submit_full, now_ns() - t0);
+            sched_yield();  // a real source goes back to waiting for input
+        } else {
+            entry_t *e = &s->entries[i];
+            e->n = n;
+            for (int w = 0; w < PAYLOAD_WORDS; w++) e->payload[w] = pattern(n, w);
+            spsc_ring_publish(&s->ring);
+            hist_add(&s->submit_draining, now_ns() - t0);
+        }
+        // Bursty sources: mostly back to back, now and then a pause
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        if ((rng & 0xFF) == 0) sched_yield();
+    }
+    atomic_fetch_add(&producers_done, 1);
+    return NULL;
+}
+
+static void drain(source_t *s) {
+    uint32_t count = 0;
+    int32_t i;
+    while (count < RING_SIZE && (i = spsc_ring_read_slot(&s->ring)) >= 0) {
+        const entry_t *e = &s->entries[i];
+        uint32_t n = e->n;
+        for (int w = 0; w < PAYLOAD_WORDS; w++) {
+            if (e->payload[w] != pattern(n, w)) {
+                s->torn++;
+                break;
+            }
+        }
+        if (n < s->next_n) s->out_of_order++;
+        s->next_n = n + 1;
+        s->delivered++;
+        spsc_ring_release(&s->ring);
+        count++;
+    }
+}
+
+static void *consumer_main(void *arg) {
+    (void)arg;
+    uint32_t cycle = 0;
+    for (;;) {
+        bool done = atomic_load(&producers_done) == SOURCES;
+        for (int s = 0; s < SOURCES; s++) drain(&sources[s]);
+        if (done) break;  // one last pass after every producer finished
+        // Now and then stall like a control task held up by a higher priority
+        if (++cycle % 512 == 0) usleep(200);
+    }
+    return NULL;
+}
+
+static void run_ring(long frames) {
+    printf("\nring: %d sources x %ld frames, %d slots each\n", SOURCES, frames, RING_SIZE);
+    memset(sources, 0, sizeof(sources));
+    atomic_store(&producers_done, 0);
+    for (int s = 0; s < SOURCES; s++) {
+        spsc_ring_init(&sources[s].ring, RING_SIZE);
+        sources[s].frames = frames;
+    }
+
+    pthread_t ct, pt[SOURCES];
+    pthread_create(&ct, NULL, consumer_main, NULL);
+    for (int s = 0; s < SOURCES; s++) pthread_create(&pt[s], NULL, producer_main, &sources[s]);
+    for (int s = 0; s < SOURCES; s++) pthread_join(pt[s], NULL);
+    pthread_join(ct, NULL);
+
+    bool accounted = true, intact = true, ordered = true, empty = true;
+    hist_t draining = {0}, full = {0};
+    for (int s = 0; s < SOURCES; s++) {
+        source_t *src = &sources[s];
+        printf("  source %d: delivered %lu, refused %lu\n", s,
+               (unsigned long)src->delivered, (unsigned long)src->refused);
+        accounted &= (long)src->delivered + src->refused == src->frames;
+        intact    &= src->torn == 0;
+        ordered   &= src->out_of_order == 0;
+        empty     &= spsc_ring_read_slot(&src->ring) < 0;
+        for (int b = 0; b < HIST_BUCKETS; b++) {
+            draining.count[b] += src->submit_draining.count[b];
+            full.count[b]     += src->submit_full.count[b];
+        }
+        draining.total += src->submit_draining.total;
+        full.total     += src->submit_full.total;
+        if (src->submit_draining.max_ns > draining.max_ns) draining.max_ns = src->submit_draining.max_ns;
+        if (src->submit_full.max_ns > full.max_ns) full.max_ns = src->submit_full.max_ns;
+    }
+    hist_print("submit (room)", &draining);
+    if (full.total) hist_print("submit (full, refused)", &full);
+
+    check("ring", "every frame delivered once or counted as refused", accounted);
+    check("ring", "no torn entries", intact);
+    check("ring", "frames delivered in submit order", ordered);
+    check("ring", "rings empty at the end", empty);
+    check("ring", "full rings were hit (refusal path exercised)", full.total > 0);
+    check("ring", "submit p99 with room below 5 us", hist_pct(&draining, 99) <= SUBMIT_P99_NS);
+    check("ring", "submit p99 on a full ring below 5 us",
+          full.total == 0 || hist_pct(&full, 99) <= SUBMIT_P99_NS);
+}
+
+// ---------------------------------------------------------------------------
+//  Seqlock phase
+// ---------------------------------------------------------------------------
+
+static seqlock_t status_lock;
+static struct {
+    uint32_t gen;
+    uint32_t words[STATUS_WORDS];
+} status;
+static atomic_int writer_stop;
+
+typedef struct {
+    hist_t write;
+    uint64_t writes;
+} writer_t;
+
+typedef struct {
+    uint64_t copies;
+    uint64_t retries;
+    uint64_t yields;
+    uint64_t torn;       // passed seqlock_read_valid() but inconsistent
+    uint64_t caught;     // discarded by seqlock_read_valid() and really torn
+    uint64_t backwards;  // generation went down
+    uint32_t last_gen;
+} reader_t;
+
+static void *writer_main(void *arg) {
+    writer_t *w = arg;
+    uint32_t gen = 0;
+    while (!atomic_load_explicit(&writer_stop, memory_order_relaxed)) {
+        gen++;
+        uint64_t t0 = now_ns();
+        seqlock_write_begin(&status_lock);
+        status.gen = gen;
+        for (int i = 0; i < STATUS_WORDS; i++) status.words[i] = pattern(gen, i);
+        seqlock_write_end(&status_lock);
+        hist_add(&w->write, now_ns() - t0);
+        w->writes++;
+    }
+    return NULL;
+}
+
+static void *reader_main(void *arg) {
+    reader_t *r = arg;
+    while (!atomic_load_explicit(&writer_stop, memory_order_relaxed)) {
+        __typeof__(status) copy;
+        for (int attempt = 0; ; attempt++) {
+            unsigned seq = seqlock_read_begin(&status_lock);
+            copy = status;
+            if (seqlock_read_valid(&status_lock, seq)) break;
+            r->retries++;
+            for (int i = 0; i < STATUS_WORDS; i++) {
+                if (copy.words[i] != pattern(copy.gen, i)) {
+                    r->caught++;
+                    break;
+                }
+            }
+            if (attempt >= READ_ATTEMPTS) {
+                r->yields++;
+                sched_yield();
+            }
+        }
+        if (!seqlock_has_data(&status_lock)) continue;
+        for (int i = 0; i < STATUS_WORDS; i++) {
+            if (copy.words[i] != pattern(copy.gen, i)) {
+                r->torn++;
+                break;
+            }
+        }
+        if (copy.gen < r->last_gen) r->backwards++;
+        r->last_gen = copy.gen;
+        r->copies++;
+    }
+    return NULL;
+}
+
+static void run_seqlock(int readers, int seconds) {
+    printf("\nseqlock: 1 writer, %d readers, %d s, %d-word payload\n", readers, seconds,
+           STATUS_WORDS + 1);
+    memset(&status, 0, sizeof(status));
+    atomic_store(&status_lock.seq, 0);
+    atomic_store(&writer_stop, 0);
+
+    writer_t w = {0};
+    reader_t r[MAX_READERS];
+    memset(r, 0, sizeof(r));
+    pthread_t wt, rt[MAX_READERS];
+    pthread_create(&wt, NULL, writer_main, &w);
+    for (int i = 0; i < readers; i++) pthread_create(&rt[i], NULL, reader_main, &r[i]);
+    sleep((unsigned)seconds);
+    atomic_store(&writer_stop, 1);
+    pthread_join(wt, NULL);
+    for (int i = 0; i < readers; i++) pthread_join(rt[i], NULL);
+
+    reader_t sum = {0};
+    for (int i = 0; i < readers; i++) {
+        sum.copies    += r[i].copies;
+        sum.retries   += r[i].retries;
+        sum.yields    += r[i].yields;
+        sum.torn      += r[i].torn;
+        sum.caught    += r[i].caught;
+        sum.backwards += r[i].backwards;
+    }
+    printf("  writes %llu, reads %llu (retried %llu, of which really torn %llu; yielded %llu)\n",
+           (unsigned long long)w.writes, (unsigned long long)sum.copies,
+           (unsigned long long)sum.retries, (unsigned long long)sum.caught,
+           (unsigned long long)sum.yields);
+    hist_print("publish", &w.write);
+
+    check("seqlock", "no torn copy passes seqlock_read_valid()", sum.torn == 0);
+    check("seqlock", "generations never go backwards for a reader", sum.backwards == 0);
+    check("seqlock", "writes overlapped reads (retry path exercised)", sum.retries > 0);
+    check("seqlock", "every reader got copies", sum.copies >= (uint64_t)readers);
+    check("seqlock", "publish p99 below 5 us", hist_pct(&w.write, 99) <= WRITE_P99_NS);
+}
+
+int main(int argc, char **argv) {
+    long frames = 2000000;
+    int readers = 4;
+    int seconds = 2;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:t:")) != -1) {
+        switch (opt) {
+            case 'n': frames = atol(optarg); break;
+            case 'r': readers = atoi(optarg); break;
+            case 't': seconds = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n frames per source] [-r readers] [-t seconds]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (frames < 1 || readers < 1 || readers > MAX_READERS || seconds < 1) {
+        fprintf(stderr, "need frames >= 1, 1..%d readers, seconds >= 1\n", MAX_READERS);
+        return 1;
+    }
+
+    run_ring(frames);
+    run_seqlock(readers, seconds);
+
+    printf("\n%s (%d failed)\n", failures ? "FAIL" : "PASS", failures);
+    return failures;
+}
@@ -0,0 +1,333 @@
+/**
+ * @file safety_torture.c
+ * @brief Host torture test: safety state machine under concurrent transitions
+ *
+ * Hammers the firmware's safety_state.c from several threads at once while
+ * a reader thread keeps copying the journal, then checks:
+ *
+ *   mixed      random arm / disarm / watchdog disarm / e-stop / reset from
+ *              every thread, once with every writer waiting for its slot and
+ *              once with the firmware's policy (below). The transitions each thread won add up to the
+ *              transition counter, so no transition is lost or counted
+ *              twice. Every journal copy the reader takes is internally
+ *              consistent: each entry is a legal edge for its cause, and
+ *              consecutive entries chain (next.from == prev.to), so nothing
+ *              happened between them that the journal missed. Once the
+ *              writers are done, the journal holds exactly the last
+ *              SAFETY_JOURNAL_LEN transitions, less any skipped.
+ *   estop      threads race arm / disarm against one e-stop. Once the
+ *              e-stop has landed, no other transition succeeds, the machine
+ *              stays in ESTOP, and the e-stop is the last journal entry
+ *              unless it gave its slot up.
+ *
+ * Writers that find their slot still being written a lap behind wait for it
+ * (here with sched_yield()); as in the firmware, e-stops and watchdog
+ * disarms give the slot up instead, and the transition is left out. The
+ * summary shows how often each happens. Build with a short journal
+ * (-DSAFETY_JOURNAL_LEN=2) to make that happen a lot.
+ *
+ * The exit status is the number of failed checks. Build and run from the
+ * repository root (add -fsanitize=thread to also check for data races):
+ *
+ *   gcc -O2 -std=gnu17 -pthread -Ifirmware/components/safety/include \
+ *       tools/safety_torture.c firmware/components/safety/safety_state.c \
+ *       -o safety_torture && ./safety_torture [-t threads] [-n ops] [-r rounds]
+ */
+
+#include "safety_state.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_THREADS 32
+
+static safety_sm_t sm;
+static int failures = 0;
+static bool skip_policy;             // e-stops and watchdog disarms never wait
+static atomic_uint estop_skips;
+
+static void check(const char *phase, const char *what, int ok) {
+    printf("  %s  %s: %s\n", ok ? "PASS" : "FAIL", phase, what);
+    if (!ok) failures++;
+}
+
+static bool wait_slot(safety_state_t to, safety_cause_t cause) {
+    if (skip_policy && (to == SAFETY_STATE_ESTOP || cause == SAFETY_CAUSE_WATCHDOG)) {
+        if (to == SAFETY_STATE_ESTOP) atomic_fetch_add(&estop_skips, 1);
+        return false;
+    }
+    sched_yield();
+    return true;
+}
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t xorshift(uint32_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+/**
+ * @brief Is @p t a transition the state machine may make?
+ */
+static int legal_edge(const safety_transition_t *t) {
+    if (t->origin >= SAFETY_ORIGIN_COUNT) return 0;
+    switch (t->cause) {
+        case SAFETY_CAUSE_ARM:
+            return t->from == SAFETY_STATE_DISARMED && t->to == SAFETY_STATE_ARMED;
+        case SAFETY_CAUSE_DISARM:
+        case SAFETY_CAUSE_WATCHDOG:
+            return t->from == SAFETY_STATE_ARMED && t->to == SAFETY_STATE_DISARMED;
+        case SAFETY_CAUSE_ESTOP:
+        case SAFETY_CAUSE_PWM_FAULT:
+        case SAFETY_CAUSE_OVERCURRENT:
+            return t->from != SAFETY_STATE_ESTOP && t->to == SAFETY_STATE_ESTOP;
+        case SAFETY_CAUSE_ESTOP_RESET:
+            return t->from == SAFETY_STATE_ESTOP && t->to == SAFETY_STATE_DISARMED;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Validate one journal copy; returns the number of problems
+ */
+static int validate(const safety_transition_t *j, size_t n) {
+    int bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!legal_edge(&j[i])) bad++;
+        if (i > 0) {
+            if (j[i].seq <= j[i - 1].seq) bad++;
+            if (j[i].seq == j[i - 1].seq + 1 && j[i].from != j[i - 1].to) bad++;
+        }
+    }
+    return bad;
+}
+
+// ---------------------------------------------------------------------------
+//  Reader: copies the journal continuously while the writers run
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    atomic_int stop;
+    long copies;
+    long entries;
+    int  bad;
+} reader_t;
+
+static void *reader_main(void *arg) {
+    reader_t *r = arg;
+    safety_transition_t j[SAFETY_JOURNAL_LEN];
+    while (!atomic_load(&r->stop)) {
+        size_t n = safety_sm_journal(&sm, j, SAFETY_JOURNAL_LEN);
+        r->bad += validate(j, n);
+        r->copies++;
+        r->entries += (long)n;
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+//  Mixed phase
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int      id;
+    long     ops;
+    uint32_t won;   // transitions this thread made
+} mixed_t;
+
+static void *mixed_main(void *arg) {
+    mixed_t *m = arg;
+    uint32_t rng = 0x9E3779B9u * (uint32_t)(m->id + 1);
+    for (long i = 0; i < m->ops; i++) {
+        uint32_t r = xorshift(&rng);
+        safety_origin_t origin = (safety_origin_t)(r % SAFETY_ORIGIN_COUNT);
+        uint32_t op = (r >> 8) % 32;
+        safety_sm_result_t res;
+        if (op < 12) {
+            res = safety_sm_arm(&sm, origin, now_us());
+        } else if (op < 20) {
+            res = safety_sm_disarm(&sm, SAFETY_CAUSE_DISARM, origin, 0, now_us());
+        } else if (op < 27) {
+            // Failsafe timer: decide on a word, disarm only if still current
+            uint32_t w = safety_sm_word(&sm);
+            res = (safety_sm_state_of(w) == SAFETY_STATE_ARMED)
+                ? safety_sm_disarm(&sm, SAFETY_CAUSE_WATCHDOG, SAFETY_ORIGIN_SYSTEM, w, now_us())
+                : SAFETY_SM_REFUSED;
+        } else if (op < 29) {
+            res = safety_sm_estop(&sm, (safety_cause_t)(SAFETY_CAUSE_ESTOP + op % 3),
+                                  origin, now_us());
+        } else {
+            res = safety_sm_estop_reset(&sm, origin, now_us());
+        }
+        if (res == SAFETY_SM_DONE) m->won++;
+    }
+    return NULL;
+}
+
+static void run_mixed(int threads, long ops, bool skip) {
+    printf("\nmixed: %d threads x %ld ops, journal %d slots, %s\n", threads, ops,
+           SAFETY_JOURNAL_LEN, skip ? "e-stop / watchdog skip" : "all wait");
+    skip_policy = skip;
+    safety_sm_init(&sm);
+    sm.wait_slot = wait_slot;
+
+    reader_t reader = {0};
+    pthread_t rt, wt[MAX_THREADS];
+    mixed_t m[MAX_THREADS];
+    pthread_create(&rt, NULL, reader_main, &reader);
+    for (int t = 0; t < threads; t++) {
+        m[t] = (mixed_t){.id = t, .ops = ops};
+        pthread_create(&wt[t], NULL, mixed_main, &m[t]);
+    }
+    for (int t = 0; t < threads; t++) pthread_join(wt[t], NULL);
+    atomic_store(&reader.stop, 1);
+    pthread_join(rt, NULL);
+
+    uint32_t won = 0;
+    for (int t = 0; t < threads; t++) won += m[t].won;
+    uint32_t head = safety_sm_seq_of(safety_sm_word(&sm));
+    uint32_t waits = atomic_load(&sm.waits);
+    uint32_t skips = atomic_load(&sm.skips);
+
+    safety_transition_t j[SAFETY_JOURNAL_LEN];
+    size_t n = safety_sm_journal(&sm, j, SAFETY_JOURNAL_LEN);
+    size_t window = head < SAFETY_JOURNAL_LEN ? head : SAFETY_JOURNAL_LEN;
+
+    printf("  transitions %lu (won %lu), slot waits %lu, skips %lu, reader %ld copies / %ld entries\n",
+           (unsigned long)head, (unsigned long)won, (unsigned long)waits, (unsigned long)skips,
+           reader.copies, reader.entries);
+    check("mixed", "every won transition counted exactly once", won == head);
+    check("mixed", "only e-stops and watchdog disarms skip", skip || skips == 0);
+    check("mixed", "reader copies consistent and chained", reader.bad == 0);
+    check("mixed", "final journal consistent and chained", validate(j, n) == 0);
+    check("mixed", "final journal ends at the current state, or its entry was skipped",
+          n > 0 && (j[n - 1].seq == head
+                    ? j[n - 1].to == safety_sm_state_of(safety_sm_word(&sm))
+                    : skips > 0));
+    check("mixed", "final journal holds the last transitions, less the skipped",
+          n <= window && n + skips >= window && (n == 0 || j[0].seq > head - window));
+}
+
+// ---------------------------------------------------------------------------
+//  E-stop phase
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int           id;
+    atomic_int   *landed;   // set once the e-stop has returned
+    atomic_int   *go;
+    long          late_wins; // transitions won after the e-stop landed
+} racer_t;
+
+static void *racer_main(void *arg) {
+    racer_t *r = arg;
+    uint32_t rng = 0x85EBCA6Bu * (uint32_t)(r->id + 1);
+    while (!atomic_load(r->go)) {
+    }
+    for (long i = 0; i < 20000; i++) {
+        int after = atomic_load(r->landed);
+        uint32_t op = xorshift(&rng) % 3;
+        safety_sm_result_t res;
+        if (op == 0) {
+            res = safety_sm_arm(&sm, SAFETY_ORIGIN_PS4, now_us());
+        } else if (op == 1) {
+            res = safety_sm_disarm(&sm, SAFETY_CAUSE_DISARM, SAFETY_ORIGIN_HTTP, 0, now_us());
+        } else {
+            uint32_t w = safety_sm_word(&sm);
+            res = safety_sm_disarm(&sm, SAFETY_CAUSE_WATCHDOG, SAFETY_ORIGIN_SYSTEM, w, now_us());
+        }
+        if (after && res == SAFETY_SM_DONE) r->late_wins++;
+    }
+    return NULL;
+}
+
+static void run_estop(int threads, int rounds) {
+    printf("\nestop: %d racing threads, %d rounds\n", threads, rounds);
+    long late_wins = 0;
+    int not_estop = 0, not_last = 0, not_done = 0;
+    uint32_t waits = 0, skips = 0;
+    skip_policy = true;
+
+    for (int round = 0; round < rounds; round++) {
+        safety_sm_init(&sm);
+        sm.wait_slot = wait_slot;
+        atomic_int landed = 0, go = 0;
+        pthread_t wt[MAX_THREADS];
+        racer_t r[MAX_THREADS];
+        for (int t = 0; t < threads; t++) {
+            r[t] = (racer_t){.id = t + round * MAX_THREADS, .landed = &landed, .go = &go};
+            pthread_create(&wt[t], NULL, racer_main, &r[t]);
+        }
+        atomic_store(&go, 1);
+        usleep(200 + (round % 7) * 150);
+        unsigned skipped = atomic_load(&estop_skips);
+        if (safety_sm_estop(&sm, SAFETY_CAUSE_ESTOP, SAFETY_ORIGIN_SERIAL, now_us()) != SAFETY_SM_DONE) {
+            not_done++;
+        }
+        atomic_store(&landed, 1);
+        for (int t = 0; t < threads; t++) {
+            pthread_join(wt[t], NULL);
+            late_wins += r[t].late_wins;
+        }
+
+        uint32_t w = safety_sm_word(&sm);
+        if (safety_sm_state_of(w) != SAFETY_STATE_ESTOP) not_estop++;
+        safety_transition_t j[SAFETY_JOURNAL_LEN];
+        size_t n = safety_sm_journal(&sm, j, SAFETY_JOURNAL_LEN);
+        bool in_journal = atomic_load(&estop_skips) == skipped;
+        if (in_journal && (n == 0 || j[n - 1].to != SAFETY_STATE_ESTOP ||
+                           j[n - 1].seq != safety_sm_seq_of(w))) {
+            not_last++;
+        }
+        waits += atomic_load(&sm.waits);
+        skips += atomic_load(&sm.skips);
+    }
+    printf("  slot waits %lu, skips %lu\n", (unsigned long)waits, (unsigned long)skips);
+    check("estop", "e-stop always lands", not_done == 0);
+    check("estop", "no arm or disarm wins after the e-stop", late_wins == 0);
+    check("estop", "machine stays in ESTOP", not_estop == 0);
+    check("estop", "e-stop is the last journal entry, unless skipped", not_last == 0);
+}
+
+int main(int argc, char **argv) {
+    int threads = 8;
+    long ops = 200000;
+    int rounds = 50;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:n:r:")) != -1) {
+        switch (opt) {
+            case 't': threads = atoi(optarg); break;
+            case 'n': ops = atol(optarg); break;
+            case 'r': rounds = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-t threads] [-n ops per thread] [-r estop rounds]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (threads < 1 || threads > MAX_THREADS || ops < 1 || rounds < 1) {
+        fprintf(stderr, "need 1..%d threads, ops >= 1, rounds >= 1\n", MAX_THREADS);
+        return 1;
+    }
+
+    run_mixed(threads, ops, false);
+    run_mixed(threads, ops, true);
+    run_estop(threads, rounds);
+
+    printf("\n%s (%d failed)\n", failures ? "FAIL" : "PASS", failures);
+    return failures;
+}
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Encode and decode binary drive frames for the serial controller.
+
+Host side of firmware/components/control/include/serial_codec.h: 9-byte
+drive frames (type, seq, int16 throttle / steering, flags, CRC-16/CCITT-FALSE),
+COBS-encoded and terminated by 0x00, 11 bytes on the wire. JSON lines still
+work on the same port.
+
+As a library (needs pyserial for the port):
+
+  import serial
+  from serial_binary import DriveLink
+  link = DriveLink(serial.Serial("/dev/ttyUSB0", 115200))
+  link.send(0.5, -0.2, arm=True)
+
+From the command line:
+
+  tools/serial_binary.py encode 0.5 -0.2 --seq 7 --slow
+  tools/serial_binary.py decode 030107074067e604190b00
+  tools/serial_binary.py drive /dev/ttyUSB0 0.3 0.0 --rate 100 --time 2
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+FRAME_DRIVE = 0x01
+DRIVE = struct.Struct("<BBhhB")
+DRIVE_LEN = DRIVE.size + 2
+FLAG_ESTOP = 0x01
+FLAG_ARM = 0x02
+FLAG_SLOW = 0x04
+AXIS_SCALE = 32767
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_pos, code = 0, 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+        if not b or code == 0xFF:
+            out[code_pos] = code
+            code_pos, code = len(out), 1
+            out.append(0)
+    out[code_pos] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Decode one COBS frame (no delimiter); None if it is not valid COBS."""
+    out, i = bytearray(), 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data) or 0 in data[i:i + code - 1]:
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def axis(value):
+    v = max(-1.0, min(1.0, value)) * AXIS_SCALE
+    return int(v + 0.5) if v >= 0 else int(v - 0.5)  # half away from zero, as the firmware
+
+
+def encode_drive(throttle, steering, seq=0, estop=False, arm=False, slow=False):
+    """One drive frame, ready for the wire (0x00 delimiter included)."""
+    flags = (FLAG_ESTOP if estop else 0) | (FLAG_ARM if arm else 0) | (FLAG_SLOW if slow else 0)
+    raw = DRIVE.pack(FRAME_DRIVE, seq & 0xFF, axis(throttle), axis(steering), flags)
+    raw += struct.pack("<H", crc16(raw))
+    return cobs_encode(raw) + b"\x00"
+
+
+def decode_drive(frame):
+    """Decode one frame (COBS bytes, delimiter optional); None if invalid."""
+    raw = cobs_decode(frame.rstrip(b"\x00"))
+    if raw is None or len(raw) != DRIVE_LEN:
+        return None
+    if struct.unpack_from("<H", raw, DRIVE.size)[0] != crc16(raw[:DRIVE.size]):
+        return None
+    kind, seq, throttle, steering, flags = DRIVE.unpack_from(raw)
+    if kind != FRAME_DRIVE:
+        return None
+    return {
+        "seq": seq,
+        "throttle": max(-1.0, throttle / AXIS_SCALE),
+        "steering": max(-1.0, steering / AXIS_SCALE),
+        "estop": bool(flags & FLAG_ESTOP),
+        "arm": bool(flags & FLAG_ARM),
+        "slow": bool(flags & FLAG_SLOW),
+    }
+
+
+class DriveLink:
+    """Send drive frames on an open serial port, numbering them in sequence."""
+
+    def __init__(self, port):
+        self.port = port
+        self.seq = 0
+        port.write(b"\x00")  # drop any partial JSON line before the first frame
+
+    def send(self, throttle, steering, estop=False, arm=False, slow=False):
+        self.port.write(encode_drive(throttle, steering, self.seq, estop, arm, slow))
+        self.seq = (self.seq + 1) & 0xFF
+
+    def estop(self):
+        self.send(0.0, 0.0, estop=True)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    enc = sub.add_parser("encode", help="print one frame as hex")
+    enc.add_argument("throttle", type=float)
+    enc.add_argument("steering", type=float)
+    enc.add_argument("--seq", type=int, default=0)
+    for flag in ("estop", "arm", "slow"):
+        enc.add_argument("--" + flag, action="store_true")
+
+    dec = sub.add_parser("decode", help="decode a frame given as hex")
+    dec.add_argument("hex")
+
+    drv = sub.add_parser("drive", help="stream frames to a port (needs pyserial)")
+    drv.add_argument("port")
+    drv.add_argument("throttle", type=float)
+    drv.add_argument("steering", type=float)
+    drv.add_argument("--baud", type=int, default=115200)
+    drv.add_argument("--rate", type=float, default=50.0, help="frames per second")
+    drv.add_argument("--time", type=float, default=1.0, help="seconds, then stop")
+    drv.add_argument("--arm", action="store_true", help="arm with the first frame")
+    drv.add_argument("--slow", action="store_true")
+
+    args = ap.parse_args()
+    if args.cmd == "encode":
+        print(encode_drive(args.throttle, args.steering, args.seq,
+                           args.estop, args.arm, args.slow).hex())
+    elif args.cmd == "decode":
+        frame = decode_drive(bytes.fromhex(args.hex))
+        if frame is None:
+            sys.exit("invalid frame")
+        print(frame)
+    else:
+        import serial
+        link = DriveLink(serial.Serial(args.port, args.baud))
+        period = 1.0 / args.rate
+        end = time.monotonic() + args.time
+        first = True
+        while time.monotonic() < end:
+            link.send(args.throttle, args.steering, arm=args.arm and first, slow=args.slow)
+            first = False
+            time.sleep(period)
+        link.send(0.0, 0.0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,466 @@
+/**
+ * @file serial_codec_fuzz.c
+ * @brief Host check and benchmark: binary serial frames and the stream parser
+ *
+ * Runs the firmware's serial_codec.c and checks:
+ *
+ *   cobs      random buffers (0-600 bytes) survive encode / decode, with no
+ *             zero byte in the encoding
+ *   drive     random drive frames decode to what was sent, 11 bytes each
+ *   interleave a JSON line (any line ending) straight into two frames, with
+ *             no 0x00 in between: both frames arrive, no bogus JSON line
+ *   mixed     a stream of JSON lines and binary frames in random order comes
+ *             out complete and in order, with sequence gaps counted
+ *   flips     single and double bit errors in a frame are never delivered
+ *             as a different frame
+ *   garbage   random bytes (biased towards 0x00, '{' and newlines) never
+ *             overrun the parser, and almost never pass as a frame
+ *   resync    after garbage, the next JSON line and the next frame get through
+ *
+ * then times the encoder and the parser, and prints the command rate the
+ * link can carry at each baud rate, binary against the equivalent JSON line
+ * (8N1: 10 bits per byte). Exit status is the number of failed checks.
+ *
+ * Build and run from the repository root (add -fsanitize=address,undefined
+ * to catch overruns while fuzzing):
+ *
+ *   gcc -O2 -std=gnu17 -Ifirmware/components/control/include \
+ *       tools/serial_codec_fuzz.c firmware/components/control/serial_codec.c \
+ *       -o serial_codec_fuzz && ./serial_codec_fuzz [-n iterations] [-s seed] [-b baud]
+ */
+
+#include "serial_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_ITERS   200000u
+#define GARBAGE_BYTES   (64u << 20)
+#define BENCH_FRAMES    (1u << 22)
+#define MIXED_ITEMS     16
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+static int failures;
+
+static uint32_t rnd(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 16);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void check(bool ok, const char *what) {
+    printf("  %s  %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) failures++;
+}
+
+static serial_drive_t random_drive(void) {
+    return (serial_drive_t){
+        .seq      = (uint8_t)rnd(),
+        .throttle = (int16_t)rnd(),
+        .steering = (int16_t)rnd(),
+        .flags    = (uint8_t)(rnd() & 0x07),
+    };
+}
+
+static bool same_drive(const serial_drive_t *a, const serial_drive_t *b) {
+    return a->seq == b->seq && a->throttle == b->throttle && a->steering == b->steering &&
+           a->flags == b->flags;
+}
+
+/**
+ * @brief Feed bytes; collect every delivered drive frame and JSON line
+ */
+typedef struct {
+    serial_drive_t drives[MIXED_ITEMS + 4];
+    char           lines[MIXED_ITEMS + 4][SERIAL_LINE_MAX];
+    int            n_drives;
+    int            n_lines;
+    int            order[2 * MIXED_ITEMS + 8];   // 'd' or 'j' per delivery
+    int            n_order;
+} deliveries_t;
+
+static void feed(serial_rx_t *rx, const uint8_t *bytes, size_t len, deliveries_t *d) {
+    for (size_t i = 0; i < len; i++) {
+        serial_drive_t drive;
+        const char *line;
+        serial_rx_result_t res = serial_rx_push(rx, bytes[i], &drive, &line);
+        if (d == NULL) continue;
+        if (res == SERIAL_RX_DRIVE && d->n_drives < MIXED_ITEMS + 4) {
+            d->drives[d->n_drives++] = drive;
+            d->order[d->n_order++] = 'd';
+        } else if (res == SERIAL_RX_JSON && d->n_lines < MIXED_ITEMS + 4) {
+            snprintf(d->lines[d->n_lines++], SERIAL_LINE_MAX, "%s", line);
+            d->order[d->n_order++] = 'j';
+        }
+    }
+}
+
+static void test_cobs(unsigned iters) {
+    static uint8_t in[600], enc[610], dec[600];
+    bool ok = true;
+    for (unsigned it = 0; it < iters / 10 && ok; it++) {
+        size_t len = rnd() % sizeof(in);
+        unsigned zero_odds = 1 + rnd() % 64;   // from mostly zeros to almost none
+        for (size_t i = 0; i < len; i++) {
+            in[i] = (rnd() % zero_odds == 0) ? 0 : (uint8_t)(1 + rnd() % 255);
+        }
+        size_t n = serial_cobs_encode(in, len, enc);
+        if (n > len + len / 254 + 1 || memchr(enc, 0, n) != NULL) ok = false;
+        size_t m = serial_cobs_decode(enc, n, dec, sizeof(dec));
+        if (m != len || memcmp(in, dec, len) != 0) ok = false;
+    }
+    check(ok, "cobs: round trip, no zero in the encoding");
+}
+
+static void test_drive(unsigned iters) {
+    serial_rx_t rx;
+    serial_rx_reset(&rx);
+    feed(&rx, (const uint8_t *)"\0", 1, NULL);   // as a sender does before its first frame
+    uint8_t wire[SERIAL_DRIVE_WIRE_LEN + 1];
+    bool ok = true, sized = true;
+    for (unsigned it = 0; it < iters; it++) {
+        serial_drive_t sent = random_drive(), got = {0};
+        size_t n = serial_drive_encode(&sent, wire);
+        if (n != SERIAL_DRIVE_WIRE_LEN || wire[n - 1] != 0) sized = false;
+        int delivered = 0;
+        for (size_t i = 0; i < n; i++) {
+            const char *line;
+            if (serial_rx_push(&rx, wire[i], &got, &line) == SERIAL_RX_DRIVE) delivered++;
+        }
+        if (delivered != 1 || !same_drive(&sent, &got)) ok = false;
+    }
+    check(sized, "drive: 11 bytes on the wire, 0x00-terminated");
+    check(ok && rx.stats.drive_frames == iters && rx.stats.crc_errors == 0,
+          "drive: every frame decodes to what was sent");
+
+    bool axes = serial_axis_from_float(1.0f) == 32767 && serial_axis_from_float(-1.0f) == -32767 &&
+                serial_axis_from_float(2.0f) == 32767 && serial_axis_from_float(0.5f) == 16384 &&
+                serial_axis_to_float(-32768) == -1.0f && serial_axis_to_float(32767) == 1.0f;
+    check(axes, "drive: axis scaling and clamping");
+}
+
+static void test_mixed(unsigned iters) {
+    static const char *json[] = {
+        "{\"throttle\": 0.5, \"steering\": -0.2}",
+        "{\"estop\": true}",
+        "{\"arm\":true}",
+        "{\"config\": {\"expo\": 40, \"max_speed\": 80}}",
+    };
+    bool ok = true, gaps_ok = true;
+    for (unsigned it = 0; it < iters / 20 && ok; it++) {
+        serial_rx_t rx;
+        serial_rx_reset(&rx);
+        uint8_t stream[MIXED_ITEMS * 64];
+        size_t len = 0;
+        char kinds[MIXED_ITEMS];
+        serial_drive_t sent[MIXED_ITEMS];
+        const char *lines[MIXED_ITEMS];
+        int n_drives = 0, n_lines = 0;
+        uint8_t seq = (uint8_t)rnd();
+        unsigned gaps = 0;
+
+        for (int k = 0; k < MIXED_ITEMS; k++) {
+            if (rnd() & 1) {
+                // A leading 0x00 is optional, after text or not
+                if (rnd() & 1) stream[len++] = 0x00;
+                unsigned skip = (rnd() % 4 == 0) ? 1 + rnd() % 3 : 0;
+                seq += (uint8_t)(skip + 1);
+                if (n_drives > 0) gaps += skip;
+                serial_drive_t d = random_drive();
+                d.seq = seq;
+                sent[n_drives++] = d;
+                len += serial_drive_encode(&d, &stream[len]);
+                kinds[k] = 'd';
+            } else {
+                const char *j = json[rnd() % 4];
+                size_t jl = strlen(j);
+                memcpy(&stream[len], j, jl);
+                len += jl;
+                if (rnd() & 1) stream[len++] = '\r';
+                stream[len++] = '\n';
+                lines[n_lines++] = j;
+                kinds[k] = 'j';
+            }
+        }
+
+        deliveries_t d = {0};
+        feed(&rx, stream, len, &d);
+        if (d.n_drives != n_drives || d.n_lines != n_lines || d.n_order != MIXED_ITEMS) {
+            ok = false;
+            break;
+        }
+        for (int k = 0; k < MIXED_ITEMS; k++) {
+            if (d.order[k] != kinds[k]) ok = false;
+        }
+        for (int k = 0; k < n_drives; k++) {
+            if (!same_drive(&sent[k], &d.drives[k])) ok = false;
+        }
+        for (int k = 0; k < n_lines; k++) {
+            if (strcmp(lines[k], d.lines[k]) != 0) ok = false;
+        }
+        if (rx.stats.seq_gaps != gaps || rx.stats.crc_errors || rx.stats.bad_frames ||
+            rx.stats.overflows) {
+            gaps_ok = false;
+        }
+    }
+    check(ok, "mixed: JSON lines and frames delivered complete and in order");
+    check(gaps_ok, "mixed: sequence gaps counted, no errors");
+}
+
+/**
+ * @brief A JSON line straight into frames, with no 0x00 in between
+ *
+ * The first frame's COBS code byte is 0x0A when it has no zero byte, and its
+ * data may hold 0x0A / 0x0D too; none of that may end up as a JSON line.
+ */
+static void test_interleave(unsigned iters) {
+    static const char *endings[] = {"\n", "\r\n", "\r", "\r\n\r\n"};
+    bool ok = true;
+    unsigned eol_frames = 0;
+    for (unsigned it = 0; it < iters / 20 && ok; it++) {
+        serial_rx_t rx;
+        serial_rx_reset(&rx);
+        uint8_t stream[128];
+        size_t len = 0;
+        static const char json[] = "{\"throttle\": 0.5}";
+        // Start-up state, then after the line: no 0x00 before either frame
+        bool lead = rnd() & 1;
+        serial_drive_t sent[3];
+        if (lead) {
+            sent[0] = random_drive();
+            len += serial_drive_encode(&sent[0], &stream[len]);
+        }
+        memcpy(&stream[len], json, strlen(json));
+        len += strlen(json);
+        const char *eol = endings[rnd() % 4];
+        memcpy(&stream[len], eol, strlen(eol));
+        len += strlen(eol);
+        for (int k = 1; k <= 2; k++) {
+            sent[k] = random_drive();
+            if (k == 1 && (rnd() & 1)) {
+                sent[k].throttle = 0x0D0A;  // line-end bytes inside the frame
+            }
+            size_t at = len;
+            len += serial_drive_encode(&sent[k], &stream[len]);
+            if (memchr(&stream[at], '\n', len - at) || memchr(&stream[at], '\r', len - at)) {
+                eol_frames++;
+            }
+        }
+
+        deliveries_t d = {0};
+        feed(&rx, stream, len, &d);
+        int first = lead ? 0 : 1;
+        if (d.n_lines != 1 || strcmp(d.lines[0], json) != 0 || d.n_drives != 3 - first) {
+            ok = false;
+            break;
+        }
+        for (int k = first; k <= 2; k++) {
+            if (!same_drive(&d.drives[k - first], &sent[k])) ok = false;
+        }
+        if (rx.stats.bad_frames || rx.stats.crc_errors || rx.stats.overflows) ok = false;
+    }
+    printf("  %u frames carried 0x0A / 0x0D on the wire\n", eol_frames);
+    check(ok, "interleave: JSON line, then frames with no 0x00 first, all delivered");
+}
+
+static void test_flips(unsigned iters) {
+    uint8_t wire[SERIAL_DRIVE_WIRE_LEN];
+    const unsigned bits = (SERIAL_DRIVE_WIRE_LEN - 1) * 8;   // the delimiter is left alone
+    unsigned single_bad = 0, double_bad = 0, doubles = 0;
+    for (unsigned it = 0; it < iters / 20; it++) {
+        serial_drive_t sent = random_drive();
+        serial_drive_encode(&sent, wire);
+        for (unsigned b1 = 0; b1 < bits; b1++) {
+            for (unsigned b2 = b1; b2 < bits; b2++) {
+                if (b2 != b1 && rnd() % 16 != 0) continue;   // sample the pairs
+                uint8_t bad[SERIAL_DRIVE_WIRE_LEN + 1];
+                bad[0] = 0x00;
+                memcpy(&bad[1], wire, sizeof(wire));
+                bad[1 + b1 / 8] ^= (uint8_t)(1u << (b1 % 8));
+                if (b2 != b1) bad[1 + b2 / 8] ^= (uint8_t)(1u << (b2 % 8));
+
+                serial_rx_t rx;
+                serial_rx_reset(&rx);
+                deliveries_t d = {0};
+                feed(&rx, bad, sizeof(bad), &d);
+                bool wrong = false;
+                for (int k = 0; k < d.n_drives; k++) {
+                    if (!same_drive(&d.drives[k], &sent)) wrong = true;
+                }
+                if (b2 == b1) {
+                    single_bad += wrong;
+                } else {
+                    double_bad += wrong;
+                    doubles++;
+                }
+            }
+        }
+    }
+    printf("  %u double-bit errors tried, %u passed as another frame\n", doubles, double_bad);
+    check(single_bad == 0, "flips: no single-bit error passes as another frame");
+    check(double_bad == 0, "flips: no double-bit error passes as another frame");
+}
+
+static void test_garbage(void) {
+    serial_rx_t rx;
+    serial_rx_reset(&rx);
+    unsigned accepted = 0, bad_lines = 0;
+    uint64_t frames = 0;
+    for (uint32_t i = 0; i < GARBAGE_BYTES; i++) {
+        uint32_t r = rnd();
+        uint8_t byte;
+        switch (r % 16) {
+            case 0:  byte = 0x00; break;
+            case 1:  byte = '{';  break;
+            case 2:  byte = '\n'; break;
+            default: byte = (uint8_t)(r >> 8); break;
+        }
+        if (byte == 0) frames++;
+        serial_drive_t drive;
+        const char *line;
+        serial_rx_result_t res = serial_rx_push(&rx, byte, &drive, &line);
+        if (res == SERIAL_RX_DRIVE) accepted++;
+        if (res == SERIAL_RX_JSON && strlen(line) >= SERIAL_LINE_MAX) bad_lines++;
+        if (rx.len > SERIAL_LINE_MAX - 1) bad_lines++;
+    }
+    // A random 9-byte frame passes with odds 1 / 65536 (CRC) x 1 / 256 (type)
+    double expected = (double)frames / 65536.0 / 256.0;
+    printf("  %u MB of garbage: %llu delimiters, %u frames accepted (about %.3f expected), "
+           "%lu CRC errors, %lu bad frames, %lu overflows\n",
+           GARBAGE_BYTES >> 20, (unsigned long long)frames, accepted, expected,
+           (unsigned long)rx.stats.crc_errors, (unsigned long)rx.stats.bad_frames,
+           (unsigned long)rx.stats.overflows);
+    check(bad_lines == 0, "garbage: parser stays inside its buffer");
+    check(accepted <= 10.0 * expected + 2, "garbage: false frames no likelier than CRC odds");
+}
+
+static void test_resync(void) {
+    serial_rx_t rx;
+    serial_rx_reset(&rx);
+    uint8_t junk[1000];
+    for (size_t i = 0; i < sizeof(junk); i++) junk[i] = (uint8_t)(1 + rnd() % 255);
+
+    static const char json[] = "{\"arm\": true}\n";
+    deliveries_t d = {0};
+    feed(&rx, junk, sizeof(junk), &d);
+    feed(&rx, (const uint8_t *)"\n", 1, &d);
+    feed(&rx, (const uint8_t *)json, strlen(json), &d);
+    check(d.n_lines > 0 && strcmp(d.lines[d.n_lines - 1], "{\"arm\": true}") == 0,
+          "resync: text garbage, then a JSON line gets through");
+
+    uint8_t wire[SERIAL_DRIVE_WIRE_LEN];
+    serial_drive_t sent = random_drive();
+    serial_drive_encode(&sent, wire);
+    memset(&d, 0, sizeof(d));
+    feed(&rx, junk, sizeof(junk), &d);
+    feed(&rx, (const uint8_t *)"\0", 1, &d);
+    feed(&rx, wire, sizeof(wire), &d);
+    check(d.n_drives == 1 && same_drive(&d.drives[0], &sent),
+          "resync: text garbage, then 0x00 and a frame gets through");
+
+    memset(&d, 0, sizeof(d));
+    feed(&rx, wire, 5, &d);           // a frame cut short by the next 0x00
+    feed(&rx, (const uint8_t *)"\0", 1, &d);
+    feed(&rx, wire, 5, &d);           // ... or by garbage, taken as text
+    feed(&rx, junk, sizeof(junk), &d);
+    feed(&rx, (const uint8_t *)"\n", 1, &d);
+    feed(&rx, (const uint8_t *)json, strlen(json), &d);
+    check(d.n_lines > 0 && strcmp(d.lines[d.n_lines - 1], "{\"arm\": true}") == 0,
+          "resync: binary garbage, then a JSON line gets through");
+
+    memset(&d, 0, sizeof(d));
+    static const char chat[] = "ok\r\n\n{\"arm\": true}\r\n";
+    feed(&rx, (const uint8_t *)chat, strlen(chat), &d);
+    check(d.n_lines == 2 && strcmp(d.lines[1], "{\"arm\": true}") == 0,
+          "resync: a short non-JSON line does not swallow the next JSON line");
+}
+
+static void bench(uint32_t baud) {
+    uint8_t *stream = malloc((size_t)BENCH_FRAMES * SERIAL_DRIVE_WIRE_LEN + 1);
+    if (stream == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    double t0 = now_s();
+    stream[0] = 0x00;
+    size_t len = 1;
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        serial_drive_t d = {
+            .seq = (uint8_t)i, .throttle = (int16_t)(i * 7), .steering = (int16_t)(i * 13),
+        };
+        len += serial_drive_encode(&d, &stream[len]);
+    }
+    double t1 = now_s();
+
+    serial_rx_t rx;
+    serial_rx_reset(&rx);
+    uint32_t got = 0;
+    for (size_t i = 0; i < len; i++) {
+        serial_drive_t drive;
+        const char *line;
+        got += serial_rx_push(&rx, stream[i], &drive, &line) == SERIAL_RX_DRIVE;
+    }
+    double t2 = now_s();
+    free(stream);
+
+    printf("\nhost: encode %.1f M frames/s, parse %.1f M frames/s (%.0f MB/s), %u of %u decoded\n",
+           BENCH_FRAMES / (t1 - t0) / 1e6, BENCH_FRAMES / (t2 - t1) / 1e6,
+           len / (t2 - t1) / 1e6, got, BENCH_FRAMES);
+
+    char json[96];
+    int json_len = snprintf(json, sizeof(json), "{\"throttle\": %.3f, \"steering\": %.3f}\n",
+                            0.5, -0.2);
+    printf("\nlink (8N1): binary %d bytes/frame, JSON %d bytes/line (%s)\n",
+           SERIAL_DRIVE_WIRE_LEN, json_len, "{\"throttle\": 0.500, \"steering\": -0.200}");
+    printf("%9s %14s %12s\n", "baud", "binary fps", "JSON fps");
+    static const uint32_t bauds[] = {9600, 57600, 115200, 230400, 460800, 921600};
+    bool listed = false;
+    for (size_t i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++) {
+        uint32_t b = bauds[i];
+        printf("%9lu %14.0f %12.0f%s\n", (unsigned long)b, b / 10.0 / SERIAL_DRIVE_WIRE_LEN,
+               b / 10.0 / json_len, b == baud ? "  <-" : "");
+        listed |= (b == baud);
+    }
+    if (!listed) {
+        printf("%9lu %14.0f %12.0f  <-\n", (unsigned long)baud,
+               baud / 10.0 / SERIAL_DRIVE_WIRE_LEN, baud / 10.0 / json_len);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned iters = DEFAULT_ITERS;
+    uint32_t baud = 115200;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:b:")) != -1) {
+        switch (opt) {
+            case 'n': iters = strtoul(optarg, NULL, 0); break;
+            case 's': rng_state = strtoull(optarg, NULL, 0) | 1; break;
+            case 'b': baud = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-s seed] [-b baud]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    printf("serial codec: %u iterations, seed 0x%llx\n", iters, (unsigned long long)rng_state);
+    test_cobs(iters);
+    test_drive(iters);
+    test_mixed(iters);
+    test_interleave(iters);
+    test_flips(iters);
+    test_garbage();
+    test_resync();
+    bench(baud);
+
+    printf("\n%d failure(s)\n", failures);
+    return failures;
+}
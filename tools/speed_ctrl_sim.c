@@ -0,0 +1,312 @@
+/**
+ * @file speed_ctrl_sim.c
+ * @brief Host simulation: closed-loop track speed control vs open loop
+ *
+ * Drives two brushed DC motors (armature R/L, back-EMF and torque constant,
+ * inertia, viscous and Coulomb friction) with the firmware's speed_pid.c.
+ * The tracks are deliberately mismatched, the target steps from rest, and
+ * part way through both tracks meet an incline (a load torque step). The
+ * controller runs at the control loop rate with a one-tick measurement
+ * delay, optional encoder quantisation, and the motor layer's slew ramp on
+ * the duty it outputs.
+ *
+ * For each track it prints rise time (10-90%), overshoot, steady-state error
+ * before the incline, and the error and recovery time after it, for the
+ * plain open-loop mapping (duty = target), for the PID on a speed sensor
+ * (ideal or encoder), and for the PID on the firmware's current-sense
+ * estimate (speed_pid_emf_estimate() with one resistance setting for both
+ * tracks, the left motor's by default). Then it checks:
+ *
+ *   closed     rise time within MAX_RISE_S, overshoot within MAX_OVERSHOOT,
+ *              steady-state and incline error within MAX_SS_ERR, and
+ *              incline error below the open-loop one
+ *   estimate   steady-state error within MAX_EST_ERR (the estimate cannot
+ *              see the right motor's different constant), and incline error
+ *              at most half the open-loop one
+ *
+ * The exit status is the number of failed checks.
+ *
+ * Build and run from the repository root:
+ *
+ *   gcc -O2 -std=gnu17 -Ifirmware/components/motion/include \
+ *       tools/speed_ctrl_sim.c firmware/components/motion/speed_pid.c \
+ *       -lm -o speed_ctrl_sim && ./speed_ctrl_sim [options]
+ *
+ * Options (gains match the Kconfig units):
+ *   -p kp*1000  -i ki*1000  -d kd*1000  -f kff%  -s kstatic%  -c d_cutoff_hz
+ *   -H loop_hz  -r ramp_ms (0 = none)  -e encoder counts/rev (0 = ideal)
+ *   -t target%  -l incline load % of stall torque
+ *   -R estimate armature resistance, milliohm
+ */
+
+#include "speed_pid.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define SIM_DT_S     50e-6   // motor integration step
+#define SIM_END_S    3.0
+#define STEP_AT_S    0.1
+#define INCLINE_AT_S 1.5
+#define SETTLE_BAND  0.02    // recovery: back within 2% of full speed
+
+// Pass / fail bounds
+#define MAX_RISE_S    0.3
+#define MAX_OVERSHOOT 0.15
+#define MAX_SS_ERR    0.01
+#define MAX_EST_ERR   0.05
+
+typedef struct {
+    const char *name;
+    double r_ohm;      // armature resistance
+    double l_h;        // armature inductance
+    double k;          // Ke = Kt (V*s/rad = N*m/A)
+    double j;          // inertia reflected to the motor shaft
+    double b;          // viscous friction
+    double coulomb;    // dry friction torque
+} motor_params_t;
+
+typedef struct {
+    double i;          // armature current
+    double w;          // shaft speed, rad/s
+    double angle;      // shaft angle, rad (for the encoder)
+} motor_state_t;
+
+#define SUPPLY_V 12.0
+
+// Left and right drives differ: a stiffer gearbox and a worn track on the right
+static const motor_params_t motors[2] = {
+    {"left",  1.5, 2e-3, 0.050, 2.0e-4, 1.0e-4, 0.010},
+    {"right", 1.8, 2e-3, 0.047, 2.4e-4, 1.6e-4, 0.018},
+};
+
+static void motor_step(const motor_params_t *m, motor_state_t *s, double duty, double load) {
+    double v = duty * SUPPLY_V;
+    double di = (v - m->r_ohm * s->i - m->k * s->w) / m->l_h;
+    double torque = m->k * s->i - m->b * s->w - load;
+    // Dry friction opposes motion, and holds the shaft if it cannot be overcome
+    if (fabs(s->w) > 1e-3) {
+        torque -= copysign(m->coulomb, s->w);
+    } else if (fabs(torque) <= m->coulomb) {
+        torque = 0.0;
+        s->w = 0.0;
+    } else {
+        torque -= copysign(m->coulomb, torque);
+    }
+    s->i += di * SIM_DT_S;
+    s->w += torque / m->j * SIM_DT_S;
+    s->angle += s->w * SIM_DT_S;
+}
+
+typedef struct {
+    double rise_s;        // 10-90% of target
+    double overshoot;     // peak above target, fraction of target
+    double ss_err;        // mean error over the 0.2 s before the incline
+    double load_err;      // mean error over the last 0.2 s
+    double recover_s;     // incline until back within SETTLE_BAND (or -1)
+} result_t;
+
+typedef enum { MODE_OPEN, MODE_CLOSED, MODE_ESTIMATE } sim_mode_t;
+
+typedef struct {
+    sim_mode_t mode;
+    double loop_hz;
+    double ramp_per_s;    // duty slew limit, 0 = none
+    int    cpr;
+    double target;
+    double load_frac;
+    double r_est_ohm;     // resistance the estimate assumes
+    speed_pid_gains_t gains;
+} sim_opts_t;
+
+static void simulate(const sim_opts_t *o, result_t res[2]) {
+    const double no_load_w = SUPPLY_V / motors[0].k;  // 1.0 normalised speed
+    const int    substeps  = (int)lround(1.0 / (o->loop_hz * SIM_DT_S));
+    const double tick_s    = substeps * SIM_DT_S;
+
+    for (int m = 0; m < 2; m++) {
+        const motor_params_t *mp = &motors[m];
+        motor_state_t s = {0};
+        speed_pid_t pid;
+        speed_pid_reset(&pid);
+        double stall_torque = mp->k * SUPPLY_V / mp->r_ohm;
+
+        double duty = 0.0;
+        double meas = 0.0;          // what the controller sees (one tick late)
+        double prev_angle = 0.0;
+        double t10 = -1, t90 = -1, peak = 0.0;
+        double ss_sum = 0.0, load_sum = 0.0;
+        int    ss_n = 0, load_n = 0;
+        double last_out = -1.0;
+
+        for (double t = 0.0; t < SIM_END_S; t += tick_s) {
+            double target = (t >= STEP_AT_S) ? o->target : 0.0;
+            double load   = (t >= INCLINE_AT_S) ? o->load_frac * stall_torque : 0.0;
+
+            double cmd = target;
+            if (o->mode != MODE_OPEN) {
+                cmd = speed_pid_update(&pid, &o->gains, (float)target, (float)meas, (float)tick_s);
+            }
+            if (o->ramp_per_s > 0.0) {
+                double step = o->ramp_per_s * tick_s;
+                if (cmd > duty + step)      cmd = duty + step;
+                else if (cmd < duty - step) cmd = duty - step;
+            }
+            duty = cmd;
+
+            double amps = 0.0;
+            for (int k = 0; k < substeps; k++) {
+                motor_step(mp, &s, duty, load);
+                amps += fabs(s.i) / substeps;
+            }
+
+            // Speed sensor: ideal, counts per tick from an encoder, or the
+            // current-sense estimate (tick-mean current, as filtered)
+            if (o->mode == MODE_ESTIMATE) {
+                meas = speed_pid_emf_estimate((float)duty, (float)amps, (float)o->r_est_ohm,
+                                              (float)SUPPLY_V);
+            } else if (o->cpr > 0) {
+                double per_count = 2.0 * M_PI / o->cpr;
+                double counts = floor(s.angle / per_count) - floor(prev_angle / per_count);
+                meas = counts * per_count / tick_s / no_load_w;
+            } else {
+                meas = s.w / no_load_w;
+            }
+            prev_angle = s.angle;
+
+            double speed = s.w / no_load_w;
+            double tn = t + tick_s;
+            if (target > 0.0) {
+                if (t10 < 0 && speed >= 0.1 * target) t10 = tn;
+                if (t90 < 0 && speed >= 0.9 * target) t90 = tn;
+                if (tn < INCLINE_AT_S && speed > peak) peak = speed;
+            }
+            if (tn >= INCLINE_AT_S - 0.2 && tn < INCLINE_AT_S) {
+                ss_sum += target - speed;
+                ss_n++;
+            }
+            if (tn >= SIM_END_S - 0.2) {
+                load_sum += target - speed;
+                load_n++;
+            }
+            if (tn >= INCLINE_AT_S && fabs(target - speed) > SETTLE_BAND) {
+                last_out = tn;
+            }
+        }
+
+        res[m].rise_s    = (t10 >= 0 && t90 >= 0) ? t90 - t10 : -1.0;
+        res[m].overshoot = (peak > o->target) ? (peak - o->target) / o->target : 0.0;
+        res[m].ss_err    = ss_n ? ss_sum / ss_n : 0.0;
+        res[m].load_err  = load_n ? load_sum / load_n : 0.0;
+        res[m].recover_s = (last_out < 0) ? 0.0
+                         : (last_out >= SIM_END_S - tick_s) ? -1.0
+                         : last_out - INCLINE_AT_S;
+    }
+}
+
+static int failures = 0;
+
+static void check(const char *mode, const char *track, const char *what, int ok) {
+    printf("  %s  %s %s: %s\n", ok ? "PASS" : "FAIL", mode, track, what);
+    if (!ok) failures++;
+}
+
+static void print_row(const char *mode, const char *track, const result_t *r) {
+    char rise[16], rec[16];
+    if (r->rise_s < 0) snprintf(rise, sizeof(rise), "never");
+    else               snprintf(rise, sizeof(rise), "%.0f ms", r->rise_s * 1e3);
+    if (r->recover_s < 0) snprintf(rec, sizeof(rec), "never");
+    else                  snprintf(rec, sizeof(rec), "%.0f ms", r->recover_s * 1e3);
+    printf("%-9s%-7s%10s%11.1f%%%12.1f%%%13.1f%%%11s\n",
+           mode, track, rise, r->overshoot * 100.0, r->ss_err * 100.0,
+           r->load_err * 100.0, rec);
+}
+
+int main(int argc, char **argv) {
+    sim_opts_t o = {
+        .loop_hz    = 50.0,
+        .ramp_per_s = 1000.0 / 200.0,
+        .cpr        = 0,
+        .target     = 0.6,
+        .load_frac  = 0.2,
+        .r_est_ohm  = 1.5,
+        .gains = {
+            .kp = 0.8f, .ki = 6.0f, .kd = 0.0f,
+            .kff = 1.0f, .kstatic = 0.0f, .d_cutoff_hz = 20.0f, .out_limit = 1.0f,
+        },
+    };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:i:d:f:s:c:H:r:e:t:l:R:")) != -1) {
+        double v = atof(optarg);
+        switch (opt) {
+            case 'p': o.gains.kp = v / 1000.0; break;
+            case 'i': o.gains.ki = v / 1000.0; break;
+            case 'd': o.gains.kd = v / 1000.0; break;
+            case 'f': o.gains.kff = v / 100.0; break;
+            case 's': o.gains.kstatic = v / 100.0; break;
+            case 'c': o.gains.d_cutoff_hz = v; break;
+            case 'H': o.loop_hz = v; break;
+            case 'r': o.ramp_per_s = (v > 0) ? 1000.0 / v : 0.0; break;
+            case 'e': o.cpr = (int)v; break;
+            case 't': o.target = v / 100.0; break;
+            case 'l': o.load_frac = v / 100.0; break;
+            case 'R': o.r_est_ohm = v / 1000.0; break;
+            default:
+                fprintf(stderr, "usage: %s [-p kp] [-i ki] [-d kd] [-f kff] [-s kstatic] "
+                        "[-c cutoff] [-H hz] [-r ramp_ms] [-e cpr] [-t target%%] [-l load%%] "
+                        "[-R est_mohm]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (o.loop_hz <= 0.0 || o.target <= 0.0) {
+        fprintf(stderr, "loop rate and target must be positive\n");
+        return 1;
+    }
+
+    printf("target %.0f%%, incline %.0f%% of stall at %.1f s, %.0f Hz loop, ramp %s, "
+           "encoder %s\n",
+           o.target * 100.0, o.load_frac * 100.0, INCLINE_AT_S, o.loop_hz,
+           o.ramp_per_s > 0 ? "on" : "off", o.cpr > 0 ? "quantised" : "ideal");
+    printf("gains kp=%.3f ki=%.3f kd=%.3f kff=%.2f kstatic=%.2f, estimate R %.2f ohm\n",
+           o.gains.kp, o.gains.ki, o.gains.kd, o.gains.kff, o.gains.kstatic, o.r_est_ohm);
+    printf("%-9s%-7s%10s%12s%13s%14s%11s\n",
+           "mode", "track", "rise", "overshoot", "ss error", "incline err", "recover");
+
+    static const char *const mode_names[] = {"open", "closed", "estimate"};
+    result_t res[3][2];
+    for (int mode = MODE_OPEN; mode <= MODE_ESTIMATE; mode++) {
+        o.mode = (sim_mode_t)mode;
+        simulate(&o, res[mode]);
+        for (int m = 0; m < 2; m++) {
+            print_row(mode_names[mode], motors[m].name, &res[mode][m]);
+        }
+    }
+
+    printf("\n");
+    for (int m = 0; m < 2; m++) {
+        const result_t *op = &res[MODE_OPEN][m];
+        const result_t *cl = &res[MODE_CLOSED][m];
+        const result_t *es = &res[MODE_ESTIMATE][m];
+        char what[96];
+        snprintf(what, sizeof(what), "rise time within %.0f ms", MAX_RISE_S * 1e3);
+        check("closed", motors[m].name, what, cl->rise_s >= 0 && cl->rise_s <= MAX_RISE_S);
+        snprintf(what, sizeof(what), "overshoot within %.0f%%", MAX_OVERSHOOT * 100.0);
+        check("closed", motors[m].name, what, cl->overshoot <= MAX_OVERSHOOT);
+        snprintf(what, sizeof(what), "steady-state error within %.0f%%", MAX_SS_ERR * 100.0);
+        check("closed", motors[m].name, what, fabs(cl->ss_err) <= MAX_SS_ERR);
+        snprintf(what, sizeof(what), "incline error within %.0f%% and below open loop",
+                 MAX_SS_ERR * 100.0);
+        check("closed", motors[m].name, what,
+              fabs(cl->load_err) <= MAX_SS_ERR && fabs(cl->load_err) < fabs(op->load_err));
+        snprintf(what, sizeof(what), "steady-state error within %.0f%%", MAX_EST_ERR * 100.0);
+        check("estimate", motors[m].name, what, fabs(es->ss_err) <= MAX_EST_ERR);
+        check("estimate", motors[m].name, "incline error at most half of open loop",
+              fabs(es->load_err) <= 0.5 * fabs(op->load_err));
+    }
+
+    printf("\n%s (%d failed)\n", failures ? "FAIL" : "PASS", failures);
+    return failures;
+}
@@ -0,0 +1,246 @@
+/**
+ * @file thermal_sim.c
+ * @brief Host check: thermal model derating over simulated duty cycles
+ *
+ * Runs the firmware's thermal_model.c at the control loop rate through a
+ * set of load profiles, feeding back the derating the way control_manager
+ * does (the scale multiplies the commanded duty, and the load follows the
+ * duty actually applied):
+ *
+ *   curve      static output scale vs heat
+ *   cruise     50% duty for 20 min, duty estimate: must never derate
+ *   push       100% duty for 20 min, duty estimate: derates after a few
+ *              minutes and settles above min_scale without a cutoff
+ *   cycle      100% for 30 s / stopped for 30 s: derates later than push
+ *   stall      measured stall current (tracks the duty): the bridge
+ *              derates within seconds; the motor keeps heating and cuts
+ *              off well after the first warning
+ *   short      10 s of measured current that ignores the duty: cuts off,
+ *              then releases only after cooling below the resume level
+ *   stall-pid  stalled track under closed-loop speed control (default
+ *              speed_ctrl gains, 80% target, measured speed 0): the
+ *              integrator must not wind the duty past the derating, so the
+ *              track warns and cuts off as in stall
+ *
+ * Each profile prints a timeline and a PASS/FAIL line; the exit status is
+ * the number of failed checks.
+ *
+ * Build and run from the repository root:
+ *
+ *   gcc -O2 -std=gnu17 -Ifirmware/components/motion/include \
+ *       tools/thermal_sim.c firmware/components/motion/thermal_model.c \
+ *       firmware/components/motion/speed_pid.c -lm -o thermal_sim && ./thermal_sim [options]
+ *
+ * Options (Kconfig units, defaults match Kconfig):
+ *   -a motor_limit_A  -A motor_tau_s  -b bridge_limit_A  -B bridge_tau_s
+ *   -f full_duty_A    -s derate_start%  -n min_scale%  -r resume%
+ *   -H loop_hz
+ */
+
+#include "speed_pid.h"
+#include "thermal_model.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define STALL_A  25.0f   // wiper motor stall current at full duty
+#define SHORT_A  30.0f   // fault current that does not follow the duty
+#define PRINT_S  60.0    // timeline interval
+
+typedef enum { LOAD_DUTY, LOAD_STALL, LOAD_FIXED, LOAD_PID_STALL } load_kind_t;
+
+// Kconfig speed_ctrl defaults
+static const speed_pid_gains_t pid_gains = {
+    .kp = 0.8f, .ki = 6.0f, .kd = 0.0f,
+    .kff = 1.0f, .kstatic = 0.0f, .d_cutoff_hz = 20.0f, .out_limit = 1.0f,
+};
+
+typedef struct {
+    const char *name;
+    double      duration_s;
+    double      on_s;         // duty applied for on_s of every period_s
+    double      period_s;     // 0 = always on
+    float       duty;
+    load_kind_t load;
+    double      print_s;
+} profile_t;
+
+typedef struct {
+    double warn_at_s;         // first WARN, -1 = never
+    double cutoff_at_s;       // first CUTOFF, -1 = never
+    double release_at_s;      // cutoff released, -1 = never
+    float  final_scale;
+    float  max_excess;        // largest |duty| above the scale in force
+    float  cutoff_duty;       // largest |duty| while cut off
+} result_t;
+
+static int failures = 0;
+
+static void check(const char *profile, const char *what, int ok) {
+    printf("  %s  %s: %s\n", ok ? "PASS" : "FAIL", profile, what);
+    if (!ok) failures++;
+}
+
+static result_t run(const profile_t *pr, const thermal_params_t *p, int loop_hz) {
+    thermal_track_t t = {0};
+    speed_pid_t pid;
+    speed_pid_reset(&pid);
+    result_t r = {-1, -1, -1, 1.0f, 0.0f, 0.0f};
+    int cut = 0;
+    double dt = 1.0 / loop_hz;
+    float scale = 1.0f;
+    long steps = (long)(pr->duration_s * loop_hz);
+    long print_every = (long)(pr->print_s * loop_hz);
+
+    printf("\n%s\n  %8s %7s %7s %7s %7s  %s\n", pr->name,
+           "t (s)", "motor", "bridge", "amps", "scale", "state");
+    for (long i = 0; i <= steps; i++) {
+        double now = i * dt;
+        int on = (pr->period_s <= 0.0) || (fmod(now, pr->period_s) < pr->on_s);
+        if (pr->load == LOAD_FIXED) on = (now < pr->on_s);
+        float duty = on ? pr->duty * scale : 0.0f;
+        if (pr->load == LOAD_PID_STALL) {
+            // As speed_ctrl_run(): the derating is the PID's output limit
+            duty = fabsf(speed_pid_update_limited(&pid, &pid_gains, pr->duty, 0.0f,
+                                                  scale, (float)dt));
+        }
+        if (duty - scale > r.max_excess) r.max_excess = duty - scale;
+        if (cut && duty > r.cutoff_duty) r.cutoff_duty = duty;
+
+        float amps;
+        switch (pr->load) {
+            case LOAD_STALL:
+            case LOAD_PID_STALL: amps = duty * STALL_A; break;
+            case LOAD_FIXED: amps = on ? SHORT_A : 0.0f; break;
+            default:         amps = thermal_amps_from_duty(p, duty); break;
+        }
+        thermal_track_update(&t, p, amps, (float)dt);
+        scale = thermal_track_scale(&t, p);
+        thermal_state_t st = thermal_track_state(&t, p);
+        cut = (st == THERMAL_CUTOFF);
+
+        if (st == THERMAL_WARN && r.warn_at_s < 0) r.warn_at_s = now;
+        if (st == THERMAL_CUTOFF && r.cutoff_at_s < 0) r.cutoff_at_s = now;
+        if (st != THERMAL_CUTOFF && r.cutoff_at_s >= 0 && r.release_at_s < 0) r.release_at_s = now;
+
+        if (i % print_every == 0) {
+            printf("  %8.0f %7.3f %7.3f %7.2f %7.2f  %s\n", now, t.motor, t.bridge,
+                   amps, scale, thermal_state_name(st));
+        }
+    }
+    r.final_scale = scale;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    thermal_params_t p = {
+        .motor_tau_s    = 240.0f,
+        .motor_limit_a  = 6.0f,
+        .bridge_tau_s   = 20.0f,
+        .bridge_limit_a = 15.0f,
+        .full_duty_a    = 8.0f,
+        .derate_start   = 0.80f,
+        .min_scale      = 0.30f,
+        .resume         = 0.60f,
+    };
+    int loop_hz = 50;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:A:b:B:f:s:n:r:H:")) != -1) {
+        float v = strtof(optarg, NULL);
+        switch (opt) {
+            case 'a': p.motor_limit_a = v; break;
+            case 'A': p.motor_tau_s = v; break;
+            case 'b': p.bridge_limit_a = v; break;
+            case 'B': p.bridge_tau_s = v; break;
+            case 'f': p.full_duty_a = v; break;
+            case 's': p.derate_start = v / 100.0f; break;
+            case 'n': p.min_scale = v / 100.0f; break;
+            case 'r': p.resume = v / 100.0f; break;
+            case 'H': loop_hz = (int)v; break;
+            default:
+                fprintf(stderr, "usage: %s [-a motor_A] [-A motor_tau_s] [-b bridge_A] "
+                        "[-B bridge_tau_s] [-f full_duty_A] [-s start%%] [-n min%%] "
+                        "[-r resume%%] [-H loop_hz]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (loop_hz <= 0 || p.derate_start <= 0.0f || p.derate_start >= 1.0f ||
+        p.resume > p.derate_start) {
+        fprintf(stderr, "need loop_hz > 0, 0 < start < 100, resume <= start\n");
+        return 1;
+    }
+
+    printf("motor %.1f A / %.0f s, bridge %.1f A / %.0f s, full duty %.1f A, "
+           "derate %.0f%% -> %.0f%% output, resume %.0f%%, %d Hz\n",
+           p.motor_limit_a, p.motor_tau_s, p.bridge_limit_a, p.bridge_tau_s, p.full_duty_a,
+           p.derate_start * 100.0f, p.min_scale * 100.0f, p.resume * 100.0f, loop_hz);
+
+    // Static curve
+    printf("\ncurve\n  %7s %7s\n", "heat", "scale");
+    float prev = 2.0f;
+    int monotonic = 1;
+    for (int h = 0; h <= 100; h += 5) {
+        thermal_track_t t = {.motor = h / 100.0f * 0.999f};
+        float s = thermal_track_scale(&t, &p);
+        if (h % 10 == 0) printf("  %7.2f %7.2f\n", t.motor, s);
+        if (s > prev + 1e-6f) monotonic = 0;
+        prev = s;
+    }
+    thermal_track_t cool = {.motor = p.derate_start};
+    thermal_track_t edge = {.motor = 0.9999f};
+    check("curve", "full output up to derate_start",
+          thermal_track_scale(&cool, &p) == 1.0f);
+    check("curve", "reaches min_scale at the cutoff",
+          fabsf(thermal_track_scale(&edge, &p) - p.min_scale) < 0.01f);
+    check("curve", "never increases with heat", monotonic);
+
+    const profile_t cruise = {"cruise: 50% duty, duty estimate", 1200, 0, 0, 0.5f, LOAD_DUTY, PRINT_S * 2};
+    result_t r = run(&cruise, &p, loop_hz);
+    check("cruise", "never derates", r.warn_at_s < 0 && r.cutoff_at_s < 0);
+
+    const profile_t push = {"push: 100% duty, duty estimate", 1200, 0, 0, 1.0f, LOAD_DUTY, PRINT_S * 2};
+    result_t rp = run(&push, &p, loop_hz);
+    printf("  derating from %.0f s, settles at %.0f%% output\n", rp.warn_at_s, rp.final_scale * 100.0f);
+    check("push", "derates after sustained full duty", rp.warn_at_s > 30.0);
+    check("push", "settles above min_scale without a cutoff",
+          rp.cutoff_at_s < 0 && rp.final_scale > p.min_scale && rp.final_scale < 1.0f);
+
+    const profile_t cycle = {"cycle: 100% for 30 s / off 30 s", 1800, 30, 60, 1.0f, LOAD_DUTY, PRINT_S * 2};
+    result_t rc = run(&cycle, &p, loop_hz);
+    check("cycle", "derates later than continuous push (or not at all)",
+          rc.warn_at_s < 0 || rc.warn_at_s > rp.warn_at_s);
+    check("cycle", "no cutoff", rc.cutoff_at_s < 0);
+
+    const profile_t stall = {"stall: measured current follows duty", 120, 0, 0, 1.0f, LOAD_STALL, 10};
+    result_t rs = run(&stall, &p, loop_hz);
+    printf("  derating from %.1f s, cutoff at %.1f s\n", rs.warn_at_s, rs.cutoff_at_s);
+    check("stall", "derates within a bridge time constant",
+          rs.warn_at_s >= 0 && rs.warn_at_s < p.bridge_tau_s);
+    check("stall", "warning runs at least 10 s before any cutoff",
+          rs.cutoff_at_s < 0 || rs.cutoff_at_s - rs.warn_at_s >= 10.0);
+
+    const profile_t spid = {"stall-pid: closed loop, 80% target, track stalled", 120, 0, 0, 0.8f,
+                            LOAD_PID_STALL, 10};
+    result_t rsp = run(&spid, &p, loop_hz);
+    printf("  derating from %.1f s, cutoff at %.1f s\n", rsp.warn_at_s, rsp.cutoff_at_s);
+    check("stall-pid", "duty never exceeds the derating scale", rsp.max_excess < 1e-4f);
+    check("stall-pid", "derates within a bridge time constant",
+          rsp.warn_at_s >= 0 && rsp.warn_at_s < p.bridge_tau_s);
+    check("stall-pid", "cuts off, with zero duty while cut off",
+          rsp.cutoff_at_s >= 0 && rsp.cutoff_duty == 0.0f);
+
+    const profile_t shrt = {"short: 30 A regardless of duty for 10 s", 400, 10, 0, 1.0f, LOAD_FIXED, 20};
+    result_t rf = run(&shrt, &p, loop_hz);
+    printf("  cutoff at %.1f s, released at %.1f s\n", rf.cutoff_at_s, rf.release_at_s);
+    check("short", "warns before the cutoff",
+          rf.warn_at_s >= 0 && rf.cutoff_at_s > rf.warn_at_s);
+    check("short", "cuts off while the current persists",
+          rf.cutoff_at_s >= 0 && rf.cutoff_at_s < 10.0);
+    check("short", "releases only after cooling below resume",
+          rf.release_at_s > 10.0 && rf.release_at_s < 400.0);
+
+    printf("\n%s (%d failed)\n", failures ? "FAIL" : "PASS", failures);
+    return failures;
+}